@@ -0,0 +1,85 @@
+// first 8 positive examples of dataset/aids.g, a stream for -window
+XP # 1 //molid3060
+v 1 "As"
+v 2 "O"
+v 3 "O"
+d 1 2 "2"
+d 1 3 "1"
+
+XP # 2 //molid647528
+v 1 "S"
+v 2 "C"
+v 3 "C"
+v 4 "N"
+d 1 2 "1"
+d 2 3 "1"
+d 3 4 "1"
+
+XP # 3 //molid156204
+v 1 "C"
+v 2 "O"
+v 3 "O"
+v 4 "O"
+d 1 2 "2"
+d 1 3 "1"
+d 1 4 "1"
+
+XP # 4 //molid15200
+v 1 "N"
+v 2 "O"
+v 3 "O"
+v 4 "O"
+d 1 2 "1"
+d 1 3 "1"
+d 1 4 "1"
+
+XP # 5 //molid45410
+v 1 "C"
+v 2 "C"
+v 3 "C"
+v 4 "N"
+v 5 "N"
+d 1 2 "1"
+d 1 3 "2"
+d 2 4 "2"
+d 3 5 "1"
+d 4 5 "1"
+
+XP # 6 //molid617627
+v 1 "C"
+v 2 "N"
+v 3 "C"
+v 4 "C"
+v 5 "C"
+v 6 "N"
+d 1 2 "1"
+d 2 3 "1"
+d 3 4 "1"
+d 3 5 "1"
+d 5 6 "3"
+
+XP # 7 //molid45463
+v 1 "C"
+v 2 "N"
+v 3 "C"
+v 4 "C"
+v 5 "C"
+v 6 "S"
+d 1 2 "1"
+d 1 3 "1"
+d 2 4 "1"
+d 2 5 "1"
+d 3 6 "1"
+
+XP # 8 //molid640440
+v 1 "C"
+v 2 "C"
+v 3 "I"
+v 4 "C"
+v 5 "Br"
+v 6 "C"
+d 1 2 "2"
+d 2 3 "1"
+d 2 4 "1"
+d 4 5 "1"
+d 1 6 "1"
@@ -0,0 +1,23 @@
+// numeric vertex and edge labels, with and without a sign
+XP # 1
+v 1 -5
+v 2 -2.5
+v 3 +3
+v 4 "a"
+u 1 2 -1
+u 3 2 -1
+d 3 4 -.5
+XP # 2
+v 1 -5
+v 2 -2.5
+v 3 3
+v 4 "a"
+u 1 2 -1
+u 3 2 -1
+d 3 4 -0.5
+XP # 3
+v 1 -5
+v 2 -2.5
+v 3 -3
+u 1 2 -1
+u 3 2 +1
@@ -8,11 +8,19 @@
 // 12/17/09  Graves     Initial version.
 // 06/15/14  Eberle     Added fclose to GP_read_graph.
 // 01/02/15  Graves     Changed the return type of int to GP_read_graph.
+// 10/17/26  agent      GP_read_graph maps regular files into memory and
+//                      reads them with ReadMappedGraph, keeping the parser
+//                      for other inputs; returns 1 if file cannot be opened.
+// 10/17/26  agent      GP_read_graph reads regular files with
+//                      ReadGraphDescriptor.
+// 10/17/26  agent      GP_read_graph reads pipes with ReadGraphDescriptor too.
 //
 //******************************************************************************
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include "gbad.h"
 #include "actions.h"
@@ -58,27 +66,29 @@ char GP_err_str[ERR_STR_LEN];
 // The filed info->labelList is used to store labels found in the input file
 // and is assumed to be non-NULL.  The info->directed field is used to
 // determine if 'e' edges are directed.
+//
+// The file is read by ReadGraphDescriptor, which maps a regular file into
+// memory and reads other inputs (e.g., pipes) into a buffer, so every
+// input is parsed the same way as by GP_read_graph_r.  On an error, a
+// message is printed to stderr.
 //******************************************************************************
 int GP_read_graph(Graph_Info *info, char *inputFileName)
 {
    int ret;
-   FILE *tmp = yyin;
-	
-   FILE *input = fopen(inputFileName, "r");
-   if (input == NULL)
+   int fd;
+   GP_error error;
+
+   fd = open(inputFileName, O_RDONLY);
+   if (fd < 0)
    {
       fprintf(stderr, "Unable to open input file %s.\n", inputFileName);
-      exit(1);
+      return 1;
    }
-	
-   GP_file_name = inputFileName;
-	
-   yyin = input;
-   yylineno = 1;
-   ret = yyparse((void *)info);
-   yyin = tmp;
-   fclose(input);
-   
+   ret = ReadGraphDescriptor(info, fd, & error);
+   close(fd);
+   if (ret != 0)
+      fprintf(stderr, "%s:%lu: error: %s\n", inputFileName, error.lineNo,
+              error.message);
    return ret;
 }
 
@@ -0,0 +1,675 @@
+//******************************************************************************
+// canonical.c
+//
+// Canonical codes for substructure definitions.  Two definitions
+// receive the same canonical code exactly when they are isomorphic
+// (respecting vertex labels, edge labels, edge directedness and edge
+// direction), so exact substructure equality can be decided by
+// comparing codes instead of running GraphMatch.  The code is found
+// by color refinement followed by an individualization search for
+// the least code over all refined orderings of the vertices.
+//
+//
+// Date      Name       Description
+// ========  =========  ========================================================
+// 10/16/26  agent      Initial version
+//
+//******************************************************************************
+
+#include "gbad.h"
+
+// Direction classes for an edge as seen from one of its endpoints
+#define CANON_UNDIRECTED      0
+#define CANON_OUT             1
+#define CANON_IN              2
+#define CANON_DIRECTED_LOOP   3
+#define CANON_UNDIRECTED_LOOP 4
+
+#define CANON_HASH_OFFSET 14695981039346656037ULL // FNV-1a 64-bit offset
+#define CANON_HASH_PRIME  1099511628211ULL        // FNV-1a 64-bit prime
+
+
+//******************************************************************************
+// NAME: ComputeSubCanonicalCode
+//
+// INPUTS: (Substructure *sub) - substructure whose code is needed
+//
+// RETURN: (void)
+//
+// PURPOSE: Compute and store the canonical hash and, when the search
+// stays within CANONICAL_SEARCH_LIMIT nodes, the canonical code of the
+// substructure's definition.  Does nothing if already computed.
+//******************************************************************************
+
+void ComputeSubCanonicalCode(Substructure *sub)
+{
+   if (sub->canonicalDone)
+      return;
+   sub->canonicalCode = CanonicalCode(sub->definition,
+                                      &sub->canonicalCodeLength,
+                                      &sub->canonicalHash);
+   sub->canonicalDone = TRUE;
+}
+
+
+//******************************************************************************
+// NAME: SubsMatch
+//
+// INPUTS: (Substructure *sub1)
+//         (Substructure *sub2)
+//         (LabelList *labelList) - needed for fallback graph match
+//
+// RETURN: (BOOLEAN) - TRUE if definitions are isomorphic
+//
+// PURPOSE: Exact equality test for substructure definitions.  Differing
+// canonical hashes mean the definitions differ.  Otherwise, the
+// canonical codes decide; if either code was abandoned because the
+// search limit was reached, the definitions are compared with
+// GraphMatch as before.
+//******************************************************************************
+
+BOOLEAN SubsMatch(Substructure *sub1, Substructure *sub2, LabelList *labelList)
+{
+   ComputeSubCanonicalCode(sub1);
+   ComputeSubCanonicalCode(sub2);
+   if (sub1->canonicalHash != sub2->canonicalHash)
+      return FALSE;
+   if ((sub1->canonicalCode != NULL) && (sub2->canonicalCode != NULL))
+      return CanonicalCodesEqual(sub1->canonicalCode,
+                                 sub1->canonicalCodeLength,
+                                 sub2->canonicalCode,
+                                 sub2->canonicalCodeLength);
+   return GraphMatch(sub1->definition, sub2->definition, labelList, 0.0,
+                     NULL, NULL);
+}
+
+
+//******************************************************************************
+// NAME: CanonicalCodesEqual
+//
+// INPUTS: (ULONG *code1), (ULONG length1) - first code
+//         (ULONG *code2), (ULONG length2) - second code
+//
+// RETURN: (BOOLEAN) - TRUE if codes identical
+//
+// PURPOSE: Compare two canonical codes.
+//******************************************************************************
+
+BOOLEAN CanonicalCodesEqual(ULONG *code1, ULONG length1,
+                            ULONG *code2, ULONG length2)
+{
+   if (length1 != length2)
+      return FALSE;
+   return (memcmp(code1, code2, length1 * sizeof(ULONG)) == 0);
+}
+
+
+//******************************************************************************
+// NAME: CanonicalCode
+//
+// INPUTS: (Graph *graph) - graph to encode
+//         (ULONG *codeLength) - returned length of code
+//         (ULONG *hash) - returned isomorphism-invariant hash
+//
+// RETURN: (ULONG *) - canonical code, or NULL if search limit reached
+//
+// PURPOSE: Compute the canonical code of the graph.  The code is the
+// number of vertices, the number of edges, the vertex labels in
+// canonical order, and then the sorted (source, target, directed,
+// label) tuples of the edges under that order, with undirected edges
+// stored lowest position first.  The hash is computed from the
+// refined vertex coloring at the root of the search, so it is defined
+// even when the code is not.  The search visits the same number of
+// nodes for isomorphic graphs, so either both or neither of two
+// isomorphic graphs receive a code.
+//******************************************************************************
+
+ULONG *CanonicalCode(Graph *graph, ULONG *codeLength, ULONG *hash)
+{
+   CanonicalSearch search;
+   ULONG n = graph->numVertices;
+   ULONG m = graph->numEdges;
+   ULONG v;
+   ULONG i;
+   ULONG numIncidences = 0;
+   ULONG e;
+   ULONG j, k;
+   ULONG swap;
+   Edge *edge;
+   ULONG *code;
+
+   search.graph = graph;
+   search.codeLength = 2 + n + (4 * m);
+   search.numNodes = 0;
+   search.aborted = FALSE;
+   search.haveBest = FALSE;
+   search.rootHash = 0;
+
+   // incidence triples (direction class, edge label, neighbor) per vertex
+   search.incidenceStart = (ULONG *) malloc(sizeof(ULONG) * (n + 1));
+   if (search.incidenceStart == NULL)
+      OutOfMemoryError("CanonicalCode:search.incidenceStart");
+   for (v = 0; v < n; v++)
+   {
+      search.incidenceStart[v] = numIncidences;
+      numIncidences += graph->vertices[v].numEdges;
+   }
+   search.incidenceStart[n] = numIncidences;
+   search.incidence = (ULONG *) malloc(sizeof(ULONG) * 3 * (numIncidences + 1));
+   search.signatures =
+      (ULONG *) malloc(sizeof(ULONG) * 3 * (numIncidences + 1));
+   if ((search.incidence == NULL) || (search.signatures == NULL))
+      OutOfMemoryError("CanonicalCode:search.incidence");
+   for (v = 0; v < n; v++)
+   {
+      for (i = 0; i < graph->vertices[v].numEdges; i++)
+      {
+         e = graph->vertices[v].edges[i];
+         edge = & graph->edges[e];
+         numIncidences = 3 * (search.incidenceStart[v] + i);
+         if (edge->vertex1 == edge->vertex2)
+         {
+            if (edge->directed)
+               search.incidence[numIncidences] = CANON_DIRECTED_LOOP;
+            else
+               search.incidence[numIncidences] = CANON_UNDIRECTED_LOOP;
+         }
+         else if (! edge->directed)
+            search.incidence[numIncidences] = CANON_UNDIRECTED;
+         else if (edge->vertex1 == v)
+            search.incidence[numIncidences] = CANON_OUT;
+         else
+            search.incidence[numIncidences] = CANON_IN;
+         search.incidence[numIncidences + 1] = edge->label;
+         if (edge->vertex1 == v)
+            search.incidence[numIncidences + 2] = edge->vertex2;
+         else
+            search.incidence[numIncidences + 2] = edge->vertex1;
+         // keep each vertex's triples sorted for CanonicalTwins
+         j = numIncidences;
+         while ((j > 3 * search.incidenceStart[v]) &&
+                (CompareTriples(&search.incidence[j - 3],
+                                search.incidence[j],
+                                search.incidence[j + 1],
+                                search.incidence[j + 2]) > 0))
+         {
+            for (k = 0; k < 3; k++)
+            {
+               swap = search.incidence[j - 3 + k];
+               search.incidence[j - 3 + k] = search.incidence[j + k];
+               search.incidence[j + k] = swap;
+            }
+            j -= 3;
+         }
+      }
+   }
+
+   // one coloring per search depth; depth never exceeds number of vertices
+   search.colors = (ULONG *) malloc(sizeof(ULONG) * (n + 1) * (n + 1));
+   search.order = (ULONG *) malloc(sizeof(ULONG) * (n + 1));
+   search.scratch = (ULONG *) malloc(sizeof(ULONG) * (n + 1));
+   search.edgeTuples = (ULONG *) malloc(sizeof(ULONG) * 4 * (m + 1));
+   search.code = (ULONG *) malloc(sizeof(ULONG) * search.codeLength);
+   search.bestCode = (ULONG *) malloc(sizeof(ULONG) * search.codeLength);
+   if ((search.colors == NULL) || (search.order == NULL) ||
+       (search.scratch == NULL) || (search.edgeTuples == NULL) ||
+       (search.code == NULL) || (search.bestCode == NULL))
+      OutOfMemoryError("CanonicalCode:search");
+
+   // initial coloring by vertex label
+   for (v = 0; v < n; v++)
+      search.colors[v] = graph->vertices[v].label;
+   CanonicalSearchNode(&search, 0);
+
+   *hash = search.rootHash;
+   if (search.aborted)
+   {
+      free(search.bestCode);
+      code = NULL;
+      *codeLength = 0;
+   }
+   else
+   {
+      code = search.bestCode;
+      *codeLength = search.codeLength;
+   }
+   free(search.code);
+   free(search.edgeTuples);
+   free(search.scratch);
+   free(search.order);
+   free(search.colors);
+   free(search.signatures);
+   free(search.incidence);
+   free(search.incidenceStart);
+   return code;
+}
+
+
+//******************************************************************************
+// NAME: CanonicalSearchNode
+//
+// INPUTS: (CanonicalSearch *search) - search state
+//         (ULONG depth) - depth of node; coloring at this depth is input
+//
+// RETURN: (void)
+//
+// PURPOSE: Refine the coloring at the given depth.  If every vertex
+// has its own color, the coloring is a vertex ordering, and its code
+// replaces the best code if smaller.  Otherwise, each vertex of the
+// first color class with more than one vertex is individualized in
+// turn and searched at the next depth, skipping vertices that are
+// twins of one already tried.
+//******************************************************************************
+
+void CanonicalSearchNode(CanonicalSearch *search, ULONG depth)
+{
+   ULONG n = search->graph->numVertices;
+   ULONG *colors = search->colors + (depth * n);
+   ULONG *nextColors = colors + n;
+   ULONG numColors;
+   ULONG target;
+   ULONG v;
+   ULONG u;
+
+   numColors = RefineColors(search, colors);
+   search->numNodes++;
+   if (search->numNodes > CANONICAL_SEARCH_LIMIT)
+   {
+      search->aborted = TRUE;
+      return;
+   }
+   if (depth == 0)
+      search->rootHash = CanonicalColoringHash(search, colors);
+
+   if (numColors == n)
+   {
+      CanonicalLeaf(search, colors);
+      return;
+   }
+
+   // find first color class containing more than one vertex
+   for (v = 0; v < n; v++)
+      search->scratch[v] = 0;
+   for (v = 0; v < n; v++)
+      search->scratch[colors[v]]++;
+   target = 0;
+   while (search->scratch[target] < 2)
+      target++;
+
+   for (v = 0; v < n; v++)
+   {
+      // individualizing a twin of an earlier vertex in the class would
+      // repeat that vertex's subtree under an automorphism
+      for (u = 0; u < v; u++)
+         if ((colors[u] == target) && CanonicalTwins(search, u, v))
+            break;
+      if ((colors[v] == target) && (u == v))
+      {
+         for (u = 0; u < n; u++)
+         {
+            if (colors[u] > target)
+               nextColors[u] = colors[u] + 1;
+            else if ((colors[u] == target) && (u != v))
+               nextColors[u] = target + 1;
+            else
+               nextColors[u] = colors[u];
+         }
+         CanonicalSearchNode(search, depth + 1);
+         if (search->aborted)
+            return;
+      }
+   }
+}
+
+
+//******************************************************************************
+// NAME: CanonicalTwins
+//
+// INPUTS: (CanonicalSearch *search) - search state
+//         (ULONG u), (ULONG v) - vertices of the same color
+//
+// RETURN: (BOOLEAN) - TRUE if exchanging u and v is an automorphism
+//
+// PURPOSE: Vertices u and v are twins if they have the same incident
+// edges to every other vertex, and the edges among u and v look the
+// same from both.  Each vertex's incidence triples are sorted, so the
+// triples to other vertices are compared in order, and then the
+// (direction class, label) pairs of the triples between u and v.
+//******************************************************************************
+
+BOOLEAN CanonicalTwins(CanonicalSearch *search, ULONG u, ULONG v)
+{
+   ULONG *incidence = search->incidence;
+   ULONG iu, iv;
+   ULONG pass;
+   ULONG finishU = 3 * search->incidenceStart[u + 1];
+   ULONG finishV = 3 * search->incidenceStart[v + 1];
+   BOOLEAN between;
+
+   if ((finishU - (3 * search->incidenceStart[u])) !=
+       (finishV - (3 * search->incidenceStart[v])))
+      return FALSE;
+   for (pass = 0; pass < 2; pass++)
+   {
+      between = (pass == 1);
+      iu = 3 * search->incidenceStart[u];
+      iv = 3 * search->incidenceStart[v];
+      while (TRUE)
+      {
+         while ((iu < finishU) &&
+                (((incidence[iu + 2] == u) || (incidence[iu + 2] == v)) !=
+                 between))
+            iu += 3;
+         while ((iv < finishV) &&
+                (((incidence[iv + 2] == u) || (incidence[iv + 2] == v)) !=
+                 between))
+            iv += 3;
+         if ((iu >= finishU) || (iv >= finishV))
+            break;
+         if ((incidence[iu] != incidence[iv]) ||
+             (incidence[iu + 1] != incidence[iv + 1]) ||
+             ((! between) && (incidence[iu + 2] != incidence[iv + 2])))
+            return FALSE;
+         iu += 3;
+         iv += 3;
+      }
+      if ((iu < finishU) || (iv < finishV))
+         return FALSE;
+   }
+   return TRUE;
+}
+
+
+//******************************************************************************
+// NAME: RefineColors
+//
+// INPUTS: (CanonicalSearch *search) - search state
+//         (ULONG *colors) - vertex coloring, refined in place
+//
+// RETURN: (ULONG) - number of colors in refined coloring
+//
+// PURPOSE: Repeatedly split color classes by the sorted multiset of
+// (direction class, edge label, neighbor color) over each vertex's
+// edges, until no class splits.  Colors are renumbered 0..k-1 in
+// order of (old color, multiset), so the result depends only on the
+// input coloring up to isomorphism.
+//******************************************************************************
+
+ULONG RefineColors(CanonicalSearch *search, ULONG *colors)
+{
+   ULONG n = search->graph->numVertices;
+   ULONG numColors = 0;
+   ULONG newNumColors;
+   ULONG v;
+   ULONG i, j;
+   ULONG start, finish;
+   ULONG *sig = search->signatures;
+   ULONG *order = search->order;
+   ULONG *newColors = search->scratch;
+   ULONG t0, t1, t2;
+
+   if (n == 0)
+      return 0;
+   while (TRUE)
+   {
+      // build sorted signature of each vertex
+      for (v = 0; v < n; v++)
+      {
+         start = search->incidenceStart[v];
+         finish = search->incidenceStart[v + 1];
+         for (i = start; i < finish; i++)
+         {
+            t0 = search->incidence[3 * i];
+            t1 = search->incidence[(3 * i) + 1];
+            t2 = colors[search->incidence[(3 * i) + 2]];
+            j = i;
+            while ((j > start) &&
+                   CompareTriples(&sig[3 * (j - 1)], t0, t1, t2) > 0)
+            {
+               sig[3 * j] = sig[3 * (j - 1)];
+               sig[(3 * j) + 1] = sig[(3 * (j - 1)) + 1];
+               sig[(3 * j) + 2] = sig[(3 * (j - 1)) + 2];
+               j--;
+            }
+            sig[3 * j] = t0;
+            sig[(3 * j) + 1] = t1;
+            sig[(3 * j) + 2] = t2;
+         }
+      }
+
+      // order vertices by (color, signature)
+      for (i = 0; i < n; i++)
+      {
+         v = i;
+         j = i;
+         while ((j > 0) &&
+                (CompareCanonicalVertices(search, colors, order[j - 1], v) > 0))
+         {
+            order[j] = order[j - 1];
+            j--;
+         }
+         order[j] = v;
+      }
+
+      // renumber colors by rank
+      newNumColors = 1;
+      newColors[order[0]] = 0;
+      for (i = 1; i < n; i++)
+      {
+         if (CompareCanonicalVertices(search, colors, order[i - 1],
+                                      order[i]) != 0)
+            newNumColors++;
+         newColors[order[i]] = newNumColors - 1;
+      }
+      for (v = 0; v < n; v++)
+         colors[v] = newColors[v];
+      if (newNumColors == numColors)
+         break;
+      numColors = newNumColors;
+   }
+   return numColors;
+}
+
+
+//******************************************************************************
+// NAME: CompareTriples
+//
+// INPUTS: (ULONG *triple) - stored triple
+//         (ULONG t0), (ULONG t1), (ULONG t2) - triple to compare with
+//
+// RETURN: (int) - negative, zero or positive as triple is less than,
+//                 equal to, or greater than (t0, t1, t2)
+//
+// PURPOSE: Lexicographic comparison of signature triples.
+//******************************************************************************
+
+int CompareTriples(ULONG *triple, ULONG t0, ULONG t1, ULONG t2)
+{
+   if (triple[0] != t0)
+      return (triple[0] < t0) ? -1 : 1;
+   if (triple[1] != t1)
+      return (triple[1] < t1) ? -1 : 1;
+   if (triple[2] != t2)
+      return (triple[2] < t2) ? -1 : 1;
+   return 0;
+}
+
+
+//******************************************************************************
+// NAME: CompareCanonicalVertices
+//
+// INPUTS: (CanonicalSearch *search) - search state with signatures built
+//         (ULONG *colors) - current coloring
+//         (ULONG v1), (ULONG v2) - vertices to compare
+//
+// RETURN: (int) - negative, zero or positive
+//
+// PURPOSE: Order vertices by color, then number of edges, then sorted
+// signature.
+//******************************************************************************
+
+int CompareCanonicalVertices(CanonicalSearch *search, ULONG *colors,
+                             ULONG v1, ULONG v2)
+{
+   ULONG start1 = 3 * search->incidenceStart[v1];
+   ULONG start2 = 3 * search->incidenceStart[v2];
+   ULONG length1 = (3 * search->incidenceStart[v1 + 1]) - start1;
+   ULONG length2 = (3 * search->incidenceStart[v2 + 1]) - start2;
+   ULONG i;
+
+   if (colors[v1] != colors[v2])
+      return (colors[v1] < colors[v2]) ? -1 : 1;
+   if (length1 != length2)
+      return (length1 < length2) ? -1 : 1;
+   for (i = 0; i < length1; i++)
+   {
+      if (search->signatures[start1 + i] != search->signatures[start2 + i])
+         return (search->signatures[start1 + i] <
+                 search->signatures[start2 + i]) ? -1 : 1;
+   }
+   return 0;
+}
+
+
+//******************************************************************************
+// NAME: BuildEdgeTuples
+//
+// INPUTS: (CanonicalSearch *search) - search state
+//         (ULONG *colors) - coloring used as vertex positions
+//
+// RETURN: (void)
+//
+// PURPOSE: Fill search->edgeTuples with the sorted (source, target,
+// directed, label) tuples of the graph's edges under the coloring.
+// Undirected edges are stored with the lower color first.
+//******************************************************************************
+
+void BuildEdgeTuples(CanonicalSearch *search, ULONG *colors)
+{
+   Graph *graph = search->graph;
+   ULONG *tuples = search->edgeTuples;
+   ULONG e;
+   ULONG i, j, k;
+   ULONG tuple[4];
+   Edge *edge;
+   BOOLEAN less;
+
+   for (e = 0; e < graph->numEdges; e++)
+   {
+      edge = & graph->edges[e];
+      tuple[0] = colors[edge->vertex1];
+      tuple[1] = colors[edge->vertex2];
+      if ((! edge->directed) && (tuple[0] > tuple[1]))
+      {
+         tuple[0] = colors[edge->vertex2];
+         tuple[1] = colors[edge->vertex1];
+      }
+      tuple[2] = (ULONG) edge->directed;
+      tuple[3] = edge->label;
+      j = e;
+      while (j > 0)
+      {
+         less = FALSE;
+         for (k = 0; k < 4; k++)
+         {
+            if (tuple[k] != tuples[(4 * (j - 1)) + k])
+            {
+               less = (tuple[k] < tuples[(4 * (j - 1)) + k]);
+               break;
+            }
+         }
+         if (! less)
+            break;
+         for (k = 0; k < 4; k++)
+            tuples[(4 * j) + k] = tuples[(4 * (j - 1)) + k];
+         j--;
+      }
+      for (i = 0; i < 4; i++)
+         tuples[(4 * j) + i] = tuple[i];
+   }
+}
+
+
+//******************************************************************************
+// NAME: CanonicalLeaf
+//
+// INPUTS: (CanonicalSearch *search) - search state
+//         (ULONG *colors) - discrete coloring giving vertex positions
+//
+// RETURN: (void)
+//
+// PURPOSE: Build the code for the vertex ordering given by the
+// coloring and keep it if it is less than the best code so far.
+//******************************************************************************
+
+void CanonicalLeaf(CanonicalSearch *search, ULONG *colors)
+{
+   Graph *graph = search->graph;
+   ULONG n = graph->numVertices;
+   ULONG m = graph->numEdges;
+   ULONG *code = search->code;
+   ULONG *swap;
+   ULONG v;
+   ULONG i;
+
+   code[0] = n;
+   code[1] = m;
+   for (v = 0; v < n; v++)
+      code[2 + colors[v]] = graph->vertices[v].label;
+   BuildEdgeTuples(search, colors);
+   for (i = 0; i < 4 * m; i++)
+      code[2 + n + i] = search->edgeTuples[i];
+
+   if (search->haveBest)
+   {
+      for (i = 0; i < search->codeLength; i++)
+         if (code[i] != search->bestCode[i])
+            break;
+      if ((i == search->codeLength) || (code[i] > search->bestCode[i]))
+         return;
+   }
+   swap = search->bestCode;
+   search->bestCode = search->code;
+   search->code = swap;
+   search->haveBest = TRUE;
+}
+
+
+//******************************************************************************
+// NAME: CanonicalColoringHash
+//
+// INPUTS: (CanonicalSearch *search) - search state
+//         (ULONG *colors) - refined root coloring
+//
+// RETURN: (ULONG) - hash value
+//
+// PURPOSE: FNV-1a hash of the vertex labels listed by refined color
+// and of the sorted edge tuples under the refined coloring.  Refined
+// colors are isomorphism-invariant, so isomorphic graphs hash alike.
+//******************************************************************************
+
+ULONG CanonicalColoringHash(CanonicalSearch *search, ULONG *colors)
+{
+   Graph *graph = search->graph;
+   ULONG n = graph->numVertices;
+   ULONG m = graph->numEdges;
+   unsigned long long hash = CANON_HASH_OFFSET;
+   ULONG i;
+
+   hash = (hash ^ (unsigned long long) n) * CANON_HASH_PRIME;
+   hash = (hash ^ (unsigned long long) m) * CANON_HASH_PRIME;
+   // search->order holds vertices sorted by refined color
+   for (i = 0; i < n; i++)
+   {
+      hash = (hash ^ (unsigned long long) colors[search->order[i]]) *
+             CANON_HASH_PRIME;
+      hash = (hash ^ (unsigned long long)
+                     graph->vertices[search->order[i]].label) *
+             CANON_HASH_PRIME;
+   }
+   BuildEdgeTuples(search, colors);
+   for (i = 0; i < 4 * m; i++)
+      hash = (hash ^ (unsigned long long) search->edgeTuples[i]) *
+             CANON_HASH_PRIME;
+   return (ULONG) hash;
+}
@@ -0,0 +1,251 @@
+#!/bin/sh
+#******************************************************************************
+# check.sh
+#
+# Runs gbad on the sample graphs (../graphs/*.g) with the single-threaded
+# command line, and checks that the same substructures come out of
+#   - the command line with -threads,
+#   - the command line on the graph2bin binary form of each graph,
+#   - the command line reading each graph from a pipe,
+#   - the server (gbad -serve), which runs the libgbad.so interface, for
+#     both the text and the binary graph, and
+#   - windowed discovery (-window) with -threads.
+# It also checks that the -window -eval 2 values on the stream of
+# examples in AIDS_STREAM.g are those of batch discovery on each window.
+# Run by "make check" after building gbad and graph2bin.  Prints each
+# difference and exits non-zero if there is any.
+#
+# Date      Name       Description
+# ========  =========  ========================================================
+# 10/17/26  agent      Initial version
+# 10/17/26  agent      Compare input read from a pipe
+# 10/17/26  agent      Compare -window values with batch discovery
+#
+#******************************************************************************
+
+GRAPHS=${GRAPHS:-../graphs}
+THREADS=${THREADS:-4}
+WORK=$(mktemp -d)
+SOCKET=$WORK/gbad.sock
+status=0
+server=
+
+trap 'if [ -n "$server" ]; then kill $server; fi; rm -rf $WORK' EXIT
+
+# drop lines that differ between equivalent runs; a missing file is empty
+filter()
+{
+   if [ -f "$1" ]
+   then
+      grep -v -e "lapsed" -e "Input file" -e "Output file" -e "Threads\.\." "$1"
+   fi
+}
+
+# compare two files, filtered, reporting a difference
+same()
+{
+   filter "$2" > $WORK/a
+   filter "$3" > $WORK/b
+   if ! cmp -s $WORK/a $WORK/b
+   then
+      echo "FAIL: $1"
+      status=1
+   fi
+}
+
+# send a graph to the server, writing the reply frames to stdout
+cat > $WORK/client.py <<'EOF'
+import socket, struct, sys
+
+def read(sock, length):
+    data = b""
+    while len(data) < length:
+        chunk = sock.recv(length - len(data))
+        if not chunk:
+            sys.exit("connection closed by gbad server")
+        data += chunk
+    return data
+
+sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+sock.connect(sys.argv[1])
+options = sys.argv[2].encode()
+with open(sys.argv[3], "rb") as f:
+    graph = f.read()
+sock.sendall(struct.pack("!I", len(options)) + options +
+             struct.pack("!I", len(graph)) + graph)
+frame = read(sock, struct.unpack("!I", read(sock, 4))[0])
+while frame:
+    sys.stdout.buffer.write(frame)
+    frame = read(sock, struct.unpack("!I", read(sock, 4))[0])
+EOF
+
+# compare the -window -eval 2 values of every step with batch discovery
+# on the window's examples
+cat > $WORK/window.py <<'EOF'
+import itertools, subprocess, sys
+
+gbad, graph, size, batchGraph = sys.argv[1], sys.argv[2], \
+                                int(sys.argv[3]), sys.argv[4]
+options = ["-eval", "2", "-maxsize", "3"]
+
+def run(args):
+    return subprocess.run([gbad] + args, capture_output=True,
+                          text=True).stdout.split("\n")
+
+def canonical(vertices, edges):
+    # smallest relabeling of a small graph, so equal graphs compare equal
+    best = None
+    for order in itertools.permutations(range(len(vertices))):
+        new = dict((v, i) for i, v in enumerate(order))
+        form = (tuple(vertices[v] for v in order),
+                tuple(sorted((kind, new[a], new[b], label)
+                             if kind != "u" else
+                             (kind, min(new[a], new[b]),
+                              max(new[a], new[b]), label)
+                             for kind, a, b, label in edges)))
+        if best is None or form < best:
+            best = form
+    return best
+
+def subs(lines):
+    # (value, instances) of each substructure printed in lines
+    found = {}
+    i = 0
+    while i < len(lines):
+        if " Substructure: value = " in lines[i]:
+            value = float(lines[i].split("value = ")[1].split(",")[0])
+            instances = int(lines[i].split("instances = ")[1])
+            vertices, edges = [], []
+            i += 2
+            while i < len(lines) and lines[i].startswith("    "):
+                fields = lines[i].split(None, 3)
+                if fields[0] == "v":
+                    vertices.append(fields[2])
+                else:
+                    edges.append((fields[0], int(fields[1]) - 1,
+                                  int(fields[2]) - 1, fields[3]))
+                i += 1
+            found[canonical(vertices, edges)] = (value, instances)
+        else:
+            i += 1
+    return found
+
+examples = []
+for line in open(graph):
+    if line.startswith("XP"):
+        examples.append([])
+    if examples:
+        examples[-1].append(line)
+
+status = 0
+compared = 0
+steps = "\n".join(run(options + ["-window", str(size), graph])) \
+        .split("----- Example ")[1:]
+if len(steps) != len(examples):
+    sys.exit("FAIL: -window %d reported %d of %d examples" %
+             (size, len(steps), len(examples)))
+for step, text in enumerate(steps, 1):
+    window = subs(text.split("\n"))
+    first = max(0, step - size)
+    with open(batchGraph, "w") as f:
+        for number, example in enumerate(examples[first:step], 1):
+            f.write("XP # %d\n" % number + "".join(example[1:]))
+    batch = subs(run(options + ["-beam", "100000", "-nsubs", "100000",
+                                "-limit", "100000", batchGraph]))
+    for sub, (value, instances) in window.items():
+        if len(sub[0]) == 1 and instances == 1:
+            # batch discovery starts only from labels with two instances
+            pass
+        elif sub not in batch:
+            print("FAIL: -window %d example %d: substructure %s not "
+                  "found by batch discovery" % (size, step, sub))
+            status = 1
+        elif (abs(batch[sub][0] - value) > 1e-5 or
+              batch[sub][1] != instances):
+            print("FAIL: -window %d example %d: value %g, %d instances, "
+                  "batch %g, %d instances" % (size, step, value, instances,
+                                               batch[sub][0], batch[sub][1]))
+            status = 1
+        else:
+            compared += 1
+if compared == 0:
+    print("FAIL: -window %d: no substructures compared" % size)
+    status = 1
+sys.exit(status)
+EOF
+
+./gbad -serve $SOCKET -workers 2 > $WORK/server.log 2>&1 &
+server=$!
+tries=0
+while [ ! -S $SOCKET ] && [ $tries -lt 50 ]
+do
+   sleep 0.1
+   tries=$((tries + 1))
+done
+
+for graph in $GRAPHS/*.g
+do
+   name=$(basename $graph .g)
+   # SG_*.g hold substructures written by -out, not input graphs
+   case $name in
+   SG_*) ;;
+   *)
+      ./graph2bin $graph $WORK/$name.bin > /dev/null
+      rm -f $WORK/*.out
+      for options in "-minsize 1 -maxsize 10 -nsubs 10" \
+                     "-mdl 0.2 -iterations 2" "-mps 0.2"
+      do
+         ./gbad $options -out $WORK/cli.out $graph > $WORK/cli.log 2>&1
+         ./gbad -threads $THREADS $options -out $WORK/threads.out $graph \
+            > $WORK/threads.log 2>&1
+         same "$name $options -threads $THREADS" $WORK/cli.log $WORK/threads.log
+         same "$name $options -threads $THREADS -out" $WORK/cli.out \
+            $WORK/threads.out
+         ./gbad $options -out $WORK/bin.out $WORK/$name.bin \
+            > $WORK/bin.log 2>&1
+         same "$name $options binary" $WORK/cli.log $WORK/bin.log
+         same "$name $options binary -out" $WORK/cli.out $WORK/bin.out
+         cat $graph | ./gbad $options -out $WORK/pipe.out /dev/stdin \
+            > $WORK/pipe.log 2>&1
+         same "$name $options pipe" $WORK/cli.log $WORK/pipe.log
+         same "$name $options pipe -out" $WORK/cli.out $WORK/pipe.out
+         python3 $WORK/client.py $SOCKET "$options" $graph \
+            > $WORK/server.out 2>&1
+         same "$name $options server" $WORK/cli.out $WORK/server.out
+         python3 $WORK/client.py $SOCKET "$options" $WORK/$name.bin \
+            > $WORK/server.out 2>&1
+         same "$name $options server binary" $WORK/cli.out $WORK/server.out
+      done
+      ./gbad -window 2 -nsubs 5 -out $WORK/cli.out $graph \
+         > $WORK/cli.log 2>&1
+      ./gbad -threads $THREADS -window 2 -nsubs 5 -out $WORK/threads.out \
+         $graph > $WORK/threads.log 2>&1
+      same "$name -window 2 -threads $THREADS" $WORK/cli.log $WORK/threads.log
+      same "$name -window 2 -threads $THREADS -out" $WORK/cli.out \
+         $WORK/threads.out
+      ;;
+   esac
+done
+
+# windows of AIDS_STREAM.g's examples, which fill and retire slots
+for size in 1 3 5
+do
+   if ! python3 $WORK/window.py ./gbad $GRAPHS/AIDS_STREAM.g $size \
+        $WORK/window.g
+   then
+      status=1
+   fi
+done
+
+# signed numeric labels are read as such
+if ! ./gbad $GRAPHS/SIGNED.g | grep -q '^    v 1 -5$'
+then
+   echo "FAIL: SIGNED labels"
+   status=1
+fi
+
+if [ $status -eq 0 ]
+then
+   echo "check passed"
+fi
+exit $status
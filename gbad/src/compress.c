@@ -10,6 +10,21 @@
 // 11/08/09  Eberle     Removed checks for mps option, as redesign of algorithm
 //                      implementation no longer needs this logic
 // 12/17/09  Graves     Added GUI coloring attributes to compressed graph
+// 10/16/26  agent      CompressLabelListWithGraph stores each distinct label
+//                      only once.
+// 10/16/26  agent      Compressed graph adjacency is built once, after all
+//                      edges are copied
+// 10/16/26  agent      Copy vertex and edge information tables; overlap
+//                      edges keep theirs alongside the edge array
+// 10/17/26  agent      Instance and example marks and the vertex mapping
+//                      kept in the parameters' VisitSets
+// 10/17/26  agent      Example coverage and per-vertex examples from posVertexExamples
+// 10/17/26  agent      Relabeling a graph frees its label index
+// 10/17/26  agent      Relabeled graphs drop their edge type index
+// 10/17/26  agent      InstancesOverlap takes vertex coverage marks
+// 10/17/26  agent      GBAD-P vertex mappings written by WriteAnomFile
+//                      after the final compression
+// 10/17/26  agent      WriteAnomFile only called if writeAnomFiles is set
 //
 //******************************************************************************
 
@@ -51,12 +66,15 @@ Graph *CompressGraph(Graph *graph, InstanceList *instanceList,
    ULONG subLabelIndex;
    ULONG overlapLabelIndex;
    Graph *compressedGraph;
+   VertexInfo *vertexInfo;
    ULONG startVertex = 0;
    ULONG startEdge = 0;
 
    // parameters used
    LabelList *labelList = parameters->labelList;
    BOOLEAN allowInstanceOverlap = parameters->allowInstanceOverlap;
+   VisitSet *vertexVisits = parameters->vertexVisits;
+   VisitSet *edgeVisits = parameters->edgeVisits;
 
    // assign "SUB" and "OVERLAP" labels an index of where they would be
    // in the label list if actually added
@@ -68,6 +86,8 @@ Graph *CompressGraph(Graph *graph, InstanceList *instanceList,
    numInstanceEdges = 0;
    instanceNo = 1;
    instanceListNode = instanceList->head;
+   ClearVisitSet(vertexVisits, graph->numVertices);
+   ClearVisitSet(edgeVisits, graph->numEdges);
 
    // Count number of vertices and edges that will be compressed by instances
    while (instanceListNode != NULL)
@@ -75,21 +95,21 @@ Graph *CompressGraph(Graph *graph, InstanceList *instanceList,
       instance = instanceListNode->instance;
       for (v = 0; v < instance->numVertices; v++)      // add in unique vertices
       {
-         if ((!graph->vertices[instance->vertices[v]].used) &&
+         if ((! VISITED(vertexVisits, instance->vertices[v])) &&
              ((instance->vertices[v] >= startVertex)))
          {
             numInstanceVertices++;
-            graph->vertices[instance->vertices[v]].used = TRUE;
+            VISIT(vertexVisits, instance->vertices[v]);
             // assign vertex to first instance it occurs in
-            graph->vertices[instance->vertices[v]].map = instanceNo - 1;
+            vertexVisits->values[instance->vertices[v]] = instanceNo - 1;
          }
       }
       for (e = 0; e < instance->numEdges; e++) // add in unique edges
-         if ((!graph->edges[instance->edges[e]].used) &&
+         if ((! VISITED(edgeVisits, instance->edges[e])) &&
              ((instance->edges[e] >= startEdge)))
          {
             numInstanceEdges++;
-            graph->edges[instance->edges[e]].used = TRUE;
+            VISIT(edgeVisits, instance->edges[e]);
          }
       instanceNo++;
       instanceListNode = instanceListNode->next;
@@ -100,6 +120,8 @@ Graph *CompressGraph(Graph *graph, InstanceList *instanceList,
    nv = graph->numVertices - numInstanceVertices + numInstances;
    ne = graph->numEdges - numInstanceEdges;
    compressedGraph = AllocateGraph(nv, ne);
+   if (graph->vertexInfo != NULL)
+      AllocateGraphInfo(compressedGraph);
 
    // insert SUB vertices for each instance
    vertexIndex = 0;
@@ -108,10 +130,15 @@ Graph *CompressGraph(Graph *graph, InstanceList *instanceList,
       compressedGraph->vertices[vertexIndex].label = subLabelIndex;
       compressedGraph->vertices[vertexIndex].numEdges = 0;
       compressedGraph->vertices[vertexIndex].edges = NULL;
-      compressedGraph->vertices[vertexIndex].map = VERTEX_UNMAPPED;
-      compressedGraph->vertices[vertexIndex].used = FALSE;
-      compressedGraph->vertices[vertexIndex].originalVertexIndex = -1;
-      compressedGraph->vertices[vertexIndex].color = NO_COLOR;
+      if (compressedGraph->vertexInfo != NULL)
+      {
+         vertexInfo = & compressedGraph->vertexInfo[vertexIndex];
+         vertexInfo->sourceVertex = 0;
+         vertexInfo->sourceExample = 0;
+         vertexInfo->originalVertexIndex = -1;
+         vertexInfo->color = NO_COLOR;
+         vertexInfo->anomalousValue = 2.0;
+      }
       vertexIndex++;
    }
 
@@ -123,16 +150,7 @@ Graph *CompressGraph(Graph *graph, InstanceList *instanceList,
    if (allowInstanceOverlap)
       AddOverlapEdges(compressedGraph, graph, instanceList, overlapLabelIndex,
                       startVertex, startEdge, parameters);
-
-   // reset used flag of instances' vertices and edges
-   instanceListNode = instanceList->head;
-   while (instanceListNode != NULL) 
-   {
-      instance = instanceListNode->instance;
-      MarkInstanceVertices(instance, graph, FALSE);
-      MarkInstanceEdges(instance, graph, FALSE);
-      instanceListNode = instanceListNode->next;
-   }
+   BuildGraphAdjacency(compressedGraph);
 
    return compressedGraph;
 }
@@ -168,11 +186,12 @@ Graph *CompressGraph(Graph *graph, InstanceList *instanceList,
 // the instance list's order.  I.e., the ith instance in the instance
 // list corresponds to compressedGraph->vertices[i-1].
 //
-// 2. All vertices and edges in the instances are marked (used=TRUE)
-// in the graph.  Instance vertices will be unmarked as processed.
+// 2. All vertices and edges in the instances are marked in
+// parameters->vertexVisits and parameters->edgeVisits.  Instance
+// vertices will be unmarked as processed.
 //
 // 3. The vertices in the given graph are all mapped to their appropriate
-// vertices in the compressedGraph.
+// vertices in the compressedGraph by parameters->vertexVisits->values.
 //
 // 4. For external edges pointing to vertices shared by multiple
 // instances, the compressed graph already contains one such edge
@@ -195,13 +214,16 @@ void AddOverlapEdges(Graph *compressedGraph, Graph *graph,
    ULONG e;
    Vertex *vertex1;
    Vertex *vertex2;
-   Edge *edge1;
    Edge *overlapEdges;
+   EdgeInfo *overlapEdgeInfo;
    ULONG numOverlapEdges;
    ULONG totalEdges;
    ULONG edgeIndex;
+   VisitSet *vertexVisits = parameters->vertexVisits;
+   VisitSet *edgeVisits = parameters->edgeVisits;
 
    overlapEdges = NULL;
+   overlapEdgeInfo = NULL;
    numOverlapEdges = 0;
    // for each instance1 in substructure's instance
    instanceListNode1 = instanceList->head;
@@ -213,8 +235,8 @@ void AddOverlapEdges(Graph *compressedGraph, Graph *graph,
       for (v1 = 0; v1 < instance1->numVertices; v1++) 
       {
          vertex1 = &graph->vertices[instance1->vertices[v1]];
-         if (vertex1->used) 
-         {  // (used==TRUE) indicates unchecked for sharing
+         if (VISITED(vertexVisits, instance1->vertices[v1])) 
+         {  // (marked) indicates unchecked for sharing
             // for each instance2 after instance1
             instanceListNode2 = instanceListNode1->next;
             instanceNo2 = instanceNo1 + 1;
@@ -231,20 +253,23 @@ void AddOverlapEdges(Graph *compressedGraph, Graph *graph,
                      // add undirected "OVERLAP" edge between corresponding
                      // "SUB" vertices, if not already there
                      overlapEdges =
-                        AddOverlapEdge(overlapEdges, &numOverlapEdges,
+                        AddOverlapEdge(overlapEdges, & overlapEdgeInfo,
+                                       &numOverlapEdges,
                                        instanceNo1 - 1, instanceNo2 - 1,
                                        overlapLabelIndex, parameters);
                      // for external edges involving vertex1, 
                      // duplicate for vertex2
                      for (e = 0; e < vertex1->numEdges; e++) 
                      {
-                        edge1 = &graph->edges[vertex1->edges[e]];
-                        if ((!edge1->used) &&
+                        if ((! VISITED(edgeVisits, vertex1->edges[e])) &&
                             (vertex1->edges[e] >= startEdge))
                         { // edge external to instance
                            overlapEdges =
-                              AddDuplicateEdges(overlapEdges, &numOverlapEdges,
-                                                edge1, graph, instanceNo1 - 1,
+                              AddDuplicateEdges(overlapEdges,
+                                                & overlapEdgeInfo,
+                                                &numOverlapEdges,
+                                                vertex1->edges[e], graph,
+                                                instanceNo1 - 1,
                                                 instanceNo2 - 1, parameters);
                         }
                      }
@@ -253,7 +278,8 @@ void AddOverlapEdges(Graph *compressedGraph, Graph *graph,
                instanceListNode2 = instanceListNode2->next;
                instanceNo2++;
             }
-            vertex1->used = FALSE; // i.e., done processing vertex1 for overlap
+            // done processing vertex1 for overlap
+            UNVISIT(vertexVisits, instance1->vertices[v1]);
          }
       }
       instanceListNode1 = instanceListNode1->next;
@@ -268,6 +294,13 @@ void AddOverlapEdges(Graph *compressedGraph, Graph *graph,
          (Edge *) realloc(compressedGraph->edges, (totalEdges * sizeof(Edge)));
       if (compressedGraph->edges == NULL)
          OutOfMemoryError("AddOverlapEdges:compressedGraph->edges");
+      if (compressedGraph->edgeInfo != NULL)
+      {
+         compressedGraph->edgeInfo = (EdgeInfo *)
+            realloc(compressedGraph->edgeInfo, (totalEdges * sizeof(EdgeInfo)));
+         if (compressedGraph->edgeInfo == NULL)
+            OutOfMemoryError("AddOverlapEdges:compressedGraph->edgeInfo");
+      }
       edgeIndex = compressedGraph->numEdges;
       for (e = 0; e < numOverlapEdges; e++) 
       {
@@ -277,20 +310,28 @@ void AddOverlapEdges(Graph *compressedGraph, Graph *graph,
                       overlapEdges[e].label, overlapEdges[e].directed,
                       overlapEdges[e].spansIncrement);
          else
-            StoreAnomalousEdge(compressedGraph->edges, edgeIndex,
+            StoreAnomalousEdge(compressedGraph->edges,
+                               compressedGraph->edgeInfo, edgeIndex,
                                overlapEdges[e].vertex1, overlapEdges[e].vertex2,
                                overlapEdges[e].label, overlapEdges[e].directed,
                                overlapEdges[e].spansIncrement,
                                overlapEdges[e].anomalous, 
-			       overlapEdges[e].sourceVertex1,
-			       overlapEdges[e].sourceVertex2,
-			       overlapEdges[e].sourceExample);
-         AddEdgeToVertices(compressedGraph, edgeIndex);
+			       overlapEdgeInfo[e].sourceVertex1,
+			       overlapEdgeInfo[e].sourceVertex2,
+			       overlapEdgeInfo[e].sourceExample);
+         // overlap edges are not in the original graph, so not colored
+         if (compressedGraph->edgeInfo != NULL)
+         {
+            compressedGraph->edgeInfo[edgeIndex].originalEdgeIndex = 0;
+            compressedGraph->edgeInfo[edgeIndex].color = NO_COLOR;
+            compressedGraph->edgeInfo[edgeIndex].anomalousValue = 2.0;
+         }
          edgeIndex++;
       }
       compressedGraph->numEdges += numOverlapEdges;
-      free(overlapEdges);
    }
+   free(overlapEdges);
+   free(overlapEdgeInfo);
 }
 
 
@@ -299,6 +340,8 @@ void AddOverlapEdges(Graph *compressedGraph, Graph *graph,
 //
 // INPUTS: (Edge *overlapEdges) - edge array possibly realloc-ed to store
 //                                edge
+//         (EdgeInfo **overlapEdgeInfo) - pointer to edge information array
+//           kept alongside overlapEdges
 //         (ULONG *numOverlapEdgesPtr) - pointer to variable holding number
 //           of total overlapping edges; this may or may not be incremented
 //           depending on uniqueness of "OVERLAP" edge
@@ -315,7 +358,8 @@ void AddOverlapEdges(Graph *compressedGraph, Graph *graph,
 // numOverlapEdgesPtr.  Assumes sub1VertexIndex < sub2VertexIndex.
 //******************************************************************************
 
-Edge *AddOverlapEdge(Edge *overlapEdges, ULONG *numOverlapEdgesPtr,
+Edge *AddOverlapEdge(Edge *overlapEdges, EdgeInfo **overlapEdgeInfo,
+                     ULONG *numOverlapEdgesPtr,
                      ULONG sub1VertexIndex, ULONG sub2VertexIndex,
                      ULONG overlapLabelIndex, Parameters *parameters)
 {
@@ -331,15 +375,14 @@ Edge *AddOverlapEdge(Edge *overlapEdges, ULONG *numOverlapEdgesPtr,
          found = TRUE;
    if (! found) 
    {
-      overlapEdges = (Edge *) realloc(overlapEdges,
-                                      ((numOverlapEdges + 1) * sizeof(Edge)));
-      if (overlapEdges == NULL)
-         OutOfMemoryError("AddOverlapEdge:overlapEdges");
+      overlapEdges = GrowOverlapEdges(overlapEdges, overlapEdgeInfo,
+                                      numOverlapEdges + 1);
       if (parameters->noAnomalyDetection)
          StoreEdge(overlapEdges, numOverlapEdges, sub1VertexIndex,
                    sub2VertexIndex, overlapLabelIndex, FALSE, FALSE);
       else
-         StoreAnomalousEdge(overlapEdges, numOverlapEdges, sub1VertexIndex,
+         StoreAnomalousEdge(overlapEdges, *overlapEdgeInfo,
+                            numOverlapEdges, sub1VertexIndex,
                             sub2VertexIndex, overlapLabelIndex, FALSE, FALSE,
                             FALSE, 0, 0, 0);
       numOverlapEdges++;
@@ -353,9 +396,11 @@ Edge *AddOverlapEdge(Edge *overlapEdges, ULONG *numOverlapEdgesPtr,
 // NAME: AddDuplicateEdges
 //
 // INPUTS: (Edge *overlapEdges) - edge array realloc-ed to store new edge
+//         (EdgeInfo **overlapEdgeInfo) - pointer to edge information array
+//           kept alongside overlapEdges
 //         (ULONG *numOverlapEdgesPtr) - pointer to variable holding number
 //           of total overlapping edges; will be incremented by 1, 2 or 3
-//         (Edge *edge) - edge to be duplicated
+//         (ULONG edgeIndex) - index of edge to be duplicated
 //         (Graph *graph) - uncompressed graph containing edge
 //         (ULONG sub1VertexIndex) - "SUB" vertex index for first instance
 //         (ULONG sub2VertexIndex) - "SUB" vertex index for second instance
@@ -379,48 +424,62 @@ Edge *AddOverlapEdge(Edge *overlapEdges, ULONG *numOverlapEdgesPtr,
 //              then add duplicate edge from S2 to S1
 //******************************************************************************
 
-Edge *AddDuplicateEdges(Edge *overlapEdges, ULONG *numOverlapEdgesPtr,
-                        Edge *edge, Graph *graph,
+Edge *AddDuplicateEdges(Edge *overlapEdges, EdgeInfo **overlapEdgeInfo,
+                        ULONG *numOverlapEdgesPtr,
+                        ULONG edgeIndex, Graph *graph,
                         ULONG sub1VertexIndex, ULONG sub2VertexIndex,
 			Parameters *parameters)
 {
    ULONG numOverlapEdges;
    ULONG v1, v2;
-
+   Edge *edge;
+   VisitSet *vertexVisits = parameters->vertexVisits;
+   ULONG *vertexMap = vertexVisits->values;
+   ULONG sourceVertex1 = 0;
+   ULONG sourceVertex2 = 0;
+   ULONG sourceExample = 0;
+
+   edge = & graph->edges[edgeIndex];
+   if (graph->edgeInfo != NULL)
+   {
+      sourceVertex1 = graph->edgeInfo[edgeIndex].sourceVertex1;
+      sourceVertex2 = graph->edgeInfo[edgeIndex].sourceVertex2;
+      sourceExample = graph->edgeInfo[edgeIndex].sourceExample;
+   }
    numOverlapEdges = *numOverlapEdgesPtr;
-   overlapEdges = (Edge *) realloc(overlapEdges,
-                                   ((numOverlapEdges + 1) * sizeof(Edge)));
-   if (overlapEdges == NULL)
-      OutOfMemoryError("AddDuplicateEdges:overlapEdges1");
+   overlapEdges = GrowOverlapEdges(overlapEdges, overlapEdgeInfo,
+                                   numOverlapEdges + 1);
 
-   if (graph->vertices[edge->vertex1].map != sub1VertexIndex) 
+   if (vertexMap[edge->vertex1] != sub1VertexIndex) 
    {
       // duplicate edge from external vertex
-      v1 = graph->vertices[edge->vertex1].map;
+      v1 = vertexMap[edge->vertex1];
       v2 = sub2VertexIndex;
       if (parameters->noAnomalyDetection)
          StoreEdge(overlapEdges, numOverlapEdges, v1, v2, edge->label,
                    edge->directed, edge->spansIncrement);
       else
-         StoreAnomalousEdge(overlapEdges, numOverlapEdges, v1, v2, edge->label,
+         StoreAnomalousEdge(overlapEdges, *overlapEdgeInfo,
+                            numOverlapEdges, v1, v2, edge->label,
                             edge->directed, edge->spansIncrement,
-                            edge->anomalous, edge->sourceVertex1,
-			    edge->sourceVertex2, edge->sourceExample);
+                            edge->anomalous, sourceVertex1,
+			    sourceVertex2, sourceExample);
       numOverlapEdges++;
    } 
-   else if (graph->vertices[edge->vertex2].map != sub1VertexIndex) 
+   else if (vertexMap[edge->vertex2] != sub1VertexIndex) 
    {
       // duplicate edge to an external vertex
       v1 = sub2VertexIndex;
-      v2 = graph->vertices[edge->vertex2].map;
+      v2 = vertexMap[edge->vertex2];
       if (parameters->noAnomalyDetection)
          StoreEdge(overlapEdges, numOverlapEdges, v1, v2, edge->label,
                    edge->directed, edge->spansIncrement);
       else
-         StoreAnomalousEdge(overlapEdges, numOverlapEdges, v1, v2, edge->label,
+         StoreAnomalousEdge(overlapEdges, *overlapEdgeInfo,
+                            numOverlapEdges, v1, v2, edge->label,
                             edge->directed, edge->spansIncrement,
-                            edge->anomalous, edge->sourceVertex1,
-			    edge->sourceVertex2, edge->sourceExample);
+                            edge->anomalous, sourceVertex1,
+			    sourceVertex2, sourceExample);
       numOverlapEdges++;
    } 
    else 
@@ -432,63 +491,62 @@ Edge *AddDuplicateEdges(Edge *overlapEdges, ULONG *numOverlapEdgesPtr,
          StoreEdge(overlapEdges, numOverlapEdges, v1, v2, edge->label,
                    edge->directed, edge->spansIncrement);
       else
-         StoreAnomalousEdge(overlapEdges, numOverlapEdges, v1, v2, edge->label,
+         StoreAnomalousEdge(overlapEdges, *overlapEdgeInfo,
+                            numOverlapEdges, v1, v2, edge->label,
                             edge->directed, edge->spansIncrement,
-                            edge->anomalous, edge->sourceVertex1,
-			    edge->sourceVertex2, edge->sourceExample);
+                            edge->anomalous, sourceVertex1,
+			    sourceVertex2, sourceExample);
       numOverlapEdges++;
       // if other vertex unmarked (i.e., overlapping and already processed)
       // then duplicate edge connecting Sub2 to Sub2
-      if ((! graph->vertices[edge->vertex1].used) ||
-          (! graph->vertices[edge->vertex2].used)) 
+      if ((! VISITED(vertexVisits, edge->vertex1)) ||
+          (! VISITED(vertexVisits, edge->vertex2))) 
       {
-         overlapEdges = (Edge *) realloc(overlapEdges,
-                                 ((numOverlapEdges + 1) * sizeof(Edge)));
-         if (overlapEdges == NULL)
-            OutOfMemoryError ("AddDuplicateEdges:overlapEdges2");
+         overlapEdges = GrowOverlapEdges(overlapEdges, overlapEdgeInfo,
+                                         numOverlapEdges + 1);
          if (parameters->noAnomalyDetection)
             StoreEdge(overlapEdges, numOverlapEdges, v2, v2, edge->label,
                       edge->directed, edge->spansIncrement);
          else
-            StoreAnomalousEdge(overlapEdges, numOverlapEdges, v2, v2, edge->label,
+            StoreAnomalousEdge(overlapEdges, *overlapEdgeInfo,
+                               numOverlapEdges, v2, v2, edge->label,
                                edge->directed, edge->spansIncrement,
-                               edge->anomalous, edge->sourceVertex1,
-			       edge->sourceVertex2, edge->sourceExample);
+                               edge->anomalous, sourceVertex1,
+			       sourceVertex2, sourceExample);
          numOverlapEdges++;
       }
       // if edge connects Sub1 to the same vertex in Sub1 (self edge)
       // then add duplicate edge connecting Sub2 to Sub2
       if (edge->vertex1 == edge->vertex2) 
       {
-         overlapEdges = (Edge *) realloc(overlapEdges,
-                               ((numOverlapEdges + 1) * sizeof(Edge)));
-         if (overlapEdges == NULL)
-            OutOfMemoryError("AddDuplicateEdges:overlapEdges3");
+         overlapEdges = GrowOverlapEdges(overlapEdges, overlapEdgeInfo,
+                                         numOverlapEdges + 1);
          if (parameters->noAnomalyDetection)
             StoreEdge(overlapEdges, numOverlapEdges, v2, v2, edge->label,
                       edge->directed, edge->spansIncrement);
          else
-            StoreAnomalousEdge(overlapEdges, numOverlapEdges, v2, v2, edge->label,
+            StoreAnomalousEdge(overlapEdges, *overlapEdgeInfo,
+                               numOverlapEdges, v2, v2, edge->label,
                                edge->directed, edge->spansIncrement,
-                               edge->anomalous, edge->sourceVertex1,
-			       edge->sourceVertex2, edge->sourceExample);
+                               edge->anomalous, sourceVertex1,
+			       sourceVertex2, sourceExample);
          numOverlapEdges++;
          // if edge directed
          // then add duplicate edge from S2 to S1
          if (edge->directed) 
          {
-            overlapEdges = (Edge *) realloc(overlapEdges,
-                                    ((numOverlapEdges + 1) * sizeof(Edge)));
-            if (overlapEdges == NULL)
-               OutOfMemoryError("AddDuplicateEdges:overlapEdges4");
+            overlapEdges = GrowOverlapEdges(overlapEdges, overlapEdgeInfo,
+                                            numOverlapEdges + 1);
             if (parameters->noAnomalyDetection)
                StoreEdge(overlapEdges, numOverlapEdges, v2, v1, edge->label,
                          edge->directed, edge->spansIncrement);
             else
-               StoreAnomalousEdge(overlapEdges, numOverlapEdges, v2, v1, edge->label,
+               StoreAnomalousEdge(overlapEdges,
+                                  *overlapEdgeInfo,
+                                  numOverlapEdges, v2, v1, edge->label,
                                   edge->directed, edge->spansIncrement,
-                                  edge->anomalous, edge->sourceVertex1,
-				  edge->sourceVertex2, edge->sourceExample);
+                                  edge->anomalous, sourceVertex1,
+				  sourceVertex2, sourceExample);
             numOverlapEdges++;
          }
       }
@@ -498,6 +556,35 @@ Edge *AddDuplicateEdges(Edge *overlapEdges, ULONG *numOverlapEdgesPtr,
 }
 
 
+//******************************************************************************
+// NAME: GrowOverlapEdges
+//
+// INPUTS: (Edge *overlapEdges) - edge array to be realloc-ed
+//         (EdgeInfo **overlapEdgeInfo) - pointer to edge information array
+//           kept alongside overlapEdges, also realloc-ed
+//         (ULONG numOverlapEdges) - new number of edges in the arrays
+//
+// RETURN: (Edge *) - realloc-ed edge array
+//
+// PURPOSE: Resize the overlap edge array and its edge information array
+// to hold the given number of edges.
+//******************************************************************************
+
+Edge *GrowOverlapEdges(Edge *overlapEdges, EdgeInfo **overlapEdgeInfo,
+                       ULONG numOverlapEdges)
+{
+   overlapEdges = (Edge *) realloc(overlapEdges,
+                                   (numOverlapEdges * sizeof(Edge)));
+   if (overlapEdges == NULL)
+      OutOfMemoryError("GrowOverlapEdges:overlapEdges");
+   *overlapEdgeInfo = (EdgeInfo *) realloc(*overlapEdgeInfo,
+                                 (numOverlapEdges * sizeof(EdgeInfo)));
+   if (*overlapEdgeInfo == NULL)
+      OutOfMemoryError("GrowOverlapEdges:overlapEdgeInfo");
+   return overlapEdges;
+}
+
+
 //******************************************************************************
 // NAME: WriteCompressedGraphToFile
 //
@@ -537,7 +624,9 @@ void WriteCompressedGraphToFile(Substructure *sub, Parameters *parameters,
    label.labelType = STRING_LABEL;
    label.labelValue.stringLabel = subLabelString;
    StoreLabel(&label, labelList);
-   if (allowInstanceOverlap && InstancesOverlap(sub->instances))
+   if (allowInstanceOverlap &&
+       InstancesOverlap(sub->instances, parameters->coverVisits,
+                        posGraph->numVertices))
    {
       sprintf(overlapLabelString, "%s_%lu", OVERLAP_LABEL_STRING,
               iteration);
@@ -585,6 +674,8 @@ void CompressFinalGraphs(Substructure *sub, Parameters *parameters,
                          ULONG iteration, BOOLEAN predefinedSub)
 {
    Graph *compressedPosGraph;
+   InstanceListNode *instanceListNode;
+   ULONG numInstances;
    char subLabelString[TOKEN_LEN];
    char overlapLabelString[TOKEN_LEN];
    Label label;
@@ -594,6 +685,7 @@ void CompressFinalGraphs(Substructure *sub, Parameters *parameters,
    Graph *posGraph              = parameters->posGraph;
    BOOLEAN allowInstanceOverlap = parameters->allowInstanceOverlap;
    LabelList *labelList         = parameters->labelList;
+   VisitSet *coverVisits        = parameters->coverVisits;
 
    compressedPosGraph = posGraph;
 
@@ -618,7 +710,26 @@ void CompressFinalGraphs(Substructure *sub, Parameters *parameters,
    // DEBUG
 
    if (sub->numInstances > 0)
+   {
       compressedPosGraph = CompressGraph(posGraph, sub->instances, parameters);
+      CompressVertexExamples(sub->instances, posGraph, compressedPosGraph,
+                             parameters);
+      if ((parameters->prob) && (parameters->writeAnomFiles))
+      {
+         // the vertices of each instance, including those AddOverlapEdges
+         // unmarked, are left out after the instances' "SUB" vertices
+         ClearVisitSet(coverVisits, posGraph->numVertices);
+         numInstances = 0;
+         instanceListNode = sub->instances->head;
+         while (instanceListNode != NULL)
+         {
+            MarkInstanceVertices(instanceListNode->instance, coverVisits);
+            numInstances++;
+            instanceListNode = instanceListNode->next;
+         }
+         WriteAnomFile(posGraph, coverVisits, numInstances, parameters);
+      }
+   }
 
    // add "SUB" and "OVERLAP" (if used) labels to label list
    if (predefinedSub)
@@ -630,7 +741,9 @@ void CompressFinalGraphs(Substructure *sub, Parameters *parameters,
    label.labelType = STRING_LABEL;
    label.labelValue.stringLabel = subLabelString;
    StoreLabel(& label, labelList);
-   if (allowInstanceOverlap && InstancesOverlap(sub->instances))
+   if (allowInstanceOverlap &&
+       InstancesOverlap(sub->instances, parameters->coverVisits,
+                        posGraph->numVertices))
    {
       if (predefinedSub)
          sprintf(overlapLabelString, "%s_%s_%lu", PREDEFINED_PREFIX,
@@ -676,6 +789,59 @@ void CompressFinalGraphs(Substructure *sub, Parameters *parameters,
 }
 
 
+//******************************************************************************
+// NAME: CompressVertexExamples
+//
+// INPUTS: (InstanceList *instanceList) - instances the graph was
+//                                        compressed with
+//         (Graph *graph) - positive graph before compression
+//         (Graph *compressedGraph) - graph returned by CompressGraph
+//         (Parameters *parameters)
+//
+// RETURN: (void)
+//
+// PURPOSE: Carry parameters->posVertexExamples over to the compressed
+// positive graph.  Each "SUB" vertex is in the example of its instance,
+// and every other vertex in the example it was in before compression.
+// Relies on parameters->vertexVisits->values still mapping the vertices
+// of graph to those of compressedGraph, as CompressGraph leaves it.
+//******************************************************************************
+
+void CompressVertexExamples(InstanceList *instanceList, Graph *graph,
+                            Graph *compressedGraph, Parameters *parameters)
+{
+   ULONG *newVertexExamples;
+   InstanceListNode *instanceListNode;
+   ULONG v;
+
+   // parameters used
+   ULONG *posVertexExamples = parameters->posVertexExamples;
+   VisitSet *vertexVisits   = parameters->vertexVisits;
+
+   if (posVertexExamples == NULL)
+      return;
+
+   newVertexExamples = (ULONG *) malloc(sizeof(ULONG) *
+                                        (compressedGraph->numVertices + 1));
+   if (newVertexExamples == NULL)
+      OutOfMemoryError("CompressVertexExamples:newVertexExamples");
+   for (v = 0; v < graph->numVertices; v++)
+      newVertexExamples[vertexVisits->values[v]] = posVertexExamples[v];
+   // "SUB" vertices come first, in instance list order
+   v = 0;
+   instanceListNode = instanceList->head;
+   while (instanceListNode != NULL)
+   {
+      newVertexExamples[v] =
+         posVertexExamples[instanceListNode->instance->vertices[0]];
+      v++;
+      instanceListNode = instanceListNode->next;
+   }
+   free(posVertexExamples);
+   parameters->posVertexExamples = newVertexExamples;
+}
+
+
 //******************************************************************************
 // NAME: CompressLabelListWithGraph
 //
@@ -687,27 +853,50 @@ void CompressFinalGraphs(Substructure *sub, Parameters *parameters,
 //
 // PURPOSE: Adds to newLabelList only the labels present in the given
 // graph.  The graph's labels are replaced with indices to the new
-// label list.
+// label list.  The new index of each old label is remembered, so each
+// distinct label is stored (and hashed) only once.
 //******************************************************************************
 
 void CompressLabelListWithGraph(LabelList *newLabelList, Graph *graph,
                                 Parameters *parameters)
 {
    ULONG v, e;
+   ULONG i;
+   ULONG *newLabelIndex;
+   ULONG label;
 
    // parameters used
    LabelList *labelList = parameters->labelList;
 
+   newLabelIndex = (ULONG *) malloc(sizeof(ULONG) * (labelList->numLabels + 1));
+   if (newLabelIndex == NULL)
+      OutOfMemoryError("CompressLabelListWithGraph:newLabelIndex");
+   for (i = 0; i < labelList->numLabels; i++)
+      newLabelIndex[i] = MAX_UNSIGNED_LONG;
+
    // add graph's vertex labels to new label list
    for (v = 0; v < graph->numVertices; v++)
-      graph->vertices[v].label =
-         StoreLabel(& labelList->labels[graph->vertices[v].label],
-                    newLabelList);
+   {
+      label = graph->vertices[v].label;
+      if (newLabelIndex[label] == MAX_UNSIGNED_LONG)
+         newLabelIndex[label] = StoreLabel(& labelList->labels[label],
+                                           newLabelList);
+      graph->vertices[v].label = newLabelIndex[label];
+   }
+   FreeGraphLabelIndex(graph); // vertex labels changed
 
    // add graph's edge labels to new label list
    for (e = 0; e < graph->numEdges; e++)
-      graph->edges[e].label =
-           StoreLabel(& labelList->labels[graph->edges[e].label], newLabelList);
+   {
+      label = graph->edges[e].label;
+      if (newLabelIndex[label] == MAX_UNSIGNED_LONG)
+         newLabelIndex[label] = StoreLabel(& labelList->labels[label],
+                                           newLabelList);
+      graph->edges[e].label = newLabelIndex[label];
+   }
+   FreeGraphEdgeIndex(graph); // vertex and edge labels changed
+
+   free(newLabelIndex);
 }
 
 
@@ -739,6 +928,8 @@ ULONG SizeOfCompressedGraph(Graph *graph, InstanceList *instanceList,
    Instance *instance;
    ULONG v, e;
    BOOLEAN allowInstanceOverlap = parameters->allowInstanceOverlap;
+   VisitSet *vertexVisits = parameters->vertexVisits;
+   VisitSet *edgeVisits = parameters->edgeVisits;
 
    size = GraphSize(graph);
 
@@ -747,37 +938,34 @@ ULONG SizeOfCompressedGraph(Graph *graph, InstanceList *instanceList,
       instanceListNode = instanceList->head;
       if (allowInstanceOverlap) 
       {
-         // reduce size by amount of unique structure, which is marked
+         // reduce size by amount of unique structure, which is marked;
+         // the graph is not compressed, so instance vertices are left
+         // unmapped
+         ClearVisitSet(vertexVisits, graph->numVertices);
+         ClearVisitSet(edgeVisits, graph->numEdges);
          while (instanceListNode != NULL) 
          {
             size++; // new "SUB" vertex of instance
             instance = instanceListNode->instance;
             // subtract unique vertices
             for (v = 0; v < instance->numVertices; v++)
-               if (!graph->vertices[instance->vertices[v]].used) 
+               if (! VISITED(vertexVisits, instance->vertices[v])) 
                {
                   size--;
-                  graph->vertices[instance->vertices[v]].used = TRUE;
+                  VISIT(vertexVisits, instance->vertices[v]);
+                  vertexVisits->values[instance->vertices[v]] =
+                     VERTEX_UNMAPPED;
                }
             for (e = 0; e < instance->numEdges; e++)   // subtract unique edges
-               if (!graph->edges[instance->edges[e]].used) 
+               if (! VISITED(edgeVisits, instance->edges[e])) 
                {
                   size--;
-                  graph->edges[instance->edges[e]].used = TRUE;
+                  VISIT(edgeVisits, instance->edges[e]);
                }
             instanceListNode = instanceListNode->next;
          }
          // increase size by number of overlap edges (assumes marked instances)
          size += NumOverlapEdges(graph, instanceList, parameters);
-         // reset used flag of instances' vertices and edges
-         instanceListNode = instanceList->head;
-         while (instanceListNode != NULL) 
-         {
-            instance = instanceListNode->instance;
-            MarkInstanceVertices(instance, graph, FALSE);
-            MarkInstanceEdges(instance, graph, FALSE);
-            instanceListNode = instanceListNode->next;
-         }
       }
       else
       {
@@ -812,8 +1000,8 @@ ULONG SizeOfCompressedGraph(Graph *graph, InstanceList *instanceList,
 // are added to all instances sharing the vertex.
 //
 // This procedure assumes all vertices and edges in the instances are
-// marked (used=TRUE) in the graph.  Instance vertices will be
-// unmarked as processed.
+// marked in parameters->vertexVisits and parameters->edgeVisits.
+// Instance vertices will be unmarked as processed.
 //******************************************************************************
 
 ULONG NumOverlapEdges(Graph *graph, InstanceList *instanceList, 
@@ -830,13 +1018,16 @@ ULONG NumOverlapEdges(Graph *graph, InstanceList *instanceList,
    ULONG e;
    Vertex *vertex1;
    Vertex *vertex2;
-   Edge *edge1;
    Edge *overlapEdges;
+   EdgeInfo *overlapEdgeInfo;
    ULONG numOverlapEdges;
    ULONG overlapLabelIndex;
+   VisitSet *vertexVisits = parameters->vertexVisits;
+   VisitSet *edgeVisits = parameters->edgeVisits;
 
    overlapLabelIndex = 0; // bogus value never used since graph not compressed
    overlapEdges = NULL;
+   overlapEdgeInfo = NULL;
    numOverlapEdges = 0;
    // for each instance1 in substructure's instance
    instanceListNode1 = instanceList->head;
@@ -848,8 +1039,8 @@ ULONG NumOverlapEdges(Graph *graph, InstanceList *instanceList,
       for (v1 = 0; v1 < instance1->numVertices; v1++) 
       {
          vertex1 = & graph->vertices[instance1->vertices[v1]];
-         if (vertex1->used) 
-         { // (used==TRUE) indicates unchecked for sharing
+         if (VISITED(vertexVisits, instance1->vertices[v1])) 
+         { // (marked) indicates unchecked for sharing
             // for each instance2 after instance1
             instanceListNode2 = instanceListNode1->next;
             instanceNo2 = instanceNo1 + 1;
@@ -865,19 +1056,21 @@ ULONG NumOverlapEdges(Graph *graph, InstanceList *instanceList,
                      // add undirected "OVERLAP" edge between corresponding
                      // "SUB" vertices, if not already there
                      overlapEdges =
-                        AddOverlapEdge(overlapEdges, & numOverlapEdges,
+                        AddOverlapEdge(overlapEdges, & overlapEdgeInfo,
+                                       & numOverlapEdges,
                                        instanceNo1 - 1, instanceNo2 - 1,
                                        overlapLabelIndex, parameters);
                      // for external edges involving vertex1, 
                      // duplicate for vertex2
                      for (e = 0; e < vertex1->numEdges; e++) 
                      {
-                        edge1 = & graph->edges[vertex1->edges[e]];
-                        if (! edge1->used) 
+                        if (! VISITED(edgeVisits, vertex1->edges[e])) 
                         { // edge external to instance
                            overlapEdges =
-                              AddDuplicateEdges(overlapEdges, & numOverlapEdges,
-                                                edge1, graph,
+                              AddDuplicateEdges(overlapEdges,
+                                                & overlapEdgeInfo,
+                                                & numOverlapEdges,
+                                                vertex1->edges[e], graph,
                                                 instanceNo1 - 1, instanceNo2 - 1,
 						parameters);
                         }
@@ -887,13 +1080,15 @@ ULONG NumOverlapEdges(Graph *graph, InstanceList *instanceList,
                instanceListNode2 = instanceListNode2->next;
                instanceNo2++;
             }
-            vertex1->used = FALSE; // i.e., done processing vertex1 for overlap
+            // done processing vertex1 for overlap
+            UNVISIT(vertexVisits, instance1->vertices[v1]);
          }
       }
       instanceListNode1 = instanceListNode1->next;
       instanceNo1++;
    }
    free (overlapEdges);
+   free (overlapEdgeInfo);
    return numOverlapEdges;
 }
 
@@ -915,13 +1110,9 @@ ULONG NumOverlapEdges(Graph *graph, InstanceList *instanceList,
 
 void RemovePosEgsCovered(Substructure *sub, Parameters *parameters)
 {
-   InstanceList *instanceList;
-   InstanceListNode *instanceListNode;
    ULONG posEg;
    ULONG posEgStartVertexIndex;
    ULONG posEgEndVertexIndex;
-   ULONG instanceVertexIndex;
-   BOOLEAN found;
    ULONG e;
    Graph *newPosGraph;
    ULONG newNumPosEgs;
@@ -935,6 +1126,9 @@ void RemovePosEgsCovered(Substructure *sub, Parameters *parameters)
    Graph *posGraph            = parameters->posGraph;
    ULONG numPosEgs            = parameters->numPosEgs;
    ULONG *posEgsVertexIndices = parameters->posEgsVertexIndices;
+   VisitSet *vertexVisits     = parameters->vertexVisits;
+   VisitSet *edgeVisits       = parameters->edgeVisits;
+   VisitSet *exampleVisits    = parameters->exampleVisits;
  
    // if no instances, then no changes to positive graph
    if (sub->instances == NULL)
@@ -944,8 +1138,12 @@ void RemovePosEgsCovered(Substructure *sub, Parameters *parameters)
    newNumVertices = 0;
    newNumEdges = 0;
    newPosEgsVertexIndices = NULL;
-   instanceList = sub->instances;
-   // for each example, look for a covering instance
+   ClearVisitSet(vertexVisits, posGraph->numVertices);
+   ClearVisitSet(edgeVisits, posGraph->numEdges);
+   // mark the examples holding an instance
+   ExamplesCovered(sub->instances, numPosEgs, parameters->posVertexExamples,
+                   exampleVisits);
+   // for each example, remove it if covered
    for (posEg = 0; posEg < numPosEgs; posEg++) 
    {
       // find example's starting and ending vertex indices
@@ -954,27 +1152,12 @@ void RemovePosEgsCovered(Substructure *sub, Parameters *parameters)
          posEgEndVertexIndex = posEgsVertexIndices[posEg + 1] - 1;
       else 
          posEgEndVertexIndex = posGraph->numVertices - 1;
-      // look for an instance whose vertices are in range
-      instanceListNode = instanceList->head;
-      found = FALSE;
-      while ((instanceListNode != NULL) && (! found)) 
+      if (VISITED(exampleVisits, posEg))
       {
-         // can check any instance vertex, so use the first
-         instanceVertexIndex = instanceListNode->instance->vertices[0];
-         if ((instanceVertexIndex >= posEgStartVertexIndex) &&
-             (instanceVertexIndex <= posEgEndVertexIndex)) 
-         {
-            // found an instance covering this example
-            found = TRUE;
-         }
-         instanceListNode = instanceListNode->next;
-      }
-      if (found) 
-      {
-         // mark vertices and edges of example (note: these will not be
-         // unmarked, because this posGraph will soon be de-allocated)
+         // mark vertices and edges of example, which are left out of
+         // the new positive graph
          MarkExample(posEgStartVertexIndex, posEgEndVertexIndex,
-                     posGraph, TRUE);
+                     posGraph, vertexVisits, edgeVisits);
       } 
       else 
       {
@@ -987,12 +1170,17 @@ void RemovePosEgsCovered(Substructure *sub, Parameters *parameters)
    }
    // count number of edges in examples left uncovered
    for (e = 0; e < posGraph->numEdges; e++)
-      if (! posGraph->edges[e].used)
+      if (! VISITED(edgeVisits, e))
          newNumEdges++;
 
    // create new positive graph and copy unmarked part of old
    newPosGraph = AllocateGraph(newNumVertices, newNumEdges);
+   if (posGraph->vertexInfo != NULL)
+      AllocateGraphInfo(newPosGraph);
    CopyUnmarkedGraph(posGraph, newPosGraph, 0, parameters);
+   BuildGraphAdjacency(newPosGraph);
+   if ((parameters->prob) && (parameters->writeAnomFiles))
+      WriteAnomFile(posGraph, vertexVisits, 0, parameters);
 
    // compress label list and recompute graphs' labels
    newLabelList = AllocateLabelList();
@@ -1006,6 +1194,7 @@ void RemovePosEgsCovered(Substructure *sub, Parameters *parameters)
    free(parameters->posEgsVertexIndices);
    parameters->posEgsVertexIndices = newPosEgsVertexIndices;
    parameters->numPosEgs = newNumPosEgs;
+   SetPosVertexExamples(parameters);
    if (parameters->evalMethod == EVAL_MDL)
       parameters->posGraphDL = MDL(newPosGraph, newLabelList->numLabels,
                                    parameters);
@@ -1027,25 +1216,28 @@ void RemovePosEgsCovered(Substructure *sub, Parameters *parameters)
 
 void MarkPosEgsCovered(Substructure *sub, Parameters *parameters)
 {
-   InstanceList *instanceList;
-   InstanceListNode *instanceListNode;
    ULONG posEg;
    ULONG posEgStartVertexIndex;
    ULONG posEgEndVertexIndex;
-   ULONG instanceVertexIndex;
-   BOOLEAN found;
 
    // parameters used
    Graph *posGraph            = parameters->posGraph;
    ULONG numPosEgs            = parameters->numPosEgs;
    ULONG *posEgsVertexIndices = parameters->posEgsVertexIndices;
+   VisitSet *vertexVisits     = parameters->vertexVisits;
+   VisitSet *edgeVisits       = parameters->edgeVisits;
+   VisitSet *exampleVisits    = parameters->exampleVisits;
  
    // if no instances, then no changes to positive graph
    if (sub->instances == NULL)
       return;
 
-   instanceList = sub->instances;
-   // for each example, look for a covering instance
+   ClearVisitSet(vertexVisits, posGraph->numVertices);
+   ClearVisitSet(edgeVisits, posGraph->numEdges);
+   // mark the examples holding an instance
+   ExamplesCovered(sub->instances, numPosEgs, parameters->posVertexExamples,
+                   exampleVisits);
+   // for each example, remove it if covered
    for (posEg = 0; posEg < numPosEgs; posEg++) 
    {
       // find example's starting and ending vertex indices
@@ -1054,27 +1246,12 @@ void MarkPosEgsCovered(Substructure *sub, Parameters *parameters)
          posEgEndVertexIndex = posEgsVertexIndices[posEg + 1] - 1;
       else 
          posEgEndVertexIndex = posGraph->numVertices - 1;
-      // look for an instance whose vertices are in range
-      instanceListNode = instanceList->head;
-      found = FALSE;
-      while ((instanceListNode != NULL) && (! found)) 
+      if (VISITED(exampleVisits, posEg))
       {
-         // can check any instance vertex, so use the first
-         instanceVertexIndex = instanceListNode->instance->vertices[0];
-         if ((instanceVertexIndex >= posEgStartVertexIndex) &&
-             (instanceVertexIndex <= posEgEndVertexIndex)) 
-         {
-            // found an instance covering this example
-            found = TRUE;
-         }
-         instanceListNode = instanceListNode->next;
-      }
-      if (found) 
-      {
-         // mark vertices and edges of example (note: these will not be
-         // unmarked, because this posGraph will soon be de-allocated)
+         // mark vertices and edges of example (note: these are left
+         // marked until the visit sets are next cleared)
          MarkExample(posEgStartVertexIndex, posEgEndVertexIndex,
-                     posGraph, TRUE);
+                     posGraph, vertexVisits, edgeVisits);
       } 
    }
 }
@@ -1132,16 +1309,17 @@ void WriteUpdatedGraphToFile(Substructure *sub, Parameters *parameters)
 // INPUTS: (ULONG egStartVertexIndex) - starting vertex of example
 //         (ULONG egEndVertexIndex) - ending vertex of example
 //         (Graph *graph) - graph containing example
-//         (BOOLEAN value) - value for used flag of example vertices/edges
+//         (VisitSet *vertexVisits) - marks on vertices of graph
+//         (VisitSet *edgeVisits) - marks on edges of graph
 //
 // RETURN: (void)
 //
-// PURPOSE: Sets the used flag to value for all vertices and edges
-// comprising the example whose range of vertices is given.
+// PURPOSE: Marks all vertices and edges comprising the example whose
+// range of vertices is given.
 //******************************************************************************
 
 void MarkExample(ULONG egStartVertexIndex, ULONG egEndVertexIndex,
-                 Graph *graph, BOOLEAN value)
+                 Graph *graph, VisitSet *vertexVisits, VisitSet *edgeVisits)
 {
    ULONG v;
    ULONG e;
@@ -1150,9 +1328,9 @@ void MarkExample(ULONG egStartVertexIndex, ULONG egEndVertexIndex,
    for (v = egStartVertexIndex; v <= egEndVertexIndex; v++) 
    {
       vertex = & graph->vertices[v];
-      vertex->used = value;
+      VISIT(vertexVisits, v);
       for (e = 0; e < vertex->numEdges; e++)
-         graph->edges[vertex->edges[e]].used = value;
+         VISIT(edgeVisits, vertex->edges[e]);
    }
 }
 
@@ -1168,9 +1346,12 @@ void MarkExample(ULONG egStartVertexIndex, ULONG egEndVertexIndex,
 //
 // RETURN: (void)
 //
-// PURPOSE: Copy unused vertices and edges from g1 to g2, starting at
+// PURPOSE: Copy vertices and edges of g1 not marked in
+// parameters->vertexVisits and parameters->edgeVisits to g2, starting at
 // vertexIndex of g2's vertex array.  Ensures that copied edges map to
-// correct vertices in g2.
+// correct vertices in g2, recording the mapping of each copied vertex in
+// parameters->vertexVisits->values.  The vertices' edge arrays are left to the
+// caller's BuildGraphAdjacency, once all edges of g2 are in place.
 //******************************************************************************
 
 void CopyUnmarkedGraph(Graph *g1, Graph *g2, ULONG vertexIndex,
@@ -1179,76 +1360,87 @@ void CopyUnmarkedGraph(Graph *g1, Graph *g2, ULONG vertexIndex,
    ULONG v, e;
    ULONG v1, v2;
    ULONG edgeIndex;
-   char outFileName[FILE_NAME_LEN];
-   FILE *outputFile = NULL;
+   VisitSet *vertexVisits = parameters->vertexVisits;
+   VisitSet *edgeVisits = parameters->edgeVisits;
 
-   if (parameters->prob)
-   {
-      // write this mapping to the appropriate file
-      strcpy(outFileName,parameters->inputFileName);
-      sprintf(outFileName,"%s.anom%lu",outFileName,
-              parameters->currentIteration);
-      if (!(outputFile = fopen(outFileName, "w")))
-      {
-         printf("ERROR (CompressGraph):  Unable to create/open file %s\n",outFileName);
-         exit(1);
-      }
-   }
-   //
    // copy unused vertices from g1 to g2
    for (v = 0; v < g1->numVertices; v++)
-      if (! g1->vertices[v].used) 
+      if (! VISITED(vertexVisits, v)) 
       {
          g2->vertices[vertexIndex].label = g1->vertices[v].label;
          g2->vertices[vertexIndex].numEdges = 0;
          g2->vertices[vertexIndex].edges = NULL;
-         g2->vertices[vertexIndex].map = VERTEX_UNMAPPED;
-         g2->vertices[vertexIndex].used = FALSE;
-         if (parameters->prob)
-            fprintf(outputFile,"%lu -> %lu\n",v+1,vertexIndex+1);
          g2->vertices[vertexIndex].anomalous = g1->vertices[v].anomalous;
-         g2->vertices[vertexIndex].sourceVertex = 
-            g1->vertices[v].sourceVertex;
-         g2->vertices[vertexIndex].sourceExample = 
-            g1->vertices[v].sourceExample;
-         g1->vertices[v].map = vertexIndex;
-         g2->vertices[vertexIndex].originalVertexIndex = g1->vertices[v].originalVertexIndex;
-         g2->vertices[vertexIndex].color = g1->vertices[v].color;
+         // source information and GUI coloring
+         if (g2->vertexInfo != NULL)
+            g2->vertexInfo[vertexIndex] = g1->vertexInfo[v];
+         vertexVisits->values[v] = vertexIndex;
          vertexIndex++;
       }
-   if (parameters->prob)
-      fclose(outputFile);
 
    // copy unused edges from g1 to g2
    edgeIndex = 0;
    for (e = 0; e < g1->numEdges; e++)
-      if (! g1->edges[e].used) 
+      if (! VISITED(edgeVisits, e)) 
       {
-         v1 = g1->vertices[g1->edges[e].vertex1].map;
-         v2 = g1->vertices[g1->edges[e].vertex2].map;
-         if (parameters->noAnomalyDetection)
-            StoreEdge(g2->edges, edgeIndex, v1, v2, g1->edges[e].label,
-                      g1->edges[e].directed, g1->edges[e].spansIncrement);
-         else
-            StoreAnomalousEdge(g2->edges, edgeIndex, v1, v2,
-                               g1->edges[e].label,
-                               g1->edges[e].directed,
-                               g1->edges[e].spansIncrement,
-                               g1->edges[e].anomalous,
-                               g1->edges[e].sourceVertex1,
-                               g1->edges[e].sourceVertex2,
-                               g1->edges[e].sourceExample);
-         AddEdgeToVertices(g2, edgeIndex);
+         v1 = vertexVisits->values[g1->edges[e].vertex1];
+         v2 = vertexVisits->values[g1->edges[e].vertex2];
+         StoreEdge(g2->edges, edgeIndex, v1, v2, g1->edges[e].label,
+                   g1->edges[e].directed, g1->edges[e].spansIncrement);
+         if (! parameters->noAnomalyDetection)
+            g2->edges[edgeIndex].anomalous = g1->edges[e].anomalous;
          
-         // GUI coloring
-         g2->edges[edgeIndex].originalEdgeIndex = g1->edges[e].originalEdgeIndex;
-         g2->edges[edgeIndex].color = g1->edges[e].color;
+         // source information and GUI coloring
+         if (g2->edgeInfo != NULL)
+            g2->edgeInfo[edgeIndex] = g1->edgeInfo[e];
          
          edgeIndex++;
       }
 }
 
 
+//******************************************************************************
+// NAME: WriteAnomFile
+//
+// INPUTS: (Graph *graph) - graph being compressed
+//         (VisitSet *vertexVisits) - marks on vertices of graph left out
+//           of the compressed graph
+//         (ULONG vertexIndex) - index into the compressed graph's vertex
+//           array of the first vertex copied from graph
+//         (Parameters *parameters)
+//
+// RETURN: (void)
+//
+// PURPOSE: GBAD-P: Writes the mapping of the unmarked vertices of graph to
+// their vertices in the compressed graph, in the order CopyUnmarkedGraph
+// copies them, to the file <inputFileName>.anom<currentIteration>.  Only
+// called from the main thread, once the graph is compressed for good.
+//******************************************************************************
+
+void WriteAnomFile(Graph *graph, VisitSet *vertexVisits, ULONG vertexIndex,
+                   Parameters *parameters)
+{
+   ULONG v;
+   char outFileName[FILE_NAME_LEN];
+   FILE *outputFile;
+
+   sprintf(outFileName, "%s.anom%lu", parameters->inputFileName,
+           parameters->currentIteration);
+   if (!(outputFile = fopen(outFileName, "w")))
+   {
+      printf("ERROR (CompressGraph):  Unable to create/open file %s\n",outFileName);
+      exit(1);
+   }
+   for (v = 0; v < graph->numVertices; v++)
+      if (! VISITED(vertexVisits, v))
+      {
+         fprintf(outputFile,"%lu -> %lu\n",v+1,vertexIndex+1);
+         vertexIndex++;
+      }
+   fclose(outputFile);
+}
+
+
 //******************************************************************************
 // NAME: CompressWithPredefinedSubs
 //
@@ -9,6 +9,13 @@
 // 12/17/09  Graves     Added GUI coloring support
 // 11/13/12  Eberle     Changed logic in DiscoverSubs to ignore single-instance
 //                      substructures
+// 10/16/26  agent      Added -threads option to extend and evaluate parent
+//                      substructures in parallel
+// 10/16/26  agent      Cache positive graph's MDL statistics during discovery
+// 10/17/26  agent      Discovery threads share the positive graph and keep
+//                      private VisitSets
+// 10/17/26  agent      GetInitialSubs collects instances from the graph label index
+// 10/17/26  agent      Worker threads get their own vertex coverage marks
 //
 //******************************************************************************
 
@@ -57,17 +64,17 @@ void color_subs(Parameters *parameters, SubList *discoveredSubList)
             Instance *instance = instanceListNode->instance;
             for (index=0; index < instance->numVertices; index++)
             {
-               originalIndex = parameters->posGraph->vertices[instance->vertices[index]].originalVertexIndex;
-               if ((parameters->posGraph->vertices[instance->vertices[index]].color != NO_COLOR) && 
-                   (parameters->originalPosGraph->vertices[originalIndex].color == VERTEX_DEFAULT))
-                  parameters->originalPosGraph->vertices[originalIndex].color = posVertexColor;
+               originalIndex = parameters->posGraph->vertexInfo[instance->vertices[index]].originalVertexIndex;
+               if ((parameters->posGraph->vertexInfo[instance->vertices[index]].color != NO_COLOR) && 
+                   (parameters->originalPosGraph->vertexInfo[originalIndex].color == VERTEX_DEFAULT))
+                  parameters->originalPosGraph->vertexInfo[originalIndex].color = posVertexColor;
             }
             for (index=0; index < instance->numEdges; index++)
             {
-               originalIndex = parameters->posGraph->edges[instance->edges[index]].originalEdgeIndex;
-               if ((parameters->posGraph->edges[instance->edges[index]].color != NO_COLOR) && 
-                   (parameters->originalPosGraph->edges[originalIndex].color == EDGE_DEFAULT))
-                  parameters->originalPosGraph->edges[originalIndex].color = posEdgeColor;
+               originalIndex = parameters->posGraph->edgeInfo[instance->edges[index]].originalEdgeIndex;
+               if ((parameters->posGraph->edgeInfo[instance->edges[index]].color != NO_COLOR) && 
+                   (parameters->originalPosGraph->edgeInfo[originalIndex].color == EDGE_DEFAULT))
+                  parameters->originalPosGraph->edgeInfo[originalIndex].color = posEdgeColor;
             }
             instanceListNode = instanceListNode->next;
          }
@@ -103,6 +110,15 @@ SubList *DiscoverSubs(Parameters *parameters, ULONG currentIteration)
    SubListNode *extendedSubListNode;
    Substructure *parentSub;
    Substructure *extendedSub;
+   SubList **extendedSubLists = NULL;
+   DiscoverThreads *threads = NULL;
+   ULONG parentIndex;
+
+   // cache posGraph's MDL terms for evaluating substructures; GBAD-P
+   // relies on CompressGraph's vertex mapping files, so it compresses
+   if ((parameters->evalMethod == EVAL_MDL) && (! parameters->prob))
+      parameters->posGraphStats =
+         AllocateMDLGraphStats(parameters->posGraph, parameters->vertexVisits);
 
    //
    // get initial one-vertex substructures
@@ -119,12 +135,20 @@ SubList *DiscoverSubs(Parameters *parameters, ULONG currentIteration)
    ULONG maxVertices    = parameters->maxVertices;
    ULONG minVertices    = parameters->minVertices;
    ULONG outputLevel    = parameters->outputLevel;
-   ULONG evalMethod     = parameters->evalMethod;
+   ULONG numThreads     = parameters->numThreads;
 
+   if (numThreads > 1)
+      threads = AllocateDiscoverThreads(parameters);
    discoveredSubList = AllocateSubList();
    while ((limit > 0) && (parentSubList->head != NULL)) 
    {
+      // with multiple threads, all extensions at this level are
+      // computed first; they are then consumed below in list order
+      if (numThreads > 1)
+         extendedSubLists = ExtendSubsInParallel(parentSubList, limit,
+                                                 threads);
       parentSubListNode = parentSubList->head;
+      parentIndex = 0;
       childSubList = AllocateSubList();
       // extend each substructure in parent list
       while (parentSubListNode != NULL)
@@ -139,17 +163,16 @@ SubList *DiscoverSubs(Parameters *parameters, ULONG currentIteration)
             printf("\n");
             parameters->outputLevel = outputLevel;
          }
-         if ((((parentSub->numInstances > 1) && (evalMethod != EVAL_SETCOVER) &&
-               (parameters->noAnomalyDetection)) ||
-              ((parentSub->numInstances > 1) &&
-               (!parameters->noAnomalyDetection))) &&
-             (limit > 0))
+         if (SubToBeExtended(parentSub, parameters) && (limit > 0))
          {
             limit--;
             if (outputLevel > 3)
                printf("%lu substructures left to be considered\n", limit);
             fflush(stdout);
-            extendedSubList = ExtendSub(parentSub, parameters);
+            if (numThreads > 1)
+               extendedSubList = extendedSubLists[parentIndex];
+            else
+               extendedSubList = ExtendSub(parentSub, parameters);
             //
             // If this is the first iteration, call SetExampleNumber
             // so that the edges in each of the possible instances
@@ -167,7 +190,9 @@ SubList *DiscoverSubs(Parameters *parameters, ULONG currentIteration)
                if (extendedSub->definition->numVertices <= maxVertices) 
                {
                   // evaluate each extension and add to child list
-                  EvaluateSub(extendedSub, parameters);
+                  // (already evaluated by ExtendSubsInParallel if threaded)
+                  if (numThreads <= 1)
+                     EvaluateSub(extendedSub, parameters);
                   if (prune && (extendedSub->value < parentSub->value)) 
                   {
                      FreeSub(extendedSub);
@@ -215,7 +240,10 @@ SubList *DiscoverSubs(Parameters *parameters, ULONG currentIteration)
             FreeSub (parentSub);
          }
          parentSubListNode = parentSubListNode->next;
+         parentIndex++;
       }
+      free(extendedSubLists);
+      extendedSubLists = NULL;
       FreeSubList(parentSubList);
       parentSubList = childSubList;
       //
@@ -255,6 +283,10 @@ SubList *DiscoverSubs(Parameters *parameters, ULONG currentIteration)
       parentSubListNode = parentSubListNode->next;
    }
    FreeSubList(parentSubList);
+   if (threads != NULL)
+      FreeDiscoverThreads(threads);
+   FreeMDLGraphStats(parameters->posGraphStats);
+   parameters->posGraphStats = NULL;
    
    // GUI coloring
    color_subs(parameters, discoveredSubList);
@@ -263,6 +295,239 @@ SubList *DiscoverSubs(Parameters *parameters, ULONG currentIteration)
 }
 
 
+//******************************************************************************
+// NAME: SubToBeExtended
+//
+// INPUTS: (Substructure *sub) - parent substructure
+//         (Parameters *parameters)
+//
+// RETURN: (BOOLEAN) - TRUE if sub should be extended
+//
+// PURPOSE: Single-instance substructures are never extended, nor are
+// any substructures under the set-cover evaluation when not looking
+// for anomalies.  The caller also checks the remaining limit.
+//******************************************************************************
+
+BOOLEAN SubToBeExtended(Substructure *sub, Parameters *parameters)
+{
+   return (((sub->numInstances > 1) &&
+            (parameters->evalMethod != EVAL_SETCOVER) &&
+            (parameters->noAnomalyDetection)) ||
+           ((sub->numInstances > 1) && (! parameters->noAnomalyDetection)));
+}
+
+
+//******************************************************************************
+// NAME: AllocateDiscoverThreads
+//
+// INPUTS: (Parameters *parameters)
+//
+// RETURN: (DiscoverThreads *) - worker state for parameters->numThreads
+//                               threads
+//
+// PURPOSE: Give each worker its own copy of the parameters, with
+// private visit sets and a private log2Factorial cache.  Extension and
+// evaluation mark the positive graph's vertices and edges in the visit
+// sets and grow the cache, so this keeps the workers apart; the
+// positive graph and everything else reachable from the parameters is
+// only read and stays shared.
+//******************************************************************************
+
+DiscoverThreads *AllocateDiscoverThreads(Parameters *parameters)
+{
+   DiscoverThreads *pool;
+   DiscoverThread *thread;
+   Graph *posGraph = parameters->posGraph;
+   ULONG t;
+
+   pool = (DiscoverThreads *) malloc(sizeof(DiscoverThreads));
+   if (pool == NULL)
+      OutOfMemoryError("AllocateDiscoverThreads:pool");
+   pool->numThreads = parameters->numThreads;
+   pool->threads = (DiscoverThread *)
+      malloc(sizeof(DiscoverThread) * pool->numThreads);
+   if (pool->threads == NULL)
+      OutOfMemoryError("AllocateDiscoverThreads:pool->threads");
+   pool->parentSubs = NULL;
+   pool->extendedSubLists = NULL;
+   pool->numParents = 0;
+   pool->nextParent = 0;
+   pthread_mutex_init(& pool->lock, NULL);
+
+   for (t = 0; t < pool->numThreads; t++)
+   {
+      thread = & pool->threads[t];
+      thread->pool = pool;
+      thread->parameters = *parameters;
+      thread->parameters.vertexVisits =
+         AllocateVisitSet(posGraph->numVertices);
+      thread->parameters.edgeVisits = AllocateVisitSet(posGraph->numEdges);
+      thread->parameters.exampleVisits =
+         AllocateVisitSet(parameters->numPosEgs);
+      thread->parameters.coverVisits =
+         AllocateVisitSet(posGraph->numVertices);
+      thread->parameters.log2Factorial = (double *)
+         malloc(sizeof(double) * parameters->log2FactorialSize);
+      if (thread->parameters.log2Factorial == NULL)
+         OutOfMemoryError("AllocateDiscoverThreads:log2Factorial");
+      memcpy(thread->parameters.log2Factorial, parameters->log2Factorial,
+             sizeof(double) * parameters->log2FactorialSize);
+   }
+   return pool;
+}
+
+
+//******************************************************************************
+// NAME: FreeDiscoverThreads
+//
+// INPUTS: (DiscoverThreads *pool)
+//
+// RETURN: (void)
+//
+// PURPOSE: Free worker state.
+//******************************************************************************
+
+void FreeDiscoverThreads(DiscoverThreads *pool)
+{
+   ULONG t;
+
+   for (t = 0; t < pool->numThreads; t++)
+   {
+      FreeVisitSet(pool->threads[t].parameters.vertexVisits);
+      FreeVisitSet(pool->threads[t].parameters.edgeVisits);
+      FreeVisitSet(pool->threads[t].parameters.exampleVisits);
+      FreeVisitSet(pool->threads[t].parameters.coverVisits);
+      free(pool->threads[t].parameters.log2Factorial);
+   }
+   pthread_mutex_destroy(& pool->lock);
+   free(pool->threads);
+   free(pool);
+}
+
+
+//******************************************************************************
+// NAME: ExtendSubsInParallel
+//
+// INPUTS: (SubList *parentSubList) - substructures at current level
+//         (ULONG limit) - remaining number of substructures to extend
+//         (DiscoverThreads *pool) - worker state
+//
+// RETURN: (SubList **) - extended substructures of each parent, indexed
+//                        by position in parentSubList; NULL for parents
+//                        that DiscoverSubs will not extend
+//
+// PURPOSE: Extend and evaluate every parent that DiscoverSubs would
+// extend, using pool->numThreads threads.  Parents are handed out one
+// at a time.  Extensions larger than maxVertices are left unevaluated,
+// as in DiscoverSubs.  Inserting the results into the child list is
+// left to DiscoverSubs, in list order, so the beam is the same as
+// with one thread.
+//******************************************************************************
+
+SubList **ExtendSubsInParallel(SubList *parentSubList, ULONG limit,
+                               DiscoverThreads *pool)
+{
+   SubListNode *parentSubListNode;
+   SubList **extendedSubLists;
+   ULONG numParents;
+   ULONG i;
+   ULONG t;
+
+   numParents = CountSubs(parentSubList);
+   pool->parentSubs =
+      (Substructure **) malloc(sizeof(Substructure *) * (numParents + 1));
+   extendedSubLists = (SubList **) malloc(sizeof(SubList *) * (numParents + 1));
+   if ((pool->parentSubs == NULL) || (extendedSubLists == NULL))
+      OutOfMemoryError("ExtendSubsInParallel");
+
+   // decide which parents get extended, as DiscoverSubs will
+   i = 0;
+   parentSubListNode = parentSubList->head;
+   while (parentSubListNode != NULL)
+   {
+      pool->parentSubs[i] = NULL;
+      extendedSubLists[i] = NULL;
+      if (SubToBeExtended(parentSubListNode->sub,
+                          & pool->threads[0].parameters) && (limit > 0))
+      {
+         limit--;
+         pool->parentSubs[i] = parentSubListNode->sub;
+      }
+      i++;
+      parentSubListNode = parentSubListNode->next;
+   }
+   pool->numParents = numParents;
+   pool->nextParent = 0;
+   pool->extendedSubLists = extendedSubLists;
+
+   for (t = 0; t < pool->numThreads; t++)
+   {
+      if (pthread_create(& pool->threads[t].thread, NULL, ExtendSubsThread,
+                         & pool->threads[t]) != 0)
+      {
+         fprintf(stderr, "ERROR: unable to create discovery thread\n");
+         exit(1);
+      }
+   }
+   for (t = 0; t < pool->numThreads; t++)
+      pthread_join(pool->threads[t].thread, NULL);
+
+   free(pool->parentSubs);
+   pool->parentSubs = NULL;
+   pool->extendedSubLists = NULL;
+   return extendedSubLists;
+}
+
+
+//******************************************************************************
+// NAME: ExtendSubsThread
+//
+// INPUTS: (void *arg) - this thread's DiscoverThread
+//
+// RETURN: (void *) - NULL
+//
+// PURPOSE: Worker loop for ExtendSubsInParallel.  Claims the next
+// parent, extends it and evaluates the extensions with the thread's
+// own parameters, until no parents remain.
+//******************************************************************************
+
+void *ExtendSubsThread(void *arg)
+{
+   DiscoverThread *thread = (DiscoverThread *) arg;
+   DiscoverThreads *pool = thread->pool;
+   Parameters *parameters = & thread->parameters;
+   SubList *extendedSubList;
+   SubListNode *extendedSubListNode;
+   Substructure *extendedSub;
+   ULONG i;
+
+   while (TRUE)
+   {
+      pthread_mutex_lock(& pool->lock);
+      while ((pool->nextParent < pool->numParents) &&
+             (pool->parentSubs[pool->nextParent] == NULL))
+         pool->nextParent++;
+      i = pool->nextParent;
+      pool->nextParent++;
+      pthread_mutex_unlock(& pool->lock);
+      if (i >= pool->numParents)
+         break;
+
+      extendedSubList = ExtendSub(pool->parentSubs[i], parameters);
+      extendedSubListNode = extendedSubList->head;
+      while (extendedSubListNode != NULL)
+      {
+         extendedSub = extendedSubListNode->sub;
+         if (extendedSub->definition->numVertices <= parameters->maxVertices)
+            EvaluateSub(extendedSub, parameters);
+         extendedSubListNode = extendedSubListNode->next;
+      }
+      pool->extendedSubLists[i] = extendedSubList;
+   }
+   return NULL;
+}
+
+
 //******************************************************************************
 // NAME: GetInitialSubs
 //
@@ -283,6 +548,7 @@ SubList *GetInitialSubs(Parameters *parameters)
    Graph *g;
    Substructure *sub;
    Instance *instance;
+   GraphLabelIndex *labelIndex;
 
    // parameters used
    Graph *posGraph      = parameters->posGraph;
@@ -298,6 +564,7 @@ SubList *GetInitialSubs(Parameters *parameters)
   
    numInitialSubs = 0;
    initialSubs = AllocateSubList();
+   labelIndex = GetGraphLabelIndex(posGraph);
    for (i = startVertexIndex; i < posGraph->numVertices; i++)
    {
       vertexLabelIndex = posGraph->vertices[i].label;
@@ -314,24 +581,23 @@ SubList *GetInitialSubs(Parameters *parameters)
          sub = AllocateSub();
          sub->definition = g;
          sub->instances = AllocateInstanceList();
-         // collect instances in positive graph
-         j = posGraph->numVertices;
+         // collect instances in positive graph, from the vertices with
+         // the label, last first (i is the first of them)
+         j = labelIndex->starts[vertexLabelIndex + 1];
          do 
          {
             j--;
-            if (posGraph->vertices[j].label == vertexLabelIndex) 
-            {
-               // ***** do inexact label matches here? (instance->minMatchCost
-               // ***** too)
-               instance = AllocateInstance(1, 0);
-               instance->vertices[0] = j;
-               instance->mapping[0].v1 = 0;
-               instance->mapping[0].v2 = j;
-               instance->minMatchCost = 0.0;
-               InstanceListInsert(instance, sub->instances, FALSE);
-               sub->numInstances++;
-            }
-         } while (j > i);
+            // ***** do inexact label matches here? (instance->minMatchCost
+            // ***** too)
+            instance = AllocateInstance(1, 0,
+                                        parameters->instanceArena);
+            instance->vertices[0] = labelIndex->vertices[j];
+            instance->mapping[0].v1 = 0;
+            instance->mapping[0].v2 = labelIndex->vertices[j];
+            instance->minMatchCost = 0.0;
+            InstanceListInsert(instance, sub->instances, FALSE);
+            sub->numInstances++;
+         } while (j > labelIndex->starts[vertexLabelIndex]);
 
          //
          // Only keep substructures if more than one positive
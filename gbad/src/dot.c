@@ -8,6 +8,8 @@
 // ========  =========  ========================================================
 // 11/30/09  Eberle     Initial version, taken from SUBDUE 5.2.1
 // 12/17/09  Graves     Added GUI coloring support
+// 10/16/26  agent      Colors read from graph information tables
+// 10/17/26  agent      Instance marks kept in the parameters' VisitSets
 //
 //******************************************************************************
 
@@ -156,6 +158,8 @@ void WriteGraphWithInstancesToDotFile(char *dotFileName, Graph *graph,
 
    // parameters used
    LabelList *labelList = parameters->labelList;
+   VisitSet *vertexVisits = parameters->vertexVisits;
+   VisitSet *edgeVisits = parameters->edgeVisits;
 
    // open dot file for writing
    dotFile = fopen(dotFileName, "w");
@@ -172,6 +176,8 @@ void WriteGraphWithInstancesToDotFile(char *dotFileName, Graph *graph,
    vertexOffset = 0; // always zero for writing just one graph
    // first write instances of graph to dot file
    i = 0;
+   ClearVisitSet(vertexVisits, graph->numVertices);
+   ClearVisitSet(edgeVisits, graph->numEdges);
    instanceListNode = instanceList->head;
    while (instanceListNode != NULL) 
    {
@@ -182,35 +188,25 @@ void WriteGraphWithInstancesToDotFile(char *dotFileName, Graph *graph,
       for (e = 0; e < instance->numEdges; e++)
          WriteEdgeToDotFile(dotFile, instance->edges[e], vertexOffset,
                             graph, labelList, "blue");
-      MarkInstanceVertices(instance, graph, TRUE);
-      MarkInstanceEdges(instance, graph, TRUE);
+      MarkInstanceVertices(instance, vertexVisits);
+      MarkInstanceEdges(instance, edgeVisits);
       instanceListNode = instanceListNode->next;
       i++;
    }
 
    // write rest of graph to dot file
    for (v = 0; v < graph->numVertices; v++)
-      if (! graph->vertices[v].used)
+      if (! VISITED(vertexVisits, v))
          WriteVertexToDotFile(dotFile, v, vertexOffset, graph, labelList,
                               "black");
    for (e = 0; e < graph->numEdges; e++)
-      if (! graph->edges[e].used)
+      if (! VISITED(edgeVisits, e))
          WriteEdgeToDotFile(dotFile, e, vertexOffset, graph, labelList,
                             "black");
 
    // write end of dot file
    fprintf(dotFile, "}\n");
    fclose(dotFile);
-
-   // unmark instance vertices and edges
-   instanceListNode = instanceList->head;
-   while (instanceListNode != NULL) 
-   {
-      instance = instanceListNode->instance;
-      MarkInstanceVertices(instance, graph, FALSE);
-      MarkInstanceEdges(instance, graph, FALSE);
-      instanceListNode = instanceListNode->next;
-   }
 }
 
 
@@ -321,7 +317,10 @@ void WriteSubsToDotFile(char *dotFileName, Graph **subGraphs,
 void WriteVertexToDotFile(FILE *dotFile, ULONG v, ULONG vertexOffset,
                           Graph *graph, LabelList *labelList, char *color)
 {
-   char *vertex_color = get_color(graph->vertices[v].color);
+   char *vertex_color = get_color(NO_COLOR);
+
+   if (graph->vertexInfo != NULL)
+      vertex_color = get_color(graph->vertexInfo[v].color);
    
    fprintf(dotFile, "  %lu [label=\"", (v + vertexOffset + 1));
    WriteLabelToFile(dotFile, graph->vertices[v].label, labelList, TRUE);
@@ -351,7 +350,10 @@ void WriteEdgeToDotFile(FILE *dotFile, ULONG e, ULONG vertexOffset,
 
    edge = & graph->edges[e];
    
-   char *edge_color = get_color(edge->color);
+   char *edge_color = get_color(NO_COLOR);
+
+   if (graph->edgeInfo != NULL)
+      edge_color = get_color(graph->edgeInfo[e].color);
       
    fprintf(dotFile, "  %lu -> %lu [label=\"",
            (edge->vertex1 + vertexOffset + 1),
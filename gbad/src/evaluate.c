@@ -9,6 +9,13 @@
 // Date      Name       Description
 // ========  =========  ========================================================
 // 08/12/09  Eberle     Initial version, taken from SUBDUE 5.2.1
+// 10/16/26  agent      Compute MDL of compressed graph from cached vertex
+//                      statistics when instances do not overlap
+// 10/17/26  agent      Vertex and edge marks kept in the parameters' VisitSets
+// 10/17/26  agent      Factored CompressedPosGraphSize out of EvaluateSub
+// 10/17/26  agent      ExamplesCovered takes one pass over the instances
+// 10/17/26  agent      InstancesOverlap takes vertex coverage marks
+// 10/17/26  agent      CompressedGraphDL computes row terms once per row count
 //
 //******************************************************************************
 
@@ -36,7 +43,8 @@
 // replacing each instance of s in g with a new single vertex (e.g.,
 // Sub_1) and reconnecting edges external to the instance to point to
 // the new vertex.  For EVAL_SIZE, the size(g|s) can be computed
-// without actually performing the compression.
+// without actually performing the compression.  The same holds for
+// EVAL_MDL when the instances do not overlap (see CompressedGraphDL).
 //
 // If the evaluation method is EVAL_SETCOVER, then the evaluation of
 // substructure S becomes
@@ -53,7 +61,6 @@ void EvaluateSub(Substructure *sub, Parameters *parameters)
    double sizeOfPosGraph;
    double sizeOfCompressedPosGraph;
    double subValue = 0.0;
-   Graph *compressedGraph;
    ULONG numLabels;
    ULONG posEgsCovered;
 
@@ -62,7 +69,6 @@ void EvaluateSub(Substructure *sub, Parameters *parameters)
    double posGraphDL            = parameters->posGraphDL;
    ULONG numPosEgs              = parameters->numPosEgs;
    LabelList *labelList         = parameters->labelList;
-   BOOLEAN allowInstanceOverlap = parameters->allowInstanceOverlap;
    ULONG evalMethod             = parameters->evalMethod;
 
    // calculate number of examples covered by this substructure
@@ -74,24 +80,16 @@ void EvaluateSub(Substructure *sub, Parameters *parameters)
          numLabels = labelList->numLabels;
          sizeOfSub = MDL(sub->definition, numLabels, parameters);
          sizeOfPosGraph = posGraphDL; // cached at beginning
-         compressedGraph = CompressGraph(posGraph, sub->instances, parameters);
-         numLabels++; // add one for new "SUB" vertex label
-         if ((allowInstanceOverlap) && (InstancesOverlap(sub->instances)))
-            numLabels++; // add one for new "OVERLAP" edge label
-         sizeOfCompressedPosGraph = MDL(compressedGraph, numLabels, parameters);
-         // add extra bits to describe where external edges connect to instances
-         sizeOfCompressedPosGraph +=
-            ExternalEdgeBits(compressedGraph,sub->definition,sub->numInstances);
+         sizeOfCompressedPosGraph =
+            CompressedPosGraphSize(sub, numLabels, parameters);
          subValue = sizeOfPosGraph / (sizeOfSub + sizeOfCompressedPosGraph);
-         FreeGraph(compressedGraph);
       break;
 
       case EVAL_SIZE:
          sizeOfSub = (double) GraphSize(sub->definition);
          sizeOfPosGraph = (double) GraphSize(posGraph);
          sizeOfCompressedPosGraph =
-           (double) SizeOfCompressedGraph(posGraph, sub->instances,
-                                          parameters, POS);
+            CompressedPosGraphSize(sub, labelList->numLabels, parameters);
          subValue = sizeOfPosGraph / (sizeOfSub + sizeOfCompressedPosGraph);
 
       break;
@@ -107,6 +105,58 @@ void EvaluateSub(Substructure *sub, Parameters *parameters)
 }
 
 
+//******************************************************************************
+// NAME: CompressedPosGraphSize
+//
+// INPUTS: (Substructure *sub) - substructure whose instances compress
+//                               parameters->posGraph
+//         (ULONG numLabels) - number of labels of posGraph
+//         (Parameters *parameters)
+//
+// RETURN: (double) - size of posGraph compressed with sub
+//
+// PURPOSE: Compute size(G|S) of EvaluateSub for the EVAL_MDL or EVAL_SIZE
+// evaluation method.
+//******************************************************************************
+
+double CompressedPosGraphSize(Substructure *sub, ULONG numLabels,
+                              Parameters *parameters)
+{
+   double sizeOfCompressedPosGraph;
+   Graph *compressedGraph;
+
+   // parameters used
+   Graph *posGraph              = parameters->posGraph;
+   BOOLEAN allowInstanceOverlap = parameters->allowInstanceOverlap;
+
+   if (parameters->evalMethod == EVAL_SIZE)
+      return (double) SizeOfCompressedGraph(posGraph, sub->instances,
+                                            parameters, POS);
+
+   numLabels++; // add one for new "SUB" vertex label
+   // without overlapping instances, the compressed graph's
+   // description length follows from posGraph's cached statistics
+   if ((parameters->posGraphStats == NULL) ||
+       (! CompressedGraphDL(sub, numLabels, parameters,
+                            & sizeOfCompressedPosGraph)))
+   {
+      compressedGraph = CompressGraph(posGraph, sub->instances, parameters);
+      if ((allowInstanceOverlap) &&
+          (InstancesOverlap(sub->instances, parameters->coverVisits,
+                            posGraph->numVertices)))
+         numLabels++; // add one for new "OVERLAP" edge label
+      sizeOfCompressedPosGraph = MDL(compressedGraph, numLabels, parameters);
+      // add extra bits to describe where external edges connect
+      // to instances
+      sizeOfCompressedPosGraph +=
+         ExternalEdgeBits(compressedGraph, sub->definition,
+                          sub->numInstances);
+      FreeGraph(compressedGraph);
+   }
+   return sizeOfCompressedPosGraph;
+}
+
+
 //******************************************************************************
 // NAME: GraphSize
 //
@@ -184,7 +234,7 @@ double MDL(Graph *graph, ULONG numLabels, Parameters *parameters)
    M = 0;
    for (v1 = 0; v1 < V; v1++) 
    {
-      ki = NumUniqueEdges(graph, v1);
+      ki = NumUniqueEdges(graph, v1, parameters->vertexVisits);
       rowBits -= (Log2Factorial(ki, parameters) +
                   Log2Factorial((V - ki), parameters));
       if (ki > B) 
@@ -211,6 +261,7 @@ double MDL(Graph *graph, ULONG numLabels, Parameters *parameters)
 //
 // INPUTS: (Graph *graph) - graph containing vertex
 //         (ULONG v1) - vertex to find number of unique edges
+//         (VisitSet *vertexVisits) - scratch marks on graph's vertices
 //
 // RETURN: (ULONG) - number of unique edges of vertex v1
 //
@@ -220,7 +271,7 @@ double MDL(Graph *graph, ULONG numLabels, Parameters *parameters)
 // undirected edges.
 //******************************************************************************
 
-ULONG NumUniqueEdges(Graph *graph, ULONG v1)
+ULONG NumUniqueEdges(Graph *graph, ULONG v1, VisitSet *vertexVisits)
 {
    ULONG e;
    ULONG v2;
@@ -228,6 +279,7 @@ ULONG NumUniqueEdges(Graph *graph, ULONG v1)
    ULONG numUniqueEdges;
 
    numUniqueEdges = 0;
+   ClearVisitSet(vertexVisits, graph->numVertices);
    // look through all edges of vertex v1
    for (e = 0; e < graph->vertices[v1].numEdges; e++) 
    {
@@ -240,20 +292,13 @@ ULONG NumUniqueEdges(Graph *graph, ULONG v1)
       if (((edge->directed) && (edge->vertex1 == v1)) || // out-going edge
           ((! edge->directed) && (v2 >= v1))) 
       {
-         if (! graph->vertices[v2].used) 
+         if (! VISITED(vertexVisits, v2)) 
          {
             numUniqueEdges++;
-            graph->vertices[v2].used = TRUE;
+            VISIT(vertexVisits, v2);
          }
       }
    }
-   // reset vertex used flags
-   for (e = 0; e < graph->vertices[v1].numEdges; e++) 
-   {
-      edge = & graph->edges[graph->vertices[v1].edges[e]];
-      graph->vertices[edge->vertex1].used = FALSE;
-      graph->vertices[edge->vertex2].used = FALSE;
-   }
    return numUniqueEdges;
 }
 
@@ -369,6 +414,425 @@ double ExternalEdgeBits(Graph *compressedGraph, Graph *subGraph,
    return edgeBits;
 }
 
+
+//******************************************************************************
+// NAME: AllocateMDLGraphStats
+//
+// INPUTS: (Graph *graph) - graph whose statistics are cached
+//         (VisitSet *vertexVisits) - scratch marks on graph's vertices
+//
+// RETURN: (MDLGraphStats *) - per-vertex MDL statistics of graph
+//
+// PURPOSE: Cache, for each vertex of the graph, the row count k_i and
+// the maximum number of edges to a single vertex used by MDL.
+// CompressedGraphDL uses these to compute the description length of
+// the graph compressed with a substructure without building the
+// compressed graph.
+//******************************************************************************
+
+MDLGraphStats *AllocateMDLGraphStats(Graph *graph, VisitSet *vertexVisits)
+{
+   MDLGraphStats *stats;
+   ULONG v;
+
+   stats = (MDLGraphStats *) malloc(sizeof(MDLGraphStats));
+   if (stats == NULL)
+      OutOfMemoryError("AllocateMDLGraphStats:stats");
+   stats->rowCount = (ULONG *) malloc(sizeof(ULONG) * (graph->numVertices + 1));
+   stats->maxEdges = (ULONG *) malloc(sizeof(ULONG) * (graph->numVertices + 1));
+   if ((stats->rowCount == NULL) || (stats->maxEdges == NULL))
+      OutOfMemoryError("AllocateMDLGraphStats:arrays");
+   stats->maxDegree = 0;
+   stats->maxRowCount = 0;
+   for (v = 0; v < graph->numVertices; v++)
+   {
+      stats->rowCount[v] = NumUniqueEdges(graph, v, vertexVisits);
+      stats->maxEdges[v] = MaxEdgesToSingleVertex(graph, v);
+      if (graph->vertices[v].numEdges > stats->maxDegree)
+         stats->maxDegree = graph->vertices[v].numEdges;
+      if (stats->rowCount[v] > stats->maxRowCount)
+         stats->maxRowCount = stats->rowCount[v];
+   }
+   return stats;
+}
+
+
+//******************************************************************************
+// NAME: FreeMDLGraphStats
+//
+// INPUTS: (MDLGraphStats *stats)
+//
+// RETURN: (void)
+//
+// PURPOSE: Free cached MDL statistics.
+//******************************************************************************
+
+void FreeMDLGraphStats(MDLGraphStats *stats)
+{
+   if (stats != NULL)
+   {
+      free(stats->rowCount);
+      free(stats->maxEdges);
+      free(stats);
+   }
+}
+
+
+//******************************************************************************
+// NAME: CompressedGraphDL
+//
+// INPUTS: (Substructure *sub) - substructure compressing the graph
+//         (ULONG numLabels) - number of labels, including "SUB"
+//         (Parameters *parameters)
+//         (double *description) - returned description length
+//
+// RETURN: (BOOLEAN) - FALSE if the instances share vertices, in which
+//                     case nothing is computed
+//
+// PURPOSE: Compute MDL(CompressGraph(posGraph, sub->instances)) plus
+// ExternalEdgeBits without building the compressed graph.  Only the
+// rows of the "SUB" vertices and of the vertices adjacent to an
+// instance differ from the rows cached in parameters->posGraphStats,
+// so only those are recomputed.  Vertices are compared by their index
+// in the compressed graph, where the "SUB" vertices come first and the
+// rest keep their relative order, and each row's edges are taken in
+// edge index order as CompressGraph would store them.  The rows are
+// then summed in the compressed graph's vertex order, so the result
+// is bit-for-bit that of MDL.  Overlapping instances, which need
+// "OVERLAP" and duplicated edges, are left to CompressGraph.
+//******************************************************************************
+
+BOOLEAN CompressedGraphDL(Substructure *sub, ULONG numLabels,
+                          Parameters *parameters, double *description)
+{
+   InstanceListNode *instanceListNode;
+   Instance *instance;
+   Vertex *vertex;
+   Edge *edge;
+   ULONG *neighbors;     // non-instance vertices adjacent to an instance
+   ULONG *rowCounts;     // new k_i of "SUB" vertices, then of neighbors
+   ULONG *maxEdges;      // new maximum edges of "SUB" vertices, neighbors
+   ULONG *rowEdges;      // edges of a "SUB" vertex
+   ULONG *scratch;
+   double *rowTerms;     // lg(k!) + lg((V - k)!) of each row count k
+   ULONG maxRowCount;
+   ULONG numInstances = 0;
+   ULONG numInstanceVertices = 0;
+   ULONG numInstanceEdges = 0;
+   ULONG numBoundaryEdges = 0;
+   ULONG numNeighbors = 0;
+   ULONG numRowEdges;
+   ULONG V, E, L;
+   ULONG B, K, M;
+   ULONG ki, mi;
+   ULONG next;
+   ULONG i, j, v, e;
+   BOOLEAN overlap = FALSE;
+   double log2SubVertices;
+   double externalBits;
+   double vertexBits, rowBits, edgeBits;
+
+   // parameters used
+   Graph *graph          = parameters->posGraph;
+   MDLGraphStats *stats  = parameters->posGraphStats;
+   VisitSet *vertexVisits = parameters->vertexVisits;
+   VisitSet *edgeVisits   = parameters->edgeVisits;
+
+   // mark instance vertices with their instance number
+   ClearVisitSet(vertexVisits, graph->numVertices);
+   ClearVisitSet(edgeVisits, graph->numEdges);
+   instanceListNode = sub->instances->head;
+   while ((instanceListNode != NULL) && (! overlap))
+   {
+      instance = instanceListNode->instance;
+      for (v = 0; v < instance->numVertices; v++)
+      {
+         vertex = & graph->vertices[instance->vertices[v]];
+         if (VISITED(vertexVisits, instance->vertices[v]))
+            overlap = TRUE;
+         VISIT(vertexVisits, instance->vertices[v]);
+         vertexVisits->values[instance->vertices[v]] = numInstances;
+         numBoundaryEdges += vertex->numEdges;
+      }
+      MarkInstanceEdges(instance, edgeVisits);
+      numInstanceVertices += instance->numVertices;
+      numInstanceEdges += instance->numEdges;
+      numInstances++;
+      instanceListNode = instanceListNode->next;
+   }
+   if (overlap || (numInstances != sub->numInstances))
+      return FALSE;
+
+   V = graph->numVertices - numInstanceVertices + numInstances;
+   E = graph->numEdges - numInstanceEdges;
+   L = numLabels;
+   neighbors = (ULONG *) malloc(sizeof(ULONG) * (numBoundaryEdges + 1));
+   rowCounts = (ULONG *) malloc(sizeof(ULONG) *
+                                (numInstances + numBoundaryEdges + 1));
+   maxEdges = (ULONG *) malloc(sizeof(ULONG) *
+                               (numInstances + numBoundaryEdges + 1));
+   rowEdges = (ULONG *) malloc(sizeof(ULONG) * (numBoundaryEdges + 1));
+   scratch = (ULONG *) malloc(sizeof(ULONG) *
+                              (numBoundaryEdges + stats->maxDegree + 1));
+   if ((neighbors == NULL) || (rowCounts == NULL) || (maxEdges == NULL) ||
+       (rowEdges == NULL) || (scratch == NULL))
+      OutOfMemoryError("CompressedGraphDL");
+
+   // rows of "SUB" vertices, with external edge bits added in the same
+   // order as ExternalEdgeBits
+   log2SubVertices = Log2(sub->definition->numVertices);
+   externalBits = 0.0;
+   i = 0;
+   instanceListNode = sub->instances->head;
+   while (instanceListNode != NULL)
+   {
+      instance = instanceListNode->instance;
+      numRowEdges = 0;
+      for (v = 0; v < instance->numVertices; v++)
+      {
+         vertex = & graph->vertices[instance->vertices[v]];
+         for (e = 0; e < vertex->numEdges; e++)
+         {
+            edge = & graph->edges[vertex->edges[e]];
+            if (! VISITED(edgeVisits, vertex->edges[e]))
+            {
+               rowEdges[numRowEdges] = vertex->edges[e];
+               numRowEdges++;
+               if (! VISITED(vertexVisits, edge->vertex1))
+               {
+                  neighbors[numNeighbors] = edge->vertex1;
+                  numNeighbors++;
+               }
+               else if (! VISITED(vertexVisits, edge->vertex2))
+               {
+                  neighbors[numNeighbors] = edge->vertex2;
+                  numNeighbors++;
+               }
+            }
+         }
+      }
+      numRowEdges = SortUniqueULONGs(rowEdges, numRowEdges);
+      for (e = 0; e < numRowEdges; e++)
+      {
+         edge = & graph->edges[rowEdges[e]];
+         externalBits += log2SubVertices;
+         if (CompressedVertexKey(vertexVisits, edge->vertex1, numInstances) ==
+             CompressedVertexKey(vertexVisits, edge->vertex2, numInstances))
+            externalBits += log2SubVertices;
+      }
+      CompressedRowStats(graph, vertexVisits, i, rowEdges, numRowEdges,
+                         numInstances, scratch, & rowCounts[i], & maxEdges[i]);
+      i++;
+      instanceListNode = instanceListNode->next;
+   }
+
+   // rows of vertices adjacent to an instance
+   numNeighbors = SortUniqueULONGs(neighbors, numNeighbors);
+   for (j = 0; j < numNeighbors; j++)
+   {
+      vertex = & graph->vertices[neighbors[j]];
+      CompressedRowStats(graph, vertexVisits, numInstances + neighbors[j],
+                         vertex->edges, vertex->numEdges, numInstances, scratch,
+                         & rowCounts[numInstances + j],
+                         & maxEdges[numInstances + j]);
+   }
+
+   // a row's term depends only on its k_i, so compute each possible
+   // term once, exactly as MDL computes it
+   maxRowCount = stats->maxRowCount;
+   for (i = 0; i < (numInstances + numNeighbors); i++)
+      if (rowCounts[i] > maxRowCount)
+         maxRowCount = rowCounts[i];
+   if (maxRowCount > V)
+      maxRowCount = V;
+   rowTerms = (double *) malloc(sizeof(double) * (maxRowCount + 1));
+   if (rowTerms == NULL)
+      OutOfMemoryError("CompressedGraphDL:rowTerms");
+   for (ki = 0; ki <= maxRowCount; ki++)
+      rowTerms[ki] = (Log2Factorial(ki, parameters) +
+                      Log2Factorial((V - ki), parameters));
+
+   // sum rows in compressed vertex order, as MDL does, taking the
+   // remaining rows from the cache
+   vertexBits = Log2(V) + (V * Log2(L));
+   rowBits = V * Log2Factorial(V, parameters);
+   edgeBits = E * (1 + Log2(L));
+   B = 0;
+   K = 0;
+   M = 0;
+   next = 0;
+   v = 0;
+   for (i = 0; i < V; i++)
+   {
+      if (i < numInstances)
+      {
+         ki = rowCounts[i];
+         mi = maxEdges[i];
+      }
+      else
+      {
+         while (VISITED(vertexVisits, v))
+            v++;
+         if ((next < numNeighbors) && (neighbors[next] == v))
+         {
+            ki = rowCounts[numInstances + next];
+            mi = maxEdges[numInstances + next];
+            next++;
+         }
+         else
+         {
+            ki = stats->rowCount[v];
+            mi = stats->maxEdges[v];
+         }
+         v++;
+      }
+      rowBits -= rowTerms[ki];
+      if (ki > B)
+         B = ki;
+      K += ki;
+      if (mi > M)
+         M = mi;
+   }
+   rowBits += ((V + 1) * Log2(B + 1));
+   edgeBits += ((K + 1) * Log2(M));
+   *description = vertexBits + rowBits + edgeBits;
+   *description += externalBits;
+
+   free(rowTerms);
+   free(scratch);
+   free(rowEdges);
+   free(maxEdges);
+   free(rowCounts);
+   free(neighbors);
+   return TRUE;
+}
+
+
+//******************************************************************************
+// NAME: CompressedVertexKey
+//
+// INPUTS: (VisitSet *vertexVisits) - marks on graph's vertices, with
+//                                    instance vertices marked
+//         (ULONG v) - vertex of graph
+//         (ULONG numInstances) - number of instances
+//
+// RETURN: (ULONG) - key of v's vertex in the compressed graph
+//
+// PURPOSE: Instance vertices (marked, value = instance number) are
+// keyed by their "SUB" vertex, and other vertices follow the "SUB"
+// vertices in their original order, so keys order vertices the same
+// way as their indices in the compressed graph.
+//******************************************************************************
+
+ULONG CompressedVertexKey(VisitSet *vertexVisits, ULONG v, ULONG numInstances)
+{
+   if (VISITED(vertexVisits, v))
+      return vertexVisits->values[v];
+   return numInstances + v;
+}
+
+
+//******************************************************************************
+// NAME: CompressedRowStats
+//
+// INPUTS: (Graph *graph) - graph containing row's edges
+//         (VisitSet *vertexVisits) - marks on graph's vertices, with
+//                                    instance vertices marked
+//         (ULONG key) - compressed vertex key of the row's vertex
+//         (ULONG *edgeIndices) - row's edges, in edge index order
+//         (ULONG numEdges) - number of row edges
+//         (ULONG numInstances) - number of instances
+//         (ULONG *scratch) - space for numEdges values
+//         (ULONG *rowCount) - returned NumUniqueEdges of the row
+//         (ULONG *maxEdges) - returned MaxEdgesToSingleVertex of the row
+//
+// RETURN: (void)
+//
+// PURPOSE: Compute NumUniqueEdges and MaxEdgesToSingleVertex for a
+// vertex of the compressed graph, following those functions exactly
+// with vertex indices replaced by compressed vertex keys.
+//******************************************************************************
+
+void CompressedRowStats(Graph *graph, VisitSet *vertexVisits, ULONG key,
+                        ULONG *edgeIndices, ULONG numEdges, ULONG numInstances,
+                        ULONG *scratch, ULONG *rowCount, ULONG *maxEdges)
+{
+   Edge *edge1, *edge2;
+   ULONG i, j;
+   ULONG numTargets = 0;
+   ULONG source1, source2;
+   ULONG v2, v2j;
+   ULONG numEdgesToVertex2;
+
+   *maxEdges = 0;
+   for (i = 0; i < numEdges; i++)
+   {
+      edge1 = & graph->edges[edgeIndices[i]];
+      source1 = CompressedVertexKey(vertexVisits, edge1->vertex1,
+                                    numInstances);
+      if (source1 == key)
+         v2 = CompressedVertexKey(vertexVisits, edge1->vertex2, numInstances);
+      else
+         v2 = source1;
+      if (((edge1->directed) && (source1 == key)) || // outgoing edge
+          ((! edge1->directed) && (v2 >= key)))
+      {
+         scratch[numTargets] = v2;
+         numTargets++;
+         // count how many edges to v2
+         numEdgesToVertex2 = 1;
+         for (j = i + 1; j < numEdges; j++)
+         {
+            edge2 = & graph->edges[edgeIndices[j]];
+            source2 = CompressedVertexKey(vertexVisits, edge2->vertex1,
+                                          numInstances);
+            if (source2 == key)
+               v2j = CompressedVertexKey(vertexVisits, edge2->vertex2,
+                                         numInstances);
+            else
+               v2j = source2;
+            if ((v2j == v2) &&
+                (((edge2->directed) && (source2 == key)) ||
+                 ((! edge1->directed) && (v2j >= key))))
+               numEdgesToVertex2++;
+         }
+         if (numEdgesToVertex2 > *maxEdges)
+            *maxEdges = numEdgesToVertex2;
+      }
+   }
+   *rowCount = SortUniqueULONGs(scratch, numTargets);
+}
+
+
+//******************************************************************************
+// NAME: SortUniqueULONGs
+//
+// INPUTS: (ULONG *values) - array of values
+//         (ULONG numValues) - number of values
+//
+// RETURN: (ULONG) - number of distinct values
+//
+// PURPOSE: Sort values in increasing order and remove duplicates, so
+// the distinct values occupy the front of the array.
+//******************************************************************************
+
+ULONG SortUniqueULONGs(ULONG *values, ULONG numValues)
+{
+   ULONG i;
+   ULONG numUnique;
+
+   SortULONGs(values, numValues);
+   numUnique = 0;
+   for (i = 0; i < numValues; i++)
+      if ((i == 0) || (values[i] != values[numUnique - 1]))
+      {
+         values[numUnique] = values[i];
+         numUnique++;
+      }
+   return numUnique;
+}
+
+
 //******************************************************************************
 // NAME: Log2Factorial
 //
@@ -436,17 +900,16 @@ double Log2(ULONG number)
 // RETURN: (ULONG) - number of positive examples covered by sub
 //
 // PURPOSE: Returns the number of positive examples that contain the
-// substructure sub as a subgraph.
+// substructure sub as a subgraph.  The examples covered are left marked
+// in parameters->exampleVisits.
 //******************************************************************************
 
 ULONG PosExamplesCovered(Substructure *sub, Parameters *parameters)
 {
-   ULONG start = 0;
-
    return ExamplesCovered(sub->instances,
-                          parameters->posGraph,
                           parameters->numPosEgs,
-                          parameters->posEgsVertexIndices, start);
+                          parameters->posVertexExamples,
+                          parameters->exampleVisits);
 }
 
 
@@ -454,62 +917,44 @@ ULONG PosExamplesCovered(Substructure *sub, Parameters *parameters)
 // NAME: ExamplesCovered
 //
 // INPUTS: (InstanceList *instanceList) - instances of substructure
-//         (Graph *graph) - graph containing instances and examples
 //         (ULONG numEgs) - number of examples to consider
-//         (ULONG *egsVertexIndices) - vertex indices of each examples
-//           starting vertex
-//         (ULONG start) - start vertex for current increment
+//         (ULONG *vertexExamples) - example of each vertex of the graph
+//           containing the instances (used only if numEgs > 1)
+//         (VisitSet *exampleVisits) - marks on examples
 //
 // RETURN: (ULONG) - number of examples covered by instances
 //
-// PURPOSE: Return the number of examples, whose starting vertices are
-// stored in egsVertexIndices, are covered by an instance in
-// instanceList.  Note that one example may contain more than one
-// instance.
+// PURPOSE: Return the number of examples covered by an instance in
+// instanceList, marking each of them in exampleVisits.  Note that one
+// example may contain more than one instance, and that the examples are
+// found in a single pass over the instances.
 //******************************************************************************
 
-ULONG ExamplesCovered(InstanceList *instanceList, Graph *graph,
-                      ULONG numEgs, ULONG *egsVertexIndices, ULONG start)
+ULONG ExamplesCovered(InstanceList *instanceList, ULONG numEgs,
+                      ULONG *vertexExamples, VisitSet *exampleVisits)
 {
-   ULONG i;
-   ULONG egStartVertexIndex;
-   ULONG egEndVertexIndex;
-   ULONG instanceVertexIndex;
+   ULONG egNo;
    InstanceListNode *instanceListNode;
-   BOOLEAN found;
    ULONG numEgsCovered;
 
    numEgsCovered = 0;
-   if (instanceList != NULL) 
+   ClearVisitSet(exampleVisits, numEgs);
+   if ((instanceList != NULL) && (numEgs > 0))
    {
-      // for each example, look for a covering instance
-      for (i = 0; i < numEgs; i++)
+      instanceListNode = instanceList->head;
+      while (instanceListNode != NULL)
       {
-         // find example's starting and ending vertex indices
-         egStartVertexIndex = egsVertexIndices[i];
-         if (egStartVertexIndex >= start)
+         // can check any instance vertex, so use the first
+         egNo = 0;
+         if (numEgs > 1)
+            egNo = vertexExamples[instanceListNode->instance->vertices[0]];
+         if (! VISITED(exampleVisits, egNo))
          {
-            if (i < (numEgs - 1))
-               egEndVertexIndex = egsVertexIndices[i + 1] - 1;
-            else
-               egEndVertexIndex = graph->numVertices - 1;
-            // look for an instance whose vertices are in range
-            instanceListNode = instanceList->head;
-            found = FALSE;
-            while ((instanceListNode != NULL) && (! found))
-            {
-               // can check any instance vertex, so use the first
-               instanceVertexIndex = instanceListNode->instance->vertices[0];
-               if ((instanceVertexIndex >= egStartVertexIndex) &&
-                   (instanceVertexIndex <= egEndVertexIndex))
-               {
-                  // found an instance covering this example
-                  numEgsCovered++;
-                  found = TRUE;
-               }
-               instanceListNode = instanceListNode->next;
-            }
+            // found an instance covering this example
+            VISIT(exampleVisits, egNo);
+            numEgsCovered++;
          }
+         instanceListNode = instanceListNode->next;
       }
    }
    return numEgsCovered;
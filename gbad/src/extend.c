@@ -6,6 +6,11 @@
 // Date      Name       Description
 // ========  =========  ========================================================
 // 08/12/09  Eberle     Initial version, taken from SUBDUE 5.2.1
+// 10/16/26  agent      Extended subs added to sub list hash index
+// 10/16/26  agent      Exact extension groups instances by canonical code
+// 10/17/26  agent      Extension marks instance edges in a VisitSet
+// 10/17/26  agent      Instance overlap checked against vertex coverage marks
+// 10/17/26  agent      Dropped the unread instance used flag
 //
 //******************************************************************************
 
@@ -26,6 +31,9 @@
 // given substructure in all possible ways according to the graph.
 // Matching extended instances are collected into new extended
 // substructures, and all such extended substructures are returned.
+// With a zero match threshold, instances are grouped by canonical
+// code in one pass (see GroupInstancesIntoSubs); otherwise each new
+// substructure is matched against every extended instance.
 //******************************************************************************
 
 SubList *ExtendSub(Substructure *sub, Parameters *parameters)
@@ -45,6 +53,12 @@ SubList *ExtendSub(Substructure *sub, Parameters *parameters)
    extendedSubs = AllocateSubList();
    newInstanceList = ExtendInstances(sub->instances, posGraph, FALSE,
                                      parameters);
+   if (parameters->threshold == 0.0)
+   {
+      GroupInstancesIntoSubs(newInstanceList, extendedSubs, parameters);
+      FreeInstanceList(newInstanceList);
+      return extendedSubs;
+   }
    newInstanceListNode = newInstanceList->head;
    while (newInstanceListNode != NULL) 
    {
@@ -63,6 +77,7 @@ SubList *ExtendSub(Substructure *sub, Parameters *parameters)
             newSubListNode = AllocateSubListNode(newSub);
             newSubListNode->next = extendedSubs->head;
             extendedSubs->head = newSubListNode;
+            SubListIndexInsert(newSubListNode, extendedSubs);
          } else FreeSub(newSub);
       }
       newInstanceListNode = newInstanceListNode->next;
@@ -96,7 +111,7 @@ InstanceList *ExtendInstances(InstanceList *instanceList, Graph *graph,
    ULONG v;
    ULONG e;
    Vertex *vertex;
-   Edge *edge;
+   VisitSet *edgeVisits = parameters->edgeVisits;
 
    char subLabelString[TOKEN_LEN];
    sprintf(subLabelString, "%s_%lu", SUB_LABEL_STRING, (parameters->currentIteration-1));
@@ -106,14 +121,14 @@ InstanceList *ExtendInstances(InstanceList *instanceList, Graph *graph,
    while (instanceListNode != NULL) 
    {
       instance = instanceListNode->instance;
-      MarkInstanceEdges(instance, graph, TRUE);
+      ClearVisitSet(edgeVisits, graph->numEdges);
+      MarkInstanceEdges(instance, edgeVisits);
       for (v = 0; v < instance->numVertices; v++) 
       {
          vertex = & graph->vertices[instance->vertices[v]];
          for (e = 0; e < vertex->numEdges; e++) 
          {
-            edge = & graph->edges[vertex->edges[e]];
-            if (! edge->used) 
+            if (! VISITED(edgeVisits, vertex->edges[e])) 
             {
                // add new instance to list
                //
@@ -137,7 +152,6 @@ InstanceList *ExtendInstances(InstanceList *instanceList, Graph *graph,
             }
          }
       }
-      MarkInstanceEdges(instance, graph, FALSE);
       instanceListNode = instanceListNode->next;
    }
    return newInstanceList;
@@ -183,10 +197,10 @@ Instance *CreateExtendedInstance(Instance *instance, ULONG v, ULONG e,
    // allocate memory for new instance
    if (! found)
       newInstance = AllocateInstance(instance->numVertices + 1,
-                                     instance->numEdges + 1);
+                                     instance->numEdges + 1, instance->arena);
    else 
       newInstance = AllocateInstance(instance->numVertices,
-                                     instance->numEdges + 1);
+                                     instance->numEdges + 1, instance->arena);
 
    //
    // GBAD-P: If flagging instance as anomalous, set anomalous vertices.
@@ -302,7 +316,8 @@ Substructure *CreateSubFromInstance(Instance *instance, Graph *graph)
 // PURPOSE: Add instance from instanceList to sub's positive
 // instances if the instance matches sub's definition.  If
 // allowInstanceOverlap=FALSE, then instances added only if they do
-// not overlap with existing instances.
+// not overlap with existing instances, whose vertices are kept marked
+// in parameters->coverVisits.
 //******************************************************************************
 void AddPosInstancesToSub(Substructure *sub, Instance *subInstance,
                            InstanceList *instanceList, Parameters *parameters,
@@ -320,11 +335,14 @@ void AddPosInstancesToSub(Substructure *sub, Instance *subInstance,
    LabelList *labelList         = parameters->labelList;
    BOOLEAN allowInstanceOverlap = parameters->allowInstanceOverlap;
    double threshold             = parameters->threshold;
+   VisitSet *coverVisits        = parameters->coverVisits;
 
-   // collect positive instances of substructure
+   // collect positive instances of substructure, marking the vertices
+   // they cover
    if (instanceList != NULL) 
    {
       sub->instances = AllocateInstanceList();
+      ClearVisitSet(coverVisits, posGraph->numVertices);
       //
       // Go ahead an insert the subInstance onto the list of instances for the
       // substructure, as it is obviously an instance.
@@ -335,8 +353,8 @@ void AddPosInstancesToSub(Substructure *sub, Instance *subInstance,
       if ((parameters->prob) && (parameters->currentIteration > 1)) {
          // Do not duplicate...
       } else {
-         subInstance->used = TRUE;
          InstanceListInsert(subInstance, sub->instances, FALSE);
+         MarkInstanceVertices(subInstance, coverVisits);
          sub->numInstances++;
       }
       //
@@ -350,7 +368,7 @@ void AddPosInstancesToSub(Substructure *sub, Instance *subInstance,
             // GBAD-P: Allow for overlap if probabilistic approach is chosen.
             //
             if ((allowInstanceOverlap ||
-                (! InstanceListOverlap(instance, sub->instances))) ||
+                (! InstanceVerticesMarked(instance, coverVisits))) ||
                 ((parameters->prob) && (parameters->currentIteration > 1)))
             {
                thresholdLimit = threshold *
@@ -362,6 +380,7 @@ void AddPosInstancesToSub(Substructure *sub, Instance *subInstance,
                   if (matchCost < instance->minMatchCost)
                      instance->minMatchCost = matchCost;
                   InstanceListInsert(instance, sub->instances, FALSE);
+                  MarkInstanceVertices(instance, coverVisits);
                   sub->numInstances++;
                }
 	       //
@@ -374,3 +393,173 @@ void AddPosInstancesToSub(Substructure *sub, Instance *subInstance,
       }
    }
 }
+
+
+//******************************************************************************
+// NAME: GroupInstancesIntoSubs
+//
+// INPUTS: (InstanceList *instanceList) - extended instances
+//         (SubList *extendedSubs) - list to receive new substructures
+//         (Parameters *parameters)
+//
+// RETURN: (void)
+//
+// PURPOSE: Exact (threshold = 0) replacement for the CreateSubFromInstance/
+// AddPosInstancesToSub loop in ExtendSub.  Each instance's graph is
+// keyed by its canonical code, and instances with the same key are
+// chained together in list order.  Each group then becomes one
+// substructure, defined by the group's first instance, and groups are
+// added to extendedSubs in order of first appearance, so the result is
+// the same as matching every new substructure against every instance.
+//******************************************************************************
+
+void GroupInstancesIntoSubs(InstanceList *instanceList, SubList *extendedSubs,
+                            Parameters *parameters)
+{
+   InstanceListNode *instanceListNode;
+   SubListNode *newSubListNode;
+   Substructure *newSub;
+   Substructure **groupSubs;
+   Instance **instances;
+   ULONG *memberNext;
+   ULONG *groupFirst;
+   ULONG *groupLast;
+   ULONG *table;
+   ULONG numInstances;
+   ULONG numGroups = 0;
+   ULONG tableSize = 1;
+   ULONG slot;
+   ULONG g;
+   ULONG i;
+
+   // parameters used
+   Graph *posGraph      = parameters->posGraph;
+   LabelList *labelList = parameters->labelList;
+
+   numInstances = CountInstances(instanceList);
+   if (numInstances == 0)
+      return;
+   while (tableSize < 2 * numInstances)
+      tableSize = 2 * tableSize;
+
+   instances = (Instance **) malloc(sizeof(Instance *) * numInstances);
+   groupSubs = (Substructure **) malloc(sizeof(Substructure *) * numInstances);
+   memberNext = (ULONG *) malloc(sizeof(ULONG) * numInstances);
+   groupFirst = (ULONG *) malloc(sizeof(ULONG) * numInstances);
+   groupLast = (ULONG *) malloc(sizeof(ULONG) * numInstances);
+   table = (ULONG *) malloc(sizeof(ULONG) * tableSize);
+   if ((instances == NULL) || (groupSubs == NULL) || (memberNext == NULL) ||
+       (groupFirst == NULL) || (groupLast == NULL) || (table == NULL))
+      OutOfMemoryError("GroupInstancesIntoSubs");
+   for (slot = 0; slot < tableSize; slot++)
+      table[slot] = MAX_UNSIGNED_LONG;
+
+   // assign each instance to the group of its canonical code
+   i = 0;
+   instanceListNode = instanceList->head;
+   while (instanceListNode != NULL)
+   {
+      instances[i] = instanceListNode->instance;
+      memberNext[i] = MAX_UNSIGNED_LONG;
+      newSub = CreateSubFromInstance(instances[i], posGraph);
+      ComputeSubCanonicalCode(newSub);
+      slot = newSub->canonicalHash & (tableSize - 1);
+      while ((table[slot] != MAX_UNSIGNED_LONG) &&
+             (! SubsMatch(newSub, groupSubs[table[slot]], labelList)))
+         slot = (slot + 1) & (tableSize - 1);
+      if (table[slot] == MAX_UNSIGNED_LONG)
+      {
+         g = numGroups;
+         numGroups++;
+         table[slot] = g;
+         groupSubs[g] = newSub;
+         groupFirst[g] = i;
+      }
+      else
+      {
+         g = table[slot];
+         memberNext[groupLast[g]] = i;
+         FreeSub(newSub);
+      }
+      groupLast[g] = i;
+      i++;
+      instanceListNode = instanceListNode->next;
+   }
+
+   // each group becomes a substructure, added to head of extendedSubs
+   for (g = 0; g < numGroups; g++)
+   {
+      AddGroupInstancesToSub(groupSubs[g], instances, memberNext,
+                             groupFirst[g], parameters);
+      newSubListNode = AllocateSubListNode(groupSubs[g]);
+      newSubListNode->next = extendedSubs->head;
+      extendedSubs->head = newSubListNode;
+      SubListIndexInsert(newSubListNode, extendedSubs);
+   }
+
+   free(table);
+   free(groupLast);
+   free(groupFirst);
+   free(memberNext);
+   free(groupSubs);
+   free(instances);
+}
+
+
+//******************************************************************************
+// NAME: AddGroupInstancesToSub
+//
+// INPUTS: (Substructure *sub) - substructure to collect instances
+//         (Instance **instances) - extended instances in list order
+//         (ULONG *memberNext) - next instance in same group, or
+//                               MAX_UNSIGNED_LONG at end of group
+//         (ULONG first) - index of group's first instance
+//         (Parameters *parameters)
+//
+// RETURN: (void)
+//
+// PURPOSE: Counterpart of AddPosInstancesToSub for a group of
+// instances already known to match sub's definition exactly.  The
+// same overlap rules apply, and instances are considered in the same
+// order, starting with the instance the substructure was built from.
+//******************************************************************************
+
+void AddGroupInstancesToSub(Substructure *sub, Instance **instances,
+                            ULONG *memberNext, ULONG first,
+                            Parameters *parameters)
+{
+   Instance *instance;
+   ULONG i;
+
+   // parameters used
+   Graph *posGraph              = parameters->posGraph;
+   BOOLEAN allowInstanceOverlap = parameters->allowInstanceOverlap;
+   VisitSet *coverVisits        = parameters->coverVisits;
+
+   sub->instances = AllocateInstanceList();
+   ClearVisitSet(coverVisits, posGraph->numVertices);
+   //
+   // GBAD-P:  Avoid duplicates when doing probabilistic approach after
+   //          the first situation.
+   //
+   if ((parameters->prob) && (parameters->currentIteration > 1)) {
+      // Do not duplicate...
+   } else {
+      InstanceListInsert(instances[first], sub->instances, FALSE);
+      MarkInstanceVertices(instances[first], coverVisits);
+      sub->numInstances++;
+   }
+   for (i = first; i != MAX_UNSIGNED_LONG; i = memberNext[i])
+   {
+      instance = instances[i];
+      if ((allowInstanceOverlap ||
+          (! InstanceVerticesMarked(instance, coverVisits))) ||
+          ((parameters->prob) && (parameters->currentIteration > 1)))
+      {
+         instance->minMatchCost = 0.0;
+         InstanceListInsert(instance, sub->instances, FALSE);
+         MarkInstanceVertices(instance, coverVisits);
+         sub->numInstances++;
+      }
+   }
+}
@@ -37,6 +37,14 @@
 // 09/26/16  Eberle     Fixed memory leak in FindAnomalousInstances, and fixed
 //                      counting of matching instances in 
 //                      ScoreAndPrintAnomalousAncestors (MPS)
+// 10/17/26  agent      Vertex and edge marks kept in VisitSets
+// 10/17/26  agent      Instances allocated from the parameters' arena; fixed
+//                      read of freed instance in ExtendPotentialInstancesByEdge
+// 10/17/26  agent      Instance example numbers read from posVertexExamples
+// 10/17/26  agent      Initial anomalous instances seeded from the graph label index
+// 10/17/26  agent      Anomalous instances checked against the normative
+//                      pattern's vertex coverage marks
+// 10/17/26  agent      Instance frequencies counted by canonical code grouping
 //
 //******************************************************************************
 
@@ -241,11 +249,11 @@ void PrintProbabilisticAnomalies(InstanceList *instanceList,
             for (i=0;i<firstInstanceListNode->instance->numVertices;i++)
             {
                // GUI coloring
-               orignalIndex = posGraph->vertices[firstInstanceListNode->instance->vertices[i]].originalVertexIndex;
-               if ((parameters->posGraph->vertices[firstInstanceListNode->instance->vertices[i]].color != NO_COLOR) && 
-                   (parameters->originalPosGraph->vertices[orignalIndex].color != POSITIVE_ANOM_VERTEX))
+               orignalIndex = posGraph->vertexInfo[firstInstanceListNode->instance->vertices[i]].originalVertexIndex;
+               if ((parameters->posGraph->vertexInfo[firstInstanceListNode->instance->vertices[i]].color != NO_COLOR) && 
+                   (parameters->originalPosGraph->vertexInfo[orignalIndex].color != POSITIVE_ANOM_VERTEX))
                {
-                  parameters->originalPosGraph->vertices[orignalIndex].color = POSITIVE_PARTIAL_ANOM_VERTEX;
+                  parameters->originalPosGraph->vertexInfo[orignalIndex].color = POSITIVE_PARTIAL_ANOM_VERTEX;
                }
 
                if ((parameters->labelList->labels[posGraph->vertices[firstInstanceListNode->instance->vertices[i]].label].labelType == STRING_LABEL) &&
@@ -264,11 +272,11 @@ void PrintProbabilisticAnomalies(InstanceList *instanceList,
             for (i=0;i<firstInstanceListNode->instance->numEdges;i++)
             {
                // GUI coloring
-               orignalIndex = posGraph->edges[firstInstanceListNode->instance->edges[i]].originalEdgeIndex;
-               if ((parameters->posGraph->edges[firstInstanceListNode->instance->edges[i]].color != NO_COLOR) && 
-                   (parameters->originalPosGraph->edges[orignalIndex].color != POSITIVE_ANOM_EDGE))
+               orignalIndex = posGraph->edgeInfo[firstInstanceListNode->instance->edges[i]].originalEdgeIndex;
+               if ((parameters->posGraph->edgeInfo[firstInstanceListNode->instance->edges[i]].color != NO_COLOR) && 
+                   (parameters->originalPosGraph->edgeInfo[orignalIndex].color != POSITIVE_ANOM_EDGE))
                {
-                  parameters->originalPosGraph->edges[orignalIndex].color = POSITIVE_PARTIAL_ANOM_VERTEX;
+                  parameters->originalPosGraph->edgeInfo[orignalIndex].color = POSITIVE_PARTIAL_ANOM_VERTEX;
                }
 
                firstInstanceListNode->instance->anomalousEdges[firstInstanceListNode->instance->numAnomalousEdges] = 
@@ -281,9 +289,9 @@ void PrintProbabilisticAnomalies(InstanceList *instanceList,
          count++;
          ULONG posEgNo;
          ULONG numPosEgs = parameters->numPosEgs;
-         ULONG *posEgsVertexIndices = parameters->posEgsVertexIndices;
+         ULONG *posVertexExamples = parameters->posVertexExamples;
          posEgNo = InstanceExampleNumber(firstInstanceListNode->instance,
-                                         posEgsVertexIndices, numPosEgs);
+                                         posVertexExamples, numPosEgs);
          printf(" from positive example %lu:\n", posEgNo);
          PrintAnomalousInstance(firstInstanceListNode->instance, posGraph, 
 	                        parameters);
@@ -301,6 +309,8 @@ void PrintProbabilisticAnomalies(InstanceList *instanceList,
 // NAME: StoreAnomalousEdge (GBAD)
 //
 // INPUTS: (Edge *overlapEdges) - edge array where edge is stored
+//         (EdgeInfo *overlapEdgeInfo) - edge information array kept
+//                                       alongside overlapEdges; NULL if none
 //         (ULONG edgeIndex) - index into edge array where edge is stored
 //         (ULONG v1) - vertex1 of edge
 //         (ULONG v2) - vertex2 of edge
@@ -317,7 +327,8 @@ void PrintProbabilisticAnomalies(InstanceList *instanceList,
 //       compress.c.
 //******************************************************************************
 
-void StoreAnomalousEdge(Edge *overlapEdges, ULONG edgeIndex,
+void StoreAnomalousEdge(Edge *overlapEdges, EdgeInfo *overlapEdgeInfo,
+                        ULONG edgeIndex,
                         ULONG v1, ULONG v2, ULONG label, BOOLEAN directed,
                         BOOLEAN spansIncrement, BOOLEAN anomalous,
 			ULONG sourceVertex1, ULONG sourceVertex2,
@@ -327,12 +338,14 @@ void StoreAnomalousEdge(Edge *overlapEdges, ULONG edgeIndex,
    overlapEdges[edgeIndex].vertex2 = v2;
    overlapEdges[edgeIndex].label = label;
    overlapEdges[edgeIndex].directed = directed;
-   overlapEdges[edgeIndex].used = FALSE;
    overlapEdges[edgeIndex].spansIncrement = spansIncrement;
    overlapEdges[edgeIndex].anomalous = anomalous;
-   overlapEdges[edgeIndex].sourceVertex1 = sourceVertex1;
-   overlapEdges[edgeIndex].sourceVertex2 = sourceVertex2;
-   overlapEdges[edgeIndex].sourceExample = sourceExample;
+   if (overlapEdgeInfo != NULL)
+   {
+      overlapEdgeInfo[edgeIndex].sourceVertex1 = sourceVertex1;
+      overlapEdgeInfo[edgeIndex].sourceVertex2 = sourceVertex2;
+      overlapEdgeInfo[edgeIndex].sourceExample = sourceExample;
+   }
 }
 
 
@@ -361,11 +374,11 @@ void PrintAnomalousVertex(Graph *graph, ULONG vertexIndex, LabelList *labelList,
    // GUI coloring
    if (parameters->currentIteration == 1)
    {
-      orignalIndex = parameters->posGraph->vertices[vertexIndex].originalVertexIndex;
-      if ((parameters->posGraph->vertices[vertexIndex].color != NO_COLOR) && 
-          (parameters->originalPosGraph->vertices[orignalIndex].color != POSITIVE_ANOM_VERTEX))
+      orignalIndex = parameters->posGraph->vertexInfo[vertexIndex].originalVertexIndex;
+      if ((parameters->posGraph->vertexInfo[vertexIndex].color != NO_COLOR) && 
+          (parameters->originalPosGraph->vertexInfo[orignalIndex].color != POSITIVE_ANOM_VERTEX))
       {
-         parameters->originalPosGraph->vertices[orignalIndex].color = 
+         parameters->originalPosGraph->vertexInfo[orignalIndex].color = 
             POSITIVE_PARTIAL_ANOM_VERTEX;
       }
    }
@@ -384,9 +397,9 @@ void PrintAnomalousVertex(Graph *graph, ULONG vertexIndex, LabelList *labelList,
          {
             // GUI coloring
             if ((parameters->currentIteration == 1) && 
-                (parameters->originalPosGraph->vertices[orignalIndex].color != NO_COLOR))
+                (parameters->originalPosGraph->vertexInfo[orignalIndex].color != NO_COLOR))
             {
-               parameters->originalPosGraph->vertices[orignalIndex].color = 
+               parameters->originalPosGraph->vertexInfo[orignalIndex].color = 
                   POSITIVE_ANOM_VERTEX;
             }
 
@@ -398,20 +411,20 @@ void PrintAnomalousVertex(Graph *graph, ULONG vertexIndex, LabelList *labelList,
                printf(" <-- anomaly");
                // If original example has a value of 0, that means it is the
                // first iteration and was never set (so output it as 1)
-               if (graph->vertices[vertexIndex].sourceExample == 0)
+               if (graph->vertexInfo[vertexIndex].sourceExample == 0)
                   printf(" (original vertex: %lu , in original example 1)",
-                         graph->vertices[vertexIndex].sourceVertex);
+                         graph->vertexInfo[vertexIndex].sourceVertex);
                else
                   printf(" (original vertex: %lu , in original example %lu)",
-                         graph->vertices[vertexIndex].sourceVertex,
-                         graph->vertices[vertexIndex].sourceExample);
+                         graph->vertexInfo[vertexIndex].sourceVertex,
+                         graph->vertexInfo[vertexIndex].sourceExample);
             }
 
             // GUI coloring
-            if (parameters->originalPosGraph->vertices[graph->vertices[vertexIndex].originalVertexIndex].anomalousValue > 
+            if (parameters->originalPosGraph->vertexInfo[graph->vertexInfo[vertexIndex].originalVertexIndex].anomalousValue > 
                 instance->probAnomalousValue)
             {
-               parameters->originalPosGraph->vertices[graph->vertices[vertexIndex].originalVertexIndex].anomalousValue = 
+               parameters->originalPosGraph->vertexInfo[graph->vertexInfo[vertexIndex].originalVertexIndex].anomalousValue = 
                   instance->probAnomalousValue;
             }
 
@@ -453,11 +466,11 @@ void PrintAnomalousEdge(Graph *graph, ULONG edgeIndex, LabelList *labelList,
    // GUI coloring
    if (parameters->currentIteration == 1)
    {
-      orignalIndex = parameters->posGraph->edges[edgeIndex].originalEdgeIndex;
-      if (parameters->originalPosGraph->edges[orignalIndex].color != 
+      orignalIndex = parameters->posGraph->edgeInfo[edgeIndex].originalEdgeIndex;
+      if (parameters->originalPosGraph->edgeInfo[orignalIndex].color != 
           POSITIVE_ANOM_EDGE)
       {
-         parameters->originalPosGraph->edges[orignalIndex].color = 
+         parameters->originalPosGraph->edgeInfo[orignalIndex].color = 
             POSITIVE_PARTIAL_ANOM_EDGE;
       }
    }
@@ -477,7 +490,7 @@ void PrintAnomalousEdge(Graph *graph, ULONG edgeIndex, LabelList *labelList,
             // GUI coloring
             if (parameters->currentIteration == 1)
             {
-               parameters->originalPosGraph->edges[orignalIndex].color = 
+               parameters->originalPosGraph->edgeInfo[orignalIndex].color = 
                   POSITIVE_ANOM_EDGE;
             }
 
@@ -489,21 +502,21 @@ void PrintAnomalousEdge(Graph *graph, ULONG edgeIndex, LabelList *labelList,
                printf(" <-- anomaly");
                // If original example has a value of 0, that means it is the
                // first iteration and was never set (so output it as 1)
-               if (graph->edges[edgeIndex].sourceExample == 0)
+               if (graph->edgeInfo[edgeIndex].sourceExample == 0)
                   printf(" (original edge vertices: %lu -- %lu, in original example 1)",
-	                 graph->edges[edgeIndex].sourceVertex1,
-	                 graph->edges[edgeIndex].sourceVertex2);
+	                 graph->edgeInfo[edgeIndex].sourceVertex1,
+	                 graph->edgeInfo[edgeIndex].sourceVertex2);
                else
                   printf(" (original edge vertices: %lu -- %lu, in original example %lu)",
-	                 graph->edges[edgeIndex].sourceVertex1,
-	                 graph->edges[edgeIndex].sourceVertex2,
-	                 graph->edges[edgeIndex].sourceExample);
+	                 graph->edgeInfo[edgeIndex].sourceVertex1,
+	                 graph->edgeInfo[edgeIndex].sourceVertex2,
+	                 graph->edgeInfo[edgeIndex].sourceExample);
             }
             // GUI coloring
-            if (parameters->originalPosGraph->edges[graph->edges[edgeIndex].originalEdgeIndex].anomalousValue > 
+            if (parameters->originalPosGraph->edgeInfo[graph->edgeInfo[edgeIndex].originalEdgeIndex].anomalousValue > 
                 instance->probAnomalousValue)
             {
-               parameters->originalPosGraph->edges[graph->edges[edgeIndex].originalEdgeIndex].anomalousValue = 
+               parameters->originalPosGraph->edgeInfo[graph->edgeInfo[edgeIndex].originalEdgeIndex].anomalousValue = 
                   instance->probAnomalousValue;
             }
 
@@ -581,7 +594,7 @@ void SetExampleNumber(SubList *subList, Parameters *parameters)
    // parameters used
    Graph *graph = parameters->posGraph;
    ULONG numPosEgs = parameters->numPosEgs;
-   ULONG *posEgsVertexIndices = parameters->posEgsVertexIndices;
+   ULONG *posVertexExamples = parameters->posVertexExamples;
 
    if (subList != NULL)
    {
@@ -598,12 +611,12 @@ void SetExampleNumber(SubList *subList, Parameters *parameters)
                {
                   instance = instanceListNode->instance;
                   posEgNo = InstanceExampleNumber(instance,
-                                                  posEgsVertexIndices, 
+                                                  posVertexExamples, 
 						  numPosEgs);
                   for (i = 0; i < instance->numEdges; i++)
-                     graph->edges[instance->edges[i]].sourceExample = posEgNo;
+                     graph->edgeInfo[instance->edges[i]].sourceExample = posEgNo;
                   for (i = 0; i < instance->numVertices; i++)
-                     graph->vertices[instance->vertices[i]].sourceExample = posEgNo;
+                     graph->vertexInfo[instance->vertices[i]].sourceExample = posEgNo;
                }
                instanceListNode = instanceListNode->next;
             }
@@ -821,9 +834,12 @@ InstanceList *FindAnomalousInstances(Substructure *sub, Graph *g2,
    BOOLEAN *reached;
    BOOLEAN noMatches;
    BOOLEAN found;
+   VisitSet *vertexVisits;  // g1 vertices whose edges have been added
+   VisitSet *edgeVisits;    // g1 edges added
    Graph *g1 = sub->definition;
    ULONG numInitialVerticesToConsider;
-   ULONG i, j, vertexLabelIndex;
+   ULONG i, j, k, vertexLabelIndex;
+   GraphLabelIndex *labelIndex;
    ULONG firstVertex = 0;
    Instance *instance = NULL;
    BOOLEAN overlaps;
@@ -837,6 +853,8 @@ InstanceList *FindAnomalousInstances(Substructure *sub, Graph *g2,
    reached = (BOOLEAN *) malloc(sizeof(BOOLEAN) * g1->numVertices);
    if (reached == NULL)
       OutOfMemoryError("FindAnomalousInstances:reached");
+   vertexVisits = AllocateVisitSet(g1->numVertices);
+   edgeVisits = AllocateVisitSet(g1->numEdges);
    for (v1 = 0; v1 < g1->numVertices; v1++)
       reached[v1] = FALSE;
 
@@ -844,9 +862,12 @@ InstanceList *FindAnomalousInstances(Substructure *sub, Graph *g2,
    // In order to make sure we don't miss the anomalous instance without
    // having to examine every possible combination, we need to specify
    // an initial set of single vertices that will guarantee proper
-   // coverage
+   // coverage.  Instances may not overlap those of the normative
+   // pattern, whose vertices are marked here for the whole search.
    //
    instanceList = AllocateInstanceList();
+   MarkInstanceListVertices(sub->instances, parameters->coverVisits,
+                            g2->numVertices);
 
    numInitialVerticesToConsider = (ULONG)((g1->numVertices + g1->numEdges) * 
                                           parameters->mdlThreshold) + 1;
@@ -855,17 +876,22 @@ InstanceList *FindAnomalousInstances(Substructure *sub, Graph *g2,
    if (numInitialVerticesToConsider > g1->numVertices)
       numInitialVerticesToConsider = g1->numVertices;
 
+   labelIndex = GetGraphLabelIndex(g2);
    for (j = 0; j < numInitialVerticesToConsider; j++)
    {
-      for (i = 0; i < g2->numVertices; i++)
+      vertexLabelIndex = g1->vertices[j].label;
+      if (vertexLabelIndex < labelIndex->numLabels)
       {
-         vertexLabelIndex = g2->vertices[i].label;
-         if (g1->vertices[j].label == vertexLabelIndex)
+         for (k = labelIndex->starts[vertexLabelIndex];
+              k < labelIndex->starts[vertexLabelIndex + 1]; k++)
          {
-            instance = AllocateInstance(1, 0);
+            i = labelIndex->vertices[k];
+            instance = AllocateInstance(1, 0,
+                                        parameters->instanceArena);
             instance->vertices[0] = i;
             instance->minMatchCost = 0.0;
-            overlaps = InstanceListOverlap(instance,sub->instances);
+            overlaps = InstanceVerticesMarked(instance,
+                                              parameters->coverVisits);
             if (!overlaps)
             {
                InstanceListInsert(instance, instanceList, FALSE);
@@ -884,12 +910,12 @@ InstanceList *FindAnomalousInstances(Substructure *sub, Graph *g2,
       noMatches = TRUE;
    while ((vertex1 != NULL) && (!noMatches))
    {
-      vertex1->used = TRUE;
+      VISIT(vertexVisits, v1);
       // extend by each unmarked edge involving vertex v1
       for (e1 = 0; ((e1 < vertex1->numEdges) && (!noMatches)); e1++)
       {
          edge1 = & g1->edges[g1->vertices[v1].edges[e1]];
-         if (!edge1->used)
+         if (! VISITED(edgeVisits, g1->vertices[v1].edges[e1]))
          {
             reached[edge1->vertex1] = TRUE;
             reached[edge1->vertex2] = TRUE;
@@ -898,7 +924,7 @@ InstanceList *FindAnomalousInstances(Substructure *sub, Graph *g2,
                                               parameters);
             if (instanceList->head == NULL)
                noMatches = TRUE;
-            edge1->used = TRUE;
+            VISIT(edgeVisits, g1->vertices[v1].edges[e1]);
          }
       }
 
@@ -907,7 +933,7 @@ InstanceList *FindAnomalousInstances(Substructure *sub, Graph *g2,
       found = FALSE;
       for (v = 0; ((v < g1->numVertices) && (! found)); v++)
       {
-         if ((! g1->vertices[v].used) && (reached[v]))
+         if ((! VISITED(vertexVisits, v)) && (reached[v]))
          {
             v1 = v;
             vertex1 = & g1->vertices[v1];
@@ -961,17 +987,144 @@ InstanceList *FindAnomalousInstances(Substructure *sub, Graph *g2,
       }
    }
    free(reached);
-
-   // set used flags to FALSE
-   for (v1 = 0; v1 < g1->numVertices; v1++)
-      g1->vertices[v1].used = FALSE;
-   for (e1 = 0; e1 < g1->numEdges; e1++)
-      g1->edges[e1].used = FALSE;
+   FreeVisitSet(vertexVisits);
+   FreeVisitSet(edgeVisits);
 
    return parentInstanceList;
 }
 
 
+//******************************************************************************
+// NAME: SetInstanceFrequencies
+//
+// INPUTS: (InstanceList *instanceList) - list of potential anomalous instances
+//         (Parameters *parameters)
+//
+// RETURN: void
+//
+// PURPOSE: Set the frequency of each instance to the number of instances
+// in the list with the same structure, i.e., whose graphs match exactly.
+// Instead of matching every pair of instances, each instance's graph is
+// given its canonical code (canonical.c), and the instances are grouped
+// through a hash table on the code's hash, comparing codes only within a
+// bucket.  Graphs whose code search was abandoned are compared with
+// GraphMatch, as in SubsMatch.
+//******************************************************************************
+void SetInstanceFrequencies(InstanceList *instanceList, Parameters *parameters)
+{
+   ULONG numInstances = 0;
+   ULONG i, r;
+   ULONG hashSize;
+   ULONG bucket;
+   ULONG *hashes;
+   ULONG *codeLengths;
+   ULONG **codes;
+   Graph **graphs;
+   Instance **instances;
+   ULONG *groups;
+   ULONG *groupSizes;
+   ULONG *bucketHeads;
+   ULONG *nextInBucket;
+   BOOLEAN match;
+   InstanceListNode *instanceListNode;
+   LabelList *labelList = parameters->labelList;
+   Graph *posGraph = parameters->posGraph;
+
+   instanceListNode = instanceList->head;
+   while (instanceListNode != NULL)
+   {
+      if (instanceListNode->instance != NULL)
+         numInstances++;
+      instanceListNode = instanceListNode->next;
+   }
+   hashSize = 1;
+   while (hashSize < (2 * numInstances))
+      hashSize *= 2;
+   instances = (Instance **) malloc(sizeof(Instance *) * (numInstances + 1));
+   graphs = (Graph **) malloc(sizeof(Graph *) * (numInstances + 1));
+   codes = (ULONG **) malloc(sizeof(ULONG *) * (numInstances + 1));
+   codeLengths = (ULONG *) malloc(sizeof(ULONG) * (numInstances + 1));
+   hashes = (ULONG *) malloc(sizeof(ULONG) * (numInstances + 1));
+   groups = (ULONG *) malloc(sizeof(ULONG) * (numInstances + 1));
+   groupSizes = (ULONG *) malloc(sizeof(ULONG) * (numInstances + 1));
+   nextInBucket = (ULONG *) malloc(sizeof(ULONG) * (numInstances + 1));
+   bucketHeads = (ULONG *) malloc(sizeof(ULONG) * hashSize);
+   if ((instances == NULL) || (graphs == NULL) || (codes == NULL) ||
+       (codeLengths == NULL) || (hashes == NULL) || (groups == NULL) ||
+       (groupSizes == NULL) || (nextInBucket == NULL) ||
+       (bucketHeads == NULL))
+      OutOfMemoryError("SetInstanceFrequencies:arrays");
+   for (bucket = 0; bucket < hashSize; bucket++)
+      bucketHeads[bucket] = MAX_UNSIGNED_LONG;
+
+   // group each instance with the first earlier instance of the same
+   // structure, if any; the group is named by that instance
+   i = 0;
+   instanceListNode = instanceList->head;
+   while (instanceListNode != NULL)
+   {
+      if (instanceListNode->instance != NULL)
+      {
+         instances[i] = instanceListNode->instance;
+         graphs[i] = InstanceToGraph(instances[i], posGraph);
+         codes[i] = CanonicalCode(graphs[i], & codeLengths[i], & hashes[i]);
+         if (codes[i] != NULL)
+         { // graph only kept for GraphMatch
+            FreeGraph(graphs[i]);
+            graphs[i] = NULL;
+         }
+         groups[i] = i;
+         groupSizes[i] = 0;
+         bucket = hashes[i] & (hashSize - 1);
+         r = bucketHeads[bucket];
+         while ((r != MAX_UNSIGNED_LONG) && (groups[i] == i))
+         {
+            match = FALSE;
+            if (hashes[r] == hashes[i])
+            {
+               if ((codes[r] != NULL) && (codes[i] != NULL))
+                  match = CanonicalCodesEqual(codes[r], codeLengths[r],
+                                              codes[i], codeLengths[i]);
+               else if ((codes[r] == NULL) && (codes[i] == NULL))
+                  match = GraphMatch(graphs[r], graphs[i], labelList, 0.0,
+                                     NULL, NULL);
+            }
+            if (match)
+               groups[i] = r;
+            r = nextInBucket[r];
+         }
+         if (groups[i] == i)
+         { // first instance of its structure
+            nextInBucket[i] = bucketHeads[bucket];
+            bucketHeads[bucket] = i;
+         }
+         groupSizes[groups[i]]++;
+         i++;
+      }
+      instanceListNode = instanceListNode->next;
+   }
+
+   for (i = 0; i < numInstances; i++)
+      instances[i]->frequency = groupSizes[groups[i]];
+
+   for (i = 0; i < numInstances; i++)
+   {
+      free(codes[i]);
+      if (graphs[i] != NULL)
+         FreeGraph(graphs[i]);
+   }
+   free(instances);
+   free(graphs);
+   free(codes);
+   free(codeLengths);
+   free(hashes);
+   free(groups);
+   free(groupSizes);
+   free(nextInBucket);
+   free(bucketHeads);
+}
+
+
 //******************************************************************************
 // NAME: ScoreAndPrintAnomalousInstances
 //
@@ -990,74 +1143,18 @@ void ScoreAndPrintAnomalousInstances(InstanceList *instanceList,
                                      Substructure *sub,
                                      Parameters *parameters)
 {
-   double matchCost;
    double anomalousValue = 0.0;
    ULONG minimumValue = MAX_UNSIGNED_LONG;
-   Instance *otherInstance = NULL;
    Instance *instance = NULL;
-   InstanceListNode *otherInstanceListNode = NULL;
    InstanceListNode *instanceListNode = NULL;
    InstanceList *anomalousInstanceList = NULL;
-   Graph *instanceGraph;
-   Graph *otherInstanceGraph;
-   LabelList *labelList = parameters->labelList;
    Graph *posGraph = parameters->posGraph;
 
    //
    // First, determine how many instances have the same substructure
    // pattern (for frequency value)
    //
-   instanceListNode = instanceList->head;
-   while (instanceListNode != NULL)
-   {
-      instance = instanceListNode->instance;
-      if (instance != NULL)
-      {
-         instanceGraph = InstanceToGraph(instance, posGraph);
-         instance->frequency = 0;
-         otherInstanceListNode = instanceList->head;
-         while (otherInstanceListNode != NULL)
-         {
-            otherInstance = otherInstanceListNode->instance;
-            if (otherInstance != NULL)
-            {
-               if ((instance->numVertices == otherInstance->numVertices) &&
-                   (instance->numEdges == otherInstance->numEdges))
-               {
-                  otherInstanceGraph = InstanceToGraph(otherInstance, posGraph);
-                  GraphMatch(instanceGraph, otherInstanceGraph, labelList,
-                             MAX_DOUBLE, & matchCost, NULL);
-                  if (matchCost == 0.0)
-                  {
-                     instance->frequency++;
-                     otherInstance->matched = TRUE;
-                  }
-                  FreeGraph(otherInstanceGraph);
-               }
-            }
-            otherInstanceListNode = otherInstanceListNode->next;
-         }
-         //
-         // Now, to speed things up, go back and set the frequency to the same
-         // value for all of the matching instances, so that they do not have to
-         // be scored again
-         //
-         otherInstanceListNode = instanceList->head;
-         while (otherInstanceListNode != NULL)
-         {
-            otherInstance = otherInstanceListNode->instance;
-            if ((otherInstance != NULL) && (otherInstance->matched))
-            {
-               otherInstance->frequency = instance->frequency;
-               otherInstance->matched = FALSE;
-            }
-            otherInstanceListNode = otherInstanceListNode->next;
-         }
-         //
-         FreeGraph(instanceGraph);
-      }
-      instanceListNode = instanceListNode->next;
-   }
+   SetInstanceFrequencies(instanceList, parameters);
    //
    // Second, calculate anomalous score for all of the potential anomalous
    // instances.
@@ -1121,9 +1218,9 @@ void ScoreAndPrintAnomalousInstances(InstanceList *instanceList,
                printf("\n");
                ULONG posEgNo;
                ULONG numPosEgs = parameters->numPosEgs;
-               ULONG *posEgsVertexIndices = parameters->posEgsVertexIndices;
+               ULONG *posVertexExamples = parameters->posVertexExamples;
                posEgNo = InstanceExampleNumber(instanceListNode->instance,
-                                               posEgsVertexIndices,
+                                               posVertexExamples,
                                                numPosEgs);
                printf(" from example %lu:\n", posEgNo);
                PrintAnomalousInstance(instanceListNode->instance, 
@@ -1358,7 +1455,6 @@ void ScoreAndPrintAnomalousAncestors(InstanceList *instanceList,
    InstanceList *reducedInstanceList = NULL;
    InstanceList *bigEnoughInstanceList = NULL;
    Graph *instanceGraph;
-   Graph *otherInstanceGraph;
    LabelList *labelList = parameters->labelList;
    Graph *posGraph = parameters->posGraph;
    BOOLEAN foundBest = FALSE;
@@ -1444,62 +1540,11 @@ void ScoreAndPrintAnomalousAncestors(InstanceList *instanceList,
       instanceListNode = instanceListNode->next;
    }
 
-   instanceListNode = reducedInstanceList->head;
-
    //
    // Third, determine how many instances have the same substructure
    // pattern (for frequency value)
    //
-   while (instanceListNode != NULL)
-   {
-      instance = instanceListNode->instance;
-      if (instance != NULL)
-      {
-         instanceGraph = InstanceToGraph(instance, posGraph);
-         instance->frequency = 0;
-         otherInstanceListNode = reducedInstanceList->head;
-         while (otherInstanceListNode != NULL)
-         {
-            otherInstance = otherInstanceListNode->instance;
-            if (otherInstance != NULL)
-            {
-               if ((instance->numVertices == otherInstance->numVertices) &&
-                   (instance->numEdges == otherInstance->numEdges))
-               {
-                  otherInstanceGraph = InstanceToGraph(otherInstance, posGraph);
-                  GraphMatch(instanceGraph, otherInstanceGraph, labelList,
-                             MAX_DOUBLE, & matchCost, NULL);
-                  if (matchCost == 0.0)
-                  {
-                     instance->frequency++;
-                     otherInstance->matched = TRUE;
-                  }
-                  FreeGraph(otherInstanceGraph);
-               }
-            }
-            otherInstanceListNode = otherInstanceListNode->next;
-         }
-         //
-         // Now, to speed things up, go back and set the frequency to the same
-         // value for all of the matching instances, so that they do not have to
-         // be scored again
-         //
-         otherInstanceListNode = reducedInstanceList->head;
-         while (otherInstanceListNode != NULL)
-         {
-            otherInstance = otherInstanceListNode->instance;
-            if ((otherInstance != NULL) && (otherInstance->matched))
-            {
-               otherInstance->frequency = instance->frequency;
-               otherInstance->matched = FALSE;
-            }
-            otherInstanceListNode = otherInstanceListNode->next;
-         } 
-         //
-         FreeGraph(instanceGraph);
-      }
-      instanceListNode = instanceListNode->next;
-   }
+   SetInstanceFrequencies(reducedInstanceList, parameters);
 
    //
    // Fourth, calculate anomalous score for all of the potential anomalous
@@ -1619,9 +1664,9 @@ void ScoreAndPrintAnomalousAncestors(InstanceList *instanceList,
                printf("\n");
                ULONG posEgNo;
                ULONG numPosEgs = parameters->numPosEgs;
-               ULONG *posEgsVertexIndices = parameters->posEgsVertexIndices;
+               ULONG *posVertexExamples = parameters->posVertexExamples;
                posEgNo = InstanceExampleNumber(instanceListNode->instance,
-                                               posEgsVertexIndices,
+                                               posVertexExamples,
                                                numPosEgs);
                printf(" from example %lu:\n", posEgNo);
                PrintAnomalousInstance(instanceListNode->instance, 
@@ -1762,9 +1807,12 @@ InstanceList *FindPotentialAnomalousAncestors(Substructure *sub, Graph *g2,
    BOOLEAN *reached;
    BOOLEAN noMatches;
    BOOLEAN found;
+   VisitSet *vertexVisits;  // g1 vertices whose edges have been added
+   VisitSet *edgeVisits;    // g1 edges added
    Graph *g1 = sub->definition;
    ULONG numInitialVerticesToConsider;
-   ULONG i, j, vertexLabelIndex;
+   ULONG i, j, k, vertexLabelIndex;
+   GraphLabelIndex *labelIndex;
    ULONG firstVertex = 0;
    Instance *instance = NULL;
    BOOLEAN overlaps;
@@ -1774,6 +1822,8 @@ InstanceList *FindPotentialAnomalousAncestors(Substructure *sub, Graph *g2,
    reached = (BOOLEAN *) malloc(sizeof(BOOLEAN) * g1->numVertices);
    if (reached == NULL)
       OutOfMemoryError("FindPotentialAnomalousAncestors:reached");
+   vertexVisits = AllocateVisitSet(g1->numVertices);
+   edgeVisits = AllocateVisitSet(g1->numEdges);
    for (v1 = 0; v1 < g1->numVertices; v1++)
       reached[v1] = FALSE;
 
@@ -1781,24 +1831,32 @@ InstanceList *FindPotentialAnomalousAncestors(Substructure *sub, Graph *g2,
    // In order to make sure we don't miss the anomalous instance without
    // having to examing every possible combination, we need to specify
    // an initial set of single vertices that will guarantee proper
-   // coverage
+   // coverage.  Instances may not overlap those of the normative
+   // pattern, whose vertices are marked here for the whole search.
    //
    instanceList = AllocateInstanceList();
+   MarkInstanceListVertices(sub->instances, parameters->coverVisits,
+                            g2->numVertices);
 
    numInitialVerticesToConsider = (ULONG) ((g1->numVertices + g1->numEdges) * 
                                            parameters->mpsThreshold) + 1;
 
+   labelIndex = GetGraphLabelIndex(g2);
    for (j = 0; j < numInitialVerticesToConsider; j++)
    {
-      for (i = 0; i < g2->numVertices; i++)
+      vertexLabelIndex = g1->vertices[j].label;
+      if (vertexLabelIndex < labelIndex->numLabels)
       {
-         vertexLabelIndex = g2->vertices[i].label;
-         if (g1->vertices[j].label == vertexLabelIndex)
+         for (k = labelIndex->starts[vertexLabelIndex];
+              k < labelIndex->starts[vertexLabelIndex + 1]; k++)
          {
-            instance = AllocateInstance(1, 0);
+            i = labelIndex->vertices[k];
+            instance = AllocateInstance(1, 0,
+                                        parameters->instanceArena);
             instance->vertices[0] = i;
             instance->minMatchCost = 0.0;
-            overlaps = InstanceListOverlap(instance,sub->instances);
+            overlaps = InstanceVerticesMarked(instance,
+                                              parameters->coverVisits);
             if (!overlaps)
             {
                InstanceListInsert(instance, instanceList, FALSE);
@@ -1817,7 +1875,7 @@ InstanceList *FindPotentialAnomalousAncestors(Substructure *sub, Graph *g2,
       noMatches = TRUE;
    while ((vertex1 != NULL) && (! noMatches))
    {
-      vertex1->used = TRUE;
+      VISIT(vertexVisits, v1);
       // extend by each unmarked edge involving vertex v1
       for (e1 = 0; ((e1 < vertex1->numEdges) && (! noMatches)); e1++)
       {
@@ -1825,7 +1883,7 @@ InstanceList *FindPotentialAnomalousAncestors(Substructure *sub, Graph *g2,
          // Need to make sure this is a new edge extension AND that we are
          // still dealing with an instance that when extended would be
          // smaller than the normative pattern
-         if ((! edge1->used) && 
+         if ((! VISITED(edgeVisits, g1->vertices[v1].edges[e1])) && 
              (((instanceList->head->instance->numVertices + 1) < g1->numVertices) ||
               ((instanceList->head->instance->numEdges + 1) < g1->numEdges)))
          {
@@ -1837,7 +1895,7 @@ InstanceList *FindPotentialAnomalousAncestors(Substructure *sub, Graph *g2,
                                                     parameters);
             if (instanceList->head == NULL)
                noMatches = TRUE;
-            edge1->used = TRUE;
+            VISIT(edgeVisits, g1->vertices[v1].edges[e1]);
          }
       }
 
@@ -1846,7 +1904,7 @@ InstanceList *FindPotentialAnomalousAncestors(Substructure *sub, Graph *g2,
       found = FALSE;
       for (v = 0; ((v < g1->numVertices) && (! found)); v++)
       {
-         if ((! g1->vertices[v].used) && (reached[v]))
+         if ((! VISITED(vertexVisits, v)) && (reached[v]))
          {
             v1 = v;
             vertex1 = & g1->vertices[v1];
@@ -1881,12 +1939,8 @@ InstanceList *FindPotentialAnomalousAncestors(Substructure *sub, Graph *g2,
       }
    }
    free(reached);
-
-   // set used flags to FALSE
-   for (v1 = 0; v1 < g1->numVertices; v1++)
-      g1->vertices[v1].used = FALSE;
-   for (e1 = 0; e1 < g1->numEdges; e1++)
-      g1->edges[e1].used = FALSE;
+   FreeVisitSet(vertexVisits);
+   FreeVisitSet(edgeVisits);
 
    return parentInstanceList;
 }
@@ -1908,6 +1962,8 @@ InstanceList *FindPotentialAnomalousAncestors(Substructure *sub, Graph *g2,
 // edge from graph g2 that matches the attributes of the given edge in
 // graph g1.  Returns a new (possibly empty) instance list containing
 // the extended instances.  The given instance list is de-allocated.
+// The vertices of sub's instances must be marked in
+// parameters->coverVisits (FindAnomalousInstances).
 //******************************************************************************
 
 InstanceList *ExtendPotentialInstancesByEdge(InstanceList *instanceList,
@@ -1921,8 +1977,8 @@ InstanceList *ExtendPotentialInstancesByEdge(InstanceList *instanceList,
    Instance *newInstance;
    ULONG v2;
    ULONG e2;
-   Edge *edge2;
    Vertex *vertex2;
+   VisitSet *edgeVisits = parameters->edgeVisits;
    BOOLEAN overlaps = FALSE;
    BOOLEAN noExtensions = TRUE;
    double matchCost;
@@ -1935,13 +1991,14 @@ InstanceList *ExtendPotentialInstancesByEdge(InstanceList *instanceList,
    while (instanceListNode != NULL)
    {
       instance = instanceListNode->instance;
-      MarkInstanceEdges(instance, g2, TRUE);
+      ClearVisitSet(edgeVisits, g2->numEdges);
+      MarkInstanceEdges(instance, edgeVisits);
       //
       // See if the instance overlaps with any of the
       // best substructure instances; if so, we can skip doing any 
       // extensions because it will never be an anomalous instance.
       //
-      overlaps = InstanceListOverlap(instance,sub->instances);
+      overlaps = InstanceVerticesMarked(instance, parameters->coverVisits);
 
       if ((!overlaps) && 
           (instance->numEdges <= g1->numEdges) &&
@@ -1953,8 +2010,7 @@ InstanceList *ExtendPotentialInstancesByEdge(InstanceList *instanceList,
             vertex2 = & g2->vertices[instance->vertices[v2]];
             for (e2 = 0; e2 < vertex2->numEdges; e2++)
             {
-               edge2 = & g2->edges[vertex2->edges[e2]];
-               if (!edge2->used)
+               if (! VISITED(edgeVisits, vertex2->edges[e2]))
                {
                   // add new instance to list
                   newInstance =
@@ -1965,9 +2021,12 @@ InstanceList *ExtendPotentialInstancesByEdge(InstanceList *instanceList,
                   {
                      // If the extension is to a normative substructure instance,
                      // no point in adding it to the new instance list
-                     if (!InstanceListOverlap(newInstance,sub->instances))
+                     if (!InstanceVerticesMarked(newInstance,
+                                                 parameters->coverVisits))
                      {
                         // if smaller than normative pattern, save it
+                        // (InstanceListInsert may free it, so the size
+                        // check below is only made otherwise)
                         if ((newInstance->numVertices < sub->definition->numVertices) &&
                             (newInstance->numEdges < sub->definition->numEdges))
                         {
@@ -1976,8 +2035,8 @@ InstanceList *ExtendPotentialInstancesByEdge(InstanceList *instanceList,
                         }
                         // if the size of the normative pattern, see if it is
                         // a candidate...
-                        if ((newInstance->numVertices == sub->definition->numVertices) &&
-                            (newInstance->numEdges == sub->definition->numEdges))
+                        else if ((newInstance->numVertices == sub->definition->numVertices) &&
+                                 (newInstance->numEdges == sub->definition->numEdges))
                         {
                            instanceGraph = InstanceToGraph(newInstance, g2);
                            GraphMatch(sub->definition,instanceGraph,parameters->labelList, MAX_DOUBLE,
@@ -2002,7 +2061,6 @@ InstanceList *ExtendPotentialInstancesByEdge(InstanceList *instanceList,
             }
          }
       }
-      MarkInstanceEdges(instance, g2, FALSE);
       instanceListNode = instanceListNode->next;
    }
 
@@ -2042,7 +2100,9 @@ InstanceList *ExtendPotentialInstancesByEdge(InstanceList *instanceList,
 // edge from graph g2 that matches the attributes of the given edge in
 // graph g1.  Returns a new (possibly empty) instance list containing
 // the extended instances.  The given instance list is de-allocated.
-// This is for the MPS approach only.
+// This is for the MPS approach only.  The vertices of sub's instances
+// must be marked in parameters->coverVisits
+// (FindPotentialAnomalousAncestors).
 //******************************************************************************
 
 InstanceList *ExtendPotentialInstancesByEdgeForMPS(InstanceList *instanceList,
@@ -2056,8 +2116,8 @@ InstanceList *ExtendPotentialInstancesByEdgeForMPS(InstanceList *instanceList,
    Instance *newInstance;
    ULONG v2;
    ULONG e2;
-   Edge *edge2;
    Vertex *vertex2;
+   VisitSet *edgeVisits = parameters->edgeVisits;
    BOOLEAN overlaps = FALSE;
    BOOLEAN noExtensions = TRUE;
 
@@ -2070,13 +2130,14 @@ InstanceList *ExtendPotentialInstancesByEdgeForMPS(InstanceList *instanceList,
    while (instanceListNode != NULL)
    {
       instance = instanceListNode->instance;
-      MarkInstanceEdges(instance, g2, TRUE);
+      ClearVisitSet(edgeVisits, g2->numEdges);
+      MarkInstanceEdges(instance, edgeVisits);
       //
       // See if the instance overlaps with any of the
       // best substructure instances; if so, we can skip doing any 
       // extensions because it will never be an anomalous instance.
       //
-      overlaps = InstanceListOverlap(instance,sub->instances);
+      overlaps = InstanceVerticesMarked(instance, parameters->coverVisits);
       //
       // Need to avoid overlapping instances, HOWEVER, it is possible that with
       // the way edges are extended, plus the "used" flags, could cause
@@ -2091,8 +2152,7 @@ InstanceList *ExtendPotentialInstancesByEdgeForMPS(InstanceList *instanceList,
             vertex2 = & g2->vertices[instance->vertices[v2]];
             for (e2 = 0; e2 < vertex2->numEdges; e2++)
             {
-               edge2 = & g2->edges[vertex2->edges[e2]];
-               if (! edge2->used)
+               if (! VISITED(edgeVisits, vertex2->edges[e2]))
                {
                   // add new instance to list
                   newInstance =
@@ -2102,7 +2162,8 @@ InstanceList *ExtendPotentialInstancesByEdgeForMPS(InstanceList *instanceList,
                   // no point in adding it to the new instance list
                   if (newInstance != NULL)
                   {
-                     if (!InstanceListOverlap(newInstance,sub->instances))
+                     if (!InstanceVerticesMarked(newInstance,
+                                                 parameters->coverVisits))
                      {
                         InstanceListInsert(newInstance, newInstanceList, TRUE);
                         noExtensions = FALSE;
@@ -2125,7 +2186,6 @@ InstanceList *ExtendPotentialInstancesByEdgeForMPS(InstanceList *instanceList,
             }
          }
       }
-      MarkInstanceEdges(instance, g2, FALSE);
       instanceListNode = instanceListNode->next;
    }
    //
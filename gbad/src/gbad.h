@@ -15,6 +15,33 @@
 //                      ExtendPotentialInstancesByEdgeForMPS
 // 06/15/14  Eberle     Modified ExtendPotentialInstancesByEdge.
 // 01/02/15  Graves     Changed the return type of GP_read_graph to int.
+// 10/16/26  agent      Added canonical code fields to substructure and
+//                      hash index to substructure list
+// 10/16/26  agent      Added numThreads parameter and discovery thread pool
+// 10/16/26  agent      Added MDLGraphStats for evaluating without compression
+// 10/16/26  agent      Match heap nodes refer to a pooled search tree
+// 10/16/26  agent      Added graph adjacency array for vertex edge arrays
+// 10/16/26  agent      Moved source and GUI fields of vertices and edges to
+//                      VertexInfo and EdgeInfo side tables
+// 10/17/26  agent      Replaced used and map fields of vertices and edges
+//                      with VisitSet marks held by the caller
+// 10/17/26  agent      Added hash index to instance list
+// 10/17/26  agent      Instances carved from an InstanceArena
+// 10/17/26  agent      Added GraphReader for memory-mapped graph input
+// 10/17/26  agent      Added GP_read_graph_r and GP_error
+// 10/17/26  agent      Added binary graph file format
+// 10/17/26  agent      Added gbadlib.c library interface
+// 10/17/26  agent      Added server.c declarations for gbad -serve
+// 10/17/26  agent      Added Window and WindowSub types for windowed discovery
+// 10/17/26  agent      Added per-vertex example table and example marks
+// 10/17/26  agent      Added graph label index
+// 10/17/26  agent      Added graph edge type index
+// 10/17/26  agent      Added vertex coverage marks for instance overlap
+// 10/17/26  agent      Added SetInstanceFrequencies
+// 10/17/26  agent      Added WriteAnomFile; instances lose their used flag
+// 10/17/26  agent      Added writeAnomFiles parameter
+// 10/17/26  agent      Added ExactGraphMatch results
+// 10/17/26  agent      Added MDLGraphStats maxRowCount
 //
 //******************************************************************************
 
@@ -27,6 +54,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 
 #define GBAD_VERSION "3.3"
 
@@ -39,6 +67,15 @@
 // If set to zero, then no limit
 #define MATCH_SEARCH_THRESHOLD_EXPONENT 3.0
 
+// Results of ExactGraphMatch
+#define EXACT_MATCH_NONE  0 // graphs are not isomorphic
+#define EXACT_MATCH_FOUND 1 // graphs are isomorphic
+#define EXACT_MATCH_LIMIT 2 // search abandoned after MaximumNodes mappings
+
+// Canonical code search abandoned after this many search nodes, in which
+// case substructure equality falls back to GraphMatch
+#define CANONICAL_SEARCH_LIMIT 2000
+
 // Starting strings for input files
 #define SUB_TOKEN        "S"  // new substructure
 #define PREDEF_SUB_TOKEN "PS" // new predefined substructure
@@ -70,6 +107,7 @@
 #define MAX_UNSIGNED_LONG ULONG_MAX  // ULONG_MAX defined in limits.h
 #define VERTEX_UNMAPPED   MAX_UNSIGNED_LONG
 #define VERTEX_DELETED    MAX_UNSIGNED_LONG - 1
+#define MATCH_SEARCH_ROOT MAX_UNSIGNED_LONG // parent of first vertex map
 #define MAX_DOUBLE        DBL_MAX    // DBL_MAX from float.h
 
 // Label types
@@ -78,6 +116,13 @@
 
 // General defines
 #define LIST_SIZE_INC  100  // initial size and increment for realloc-ed lists
+#define LABEL_HASH_INIT_SIZE   256    // initial slots in label hash index
+#define LABEL_HASH_EMPTY       MAX_UNSIGNED_LONG // unused label hash slot
+#define LABEL_ARENA_BLOCK_SIZE 65536  // bytes per label string arena block
+#define SUB_HASH_INIT_SIZE     64     // initial buckets in sub list hash index
+#define INSTANCE_HASH_INIT_SIZE 64    // initial buckets in instance list index
+#define INSTANCE_ARENA_BLOCK_SIZE 1048576 // bytes per instance arena block
+#define EDGE_TYPE_NONE MAX_UNSIGNED_LONG // edge type absent from a graph
 #define TOKEN_LEN     256  // maximum length of token from input graph file
 #define FILE_NAME_LEN 512  // maximum length of file names
 #define COMMENT       '%'  // comment character for input graph file
@@ -137,12 +182,26 @@ typedef struct
    BOOLEAN used;          // flag used to mark labels at various times
 } Label;
 
+// Label string arena block: string labels are copied into contiguous
+// blocks that are never moved, so label pointers stay valid
+typedef struct _label_arena_block
+{
+   struct _label_arena_block *next; // previously filled block
+   ULONG size;                      // bytes allocated in block
+   ULONG used;                      // bytes used in block
+   char *bytes;                     // string storage
+} LabelArenaBlock;
+
 // Label list
 typedef struct 
 {
    ULONG size;      // Number of label slots currently allocated in array
    ULONG numLabels; // Number of actual labels stored in list
    Label *labels;   // Array of labels
+   ULONG hashSize;  // Number of slots in hash index (zero or power of two)
+   ULONG *hashTable; // Open-addressing index of labels; each slot holds a
+                     //   label index or LABEL_HASH_EMPTY
+   LabelArenaBlock *arena; // String label storage, current block first
 } LabelList;
 
 // Edge
@@ -152,12 +211,16 @@ typedef struct
    ULONG   vertex2;  // target vertex index into vertices array
    ULONG   label;    // index into label list of edge's label
    BOOLEAN directed; // TRUE if edge is directed
-   BOOLEAN used;     // flag for marking edge used at various times
-                     //   used flag assumed FALSE, so always reset when done
    BOOLEAN spansIncrement;   // TRUE if edge crosses a previous increment
    BOOLEAN validPath;
    BOOLEAN anomalous; // flag indicating whether or not this vertex is an anomaly
                       // will be marked when compression takes place
+} Edge;
+
+// EdgeInfo: source and GUI information of an edge, kept apart from the
+// Edge array so that matching only touches the edge topology
+typedef struct
+{
    ULONG   sourceVertex1; // original source vertex ID
    ULONG   sourceVertex2; // original target vertex ID
    ULONG   sourceExample; // original example number
@@ -165,7 +228,7 @@ typedef struct
    ULONG originalEdgeIndex;  // index needed for coloring
    COLOR color;              // edge coloring
    double anomalousValue;    // anomalous value for appropriate coloring
-} Edge;
+} EdgeInfo;
 
 // Vertex
 typedef struct 
@@ -173,19 +236,51 @@ typedef struct
    ULONG label;    // index into label list of vertex's label
    ULONG numEdges; // number of edges defined using this vertex
    ULONG *edges;   // indices into edge array of edges using this vertex
-   ULONG map;      // used to store mapping of this vertex to corresponding
-                   //   vertex in another graph
-   BOOLEAN used;   // flag for marking vertex used at various times
-                   //   used flag assumed FALSE, so always reset when done
    BOOLEAN anomalous; // flag indicating whether or not this vertex is an anomaly
                       // will be marked when compression takes place
+} Vertex;
+
+// VertexInfo: source and GUI information of a vertex, kept apart from
+// the Vertex array
+typedef struct
+{
    ULONG   sourceVertex;  // original source vertex ID
    ULONG   sourceExample; // original example number
 
    ULONG originalVertexIndex;  // index needed for coloring
    COLOR color;                // vertex coloring
    double anomalousValue;      // anomalous value for appropriate coloring
-} Vertex;
+} VertexInfo;
+
+// GraphLabelIndex: vertices of a graph grouped by label, as a counting sort
+typedef struct
+{
+   ULONG numLabels;   // one more than the largest vertex label
+   ULONG *starts;     // vertices with label l are vertices[starts[l]] up to
+                      //   vertices[starts[l + 1] - 1]
+   ULONG *vertices;   // vertex indices, increasing within each label
+} GraphLabelIndex;
+
+// GraphEdgeIndex: edges of a graph by type, i.e. by edge label,
+// directedness and the labels of the edge's vertices, with the edges of
+// each vertex grouped by type
+typedef struct
+{
+   ULONG numTypes;    // number of distinct edge types
+   ULONG *typeKeys;   // key of each type, EDGE_TYPE_KEY_LEN values: vertex1
+                      //   label, edge label, vertex2 label, directed (the
+                      //   vertex labels of undirected edges in increasing
+                      //   order)
+   ULONG *typeCounts; // number of edges of each type
+   ULONG hashSize;    // number of slots in hash index (power of two)
+   ULONG *hashTable;  // type of each slot, or EDGE_TYPE_NONE
+   ULONG *edgeTypes;  // type of each edge
+   ULONG *starts;     // edges of vertex v are edges[starts[v]] up to
+                      //   edges[starts[v + 1] - 1]
+   ULONG *edges;      // edges of each vertex, by type, then increasing
+} GraphEdgeIndex;
+
+#define EDGE_TYPE_KEY_LEN 4
 
 // Graph
 typedef struct 
@@ -194,8 +289,44 @@ typedef struct
    ULONG  numEdges;    // number of edges in graph
    Vertex *vertices;   // array of graph vertices
    Edge   *edges;      // array of graph edges
+   ULONG  *adjacency;  // vertex edge arrays, one slice per vertex; NULL if
+                       // separately allocated
+   VertexInfo *vertexInfo; // source and GUI information of each vertex;
+                           //   NULL for substructure and instance graphs
+   EdgeInfo   *edgeInfo;   // source and GUI information of each edge
+   GraphLabelIndex *labelIndex; // vertices by label, built on first use by
+                                //   GetGraphLabelIndex; NULL if not built
+   GraphEdgeIndex *edgeIndex;   // edges by type, built on first use by
+                                //   GetGraphEdgeIndex; NULL if not built
 } Graph;
 
+// VisitSet: marks on the vertices or edges of a graph, kept outside the
+// graph so that the graph itself is only read.  An index is marked when
+// its stamp equals the current epoch, so ClearVisitSet unmarks every
+// index by advancing the epoch.
+typedef struct
+{
+   ULONG size;     // number of indices the arrays hold
+   ULONG epoch;    // stamp of marked indices; never zero
+   ULONG *stamps;  // epoch in which each index was last marked
+   ULONG *values;  // value stored per index, e.g. mapping of a vertex to
+                   //   the corresponding vertex in another graph
+} VisitSet;
+
+#define VISITED(set, i) ((set)->stamps[i] == (set)->epoch)
+#define VISIT(set, i)   ((set)->stamps[i] = (set)->epoch)
+#define UNVISIT(set, i) ((set)->stamps[i] = 0)
+
+// MDLGraphStats: per-vertex MDL terms of a graph, used to evaluate
+// substructures without compressing the graph
+typedef struct
+{
+   ULONG *rowCount;  // NumUniqueEdges of each vertex
+   ULONG *maxEdges;  // MaxEdgesToSingleVertex of each vertex
+   ULONG maxDegree;  // largest numEdges of a vertex
+   ULONG maxRowCount; // largest rowCount of a vertex
+} MDLGraphStats;
+
 // VertexMap: vertex to vertex mapping for graph match search
 typedef struct 
 {
@@ -220,8 +351,6 @@ typedef struct _instance
    VertexMap *mapping;  // instance mapped to substructure definition
    ULONG mappingIndex1; // index of source vertex of latest mapping
    ULONG mappingIndex2; // index of target vertex of latest mapping
-   BOOLEAN used;        // flag indicating instance already associated
-                        // with a substructure (for the current iteration)
    struct _instance *parentInstance;  // pointer to parent instance
    double infoAnomalousValue;  // information theoretic anomalousness value
    double probAnomalousValue;  // probabilistic anomalousness value
@@ -233,19 +362,50 @@ typedef struct _instance
    ULONG *anomalousEdges;      // indices of instance's edgs that are anomalous
    ULONG frequency;     // frequency of this type of instance
    BOOLEAN matched;     // flag to indicate if instance has already matched
+   struct _instance_arena *arena; // arena instance was carved from
+   ULONG arenaWords;    // size of instance and its arrays in the arena,
+                        //    in ULONGs
 } Instance;
 
+// Instance arena block: instances and their arrays are carved from
+// contiguous blocks, one piece per instance
+typedef struct _instance_arena_block
+{
+   struct _instance_arena_block *next; // previously filled block
+   ULONG size;                         // bytes allocated in block
+   ULONG used;                         // bytes used in block
+   char *bytes;                        // instance storage
+} InstanceArenaBlock;
+
+// InstanceArena: storage for the instances of one iteration; freed
+// instances are reused, and all blocks are released at once
+typedef struct _instance_arena
+{
+   InstanceArenaBlock *blocks; // instance storage, current block first
+   ULONG numFreeLists;         // number of free list heads
+   Instance **freeLists;       // freed instances by arenaWords, chained
+                               //    through parentInstance
+   BOOLEAN shared;             // TRUE if used by several threads
+   pthread_mutex_t lock;       // guards arena if shared
+} InstanceArena;
+
 // InstanceListNode: node in singly-linked list of instances
 typedef struct _instance_list_node 
 {
    Instance *instance;
    struct _instance_list_node *next;
+   ULONG hash;                           // InstanceHash of instance
+   struct _instance_list_node *hashNext; // next node in same index bucket
 } InstanceListNode;
 
 // InstanceList: singly-linked list of instances
 typedef struct 
 {
    InstanceListNode *head;
+   ULONG hashSize;   // number of buckets in hash index (zero if not built)
+   ULONG numHashed;  // number of nodes in hash index
+   InstanceListNode **hashTable; // index of nodes by InstanceHash, built on
+                                 //   first unique insert
 } InstanceList;
 
 // Substructure
@@ -260,6 +420,11 @@ typedef struct _substructure
    double posIncrementValue;   // DL/#Egs value of sub for positive increment
    ULONG  numParentInstances;  // number of positive parent instances
    InstanceList *parentInstances;  // instances in positive parent substructure
+   BOOLEAN canonicalDone;      // TRUE if canonical fields below computed
+   ULONG  canonicalHash;       // isomorphism-invariant hash of definition
+   ULONG  canonicalCodeLength; // length of canonical code
+   ULONG  *canonicalCode;      // canonical code of definition; NULL if
+                               //   search limit reached
 } Substructure;
 
 // SubListNode: node in singly-linked list of substructures
@@ -267,20 +432,61 @@ typedef struct _sub_list_node
 {
    Substructure *sub;
    struct _sub_list_node *next;
+   struct _sub_list_node *hashNext; // next node in same hash index bucket
 } SubListNode;
 
 // SubList: singly-linked list of substructures
 typedef struct 
 {
    SubListNode *head;
+   ULONG hashSize;   // number of buckets in hash index (zero or power of two)
+   ULONG numHashed;  // number of nodes in hash index
+   SubListNode **hashTable; // index of nodes by sub's canonical hash
 } SubList;
 
+// CanonicalSearch: state of canonical code search for one graph
+typedef struct
+{
+   Graph *graph;           // graph being encoded
+   ULONG *incidenceStart;  // start of each vertex's triples in incidence
+   ULONG *incidence;       // (direction class, edge label, neighbor) triples
+   ULONG *signatures;      // incidence triples with neighbor colors, sorted
+   ULONG *colors;          // vertex coloring for each search depth
+   ULONG *order;           // vertices sorted by refined color
+   ULONG *scratch;         // temporary per-vertex values
+   ULONG *edgeTuples;      // sorted edge tuples under a coloring
+   ULONG *code;            // code of current leaf
+   ULONG *bestCode;        // least code found so far
+   ULONG codeLength;       // length of every code for this graph
+   ULONG numNodes;         // search nodes visited
+   ULONG rootHash;         // hash of refined root coloring
+   BOOLEAN haveBest;       // TRUE once bestCode holds a code
+   BOOLEAN aborted;        // TRUE if CANONICAL_SEARCH_LIMIT reached
+} CanonicalSearch;
+
+// MatchSearchNode: one vertex map in the graph match search tree; the
+// full mapping of a search node is found by following parent links
+typedef struct
+{
+   ULONG parent; // index of parent search node, or MATCH_SEARCH_ROOT
+   ULONG v1;
+   ULONG v2;     // search node adds v1 -> v2 to its parent's mapping
+} MatchSearchNode;
+
+// MatchSearchTree: pool of search nodes for one graph match
+typedef struct
+{
+   ULONG size;      // number of search nodes allocated in memory
+   ULONG numNodes;  // number of search nodes in tree
+   MatchSearchNode *nodes;
+} MatchSearchTree;
+
 // MatchHeapNode: node in heap for graph match search queue
 typedef struct 
 {
    ULONG  depth; // depth of node in search space (number of vertices mapped)
    double cost;  // cost of mapping
-   VertexMap *mapping;
+   ULONG searchNode; // last vertex map of mapping in search tree
 } MatchHeapNode;
 
 // MatchHeap: heap of match nodes
@@ -372,6 +578,11 @@ typedef struct _increment
    ULONG startPosVertexIndex;  // Index of the first vertex in this increment
    ULONG startPosEdgeIndex;    // Index of the first edge in this increment
    double numPosEgs;           // Number of pos examples in this increment
+   Graph *graph;               // Graph of the increment (windowed discovery)
+   MDLGraphStats *graphStats;  // MDL terms of graph, if EVAL_MDL
+   ULONG numLabels;            // Labels known when the increment was added
+   double graphSize;           // size(graph), as EvaluateSub computes it
+   double graphSubSize;        // size(graph) with the "SUB" label added
 } Increment;
 
 typedef struct _increment_list_node
@@ -385,6 +596,36 @@ typedef struct
    IncrementListNode *head;
 } IncrementList;
 
+// WindowSub: substructure tracked over the increments of a window.  The
+// arrays are indexed by window slot, incrementNum modulo the window size.
+typedef struct _window_sub
+{
+   Substructure *sub;       // definition, and numInstances, numExamples and
+                            //   value over the whole window
+   ULONG *numInstances;     // instances in the increment of each slot
+   double *savings;         // size(G) - size(G|S) of each slot's increment
+   double totalSavings;     // sum of savings
+   struct _window_sub *next;
+} WindowSub;
+
+// Window: state of windowed discovery, whose increments (one positive
+// example each, oldest first) are kept in parameters->incrementList
+typedef struct
+{
+   ULONG size;                      // most increments in the window
+   ULONG numIncrements;             // increments now in the window
+   ULONG nextIncrementNum;          // incrementNum of the next increment
+   ULONG nextVertexIndex;           // startPosVertexIndex of the next one
+   ULONG nextEdgeIndex;             // startPosEdgeIndex of the next one
+   ULONG numVertices;               // vertices of increments in window
+   ULONG numEdges;                  // edges of increments in window
+   double graphSize;                // sum of increments' graphSize
+   double graphSubSize;             // sum of increments' graphSubSize
+   IncrementListNode *lastIncrement; // newest increment
+   WindowSub *subs;                 // substructures tracked
+   ULONG numSubs;                   // number of substructures tracked
+} Window;
+
 // Parameters: parameters used throughout GBAD system
 typedef struct 
 {
@@ -393,8 +634,17 @@ typedef struct
    char outFileName[FILE_NAME_LEN];     // file for machine-readable output
    Graph *posGraph;      // Graph of positive examples
    double posGraphDL;    // Description length of positive input graph
+   MDLGraphStats *posGraphStats; // MDL terms of posGraph during discovery
+   VisitSet *vertexVisits; // marks on vertices of the graph being processed
+   VisitSet *edgeVisits;   // marks on edges of the graph being processed
+   InstanceArena *instanceArena; // storage for instances of an iteration
    ULONG numPosEgs;      // Number of positive examples
    ULONG *posEgsVertexIndices; // vertex indices of where positive egs begin
+   ULONG *posVertexExamples; // example (from 0) of each posGraph vertex, kept
+                             //   through compression; NULL if numPosEgs <= 1
+   VisitSet *exampleVisits;  // marks on positive examples covered
+   VisitSet *coverVisits;    // marks on vertices claimed by the instances of
+                             //   the substructure being collected or checked
    LabelList *labelList; // List of unique labels in input graph(s)
    Graph **preSubs;      // Array of predefined substructure graphs
    ULONG numPreSubs;     // Number of predefined substructures read in
@@ -434,6 +684,8 @@ typedef struct
    ULONG posGraphSize;
    BOOLEAN mdl;          // Anomaly Detection method: Information Theoretic
    BOOLEAN prob;         // Anomaly Detection method: Probabilistic
+   BOOLEAN writeAnomFiles; // If TRUE, GBAD-P writes each iteration's vertex
+                           // mapping to <inputFileName>.anom<iteration>
    BOOLEAN mps;          // Anomaly Detection method: Max Partial Substructure
    double mdlThreshold;  // Information Theoretic (MDL) threshold
    double mpsThreshold;  // Maximum Partial Substructure (MPS) threshold
@@ -456,13 +708,56 @@ typedef struct
    BOOLEAN dotToFile;    // TRUE if file given for dot file output
    BOOLEAN optimize;     // user option to skip certain processing and assume 
                          // solution is near
+   BOOLEAN perExample;   // If TRUE, discover substructures separately in
+                         // each positive example (batch mode)
+   ULONG numThreads;     // number of threads extending parent substructures
+   ULONG windowSize;     // If > 0, discover substructures in a window of
+                         // this many positive examples, sliding one at a time
+   Window *window;       // state of windowed discovery, or NULL
 } Parameters;
 
+// DiscoverThread: state of one worker thread in DiscoverSubs
+typedef struct
+{
+   Parameters parameters; // private copy with private visit sets and
+                          //   log2Factorial cache
+   pthread_t thread;
+   struct _discover_threads *pool; // pool this thread belongs to
+} DiscoverThread;
+
+// DiscoverThreads: pool of worker threads extending parent substructures
+typedef struct _discover_threads
+{
+   ULONG numThreads;
+   DiscoverThread *threads;
+   Substructure **parentSubs;   // parents to extend at this level (NULL
+                                //   if not extended)
+   SubList **extendedSubLists;  // extensions of each parent
+   ULONG numParents;            // length of parentSubs
+   ULONG nextParent;            // next parent to be claimed by a thread
+   pthread_mutex_t lock;        // guards nextParent
+} DiscoverThreads;
+
 
 //******************************************************************************
 // Function Prototypes
 //******************************************************************************
 
+// canonical.c
+
+void ComputeSubCanonicalCode(Substructure *);
+BOOLEAN SubsMatch(Substructure *, Substructure *, LabelList *);
+BOOLEAN CanonicalCodesEqual(ULONG *, ULONG, ULONG *, ULONG);
+ULONG *CanonicalCode(Graph *, ULONG *, ULONG *);
+void CanonicalSearchNode(CanonicalSearch *, ULONG);
+BOOLEAN CanonicalTwins(CanonicalSearch *, ULONG, ULONG);
+ULONG RefineColors(CanonicalSearch *, ULONG *);
+int CompareTriples(ULONG *, ULONG, ULONG, ULONG);
+int CompareCanonicalVertices(CanonicalSearch *, ULONG *, ULONG, ULONG);
+void BuildEdgeTuples(CanonicalSearch *, ULONG *);
+void CanonicalLeaf(CanonicalSearch *, ULONG *);
+ULONG CanonicalColoringHash(CanonicalSearch *, ULONG *);
+
 // compress.c
 
 Graph *CompressGraph(Graph *, InstanceList *, Parameters *);
@@ -471,19 +766,23 @@ Graph *CompressGraph(Graph *, InstanceList *, Parameters *);
 //
 void AddOverlapEdges(Graph *, Graph *, InstanceList *, ULONG, ULONG, ULONG,
                      Parameters *);
-Edge *AddOverlapEdge(Edge *, ULONG *, ULONG, ULONG, ULONG, Parameters *);
-Edge *AddDuplicateEdges(Edge *, ULONG *, Edge *, Graph *, ULONG, ULONG,
+Edge *AddOverlapEdge(Edge *, EdgeInfo **, ULONG *, ULONG, ULONG, ULONG,
                      Parameters *);
+Edge *AddDuplicateEdges(Edge *, EdgeInfo **, ULONG *, ULONG, Graph *, ULONG,
+                        ULONG, Parameters *);
+Edge *GrowOverlapEdges(Edge *, EdgeInfo **, ULONG);
 ULONG NumOverlapEdges(Graph *, InstanceList *, Parameters *);
 //
 // GBAD
 //
 void CompressFinalGraphs(Substructure *, Parameters *, ULONG, BOOLEAN);
+void CompressVertexExamples(InstanceList *, Graph *, Graph *, Parameters *);
 void CompressLabelListWithGraph(LabelList *, Graph *, Parameters *);
 ULONG SizeOfCompressedGraph(Graph *, InstanceList *, Parameters *, ULONG);
 void RemovePosEgsCovered(Substructure *, Parameters *);
-void MarkExample(ULONG, ULONG, Graph *, BOOLEAN);
+void MarkExample(ULONG, ULONG, Graph *, VisitSet *, VisitSet *);
 void CopyUnmarkedGraph(Graph *, Graph *, ULONG, Parameters *);
+void WriteAnomFile(Graph *, VisitSet *, ULONG, Parameters *);
 void CompressWithPredefinedSubs(Parameters *);
 void WriteCompressedGraphToFile(Substructure *sub, Parameters *parameters,
                                 ULONG iteration);
@@ -496,6 +795,11 @@ void color_subs(Parameters *, SubList *);
 SubList *DiscoverSubs(Parameters *, ULONG);     // GBAD-P  change in parameters
 SubList *GetInitialSubs(Parameters *);
 BOOLEAN SinglePreviousSub(Substructure *, Parameters *);
+BOOLEAN SubToBeExtended(Substructure *, Parameters *);
+DiscoverThreads *AllocateDiscoverThreads(Parameters *);
+void FreeDiscoverThreads(DiscoverThreads *);
+SubList **ExtendSubsInParallel(SubList *, ULONG, DiscoverThreads *);
+void *ExtendSubsThread(void *);
 
 // dot.c
 char *get_color(COLOR);
@@ -509,15 +813,23 @@ void WriteEdgeToDotFile(FILE *, ULONG, ULONG, Graph *, LabelList *, char *);
 // evaluate.c
 
 void EvaluateSub(Substructure *, Parameters *);
+double CompressedPosGraphSize(Substructure *, ULONG, Parameters *);
 ULONG GraphSize(Graph *);
 double MDL(Graph *, ULONG, Parameters *);
-ULONG NumUniqueEdges(Graph *, ULONG);
+ULONG NumUniqueEdges(Graph *, ULONG, VisitSet *);
 ULONG MaxEdgesToSingleVertex(Graph *, ULONG);
 double ExternalEdgeBits(Graph *, Graph *, ULONG);
+MDLGraphStats *AllocateMDLGraphStats(Graph *, VisitSet *);
+void FreeMDLGraphStats(MDLGraphStats *);
+BOOLEAN CompressedGraphDL(Substructure *, ULONG, Parameters *, double *);
+ULONG CompressedVertexKey(VisitSet *, ULONG, ULONG);
+void CompressedRowStats(Graph *, VisitSet *, ULONG, ULONG *, ULONG, ULONG,
+                        ULONG *, ULONG *, ULONG *);
+ULONG SortUniqueULONGs(ULONG *, ULONG);
 double Log2Factorial(ULONG, Parameters *);
 double Log2(ULONG);
 ULONG PosExamplesCovered(Substructure *, Parameters *);
-ULONG ExamplesCovered(InstanceList *, Graph *, ULONG, ULONG *, ULONG);
+ULONG ExamplesCovered(InstanceList *, ULONG, ULONG *, VisitSet *);
 
 // extend.c
 
@@ -529,6 +841,9 @@ Instance *CreateExtendedInstance(Instance *, ULONG, ULONG, Graph *, BOOLEAN);
 Substructure *CreateSubFromInstance(Instance *, Graph *);
 void AddPosInstancesToSub(Substructure *, Instance *, InstanceList *, 
                           Parameters *, ULONG);
+void GroupInstancesIntoSubs(InstanceList *, SubList *, Parameters *);
+void AddGroupInstancesToSub(Substructure *, Instance **, ULONG *, ULONG,
+                            Parameters *);
 
 // gbad.c
 
@@ -536,8 +851,8 @@ void PrintProbabilisticAnomalies(InstanceList *, Parameters *);
 void RemoveSimilarSubstructures(SubList *, Parameters *);
 void FlagAnomalousVerticesAndEdges(InstanceList *,Graph *,Substructure *,
                                    Parameters *);
-void StoreAnomalousEdge(Edge *, ULONG, ULONG, ULONG, ULONG, BOOLEAN, BOOLEAN, 
-                        BOOLEAN, ULONG, ULONG, ULONG);
+void StoreAnomalousEdge(Edge *, EdgeInfo *, ULONG, ULONG, ULONG, ULONG,
+                        BOOLEAN, BOOLEAN, BOOLEAN, ULONG, ULONG, ULONG);
 void SetExampleNumber(SubList *, Parameters *);
 void PrintAnomalousVertex(Graph *, ULONG, LabelList *, Instance *, 
                           Parameters *);
@@ -552,6 +867,7 @@ InstanceList *ExtendPotentialInstancesByEdgeForMPS(InstanceList *, Graph *,
                                                    Edge *, Graph *, 
                                                    Substructure *, 
                                                    Parameters *);
+void SetInstanceFrequencies(InstanceList *, Parameters *);
 void ScoreAndPrintAnomalousInstances(InstanceList *, Substructure *, 
                                      Parameters *);
 void ScoreAndPrintAnomalousAncestors(InstanceList *, Substructure *, 
@@ -565,35 +881,60 @@ Substructure *GBAD_P(SubList *, ULONG, Parameters *);
 BOOLEAN GraphMatch(Graph *, Graph *, LabelList *, double, double *,
                    VertexMap *);
 double InexactGraphMatch(Graph *, Graph *, LabelList *, double, VertexMap *);
+ULONG ExactGraphMatch(Graph *, Graph *, VertexMap *);
+void ExactMatchOrder(Graph *, ULONG *, ULONG *, ULONG *);
+BOOLEAN ExactMatchFeasible(Graph *, Graph *, ULONG, ULONG, ULONG *, ULONG *,
+                           VisitSet *);
+double MatchCostLowerBound(Graph *, Graph *);
+ULONG CommonValues(ULONG *, ULONG, ULONG *, ULONG);
 void OrderVerticesByDegree(Graph *, ULONG *);
 ULONG MaximumNodes(ULONG);
-double DeletedEdgesCost(Graph *, Graph *, ULONG, ULONG, ULONG *, LabelList *);
-double InsertedEdgesCost(Graph *, ULONG, ULONG *);
+double DeletedEdgesCost(Graph *, Graph *, ULONG, ULONG, ULONG *, LabelList *,
+                        VisitSet *);
+double InsertedEdgesCost(Graph *, ULONG, ULONG *, VisitSet *);
 double InsertedVerticesCost(Graph *, ULONG *);
 MatchHeap *AllocateMatchHeap(ULONG);
-VertexMap *AllocateNewMapping(ULONG, VertexMap *, ULONG, ULONG);
+MatchSearchTree *AllocateMatchSearchTree(ULONG);
+ULONG AddMatchSearchNode(MatchSearchTree *, ULONG, ULONG, ULONG);
+void GetMatchSearchMapping(MatchSearchTree *, ULONG, ULONG, VertexMap *);
+void FreeMatchSearchTree(MatchSearchTree *);
 void InsertMatchHeapNode(MatchHeapNode *, MatchHeap *);
 void ExtractMatchHeapNode(MatchHeap *, MatchHeapNode *);
 void HeapifyMatchHeap(MatchHeap *);
 BOOLEAN MatchHeapEmpty(MatchHeap *);
 void MergeMatchHeaps(MatchHeap *, MatchHeap *);
 void CompressMatchHeap(MatchHeap *, ULONG);
-void PrintMatchHeapNode(MatchHeapNode *);
-void PrintMatchHeap(MatchHeap *);
+void PrintMatchHeapNode(MatchHeapNode *, MatchSearchTree *);
+void PrintMatchHeap(MatchHeap *, MatchSearchTree *);
 void ClearMatchHeap(MatchHeap *);
 void FreeMatchHeap(MatchHeap *);
 
 // graphops.c
 
 void ReadInputFile(Parameters *);
+void CopyOriginalGraph(Parameters *);
 ULONG *AddVertexIndex(ULONG *, ULONG, ULONG);
 void ReadPredefinedSubsFile(Parameters *);
 void AddVertex(Graph *, ULONG, ULONG *, ULONG);
 void AddEdge(Graph *, ULONG, ULONG, BOOLEAN, ULONG, ULONG *, BOOLEAN);
 void StoreEdge(Edge *, ULONG, ULONG, ULONG, ULONG, BOOLEAN, BOOLEAN);
-void AddEdgeToVertices(Graph *, ULONG);
+void BuildGraphAdjacency(Graph *);
+GraphLabelIndex *GetGraphLabelIndex(Graph *);
+void FreeGraphLabelIndex(Graph *);
+GraphEdgeIndex *GetGraphEdgeIndex(Graph *);
+void FreeGraphEdgeIndex(Graph *);
+void EdgeTypeKey(Graph *, Edge *, ULONG *);
+ULONG EdgeTypeHash(ULONG *);
+ULONG FindEdgeType(GraphEdgeIndex *, ULONG *);
+ULONG VertexEdgesOfType(GraphEdgeIndex *, ULONG, ULONG, ULONG **);
+VisitSet *AllocateVisitSet(ULONG);
+void ClearVisitSet(VisitSet *, ULONG);
+void FreeVisitSet(VisitSet *);
 Graph *AllocateGraph(ULONG, ULONG);
+void AllocateGraphInfo(Graph *);
 Graph *CopyGraph(Graph *);
+Graph *CopyExampleGraph(Graph *, ULONG, ULONG);
+void SetPosVertexExamples(Parameters *);
 void FreeGraph(Graph *);
 void PrintGraph(Graph *, LabelList *);
 void PrintVertex(Graph *, ULONG, LabelList *);
@@ -606,7 +947,13 @@ void WriteSubGraphToFile(FILE *, SubList *, Parameters *, BOOLEAN);
 
 LabelList *AllocateLabelList(void);
 ULONG StoreLabel(Label *, LabelList *);
+ULONG StoreStringLabel(char *, ULONG, LabelList *);
+ULONG AppendLabel(Label *, LabelList *);
 ULONG GetLabelIndex(Label *, LabelList *);
+ULONG LabelHash(Label *);
+ULONG StringLabelHash(char *, ULONG);
+void GrowLabelHashTable(LabelList *);
+char *LabelArenaCopy(char *, ULONG, LabelList *);
 ULONG SubLabelNumber(ULONG, LabelList *);
 double LabelMatchFactor(ULONG, ULONG, LabelList *);
 void PrintLabel(ULONG, LabelList *);
@@ -617,6 +964,7 @@ void WriteLabelToFile(FILE *, ULONG, LabelList *, BOOLEAN);
 // sgiso.c
 
 InstanceList *FindInstances(Graph *, Graph *, Parameters *);
+BOOLEAN EdgeTypesPresent(Graph *, Graph *);
 InstanceList *FindSingleVertexInstances(Graph *, Vertex *, Parameters *);
 InstanceList *ExtendInstancesByEdge(InstanceList *, Graph *, Edge *,
                                     Graph *, Parameters *);
@@ -634,18 +982,24 @@ void FreeSubListNode(SubListNode *);
 SubList *AllocateSubList(void);
 void SubListInsert(Substructure *, SubList *, ULONG, BOOLEAN, LabelList *);
 BOOLEAN MemberOfSubList(Substructure *, SubList *, LabelList *);
+SubListNode *FindSubInSubList(Substructure *, SubList *, BOOLEAN, LabelList *);
+void SubListIndexInsert(SubListNode *, SubList *);
+void SubListIndexRemove(SubListNode *, SubList *);
 void FreeSubList(SubList *);
 void PrintSubList(SubList *, Parameters *);
 void PrintNewBestSub(Substructure *, SubList *, Parameters *);
 ULONG CountSubs(SubList *);
-Instance *AllocateInstance(ULONG, ULONG);
+Instance *AllocateInstance(ULONG, ULONG, InstanceArena *);
 void FreeInstance(Instance *);
+InstanceArena *AllocateInstanceArena(BOOLEAN);
+void ResetInstanceArena(InstanceArena *);
+void FreeInstanceArena(InstanceArena *);
 void PrintInstance(Instance *, Graph *, LabelList *);
 void PrintInstanceList(InstanceList *, Graph *, LabelList *);
 void PrintPosInstanceList(Substructure *, Parameters *);
 //
-void MarkInstanceVertices(Instance *, Graph *, BOOLEAN);
-void MarkInstanceEdges(Instance *, Graph *, BOOLEAN);
+void MarkInstanceVertices(Instance *, VisitSet *);
+void MarkInstanceEdges(Instance *, VisitSet *);
 InstanceListNode *AllocateInstanceListNode(Instance *);
 void FreeInstanceListNode(InstanceListNode *);
 InstanceList *AllocateInstanceList(void);
@@ -653,21 +1007,24 @@ void FreeInstanceList(InstanceList *);
 ULONG InstanceExampleNumber(Instance *, ULONG *, ULONG);
 ULONG CountInstances(InstanceList *);
 void InstanceListInsert(Instance *, InstanceList *, BOOLEAN);
+void InstanceListIndexInsert(InstanceListNode *, InstanceList *);
 BOOLEAN MemberOfInstanceList(Instance *, InstanceList *);
+ULONG InstanceHash(Instance *);
 BOOLEAN InstanceMatch(Instance *, Instance *);
 BOOLEAN InstanceOverlap(Instance *, Instance *);
 BOOLEAN InstanceListOverlap(Instance *, InstanceList *);
-BOOLEAN InstancesOverlap(InstanceList *);
+BOOLEAN InstancesOverlap(InstanceList *, VisitSet *, ULONG);
+void MarkInstanceListVertices(InstanceList *, VisitSet *, ULONG);
+BOOLEAN InstanceVerticesMarked(Instance *, VisitSet *);
 Graph *InstanceToGraph(Instance *, Graph *);
 BOOLEAN InstanceContainsVertex(Instance *, ULONG);
-void AddInstanceToInstance(Instance *, Instance *);
-void AddEdgeToInstance(ULONG, Edge *, Instance *);
 void UpdateMapping(Instance *, Instance *);
 
 // utility.c
 
 void OutOfMemoryError(char *);
 void PrintBoolean(BOOLEAN);
+void SortULONGs(ULONG *, ULONG);
 Substructure * CopySub(Substructure *);
 
 
@@ -697,4 +1054,169 @@ typedef struct graph_info_t
 
 int GP_read_graph(Graph_Info *, char *);
 
+//******************************************************************************
+// graphread.c
+
+#define GP_ERROR_LEN 128  // maximum length of graph input error messages
+
+// GP_error: error found by GP_read_graph_r
+typedef struct
+{
+   ULONG lineNo;                // line of input file, or 0 if none
+   char message[GP_ERROR_LEN];  // description of error
+} GP_error;
+
+// Tokens of the graph input format, as read by ReadMappedGraph
+#define GRAPH_TOKEN_END     0  // end of input
+#define GRAPH_TOKEN_XP      1  // XP or xp
+#define GRAPH_TOKEN_PS      2  // PS or ps
+#define GRAPH_TOKEN_HASH    3  // #
+#define GRAPH_TOKEN_VERTEX  4  // v or V
+#define GRAPH_TOKEN_E_EDGE  5  // e or E
+#define GRAPH_TOKEN_D_EDGE  6  // d or D
+#define GRAPH_TOKEN_U_EDGE  7  // u or U
+#define GRAPH_TOKEN_INT     8  // digits
+#define GRAPH_TOKEN_FLOAT   9  // digits, if any, then a point and digits
+#define GRAPH_TOKEN_STRING 10  // double- or single-quoted string
+
+// GraphReader: state of ReadMappedGraph over an input file held in memory
+typedef struct
+{
+   char *buffer;       // contents of input file
+   ULONG length;       // number of characters in buffer
+   ULONG position;     // index in buffer of next character to scan
+   ULONG lineNo;       // line number of next character to scan
+   int token;          // current token (GRAPH_TOKEN_*)
+   ULONG tokenLineNo;  // line number where current token starts
+   char *tokenText;    // current token's characters in buffer (a string
+                       //   token includes its quotes)
+   ULONG tokenLength;  // number of characters in current token
+   int intValue;       // value of INT token
+   double floatValue;  // value of FLOAT token
+   GP_error *error;    // where to report an error
+} GraphReader;
+
+int GP_read_graph_r(Graph_Info *, const char *, GP_error *);
+int ReadGraphDescriptor(Graph_Info *, int, GP_error *);
+int ReadMappedGraph(Graph_Info *, char *, ULONG, GP_error *);
+int NextGraphToken(GraphReader *);
+int ReadGraphElement(GraphReader *, Graph_Info *);
+int ReadGraphLabel(GraphReader *, Graph_Info *, ULONG *);
+int GraphReaderError(GraphReader *, char *);
+
+//******************************************************************************
+// graphbin.c
+
+// Binary graph files, written by graph2bin.  A file holds, in order, a
+// GraphFileHeader, the label table (GraphFileLabel's), the vertex index
+// at which each example starts, the label of each vertex, the start of
+// each vertex's edge indices in the adjacency array (one more than the
+// number of vertices), the adjacency array, the edges (GraphFileEdge's),
+// and the null-terminated strings of the string labels.  All numbers
+// are stored in the native byte order and width of the writer.
+#define GRAPH_BINARY_MAGIC      "GBADBIN"   // first 8 bytes, with the null
+#define GRAPH_BINARY_VERSION    1
+#define GRAPH_BINARY_BYTE_ORDER 0x01020304  // byteOrder as written
+
+typedef struct
+{
+   char  magic[8];      // GRAPH_BINARY_MAGIC
+   ULONG byteOrder;     // GRAPH_BINARY_BYTE_ORDER
+   ULONG ulongSize;     // sizeof(ULONG) of the writer
+   ULONG version;       // GRAPH_BINARY_VERSION
+   ULONG numLabels;     // number of labels in label table
+   ULONG stringBytes;   // number of bytes of label strings
+   ULONG numExamples;   // number of positive examples
+   ULONG numVertices;   // number of vertices in graph
+   ULONG numEdges;      // number of edges in graph
+   ULONG numAdjacency;  // number of entries in adjacency array
+} GraphFileHeader;
+
+typedef struct
+{
+   ULONG labelType;     // STRING_LABEL or NUMERIC_LABEL
+   ULONG offset;        // offset of string in label strings
+   ULONG length;        // length of string, not counting the null
+   double numericLabel; // value of numeric label
+} GraphFileLabel;
+
+typedef struct
+{
+   ULONG vertex1;       // source vertex index
+   ULONG vertex2;       // target vertex index
+   ULONG label;         // index into label table of edge's label
+   ULONG directed;      // 1 if edge is directed, else 0
+} GraphFileEdge;
+
+BOOLEAN BinaryGraphFile(char *);
+int ReadBinaryGraph(Graph_Info *, const char *, GP_error *);
+int ReadMappedBinaryGraph(Graph_Info *, char *, ULONG, GP_error *);
+void WriteBinaryGraph(char *, Graph *, LabelList *, ULONG, ULONG *);
+int BinaryGraphError(GP_error *, char *);
+
+//******************************************************************************
+// gbadlib.c
+
+#define GBAD_MESSAGE_LEN 512  // room for GBAD_SetOption's error messages
+
+Parameters *GBAD_AllocateParameters(void);
+int GBAD_SetOption(Parameters *, int, char **, int, char *);
+int MissingOptionValue(char *, char *);
+int GBAD_SetGraph(Parameters *, ULONG, char **, ULONG, ULONG *, ULONG *,
+                  char **, BOOLEAN *, ULONG, ULONG *, GP_error *);
+int GBAD_ReadGraph(Parameters *, char *, ULONG, GP_error *);
+int SetGraphError(GP_error *, char *);
+ULONG ExampleOfVertex(ULONG *, ULONG, ULONG);
+char *GBAD_PrepareParameters(Parameters *);
+SubList *GBAD_DiscoverIteration(Parameters *, Substructure **);
+BOOLEAN GBAD_CompressIteration(Parameters *, SubList *, Substructure *);
+void GBAD_EndIteration(Parameters *, SubList *);
+Substructure *GBAD_Sub(SubList *, ULONG);
+double GBAD_VertexAnomalousValue(Parameters *, ULONG);
+double GBAD_EdgeAnomalousValue(Parameters *, ULONG);
+void GBAD_FreeParameters(Parameters *);
+
+//******************************************************************************
+// server.c
+
+#define SERVER_WORKERS     4             // default number of worker threads
+#define SERVER_BACKLOG     16            // pending connections
+#define SERVER_MAX_OPTIONS 65536         // longest option overrides
+#define SERVER_MAX_GRAPH   (1UL << 30)   // longest graph of a request
+
+// ServerInfo: state of gbad -serve shared by its worker threads
+typedef struct
+{
+   int listenFd;   // listening Unix-domain socket
+   int argc;       // number of default options
+   char **argv;    // default options of every request
+} ServerInfo;
+
+int ServeGraphs(int, char **);
+void *ServerWorker(void *);
+void ServeConnection(ServerInfo *, int);
+BOOLEAN ReadServerRequest(int, char **, char **, ULONG *);
+BOOLEAN ServeRequest(ServerInfo *, int, char *, char *, ULONG);
+BOOLEAN SetServerOptions(Parameters *, int, char **, char *);
+BOOLEAN WriteServerFrame(int, char *, ULONG);
+BOOLEAN WriteServerError(int, char *);
+BOOLEAN ReadFully(int, char *, ULONG);
+BOOLEAN WriteFully(int, char *, ULONG);
+
+// window.c
+
+Window *AllocateWindow(ULONG);
+void FreeWindow(Window *, IncrementList *);
+void WindowAddExample(Graph *, Parameters *);
+Increment *AllocateWindowIncrement(Graph *, Parameters *);
+void FreeWindowIncrement(Increment *);
+void RetireIncrement(Parameters *);
+WindowSub *FindWindowSub(Substructure *, Window *, Parameters *);
+WindowSub *AddWindowSub(Substructure *, Parameters *);
+void FreeWindowSub(WindowSub *);
+void SearchIncrement(WindowSub *, Increment *, Parameters *);
+void RemoveEmptyWindowSubs(Window *);
+void EvaluateWindowSubs(Parameters *);
+SubList *WindowBestSubs(Parameters *);
+
 #endif
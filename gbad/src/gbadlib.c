@@ -0,0 +1,1015 @@
+//******************************************************************************
+// gbadlib.c
+//
+// GBAD library interface, used by main.c and by programs that link
+// libgbad.so to run discovery and anomaly detection in-process.  A caller
+// allocates a Parameters structure, changes any settings from their
+// defaults (GBAD_SetOption), gives it a graph (GBAD_SetGraph,
+// GBAD_ReadGraph or ReadInputFile), calls GBAD_PrepareParameters, and
+// then runs one iteration at a time:
+//
+//    subList = GBAD_DiscoverIteration(parameters, & normSub);
+//    ... read subList and the anomalous values ...
+//    more = GBAD_CompressIteration(parameters, subList, normSub);
+//    GBAD_EndIteration(parameters, subList);
+//
+// Nothing here reads or writes files (GBAD-P's vertex mapping files are
+// written only if parameters->writeAnomFiles is set), and separate
+// Parameters structures share no state, so graphs may be processed
+// concurrently in one process.
+//
+// Date      Name       Description
+// ========  =========  ========================================================
+// 10/17/26  agent      Initial version, taken from main.c
+// 10/17/26  agent      Added GBAD_SetOption, taken from main.c, and
+//                      GBAD_ReadGraph, for gbad's server mode.
+// 10/17/26  agent      Added -window option for windowed discovery
+// 10/17/26  agent      Allocate and free vertex coverage marks
+// 10/17/26  agent      GBAD-P vertex mapping files off by default
+//
+//******************************************************************************
+
+#include "gbad.h"
+
+
+//******************************************************************************
+// NAME: GBAD_AllocateParameters
+//
+// INPUTS: (void)
+//
+// RETURN: (Parameters *) - parameters with default settings and no graph
+//
+// PURPOSE: Allocate a parameters structure holding the default settings
+// of the gbad program, an empty label list and no input graph.
+//******************************************************************************
+
+Parameters *GBAD_AllocateParameters(void)
+{
+   Parameters *parameters;
+
+   parameters = (Parameters *) malloc(sizeof(Parameters));
+   if (parameters == NULL)
+      OutOfMemoryError("parameters");
+
+   // GUI coloring
+   strcpy(parameters->dotFileName, "none");
+   parameters->dotToFile = FALSE;
+
+   // initialize default parameter settings
+   strcpy(parameters->inputFileName, "none");
+   parameters->directed = TRUE;
+   parameters->limit = 0;
+   parameters->numBestSubs = 3;
+   parameters->beamWidth = 4;
+   parameters->valueBased = FALSE;
+   parameters->prune = FALSE;
+   strcpy(parameters->outFileName, "none");
+   parameters->outputToFile = FALSE;
+   parameters->outputLevel = 2;
+   parameters->allowInstanceOverlap = FALSE;
+   parameters->threshold = 0.0;
+   parameters->evalMethod = EVAL_MDL;
+   parameters->iterations = 1;
+   strcpy(parameters->psInputFileName, "none");
+   parameters->predefinedSubs = FALSE;
+   parameters->minVertices = 1;
+   parameters->maxVertices = 0; // i.e., infinity
+   parameters->compress = FALSE;
+
+   parameters->mdl = FALSE;
+   parameters->mdlThreshold = 0.0;
+   parameters->mpsThreshold = 0.0;
+   parameters->prob = FALSE;
+   parameters->writeAnomFiles = FALSE;
+   parameters->mps = FALSE;
+   parameters->maxAnomalousScore = MAX_DOUBLE;
+   parameters->minAnomalousScore = 0.0;
+   parameters->noAnomalyDetection = TRUE;
+   parameters->norm = 1;
+   parameters->optimize = TRUE;
+   parameters->perExample = FALSE;
+   parameters->numThreads = 1;
+   parameters->windowSize = 0;
+   parameters->window = NULL;
+   parameters->posGraphStats = NULL;
+   parameters->currentIteration = 1;
+   parameters->numPreviousInstances = 0;
+
+   // initialize log2Factorial[0..1]
+   parameters->log2Factorial = (double *) malloc(2 * sizeof(double));
+   if (parameters->log2Factorial == NULL)
+      OutOfMemoryError("GBAD_AllocateParameters:parameters->log2Factorial");
+   parameters->log2FactorialSize = 2;
+   parameters->log2Factorial[0] = 0; // lg(0!)
+   parameters->log2Factorial[1] = 0; // lg(1!)
+
+   // visit sets grow with the graphs they mark; the instance arena is
+   // allocated by GBAD_PrepareParameters, once numThreads is known
+   parameters->vertexVisits = AllocateVisitSet(0);
+   parameters->edgeVisits = AllocateVisitSet(0);
+   parameters->exampleVisits = AllocateVisitSet(0);
+   parameters->coverVisits = AllocateVisitSet(0);
+   parameters->instanceArena = NULL;
+
+   // no graphs yet
+   parameters->labelList = AllocateLabelList();
+   parameters->posGraph = NULL;
+   parameters->posGraphDL = 0.0;
+   parameters->numPosEgs = 0;
+   parameters->posEgsVertexIndices = NULL;
+   parameters->posVertexExamples = NULL;
+   parameters->posGraphVertexListSize = 0;
+   parameters->posGraphEdgeListSize = 0;
+   parameters->preSubs = NULL;
+   parameters->numPreSubs = 0;
+   parameters->originalPosGraph = NULL;
+   parameters->originalLabelList = NULL;
+
+   parameters->incrementList = malloc(sizeof(IncrementList));
+   if (parameters->incrementList == NULL)
+      OutOfMemoryError("GBAD_AllocateParameters:parameters->incrementList");
+   parameters->incrementList->head = NULL;
+
+   return parameters;
+}
+
+
+//******************************************************************************
+// NAME: GBAD_SetOption
+//
+// INPUTS: (Parameters *parameters) - parameters to change
+//         (int argc) - number of option arguments
+//         (char **argv) - option arguments
+//         (int i) - index in argv of the option to set
+//         (char *message) - where to describe an error, of at least
+//                           GBAD_MESSAGE_LEN characters
+//
+// RETURN: (int) - number of arguments used by the option (1, or 2 if it
+//                 takes a value), or 0 if error
+//
+// PURPOSE: Set one option of the gbad command line, argv[i], with its
+// value argv[i+1] if it takes one, checking the value given.
+//******************************************************************************
+
+int GBAD_SetOption(Parameters *parameters, int argc, char **argv, int i,
+                   char *message)
+{
+   double doubleArg = 0.0;
+   ULONG ulongArg = 0;
+   ULONG argumentExists;
+   char *value = NULL;
+   int used = 1;
+
+   if (i + 1 < argc)
+      value = argv[i + 1];
+
+   if (strcmp(argv[i], "-beam") == 0)
+   {
+      if (value == NULL)
+         return MissingOptionValue(message, argv[i]);
+      used = 2;
+      sscanf(value, "%lu", &ulongArg);
+      if (ulongArg == 0)
+      {
+         sprintf(message, "beam must be greater than zero");
+         return 0;
+      }
+      parameters->beamWidth = ulongArg;
+   }
+   else if (strcmp(argv[i], "-compress") == 0)
+   {
+      parameters->compress = TRUE;
+   }
+   else if (strcmp(argv[i], "-eval") == 0)
+   {
+      if (value == NULL)
+         return MissingOptionValue(message, argv[i]);
+      used = 2;
+      sscanf(value, "%lu", &ulongArg);
+      if ((ulongArg < 1) || (ulongArg > 3))
+      {
+         sprintf(message, "eval must be 1-3");
+         return 0;
+      }
+      parameters->evalMethod = ulongArg;
+   }
+   else if (strcmp(argv[i], "-iterations") == 0)
+   {
+      if (value == NULL)
+         return MissingOptionValue(message, argv[i]);
+      used = 2;
+      sscanf(value, "%lu", &ulongArg);
+      parameters->iterations = ulongArg;
+   }
+   else if (strcmp(argv[i], "-limit") == 0)
+   {
+      if (value == NULL)
+         return MissingOptionValue(message, argv[i]);
+      used = 2;
+      sscanf(value, "%lu", &ulongArg);
+      if (ulongArg == 0)
+      {
+         sprintf(message, "limit must be greater than zero");
+         return 0;
+      }
+      parameters->limit = ulongArg;
+   }
+   else if (strcmp(argv[i], "-maxsize") == 0)
+   {
+      if (value == NULL)
+         return MissingOptionValue(message, argv[i]);
+      used = 2;
+      sscanf(value, "%lu", &ulongArg);
+      if (ulongArg == 0)
+      {
+         sprintf(message, "maxsize must be greater than zero");
+         return 0;
+      }
+      parameters->maxVertices = ulongArg;
+   }
+   else if (strcmp(argv[i], "-minsize") == 0)
+   {
+      if (value == NULL)
+         return MissingOptionValue(message, argv[i]);
+      used = 2;
+      sscanf(value, "%lu", &ulongArg);
+      if (ulongArg == 0)
+      {
+         sprintf(message, "minsize must be greater than zero");
+         return 0;
+      }
+      parameters->minVertices = ulongArg;
+   }
+   else if (strcmp(argv[i], "-nsubs") == 0)
+   {
+      if (value == NULL)
+         return MissingOptionValue(message, argv[i]);
+      used = 2;
+      sscanf(value, "%lu", &ulongArg);
+      if (ulongArg == 0)
+      {
+         sprintf(message, "nsubs must be greater than zero");
+         return 0;
+      }
+      parameters->numBestSubs = ulongArg;
+   }
+   else if (strcmp(argv[i], "-out") == 0)
+   {
+      if (value == NULL)
+         return MissingOptionValue(message, argv[i]);
+      used = 2;
+      strcpy(parameters->outFileName, value);
+      parameters->outputToFile = TRUE;
+   }
+   else if (strcmp(argv[i], "-output") == 0)
+   {
+      if (value == NULL)
+         return MissingOptionValue(message, argv[i]);
+      used = 2;
+      sscanf(value, "%lu", &ulongArg);
+      if ((ulongArg < 1) || (ulongArg > 5))
+      {
+         sprintf(message, "output must be 1-5");
+         return 0;
+      }
+      parameters->outputLevel = ulongArg;
+   }
+   else if (strcmp(argv[i], "-overlap") == 0)
+   {
+      parameters->allowInstanceOverlap = TRUE;
+   }
+   else if (strcmp(argv[i], "-perexample") == 0)
+   {
+      parameters->perExample = TRUE;
+   }
+   else if (strcmp(argv[i], "-prune") == 0)
+   {
+      parameters->prune = TRUE;
+   }
+   else if (strcmp(argv[i], "-ps") == 0)
+   {
+      if (value == NULL)
+         return MissingOptionValue(message, argv[i]);
+      used = 2;
+      strcpy(parameters->psInputFileName, value);
+      parameters->predefinedSubs = TRUE;
+   }
+   else if (strcmp(argv[i], "-threads") == 0)
+   {
+      if (value == NULL)
+         return MissingOptionValue(message, argv[i]);
+      used = 2;
+      sscanf(value, "%lu", &ulongArg);
+      if (ulongArg == 0)
+      {
+         sprintf(message, "threads must be greater than zero");
+         return 0;
+      }
+      parameters->numThreads = ulongArg;
+   }
+   else if (strcmp(argv[i], "-threshold") == 0)
+   {
+      if (value == NULL)
+         return MissingOptionValue(message, argv[i]);
+      used = 2;
+      sscanf(value, "%lf", &doubleArg);
+      if ((doubleArg < (double) 0.0) || (doubleArg > (double) 1.0))
+      {
+         sprintf(message, "threshold must be 0.0-1.0");
+         return 0;
+      }
+      parameters->threshold = doubleArg;
+   }
+   else if (strcmp(argv[i], "-undirected") == 0)
+   {
+      parameters->directed = FALSE;
+   }
+   else if (strcmp(argv[i], "-valuebased") == 0)
+   {
+      parameters->valueBased = TRUE;
+   }
+   else if (strcmp(argv[i], "-window") == 0)
+   {
+      if (value == NULL)
+         return MissingOptionValue(message, argv[i]);
+      used = 2;
+      sscanf(value, "%lu", &ulongArg);
+      if (ulongArg == 0)
+      {
+         sprintf(message, "window must be greater than zero");
+         return 0;
+      }
+      parameters->windowSize = ulongArg;
+   }
+   else if (strcmp(argv[i], "-mdl") == 0)
+   {
+      if (value == NULL)
+         return MissingOptionValue(message, argv[i]);
+      used = 2;
+      argumentExists = sscanf(value, "%lf", &doubleArg);
+      if ((argumentExists != 1) || (doubleArg <= (double) 0.0) ||
+          (doubleArg >= (double) 1.0))
+      {
+         sprintf(message, "Information Theoretic (MDL) threshold must be "
+                 "greater than 0.0 and less than 1.0");
+         return 0;
+      }
+      parameters->mdl = TRUE;
+      parameters->mdlThreshold = doubleArg;
+   }
+   else if (strcmp(argv[i], "-prob") == 0)
+   {
+      if (value == NULL)
+         return MissingOptionValue(message, argv[i]);
+      used = 2;
+      sscanf(value, "%lu", &ulongArg);
+      if (ulongArg < 2)
+      {
+         sprintf(message, "you must include a value greater than 1 as a "
+                 "parameter to the probabilistic anomaly detection method.");
+         return 0;
+      }
+      parameters->prob = TRUE;
+      parameters->iterations = ulongArg;  // overrides -iterations
+      parameters->maxAnomalousScore = 1.0;  // overrides default of MAX_DOUBLE
+   }
+   else if (strcmp(argv[i], "-mps") == 0)
+   {
+      if (value == NULL)
+         return MissingOptionValue(message, argv[i]);
+      used = 2;
+      argumentExists = sscanf(value, "%lf", &doubleArg);
+      if ((argumentExists != 1) || (doubleArg <= (double) 0.0) ||
+          (doubleArg >= (double) 1.0))
+      {
+         sprintf(message, "Maximum Partial Substructure (MPS) threshold "
+                 "must be greater than 0.0 and less than 1.0");
+         return 0;
+      }
+      parameters->mps = TRUE;
+      parameters->mpsThreshold = doubleArg;
+   }
+   else if (strcmp(argv[i], "-maxAnomalousScore") == 0)
+   {
+      if (value == NULL)
+         return MissingOptionValue(message, argv[i]);
+      used = 2;
+      argumentExists = sscanf(value, "%lf", &doubleArg);
+      if ((argumentExists != 1) || (doubleArg <= (double) 0.0) ||
+          (doubleArg >= (double) MAX_DOUBLE))
+      {
+         sprintf(message, "maximum anomalous score must be greater than "
+                 "0.0 and less than %lf", MAX_DOUBLE);
+         return 0;
+      }
+      //
+      // NOTE:  This check assumes that the user has specified a max
+      // anomalous score AFTER specifying they want to run the GBAD-P
+      // algorithm.
+      //
+      if (((doubleArg <= (double) 0.0) || (doubleArg >= 1.0)) &&
+          (parameters->prob))
+      {
+         sprintf(message, "maximum anomalous score must be greater than "
+                 "0.0 and less than 1.0");
+         return 0;
+      }
+      parameters->maxAnomalousScore = doubleArg;
+   }
+   else if (strcmp(argv[i], "-minAnomalousScore") == 0)
+   {
+      if (value == NULL)
+         return MissingOptionValue(message, argv[i]);
+      used = 2;
+      argumentExists = sscanf(value, "%lf", &doubleArg);
+      if ((argumentExists != 1) || (doubleArg < (double) 0.0) ||
+          (doubleArg >= (double) MAX_DOUBLE))
+      {
+         sprintf(message, "minimum anomalous score must be greater than "
+                 "or equal to 0.0 and less than %lf", MAX_DOUBLE);
+         return 0;
+      }
+      parameters->minAnomalousScore = doubleArg;
+   }
+   else if (strcmp(argv[i], "-norm") == 0)
+   {
+      if (value == NULL)
+         return MissingOptionValue(message, argv[i]);
+      used = 2;
+      sscanf(value, "%lu", &ulongArg);
+      if (ulongArg < 1)
+      {
+         sprintf(message, "you must specify a value of 1 or greater.");
+         return 0;
+      }
+      parameters->norm = ulongArg;
+   }
+   else if (strcmp(argv[i], "-noOpt") == 0)
+   {
+      parameters->optimize = FALSE;
+   }
+   // GUI coloring
+   else if(strcmp(argv[i], "-dot") == 0)
+   {
+      if (value == NULL)
+         return MissingOptionValue(message, argv[i]);
+      used = 2;
+      strcpy(parameters->dotFileName, value);
+      parameters->dotToFile = TRUE;
+   }
+   else
+   {
+      snprintf(message, GBAD_MESSAGE_LEN, "unknown option %s", argv[i]);
+      return 0;
+   }
+   return used;
+}
+
+
+//******************************************************************************
+// NAME: MissingOptionValue
+//
+// INPUTS: (char *message) - where to describe the error
+//         (char *option) - option given without a value
+//
+// RETURN: (int) - 0
+//
+// PURPOSE: Report an option that takes a value given as the last argument.
+//******************************************************************************
+
+int MissingOptionValue(char *message, char *option)
+{
+   snprintf(message, GBAD_MESSAGE_LEN, "%s must be given a value", option);
+   return 0;
+}
+
+
+//******************************************************************************
+// NAME: GBAD_SetGraph
+//
+// INPUTS: (Parameters *parameters) - parameters with no input graph yet
+//         (ULONG numVertices) - number of vertices
+//         (char **vertexLabels) - label of each vertex
+//         (ULONG numEdges) - number of edges
+//         (ULONG *sources) - source vertex index of each edge
+//         (ULONG *targets) - target vertex index of each edge
+//         (char **edgeLabels) - label of each edge
+//         (BOOLEAN *directed) - TRUE for each directed edge; if NULL,
+//                               edges are directed if parameters->directed
+//         (ULONG numExamples) - number of positive examples
+//         (ULONG *exampleStarts) - index of first vertex of each example;
+//                                  if NULL, the graph is one example
+//         (GP_error *error) - where to report an error
+//
+// RETURN: (int) - 0 if success, 1 if error
+//
+// PURPOSE: Build the positive graph in parameters from arrays, as
+// ReadInputFile would from the equivalent graph file.  Vertex and edge
+// indices start at zero, and vertex labels are string labels stored
+// as given (without the quotes of the graph file format).  Examples must
+// be given in order, each with at least one vertex, and each edge must
+// join vertices of one example.  The description length of the graph is
+// computed for MDL evaluation.
+//******************************************************************************
+
+int GBAD_SetGraph(Parameters *parameters, ULONG numVertices,
+                  char **vertexLabels, ULONG numEdges, ULONG *sources,
+                  ULONG *targets, char **edgeLabels, BOOLEAN *directed,
+                  ULONG numExamples, ULONG *exampleStarts,
+                  GP_error *error)
+{
+   Graph *graph;
+   ULONG *examples;
+   ULONG i, v, e;
+   ULONG example;
+   ULONG labelIndex;
+   BOOLEAN edgeDirected;
+
+   if (parameters->posGraph != NULL)
+      return SetGraphError(error, "graph already set");
+   if (exampleStarts == NULL)
+      numExamples = 1;
+   if ((numVertices == 0) || (numExamples == 0) ||
+       (numExamples > numVertices))
+      return SetGraphError(error, "no positive graphs defined");
+   examples = (ULONG *) malloc(sizeof(ULONG) * numExamples);
+   if (examples == NULL)
+      OutOfMemoryError("GBAD_SetGraph:examples");
+   examples[0] = 0;
+   for (i = 1; i < numExamples; i++)
+   {
+      examples[i] = exampleStarts[i];
+      if ((examples[i] <= examples[i - 1]) || (examples[i] >= numVertices))
+      {
+         free(examples);
+         return SetGraphError(error, "invalid example start");
+      }
+   }
+   if ((exampleStarts != NULL) && (exampleStarts[0] != 0))
+   {
+      free(examples);
+      return SetGraphError(error, "invalid example start");
+   }
+   for (e = 0; e < numEdges; e++)
+   {
+      if ((sources[e] >= numVertices) || (targets[e] >= numVertices) ||
+          (ExampleOfVertex(examples, numExamples, sources[e]) !=
+           ExampleOfVertex(examples, numExamples, targets[e])))
+      {
+         free(examples);
+         return SetGraphError(error, "invalid edge vertex");
+      }
+   }
+
+   graph = AllocateGraph(0, 0);
+   example = 0;
+   for (v = 0; v < numVertices; v++)
+   {
+      if ((example + 1 < numExamples) && (examples[example + 1] == v))
+         example++;
+      labelIndex = StoreStringLabel(vertexLabels[v], strlen(vertexLabels[v]),
+                                    parameters->labelList);
+      AddVertex(graph, labelIndex, & parameters->posGraphVertexListSize,
+                v - examples[example] + 1);
+   }
+   for (e = 0; e < numEdges; e++)
+   {
+      labelIndex = StoreStringLabel(edgeLabels[e], strlen(edgeLabels[e]),
+                                    parameters->labelList);
+      edgeDirected = parameters->directed;
+      if (directed != NULL)
+         edgeDirected = directed[e];
+      AddEdge(graph, sources[e], targets[e], edgeDirected, labelIndex,
+              & parameters->posGraphEdgeListSize, FALSE);
+   }
+   BuildGraphAdjacency(graph);
+
+   parameters->posGraph = graph;
+   parameters->numPosEgs = numExamples;
+   parameters->posEgsVertexIndices = examples;
+   CopyOriginalGraph(parameters);
+   parameters->posGraphDL = MDL(parameters->posGraph,
+                                parameters->labelList->numLabels, parameters);
+   return 0;
+}
+
+
+//******************************************************************************
+// NAME: GBAD_ReadGraph
+//
+// INPUTS: (Parameters *parameters) - parameters with no input graph yet
+//         (char *buffer) - contents of a graph file, text or binary
+//         (ULONG length) - number of bytes in buffer
+//         (GP_error *error) - where to report an error
+//
+// RETURN: (int) - 0 if success, 1 if error
+//
+// PURPOSE: Build the positive graph in parameters from a graph file held
+// in memory, as ReadInputFile would from the file itself, and compute its
+// description length for MDL evaluation.  A binary buffer (as written by
+// graph2bin) must be aligned as returned by malloc.  On an error, whatever
+// was read is left in parameters for GBAD_FreeParameters.
+//******************************************************************************
+
+int GBAD_ReadGraph(Parameters *parameters, char *buffer, ULONG length,
+                   GP_error *error)
+{
+   Graph_Info info;
+   int result;
+
+   if (parameters->posGraph != NULL)
+      return SetGraphError(error, "graph already set");
+   info.graph = NULL;
+   info.labelList = parameters->labelList;
+   info.preSubs = NULL;
+   info.numPreSubs = 0;
+   info.numPosEgs = 0;
+   info.posEgsVertexIndices = NULL;
+   info.directed = parameters->directed;
+   info.posGraphVertexListSize = 0;
+   info.posGraphEdgeListSize = 0;
+   info.vertexOffset = 0;
+   info.xp_graph = TRUE;
+
+   if ((length >= sizeof(GraphFileHeader)) &&
+       (memcmp(buffer, GRAPH_BINARY_MAGIC, sizeof(GRAPH_BINARY_MAGIC)) == 0))
+      result = ReadMappedBinaryGraph(& info, buffer, length, error);
+   else
+   {
+      result = ReadMappedGraph(& info, buffer, length, error);
+      if ((result == 0) && (info.graph != NULL))
+         BuildGraphAdjacency(info.graph);
+   }
+
+   parameters->posGraph = info.graph;
+   parameters->labelList = info.labelList;
+   parameters->numPosEgs = info.numPosEgs;
+   parameters->posEgsVertexIndices = info.posEgsVertexIndices;
+   parameters->posGraphVertexListSize = info.posGraphVertexListSize;
+   parameters->posGraphEdgeListSize = info.posGraphEdgeListSize;
+   if ((result != 0) || (parameters->posGraph == NULL))
+      return result;
+
+   CopyOriginalGraph(parameters);
+   parameters->posGraphDL = MDL(parameters->posGraph,
+                                parameters->labelList->numLabels, parameters);
+   return 0;
+}
+
+
+//******************************************************************************
+// NAME: SetGraphError
+//
+// INPUTS: (GP_error *error) - where to report error
+//         (char *message) - description of error
+//
+// RETURN: (int) - 1
+//
+// PURPOSE: Report an error in the arrays given to GBAD_SetGraph.
+//******************************************************************************
+
+int SetGraphError(GP_error *error, char *message)
+{
+   error->lineNo = 0;
+   snprintf(error->message, GP_ERROR_LEN, "%s", message);
+   return 1;
+}
+
+
+//******************************************************************************
+// NAME: ExampleOfVertex
+//
+// INPUTS: (ULONG *examples) - index of first vertex of each example
+//         (ULONG numExamples) - number of examples
+//         (ULONG v) - vertex index
+//
+// RETURN: (ULONG) - index of example containing vertex v
+//
+// PURPOSE: Binary search of the example start indices.
+//******************************************************************************
+
+ULONG ExampleOfVertex(ULONG *examples, ULONG numExamples, ULONG v)
+{
+   ULONG low = 0;
+   ULONG high = numExamples - 1;
+   ULONG middle;
+
+   while (low < high)
+   {
+      middle = (low + high + 1) / 2;
+      if (examples[middle] <= v)
+         low = middle;
+      else
+         high = middle - 1;
+   }
+   return low;
+}
+
+
+//******************************************************************************
+// NAME: GBAD_PrepareParameters
+//
+// INPUTS: (Parameters *parameters) - parameters with settings and graphs
+//
+// RETURN: (char *) - description of the error, or NULL if none
+//
+// PURPOSE: Resolve the settings that depend on each other or on the
+// positive graph, once both are known, and allocate the storage for
+// discovery.  Must be called before GBAD_DiscoverIteration.
+//******************************************************************************
+
+char *GBAD_PrepareParameters(Parameters *parameters)
+{
+   if ((parameters->mdl) || (parameters->prob) || (parameters->mps))
+      parameters->noAnomalyDetection = FALSE;
+
+   if (parameters->iterations == 0)
+      parameters->iterations = MAX_UNSIGNED_LONG; // infinity
+
+   if (parameters->instanceArena == NULL)
+      parameters->instanceArena =
+         AllocateInstanceArena(parameters->numThreads > 1);
+
+   if (parameters->numPosEgs == 0)
+      return "no positive graphs defined";
+   SetPosVertexExamples(parameters);
+
+   //
+   // In batch and windowed mode, a maxsize or limit of zero is resolved
+   // against each example in DiscoverSubsPerExample or WindowAddExample.
+   //
+   if ((parameters->perExample) || (parameters->windowSize > 0))
+   {
+      if ((parameters->maxVertices != 0) &&
+          (parameters->maxVertices < parameters->minVertices))
+         return "minsize exceeds maxsize";
+      return NULL;
+   }
+
+   // Check bounds on discovered substructures' number of vertices
+   if (parameters->maxVertices == 0)
+      parameters->maxVertices = parameters->posGraph->numVertices;
+   if (parameters->maxVertices < parameters->minVertices)
+      return "minsize exceeds maxsize";
+
+   // Set limit accordingly
+   if (parameters->limit == 0)
+   {
+      parameters->limit = parameters->posGraph->numEdges / 2;
+   }
+
+   return NULL;
+}
+
+
+//******************************************************************************
+// NAME: GBAD_DiscoverIteration
+//
+// INPUTS: (Parameters *parameters)
+//         (Substructure **normSub) - where GBAD-P puts the normative
+//                                    substructure, if prob
+//
+// RETURN: (SubList *) - best substructures of this iteration
+//
+// PURPOSE: Discover the best substructures in the positive graph for
+// iteration parameters->currentIteration, and run the chosen anomaly
+// detection methods on them.  Anomalous values found are recorded in the
+// vertex and edge information of parameters->originalPosGraph.
+//******************************************************************************
+
+SubList *GBAD_DiscoverIteration(Parameters *parameters, Substructure **normSub)
+{
+   SubList *subList;
+   ULONG iteration = parameters->currentIteration;
+   ULONG saveNumBestSubs;
+
+   if ((parameters->prob) && (iteration > 1))
+   {
+      //
+      // If GBAD-P option chosen, after the first iteration, we no longer
+      // care about minsize of maxsize after the first iteration (if the
+      // user specified these parameters), as we are just dealing with
+      // single extensions from the normative - so set it to where we
+      // just look at substructures that are composed of the normative
+      // pattern (SUB_) and the single vertex extension.
+      //
+      parameters->minVertices = 1;
+      parameters->maxVertices = 2;
+   }
+   //
+   // If the user has specified a normative pattern, on the first iteration
+   // need to save the top-N substructures, where N is what the user
+   // specified with the -norm parameter.
+   //
+   saveNumBestSubs = parameters->numBestSubs;
+   if ((iteration == 1) && (!parameters->noAnomalyDetection) &&
+       (parameters->norm > parameters->numBestSubs))
+      parameters->numBestSubs = parameters->norm;
+   //
+   // -prune is useful to get to the initial normative pattern, but
+   // possibly detremental to discovering anomalies... so, turn off
+   // pruning (in case it was turned on), so that it is not used in
+   // future iterations.
+   //
+   if ((parameters->prob) && (iteration > 1))
+   {
+      parameters->prune = FALSE;
+   }
+
+   subList = DiscoverSubs(parameters, iteration);
+
+   //
+   // Now that we have the best substructure(s), return the user
+   // specified number of best substructures to its original value.
+   //
+   if (iteration == 1)
+      parameters->numBestSubs = saveNumBestSubs;
+
+   if (subList->head != NULL)
+   {
+      //
+      // GBAD-MDL
+      //
+      if (parameters->mdl)
+         GBAD_MDL(subList,parameters);
+
+      //
+      // GBAD-MPS
+      //
+      if (parameters->mps)
+      {
+         GBAD_MPS(subList,parameters);
+      }
+
+      //
+      // GBAD-P
+      //
+      if (parameters->prob)
+      {
+         *normSub = GBAD_P(subList,iteration,parameters);
+      }
+   }
+   return subList;
+}
+
+
+//******************************************************************************
+// NAME: GBAD_CompressIteration
+//
+// INPUTS: (Parameters *parameters)
+//         (SubList *subList) - non-empty result of GBAD_DiscoverIteration
+//         (Substructure *normSub) - normative substructure from GBAD-P
+//
+// RETURN: (BOOLEAN) - FALSE if nothing is left to discover
+//
+// PURPOSE: Prepare the positive graph for the next iteration.  With
+// set-cover evaluation, the positive examples covered by the best
+// substructure are removed; otherwise the graph is compressed by the
+// best substructure, or, after the first GBAD-P iteration, by the chosen
+// normative substructure.
+//******************************************************************************
+
+BOOLEAN GBAD_CompressIteration(Parameters *parameters, SubList *subList,
+                               Substructure *normSub)
+{
+   ULONG iteration = parameters->currentIteration;
+
+   if (parameters->evalMethod == EVAL_SETCOVER)
+   {
+      RemovePosEgsCovered(subList->head->sub, parameters);
+      return (parameters->numPosEgs != 0);
+   }
+   //
+   // For the GBAD-P algorithm, multiple iterations will need
+   // to be performed, and if it is the first iteration
+   // AND the user has specified a different normative
+   // pattern (other than the best one), we need to
+   // use the substructure that was set by GBAD_P.
+   //
+   if ((iteration == 1) && (parameters->prob))
+      CompressFinalGraphs(normSub, parameters, iteration, FALSE);
+   else
+      CompressFinalGraphs(subList->head->sub, parameters, iteration, FALSE);
+   return (parameters->posGraph->numEdges != 0);
+}
+
+
+//******************************************************************************
+// NAME: GBAD_EndIteration
+//
+// INPUTS: (Parameters *parameters)
+//         (SubList *subList) - result of GBAD_DiscoverIteration
+//
+// RETURN: (void)
+//
+// PURPOSE: Free the substructures and instances of the current iteration
+// and advance to the next one.
+//******************************************************************************
+
+void GBAD_EndIteration(Parameters *parameters, SubList *subList)
+{
+   //
+   // Need to store information regarding initial best substructure, for use
+   // in future GBAD-P calculations
+   //
+   if ((parameters->prob) && (subList->head != NULL))
+      parameters->numPreviousInstances = subList->head->sub->numInstances;
+
+   FreeSubList(subList);
+   ResetInstanceArena(parameters->instanceArena);
+   parameters->currentIteration++;
+}
+
+
+//******************************************************************************
+// NAME: GBAD_Sub
+//
+// INPUTS: (SubList *subList) - list of substructures
+//         (ULONG index) - position in list, starting at zero
+//
+// RETURN: (Substructure *) - substructure at that position, or NULL
+//
+// PURPOSE: Return the substructure at the given position of the list,
+// best first.
+//******************************************************************************
+
+Substructure *GBAD_Sub(SubList *subList, ULONG index)
+{
+   SubListNode *subListNode = subList->head;
+
+   while ((subListNode != NULL) && (index > 0))
+   {
+      subListNode = subListNode->next;
+      index--;
+   }
+   if (subListNode == NULL)
+      return NULL;
+   return subListNode->sub;
+}
+
+
+//******************************************************************************
+// NAME: GBAD_VertexAnomalousValue
+//
+// INPUTS: (Parameters *parameters)
+//         (ULONG v) - index of vertex in the input graph
+//
+// RETURN: (double) - lowest anomalous value found for the vertex, or a
+//                    value greater than 1.0 if it was never anomalous
+//******************************************************************************
+
+double GBAD_VertexAnomalousValue(Parameters *parameters, ULONG v)
+{
+   return parameters->originalPosGraph->vertexInfo[v].anomalousValue;
+}
+
+
+//******************************************************************************
+// NAME: GBAD_EdgeAnomalousValue
+//
+// INPUTS: (Parameters *parameters)
+//         (ULONG e) - index of edge in the input graph
+//
+// RETURN: (double) - lowest anomalous value found for the edge, or a
+//                    value greater than 1.0 if it was never anomalous
+//******************************************************************************
+
+double GBAD_EdgeAnomalousValue(Parameters *parameters, ULONG e)
+{
+   return parameters->originalPosGraph->edgeInfo[e].anomalousValue;
+}
+
+
+//******************************************************************************
+// NAME: GBAD_FreeParameters
+//
+// INPUTS: (Parameters *parameters)
+//
+// RETURN: (void)
+//
+// PURPOSE: Free memory allocated for parameters, including its graphs and
+// label lists.  Note that the predefined substructures are de-allocated
+// as soon as they are processed, and not here.
+//******************************************************************************
+
+void GBAD_FreeParameters(Parameters *parameters)
+{
+   FreeGraph(parameters->posGraph);
+   FreeLabelList(parameters->labelList);
+   FreeGraph(parameters->originalPosGraph);
+   if (parameters->originalLabelList != NULL)
+      FreeLabelList(parameters->originalLabelList);
+   free(parameters->posEgsVertexIndices);
+   free(parameters->posVertexExamples);
+   free(parameters->log2Factorial);
+   if (parameters->window != NULL)
+      FreeWindow(parameters->window, parameters->incrementList);
+   free(parameters->incrementList);
+   FreeVisitSet(parameters->vertexVisits);
+   FreeVisitSet(parameters->edgeVisits);
+   FreeVisitSet(parameters->exampleVisits);
+   FreeVisitSet(parameters->coverVisits);
+   if (parameters->instanceArena != NULL)
+      FreeInstanceArena(parameters->instanceArena);
+   free(parameters);
+}
@@ -0,0 +1,118 @@
+//******************************************************************************
+// graph2bin_main.c
+//
+// Main functions for program to convert a graph input file into a binary
+// graph file, which gbad reads without parsing.
+//
+// Usage: graph2bin [-undirected] <graphfilename> <binfilename>
+//
+// Writes the graph defined in <graphfilename> to <binfilename> in binary
+// format.  Undirected edges ('e') are stored as directed unless
+// -undirected is given, as with gbad.
+//
+// Date      Name       Description
+// ========  =========  ========================================================
+// 10/17/26  agent      Initial version, based on graph2dot_main.c
+//
+//******************************************************************************
+
+#include "gbad.h"
+
+
+// Function prototypes
+
+int main(int, char **);
+Parameters *GetParameters(int, char **);
+void FreeParameters(Parameters *);
+
+
+//******************************************************************************
+// NAME:    main
+//
+// INPUTS:  (int argc) - number of arguments to program
+//          (char **argv) - array of strings of arguments to program
+//
+// RETURN:  (int) - 0 if all is well
+//
+// PURPOSE: Main function for graph to binary graph conversion program.
+// Takes an optional -undirected argument, then the input graph file and
+// the output file for writing the binary graph.
+//******************************************************************************
+
+int main(int argc, char **argv)
+{
+   Parameters *parameters;
+
+   if ((argc != 3) &&
+       ((argc != 4) || (strcmp(argv[1], "-undirected") != 0)))
+   {
+      printf("USAGE: %s [-undirected] <graphfilename> <binfilename>\n",
+             argv[0]);
+      exit(1);
+   }
+
+   parameters = GetParameters(argc, argv);
+   ReadInputFile(parameters);
+   WriteBinaryGraph(argv[argc - 1], parameters->posGraph,
+                    parameters->labelList, parameters->numPosEgs,
+                    parameters->posEgsVertexIndices);
+
+   FreeParameters(parameters);
+
+   return 0;
+}
+
+
+//******************************************************************************
+// NAME: GetParameters
+//
+// INPUTS: (int argc) - number of command-line arguments
+//         (char *argv[]) - array of command-line argument strings
+//
+// RETURN: (Parameters *)
+//
+// PURPOSE: Initialize parameters structure and process command-line
+// options.
+//******************************************************************************
+
+Parameters *GetParameters(int argc, char *argv[])
+{
+   Parameters *parameters;
+
+   parameters = (Parameters *) malloc(sizeof(Parameters));
+   if (parameters == NULL)
+      OutOfMemoryError("GetParameters:parameters");
+
+   // initialize parameter settings
+   strcpy(parameters->inputFileName, argv[argc - 2]);
+   parameters->labelList = AllocateLabelList();
+   parameters->directed = (argc == 3);
+   parameters->posGraph = NULL;
+   parameters->numPosEgs = 0;
+   parameters->posEgsVertexIndices = NULL;
+   parameters->posGraphVertexListSize = 0;
+   parameters->posGraphEdgeListSize = 0;
+
+   return parameters;
+}
+
+
+//******************************************************************************
+// NAME: FreeParameters
+//
+// INPUTS: (Parameters *parameters)
+//
+// RETURN: (void)
+//
+// PURPOSE: Free memory allocated for parameters.
+//******************************************************************************
+
+void FreeParameters(Parameters *parameters)
+{
+   FreeGraph(parameters->posGraph);
+   FreeGraph(parameters->originalPosGraph);
+   FreeLabelList(parameters->labelList);
+   FreeLabelList(parameters->originalLabelList);
+   free(parameters->posEgsVertexIndices);
+   free(parameters);
+}
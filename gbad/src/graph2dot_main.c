@@ -11,6 +11,7 @@
 // Date      Name       Description
 // ========  =========  ========================================================
 // 11/30/09  Eberle     Initial version, taken from SUBDUE 5.2.1
+// 10/17/26  agent      Initialize graph list sizes before reading graph
 //
 //******************************************************************************
 
@@ -84,6 +85,8 @@ Parameters *GetParameters(int argc, char *argv[])
    parameters->posGraph = NULL;
    parameters->numPosEgs = 0;
    parameters->posEgsVertexIndices = NULL;
+   parameters->posGraphVertexListSize = 0;
+   parameters->posGraphEdgeListSize = 0;
 
    return parameters;
 }
@@ -0,0 +1,456 @@
+//******************************************************************************
+// graphbin.c
+//
+// Reading and writing of binary graph files, which hold an input graph
+// with its label table, adjacency arrays and example offsets, so that it
+// can be loaded without parsing.
+//
+// Date      Name       Description
+// ========  =========  ========================================================
+// 10/17/26  agent      Initial version.
+//
+//******************************************************************************
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "gbad.h"
+
+
+//******************************************************************************
+// NAME: BinaryGraphFile
+//
+// INPUTS: (char *fileName) - input file
+//
+// RETURN: (BOOLEAN) - TRUE if file is a binary graph file
+//
+// PURPOSE: Check whether the given file is a regular file that begins
+// with the binary graph file magic string.  Other inputs, such as pipes,
+// are left unread.
+//******************************************************************************
+
+BOOLEAN BinaryGraphFile(char *fileName)
+{
+   int fd;
+   struct stat fileStatus;
+   char magic[sizeof(GRAPH_BINARY_MAGIC)];
+   BOOLEAN binary = FALSE;
+
+   fd = open(fileName, O_RDONLY);
+   if (fd < 0)
+      return FALSE;
+   if ((fstat(fd, & fileStatus) == 0) && (S_ISREG(fileStatus.st_mode)) &&
+       (read(fd, magic, sizeof(magic)) == sizeof(magic)) &&
+       (memcmp(magic, GRAPH_BINARY_MAGIC, sizeof(magic)) == 0))
+      binary = TRUE;
+   close(fd);
+   return binary;
+}
+
+
+//******************************************************************************
+// NAME: ReadBinaryGraph
+//
+// INPUTS: (Graph_Info *info) - where graph and labels are stored
+//         (const char *inputFileName) - binary graph file to read
+//         (GP_error *error) - where to report an error
+//
+// RETURN: (int) - 0 if success, 1 if error
+//
+// PURPOSE: Map the given binary graph file into memory and read it into
+// info with ReadMappedBinaryGraph.
+//******************************************************************************
+
+int ReadBinaryGraph(Graph_Info *info, const char *inputFileName,
+                    GP_error *error)
+{
+   int fd;
+   struct stat fileStatus;
+   char *buffer;
+   int ret;
+
+   fd = open(inputFileName, O_RDONLY);
+   if (fd < 0)
+      return BinaryGraphError(error, "unable to open input file");
+   if ((fstat(fd, & fileStatus) != 0) || (fileStatus.st_size == 0))
+   {
+      close(fd);
+      return BinaryGraphError(error, "unable to read input file");
+   }
+   buffer = (char *) mmap(NULL, fileStatus.st_size, PROT_READ, MAP_PRIVATE,
+                          fd, 0);
+   close(fd);
+   if (buffer == MAP_FAILED)
+      return BinaryGraphError(error, "unable to map input file");
+   ret = ReadMappedBinaryGraph(info, buffer, (ULONG) fileStatus.st_size,
+                               error);
+   munmap(buffer, fileStatus.st_size);
+   return ret;
+}
+
+
+//******************************************************************************
+// NAME: ReadMappedBinaryGraph
+//
+// INPUTS: (Graph_Info *info) - where graph and labels are stored; the
+//                              graph must be NULL
+//         (char *buffer) - contents of binary graph file
+//         (ULONG length) - number of bytes in buffer
+//         (GP_error *error) - where to report an error
+//
+// RETURN: (int) - 0 if success, 1 if error
+//
+// PURPOSE: Build info->graph, its examples and its labels from a binary
+// graph file, as GP_read_graph would from the equivalent text file.  The
+// labels are stored in info->labelList, string labels straight from the
+// buffer, and the vertex and edge arrays are filled by straight copies,
+// including the vertices' edge arrays, which are stored in the file as
+// they are left by BuildGraphAdjacency.  The file is checked throughout,
+// so a truncated or corrupt file is reported rather than read.
+//******************************************************************************
+
+int ReadMappedBinaryGraph(Graph_Info *info, char *buffer, ULONG length,
+                          GP_error *error)
+{
+   GraphFileHeader *header = (GraphFileHeader *) buffer;
+   GraphFileLabel *fileLabels;
+   GraphFileEdge *fileEdges;
+   ULONG *examples;
+   ULONG *vertexLabels;
+   ULONG *edgeStarts;
+   ULONG *adjacency;
+   char *strings;
+   ULONG *labelMap;
+   ULONG numLabels, numExamples, numVertices, numEdges, numAdjacency;
+   ULONG size;
+   ULONG i, v, e;
+   ULONG example;
+   ULONG exampleStart;
+   Graph *graph;
+   Vertex *vertex;
+   Edge *edge;
+   EdgeInfo *edgeInfo;
+   Label label;
+
+   if (info->graph != NULL)
+      return BinaryGraphError(error,
+                              "binary graph cannot be added to a graph");
+   if ((length < sizeof(GraphFileHeader)) ||
+       (memcmp(header->magic, GRAPH_BINARY_MAGIC, sizeof(header->magic))
+        != 0))
+      return BinaryGraphError(error, "not a binary graph file");
+   if ((header->byteOrder != GRAPH_BINARY_BYTE_ORDER) ||
+       (header->ulongSize != sizeof(ULONG)) ||
+       (header->version != GRAPH_BINARY_VERSION))
+      return BinaryGraphError(error,
+                              "unsupported binary graph version or byte order");
+   numLabels = header->numLabels;
+   numExamples = header->numExamples;
+   numVertices = header->numVertices;
+   numEdges = header->numEdges;
+   numAdjacency = header->numAdjacency;
+   if ((numLabels > length) || (header->stringBytes > length) ||
+       (numExamples > length) || (numVertices > length) ||
+       (numEdges > length) || (numAdjacency > length))
+      return BinaryGraphError(error, "truncated binary graph file");
+   size = sizeof(GraphFileHeader) + (numLabels * sizeof(GraphFileLabel)) +
+          ((numExamples + (2 * numVertices) + 1 + numAdjacency) *
+           sizeof(ULONG)) +
+          (numEdges * sizeof(GraphFileEdge)) + header->stringBytes;
+   if (size != length)
+      return BinaryGraphError(error, "truncated binary graph file");
+   if ((numExamples == 0) && (numVertices > 0))
+      return BinaryGraphError(error, "vertices outside of any example");
+
+   // locate sections
+   fileLabels = (GraphFileLabel *) (buffer + sizeof(GraphFileHeader));
+   examples = (ULONG *) (fileLabels + numLabels);
+   vertexLabels = examples + numExamples;
+   edgeStarts = vertexLabels + numVertices;
+   adjacency = edgeStarts + numVertices + 1;
+   fileEdges = (GraphFileEdge *) (adjacency + numAdjacency);
+   strings = (char *) (fileEdges + numEdges);
+
+   // check topology before anything is stored
+   for (i = 0; i < numExamples; i++)
+      if ((examples[i] > numVertices) ||
+          ((i == 0) && (examples[i] != 0)) ||
+          ((i > 0) && (examples[i] < examples[i - 1])))
+         return BinaryGraphError(error, "invalid example offsets");
+   if ((edgeStarts[0] != 0) || (edgeStarts[numVertices] != numAdjacency))
+      return BinaryGraphError(error, "invalid adjacency offsets");
+   for (v = 0; v < numVertices; v++)
+      if ((vertexLabels[v] >= numLabels) ||
+          (edgeStarts[v + 1] < edgeStarts[v]))
+         return BinaryGraphError(error, "invalid vertex");
+   for (e = 0; e < numEdges; e++)
+      if ((fileEdges[e].vertex1 >= numVertices) ||
+          (fileEdges[e].vertex2 >= numVertices) ||
+          (fileEdges[e].label >= numLabels) || (fileEdges[e].directed > 1))
+         return BinaryGraphError(error, "invalid edge");
+   for (v = 0; v < numVertices; v++)
+      for (i = edgeStarts[v]; i < edgeStarts[v + 1]; i++)
+         if ((adjacency[i] >= numEdges) ||
+             ((fileEdges[adjacency[i]].vertex1 != v) &&
+              (fileEdges[adjacency[i]].vertex2 != v)))
+            return BinaryGraphError(error, "invalid adjacency");
+   for (i = 0; i < numLabels; i++)
+      if ((fileLabels[i].labelType == STRING_LABEL) &&
+          ((fileLabels[i].offset >= header->stringBytes) ||
+           (fileLabels[i].length >=
+            header->stringBytes - fileLabels[i].offset) ||
+           (memchr(& strings[fileLabels[i].offset], '\0',
+                   fileLabels[i].length + 1) !=
+            & strings[fileLabels[i].offset + fileLabels[i].length])))
+         return BinaryGraphError(error, "invalid label");
+      else if ((fileLabels[i].labelType != STRING_LABEL) &&
+               (fileLabels[i].labelType != NUMERIC_LABEL))
+         return BinaryGraphError(error, "invalid label");
+
+   // store labels
+   labelMap = (ULONG *) malloc(sizeof(ULONG) * (numLabels + 1));
+   if (labelMap == NULL)
+      OutOfMemoryError("ReadMappedBinaryGraph:labelMap");
+   for (i = 0; i < numLabels; i++)
+   {
+      if (fileLabels[i].labelType == STRING_LABEL)
+         labelMap[i] = StoreStringLabel(& strings[fileLabels[i].offset],
+                                        fileLabels[i].length,
+                                        info->labelList);
+      else
+      {
+         label.labelType = NUMERIC_LABEL;
+         label.labelValue.numericLabel = fileLabels[i].numericLabel;
+         labelMap[i] = StoreLabel(& label, info->labelList);
+      }
+   }
+
+   if (numExamples == 0)
+   {
+      free(labelMap);
+      return 0;
+   }
+
+   // build graph
+   graph = AllocateGraph(numVertices, numEdges);
+   AllocateGraphInfo(graph);
+   if (numAdjacency > 0)
+   {
+      graph->adjacency = (ULONG *) malloc(sizeof(ULONG) * numAdjacency);
+      if (graph->adjacency == NULL)
+         OutOfMemoryError("ReadMappedBinaryGraph:graph->adjacency");
+      memcpy(graph->adjacency, adjacency, sizeof(ULONG) * numAdjacency);
+   }
+   example = 0;
+   exampleStart = 0;
+   for (v = 0; v < numVertices; v++)
+   {
+      while ((example < numExamples) && (examples[example] <= v))
+      {
+         exampleStart = examples[example];
+         example++;
+      }
+      vertex = & graph->vertices[v];
+      vertex->label = labelMap[vertexLabels[v]];
+      vertex->numEdges = edgeStarts[v + 1] - edgeStarts[v];
+      vertex->edges = NULL;
+      if (vertex->numEdges > 0)
+         vertex->edges = & graph->adjacency[edgeStarts[v]];
+      vertex->anomalous = FALSE;
+      graph->vertexInfo[v].sourceVertex = v - exampleStart + 1;
+      graph->vertexInfo[v].sourceExample = 0;
+      graph->vertexInfo[v].originalVertexIndex = v;
+      graph->vertexInfo[v].color = VERTEX_DEFAULT;
+      graph->vertexInfo[v].anomalousValue = 2.0;
+   }
+   for (e = 0; e < numEdges; e++)
+   {
+      edge = & graph->edges[e];
+      edge->vertex1 = fileEdges[e].vertex1;
+      edge->vertex2 = fileEdges[e].vertex2;
+      edge->label = labelMap[fileEdges[e].label];
+      edge->directed = (fileEdges[e].directed == 1);
+      edge->spansIncrement = FALSE;
+      edge->validPath = TRUE;
+      edge->anomalous = FALSE;
+      edgeInfo = & graph->edgeInfo[e];
+      edgeInfo->sourceVertex1 = graph->vertexInfo[edge->vertex1].sourceVertex;
+      edgeInfo->sourceVertex2 = graph->vertexInfo[edge->vertex2].sourceVertex;
+      edgeInfo->sourceExample = 0;
+      edgeInfo->originalEdgeIndex = e;
+      edgeInfo->color = EDGE_DEFAULT;
+      edgeInfo->anomalousValue = 2.0;
+   }
+   free(labelMap);
+
+   info->graph = graph;
+   for (i = 0; i < numExamples; i++)
+   {
+      info->numPosEgs++;
+      info->posEgsVertexIndices =
+         AddVertexIndex(info->posEgsVertexIndices, info->numPosEgs,
+                        examples[i]);
+   }
+   info->vertexOffset = examples[numExamples - 1];
+   info->posGraphVertexListSize = numVertices;
+   info->posGraphEdgeListSize = numEdges;
+   return 0;
+}
+
+
+//******************************************************************************
+// NAME: WriteBinaryGraph
+//
+// INPUTS: (char *fileName) - binary graph file to write
+//         (Graph *graph) - graph to write, whose vertex edge arrays are
+//                          slices of its adjacency array; may be NULL
+//         (LabelList *labelList) - labels of graph
+//         (ULONG numExamples) - number of positive examples in graph
+//         (ULONG *examples) - vertex index at which each example starts
+//
+// RETURN: (void)
+//
+// PURPOSE: Write the graph, its examples and its labels as a binary graph
+// file, to be read by ReadBinaryGraph.
+//******************************************************************************
+
+void WriteBinaryGraph(char *fileName, Graph *graph, LabelList *labelList,
+                      ULONG numExamples, ULONG *examples)
+{
+   FILE *binFile;
+   GraphFileHeader header;
+   GraphFileLabel fileLabel;
+   GraphFileEdge fileEdge;
+   Label *label;
+   ULONG numVertices = 0;
+   ULONG numEdges = 0;
+   ULONG numAdjacency = 0;
+   ULONG i, v, e;
+   ULONG start;
+   BOOLEAN written = TRUE;
+
+   if (graph != NULL)
+   {
+      numVertices = graph->numVertices;
+      numEdges = graph->numEdges;
+      for (v = 0; v < numVertices; v++)
+         numAdjacency += graph->vertices[v].numEdges;
+   }
+   binFile = fopen(fileName, "wb");
+   if (binFile == NULL)
+   {
+      printf("ERROR: unable to write to binary graph file %s\n", fileName);
+      exit(1);
+   }
+
+   memset(& header, 0, sizeof(GraphFileHeader));
+   memcpy(header.magic, GRAPH_BINARY_MAGIC, sizeof(header.magic));
+   header.byteOrder = GRAPH_BINARY_BYTE_ORDER;
+   header.ulongSize = sizeof(ULONG);
+   header.version = GRAPH_BINARY_VERSION;
+   header.numLabels = labelList->numLabels;
+   header.stringBytes = 0;
+   for (i = 0; i < labelList->numLabels; i++)
+      if (labelList->labels[i].labelType == STRING_LABEL)
+         header.stringBytes +=
+            strlen(labelList->labels[i].labelValue.stringLabel) + 1;
+   header.numExamples = numExamples;
+   header.numVertices = numVertices;
+   header.numEdges = numEdges;
+   header.numAdjacency = numAdjacency;
+   written = (fwrite(& header, sizeof(GraphFileHeader), 1, binFile) == 1);
+
+   // label table
+   memset(& fileLabel, 0, sizeof(GraphFileLabel));
+   start = 0;
+   for (i = 0; i < labelList->numLabels; i++)
+   {
+      label = & labelList->labels[i];
+      fileLabel.labelType = label->labelType;
+      fileLabel.offset = 0;
+      fileLabel.length = 0;
+      fileLabel.numericLabel = 0.0;
+      if (label->labelType == STRING_LABEL)
+      {
+         fileLabel.offset = start;
+         fileLabel.length = strlen(label->labelValue.stringLabel);
+         start += fileLabel.length + 1;
+      }
+      else
+         fileLabel.numericLabel = label->labelValue.numericLabel;
+      if (fwrite(& fileLabel, sizeof(GraphFileLabel), 1, binFile) != 1)
+         written = FALSE;
+   }
+
+   // examples, vertex labels and adjacency
+   if ((numExamples > 0) &&
+       (fwrite(examples, sizeof(ULONG), numExamples, binFile) != numExamples))
+      written = FALSE;
+   for (v = 0; v < numVertices; v++)
+      if (fwrite(& graph->vertices[v].label, sizeof(ULONG), 1, binFile) != 1)
+         written = FALSE;
+   start = 0;
+   for (v = 0; v <= numVertices; v++)
+   {
+      if (fwrite(& start, sizeof(ULONG), 1, binFile) != 1)
+         written = FALSE;
+      if (v < numVertices)
+         start += graph->vertices[v].numEdges;
+   }
+   for (v = 0; v < numVertices; v++)
+      if ((graph->vertices[v].numEdges > 0) &&
+          (fwrite(graph->vertices[v].edges, sizeof(ULONG),
+                  graph->vertices[v].numEdges, binFile) !=
+           graph->vertices[v].numEdges))
+         written = FALSE;
+
+   // edges
+   for (e = 0; e < numEdges; e++)
+   {
+      fileEdge.vertex1 = graph->edges[e].vertex1;
+      fileEdge.vertex2 = graph->edges[e].vertex2;
+      fileEdge.label = graph->edges[e].label;
+      fileEdge.directed = (graph->edges[e].directed ? 1 : 0);
+      if (fwrite(& fileEdge, sizeof(GraphFileEdge), 1, binFile) != 1)
+         written = FALSE;
+   }
+
+   // label strings
+   for (i = 0; i < labelList->numLabels; i++)
+   {
+      label = & labelList->labels[i];
+      if ((label->labelType == STRING_LABEL) &&
+          (fwrite(label->labelValue.stringLabel, sizeof(char),
+                  strlen(label->labelValue.stringLabel) + 1, binFile) !=
+           strlen(label->labelValue.stringLabel) + 1))
+         written = FALSE;
+   }
+
+   if ((fclose(binFile) != 0) || (! written))
+   {
+      printf("ERROR: unable to write to binary graph file %s\n", fileName);
+      exit(1);
+   }
+}
+
+
+//******************************************************************************
+// NAME: BinaryGraphError
+//
+// INPUTS: (GP_error *error) - where to report error
+//         (char *message) - description of error
+//
+// RETURN: (int) - 1
+//
+// PURPOSE: Report an error in a binary graph file, which has no line
+// numbers.
+//******************************************************************************
+
+int BinaryGraphError(GP_error *error, char *message)
+{
+   error->lineNo = 0;
+   snprintf(error->message, GP_ERROR_LEN, "%s", message);
+   return 1;
+}
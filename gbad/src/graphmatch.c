@@ -9,6 +9,15 @@
 // 08/12/09  Eberle     Initial version, taken from SUBDUE 5.2.1
 // 12/17/09  Graves     Added initialization of node cost to remove compiler
 //                      warnings
+// 10/16/26  agent      Keep search node mappings in a pooled parent-pointer
+//                      tree instead of copying them per node
+// 10/16/26  agent      GraphMatch rejects graphs whose match cost is bounded
+//                      above the threshold before searching
+// 10/16/26  agent      Added ExactGraphMatch for a threshold of zero
+// 10/17/26  agent      Matched edges of g2 marked in a VisitSet instead of
+//                      the graph
+// 10/17/26  agent      ExactGraphMatch gives up after MaximumNodes mappings, leaving
+//                      the match to InexactGraphMatch
 //
 //******************************************************************************
 
@@ -18,6 +27,15 @@
 #define HeapLeftChild(i) ((2 * i) + 1)
 #define HeapRightChild(i) ((2 * i) + 2)
 
+#define MinCost(a, b) (((a) < (b)) ? (a) : (b))
+#define MIN_VERTEX_EDIT_COST \
+   MinCost(MinCost(INSERT_VERTEX_COST, DELETE_VERTEX_COST), \
+           SUBSTITUTE_VERTEX_LABEL_COST)
+#define MIN_EDGE_EDIT_COST \
+   MinCost(MinCost(MinCost(INSERT_EDGE_COST, INSERT_EDGE_WITH_VERTEX_COST), \
+                   MinCost(DELETE_EDGE_COST, DELETE_EDGE_WITH_VERTEX_COST)), \
+           MinCost(SUBSTITUTE_EDGE_LABEL_COST, SUBSTITUTE_EDGE_DIRECTION_COST))
+
 
 //******************************************************************************
 // NAME:    GraphMatch
@@ -36,13 +54,20 @@
 // PURPOSE: Returns TRUE if g1 and g2 match with cost less than the given
 // threshold.  If so, side-effects are to store the match cost in the
 // variable pointed to by matchCost and to store the mapping between g1 and
-// g2 in the given mapping input if non-NULL.
+// g2 in the given mapping input if non-NULL.  Graphs whose match cost is
+// bounded above the threshold by MatchCostLowerBound are rejected
+// without searching, with a match cost of MAX_DOUBLE as
+// InexactGraphMatch would return.  A threshold of zero asks for an
+// isomorphism, which ExactGraphMatch finds without a cost search.  If
+// that search reaches the same limit on mappings as InexactGraphMatch,
+// the match is left to InexactGraphMatch, which then turns greedy.
 //******************************************************************************
 
 BOOLEAN GraphMatch(Graph *g1, Graph *g2, LabelList *labelList,
                    double threshold, double *matchCost, VertexMap *mapping)
 {
    double cost;
+   ULONG exactMatch = EXACT_MATCH_LIMIT;
 
    // first, quick check for exact matches
    if ((threshold == 0.0) &&
@@ -50,8 +75,23 @@ BOOLEAN GraphMatch(Graph *g1, Graph *g2, LabelList *labelList,
         (g1->numEdges != g2->numEdges)))
       return FALSE;
 
+   // next, check labels and degrees against the threshold
+   if (MatchCostLowerBound(g1, g2) > threshold)
+   {
+      if (matchCost != NULL)
+         *matchCost = MAX_DOUBLE;
+      return FALSE;
+   }
+
+   // exact matches need no cost search
+   if (threshold == 0.0)
+      exactMatch = ExactGraphMatch(g1, g2, mapping);
+   if (exactMatch == EXACT_MATCH_FOUND)
+      cost = 0.0;
+   else if (exactMatch == EXACT_MATCH_NONE)
+      cost = MAX_DOUBLE;
    // call InexactGraphMatch with larger graph first
-   if (g1->numVertices < g2->numVertices)
+   else if (g1->numVertices < g2->numVertices)
       cost = InexactGraphMatch(g2, g1, labelList, threshold, mapping);
    else 
       cost = InexactGraphMatch(g1, g2, labelList, threshold, mapping);
@@ -99,6 +139,10 @@ double InexactGraphMatch(Graph *g1, Graph *g2, LabelList *labelList,
    Edge *edge;
    MatchHeap *globalQueue = NULL;
    MatchHeap *localQueue = NULL;
+   MatchSearchTree *searchTree = NULL;
+   MatchSearchNode *searchNode;
+   ULONG s;
+   ULONG firstChild;
    MatchHeapNode node;
    MatchHeapNode newNode;
    MatchHeapNode bestNode;
@@ -111,6 +155,7 @@ double InexactGraphMatch(Graph *g1, Graph *g2, LabelList *labelList,
    ULONG *orderedVertices = NULL;
    ULONG *mapped1 = NULL; // mapping of vertices in g1 to vertices in g2
    ULONG *mapped2 = NULL; // mapping of vertices in g2 to vertices in g1
+   VisitSet *edgeVisits = NULL; // edges of g2 matched to edges of g1
 
    // Compute threshold on mappings tried before changing from optimal
    // search to greedy search
@@ -129,16 +174,18 @@ double InexactGraphMatch(Graph *g1, Graph *g2, LabelList *labelList,
    mapped2 = (ULONG *) malloc(sizeof(ULONG) * nv2);
    if (mapped2 == NULL)
       OutOfMemoryError("mapped2");
+   edgeVisits = AllocateVisitSet(g2->numEdges);
 
    globalQueue = AllocateMatchHeap(nv1 * nv1);
    localQueue = AllocateMatchHeap(nv1);
+   searchTree = AllocateMatchSearchTree(nv1 * nv1);
    node.depth = 0;
    node.cost = 0.0;
-   node.mapping = NULL;
+   node.searchNode = MATCH_SEARCH_ROOT;
    InsertMatchHeapNode(& node, globalQueue);
    bestNode.depth = 0;
    bestNode.cost = MAX_DOUBLE;
-   bestNode.mapping = NULL;
+   bestNode.searchNode = MATCH_SEARCH_ROOT;
 
    while ((! MatchHeapEmpty(globalQueue)) && (! done)) 
    {
@@ -147,10 +194,9 @@ double InexactGraphMatch(Graph *g1, Graph *g2, LabelList *labelList,
       {
          if (node.depth == nv1) 
          {   // complete mapping found
-            free(bestNode.mapping);
             bestNode.cost = node.cost;
             bestNode.depth = node.depth;
-            bestNode.mapping = node.mapping;
+            bestNode.searchNode = node.searchNode;
             if (! quickMatch)
                done = TRUE;
          } 
@@ -161,12 +207,15 @@ double InexactGraphMatch(Graph *g1, Graph *g2, LabelList *labelList,
                mapped1[i] = VERTEX_UNMAPPED;
             for (i = 0; i < nv2; i++)
                mapped2[i] = VERTEX_UNMAPPED;
-            for (i = 0; i < node.depth; i++) 
+            for (s = node.searchNode; s != MATCH_SEARCH_ROOT;
+                 s = searchNode->parent)
             {
-               mapped1[node.mapping[i].v1] = node.mapping[i].v2;
-               if (node.mapping[i].v2 != VERTEX_DELETED)
-                  mapped2[node.mapping[i].v2] = node.mapping[i].v1;
+               searchNode = & searchTree->nodes[s];
+               mapped1[searchNode->v1] = searchNode->v2;
+               if (searchNode->v2 != VERTEX_DELETED)
+                  mapped2[searchNode->v2] = searchNode->v1;
             }
+            firstChild = searchTree->numNodes;
             v1 = orderedVertices[node.depth];
             // first, try mapping v1 to nothing
             newCost = node.cost + DELETE_VERTEX_COST;
@@ -200,8 +249,8 @@ double InexactGraphMatch(Graph *g1, Graph *g2, LabelList *labelList,
                // add new node to local queue
                newNode.depth = node.depth + 1;
                newNode.cost = newCost;
-               newNode.mapping =
-                  AllocateNewMapping(node.depth + 1, node.mapping, v1,
+               newNode.searchNode =
+                  AddMatchSearchNode(searchTree, node.searchNode, v1,
                                      VERTEX_DELETED);
                InsertMatchHeapNode(& newNode, localQueue);
             }
@@ -218,9 +267,10 @@ double InexactGraphMatch(Graph *g1, Graph *g2, LabelList *labelList,
                                       g2->vertices[v2].label, labelList);
                   if ((newCost <= threshold) && (newCost < bestNode.cost)) 
                   {
-                     cost = DeletedEdgesCost(g1,g2,v1,v2,mapped1,labelList);
+                     cost = DeletedEdgesCost(g1, g2, v1, v2, mapped1, labelList,
+                                             edgeVisits);
                      newCost += cost;
-                     cost = InsertedEdgesCost(g2, v2, mapped2);
+                     cost = InsertedEdgesCost(g2, v2, mapped2, edgeVisits);
                      newCost += cost;
                   }
                   // if complete mapping, add cost for any unmapped vertices
@@ -238,21 +288,26 @@ double InexactGraphMatch(Graph *g1, Graph *g2, LabelList *labelList,
                      // add new node to local queue
                      newNode.depth = node.depth + 1;
                      newNode.cost = newCost;
-                     newNode.mapping = 
-                        AllocateNewMapping(node.depth + 1,node.mapping,v1,v2);
+                     newNode.searchNode =
+                        AddMatchSearchNode(searchTree, node.searchNode, v1, v2);
                      InsertMatchHeapNode(& newNode, localQueue);
                   }
                   mapped1[v1] = VERTEX_UNMAPPED;
                   mapped2[v2] = VERTEX_UNMAPPED;
                }
             }
-            free(node.mapping);
             // Add nodes in localQueue to globalQueue
             if (quickMatch) 
             {
                if (! MatchHeapEmpty(localQueue)) 
                {
                   ExtractMatchHeapNode(localQueue, & node);
+                  // only the best child is kept, so the others' search
+                  // nodes are reclaimed
+                  searchTree->nodes[firstChild] =
+                     searchTree->nodes[node.searchNode];
+                  searchTree->numNodes = firstChild + 1;
+                  node.searchNode = firstChild;
                   InsertMatchHeapNode(& node, globalQueue);
                   ClearMatchHeap(localQueue);
                }
@@ -261,8 +316,6 @@ double InexactGraphMatch(Graph *g1, Graph *g2, LabelList *labelList,
                MergeMatchHeaps(localQueue, globalQueue); // clears localQueue
          }
       } 
-      else 
-         free(node.mapping);
 
       // check if maximum nodes exceeded, and if so, switch to greedy search
       numNodes++;
@@ -274,17 +327,14 @@ double InexactGraphMatch(Graph *g1, Graph *g2, LabelList *labelList,
    } // end while
 
    // copy best mapping to input mapping array, if available
-   if ((mapping != NULL) && (bestNode.mapping != NULL))
-      for (i = 0; i < nv1; i++) 
-      {
-         mapping[i].v1 = bestNode.mapping[i].v1;
-         mapping[i].v2 = bestNode.mapping[i].v2;
-      }
+   if ((mapping != NULL) && (bestNode.searchNode != MATCH_SEARCH_ROOT))
+      GetMatchSearchMapping(searchTree, bestNode.searchNode, nv1, mapping);
 
    // free memory
-   free(bestNode.mapping);
+   FreeMatchSearchTree(searchTree);
    FreeMatchHeap(localQueue);
    FreeMatchHeap(globalQueue);
+   FreeVisitSet(edgeVisits);
    free(mapped2);
    free(mapped1);
    free(orderedVertices);
@@ -293,6 +343,482 @@ double InexactGraphMatch(Graph *g1, Graph *g2, LabelList *labelList,
 }
 
 
+//******************************************************************************
+// NAME:    ExactGraphMatch
+//
+// INPUTS:  (Graph *g1)
+//          (Graph *g2) - graphs to be matched, with the same numbers of
+//                        vertices and edges
+//          (VertexMap *mapping) - array to hold final vertex mapping;
+//                                 if NULL, then ignored
+//
+// RETURN:  (ULONG) - EXACT_MATCH_FOUND if g1 and g2 are isomorphic,
+//          EXACT_MATCH_NONE if not, or EXACT_MATCH_LIMIT if more than
+//          MaximumNodes(number of vertices) mappings were tried
+//
+// PURPOSE: Exact counterpart of InexactGraphMatch for a threshold of
+// zero.  Vertices of g1 are mapped one at a time, in the order given by
+// ExactMatchOrder, by depth-first backtracking.  Once a vertex of g1
+// with an already-mapped neighbor is reached, only neighbors of that
+// neighbor's image are candidates, and every candidate must pass
+// ExactMatchFeasible.  All working storage is allocated once per call.
+// A side-effect is to store the mapping between g1 and g2, in the order
+// vertices were mapped, in the given mapping input if non-NULL.
+//******************************************************************************
+
+ULONG ExactGraphMatch(Graph *g1, Graph *g2, VertexMap *mapping)
+{
+   ULONG n = g1->numVertices;
+   ULONG *storage;
+   ULONG *order;       // g1 vertices in the order they are mapped
+   ULONG *parent;      // mapped neighbor of order[d], or VERTEX_UNMAPPED
+   ULONG *next;        // next candidate to try at each depth
+   ULONG *mapped1;     // mapping of vertices in g1 to vertices in g2
+   ULONG *mapped2;     // mapping of vertices in g2 to vertices in g1
+   ULONG *scratch;
+   VisitSet *edgeVisits;
+   Vertex *parentVertex;
+   Edge *edge;
+   ULONG depth;
+   ULONG v1, v2;
+   ULONG p2;
+   ULONG i, k;
+   ULONG numNodes = 0;
+   ULONG maxNodes;
+   ULONG result;
+   BOOLEAN found;
+   BOOLEAN duplicate;
+
+   if (n == 0)
+      return EXACT_MATCH_FOUND;
+   // same limit on mappings tried as InexactGraphMatch
+   maxNodes = MaximumNodes(n);
+   storage = (ULONG *) malloc(sizeof(ULONG) * 7 * n);
+   if (storage == NULL)
+      OutOfMemoryError("ExactGraphMatch:storage");
+   order = storage;
+   parent = & storage[n];
+   next = & storage[2 * n];
+   mapped1 = & storage[3 * n];
+   mapped2 = & storage[4 * n];
+   scratch = & storage[5 * n];
+   edgeVisits = AllocateVisitSet(g2->numEdges);
+   for (i = 0; i < n; i++)
+   {
+      mapped1[i] = VERTEX_UNMAPPED;
+      mapped2[i] = VERTEX_UNMAPPED;
+   }
+   ExactMatchOrder(g1, order, parent, scratch);
+
+   depth = 0;
+   next[0] = 0;
+   while ((depth < n) && (numNodes <= maxNodes))
+   {
+      // find next feasible candidate for order[depth]
+      v1 = order[depth];
+      found = FALSE;
+      if (parent[depth] == VERTEX_UNMAPPED)
+      {
+         while ((! found) && (next[depth] < n))
+         {
+            v2 = next[depth];
+            next[depth]++;
+            if ((mapped2[v2] == VERTEX_UNMAPPED) &&
+                (ExactMatchFeasible(g1, g2, v1, v2, mapped1, mapped2,
+                                    edgeVisits)))
+               found = TRUE;
+         }
+      }
+      else
+      {
+         p2 = mapped1[parent[depth]];
+         parentVertex = & g2->vertices[p2];
+         while ((! found) && (next[depth] < parentVertex->numEdges))
+         {
+            k = next[depth];
+            next[depth]++;
+            edge = & g2->edges[parentVertex->edges[k]];
+            v2 = edge->vertex1;
+            if (v2 == p2)
+               v2 = edge->vertex2;
+            // skip mapped neighbors and those already tried through a
+            // parallel edge
+            duplicate = (mapped2[v2] != VERTEX_UNMAPPED);
+            for (i = 0; (i < k) && (! duplicate); i++)
+            {
+               edge = & g2->edges[parentVertex->edges[i]];
+               if ((edge->vertex1 == v2) || (edge->vertex2 == v2))
+                  duplicate = TRUE;
+            }
+            if ((! duplicate) &&
+                (ExactMatchFeasible(g1, g2, v1, v2, mapped1, mapped2,
+                                    edgeVisits)))
+               found = TRUE;
+         }
+      }
+
+      if (found)
+      {
+         mapped1[v1] = v2;
+         mapped2[v2] = v1;
+         numNodes++;
+         depth++;
+         if (depth < n)
+            next[depth] = 0;
+      }
+      else
+      {
+         // backtrack
+         if (depth == 0)
+            break;
+         depth--;
+         v1 = order[depth];
+         mapped2[mapped1[v1]] = VERTEX_UNMAPPED;
+         mapped1[v1] = VERTEX_UNMAPPED;
+      }
+   }
+
+   if (depth == n)
+      result = EXACT_MATCH_FOUND;
+   else if (numNodes > maxNodes)
+      result = EXACT_MATCH_LIMIT;
+   else
+      result = EXACT_MATCH_NONE;
+   if ((result == EXACT_MATCH_FOUND) && (mapping != NULL))
+      for (i = 0; i < n; i++)
+      {
+         mapping[i].v1 = order[i];
+         mapping[i].v2 = mapped1[order[i]];
+      }
+   FreeVisitSet(edgeVisits);
+   free(storage);
+
+   return result;
+}
+
+
+//******************************************************************************
+// NAME:    ExactMatchOrder
+//
+// INPUTS:  (Graph *g) - graph whose vertices are to be ordered
+//          (ULONG *order) - array to hold vertex indices in match order
+//          (ULONG *parent) - array to hold, for each position in order,
+//                            an earlier neighbor, or VERTEX_UNMAPPED
+//          (ULONG *scratch) - space for 2 * (number of vertices) values
+//
+// RETURN:  (void)
+//
+// PURPOSE: Order the vertices for ExactGraphMatch.  Each next vertex is
+// the one with the most edges to vertices already ordered, ties going
+// to the higher degree, so the search stays connected and the most
+// constrained vertices are mapped first.
+//******************************************************************************
+
+void ExactMatchOrder(Graph *g, ULONG *order, ULONG *parent, ULONG *scratch)
+{
+   ULONG n = g->numVertices;
+   ULONG *connections;
+   ULONG *firstNeighbor;
+   Edge *edge;
+   ULONG i, v, e;
+   ULONG best;
+   ULONG other;
+
+   connections = scratch;   // edges to ordered vertices, or VERTEX_UNMAPPED
+   firstNeighbor = & scratch[n];
+   for (v = 0; v < n; v++)
+   {
+      connections[v] = 0;
+      firstNeighbor[v] = VERTEX_UNMAPPED;
+   }
+   for (i = 0; i < n; i++)
+   {
+      best = VERTEX_UNMAPPED;
+      for (v = 0; v < n; v++)
+         if ((connections[v] != VERTEX_UNMAPPED) &&
+             ((best == VERTEX_UNMAPPED) ||
+              (connections[v] > connections[best]) ||
+              ((connections[v] == connections[best]) &&
+               (g->vertices[v].numEdges > g->vertices[best].numEdges))))
+            best = v;
+      order[i] = best;
+      parent[i] = firstNeighbor[best];
+      connections[best] = VERTEX_UNMAPPED; // ordered
+      for (e = 0; e < g->vertices[best].numEdges; e++)
+      {
+         edge = & g->edges[g->vertices[best].edges[e]];
+         other = edge->vertex1;
+         if (other == best)
+            other = edge->vertex2;
+         if (connections[other] != VERTEX_UNMAPPED)
+         {
+            connections[other]++;
+            if (firstNeighbor[other] == VERTEX_UNMAPPED)
+               firstNeighbor[other] = best;
+         }
+      }
+   }
+}
+
+
+//******************************************************************************
+// NAME:    ExactMatchFeasible
+//
+// INPUTS:  (Graph *g1)
+//          (Graph *g2) - graphs being matched
+//          (ULONG v1) - unmapped vertex in g1
+//          (ULONG v2) - unmapped vertex in g2
+//          (ULONG *mapped1) - mapping of vertices in g1 to vertices in g2
+//          (ULONG *mapped2) - mapping of vertices in g2 to vertices in g1
+//          (VisitSet *edgeVisits) - scratch marks on edges of g2
+//
+// RETURN:  (BOOLEAN) - TRUE if v1 -> v2 extends the mapping exactly
+//
+// PURPOSE: Check that v1 and v2 have the same label and degree, and
+// that the edges between v1 and mapped vertices (including v1 itself)
+// correspond one-to-one to the edges between v2 and their images, with
+// the same labels, directedness and direction.  These are the mappings
+// for which DeletedEdgesCost and InsertedEdgesCost add nothing.
+//******************************************************************************
+
+BOOLEAN ExactMatchFeasible(Graph *g1, Graph *g2, ULONG v1, ULONG v2,
+                           ULONG *mapped1, ULONG *mapped2,
+                           VisitSet *edgeVisits)
+{
+   Vertex *vertex1 = & g1->vertices[v1];
+   Vertex *vertex2 = & g2->vertices[v2];
+   Edge *edge1, *edge2;
+   ULONG e1, e2;
+   ULONG other1, other2;
+   ULONG target;
+   ULONG numEdges1 = 0;
+   ULONG numEdges2 = 0;
+   BOOLEAN feasible = TRUE;
+
+   if ((vertex1->label != vertex2->label) ||
+       (vertex1->numEdges != vertex2->numEdges))
+      return FALSE;
+
+   mapped1[v1] = v2;
+   mapped2[v2] = v1;
+   ClearVisitSet(edgeVisits, g2->numEdges);
+   // match each edge of v1 to a mapped vertex with an unused edge of v2
+   for (e1 = 0; (e1 < vertex1->numEdges) && feasible; e1++)
+   {
+      edge1 = & g1->edges[vertex1->edges[e1]];
+      other1 = edge1->vertex1;
+      if (other1 == v1)
+         other1 = edge1->vertex2;
+      if (mapped1[other1] != VERTEX_UNMAPPED)
+      {
+         numEdges1++;
+         target = mapped1[other1];
+         feasible = FALSE;
+         for (e2 = 0; (e2 < vertex2->numEdges) && (! feasible); e2++)
+         {
+            edge2 = & g2->edges[vertex2->edges[e2]];
+            other2 = edge2->vertex1;
+            if (other2 == v2)
+               other2 = edge2->vertex2;
+            if ((! VISITED(edgeVisits, vertex2->edges[e2])) &&
+                (other2 == target) &&
+                (edge1->label == edge2->label) &&
+                (edge1->directed == edge2->directed) &&
+                ((! edge1->directed) ||
+                 ((edge1->vertex1 == v1) == (edge2->vertex1 == v2))))
+            {
+               VISIT(edgeVisits, vertex2->edges[e2]);
+               feasible = TRUE;
+            }
+         }
+      }
+   }
+   // v2 must have no other edges to mapped vertices
+   for (e2 = 0; e2 < vertex2->numEdges; e2++)
+   {
+      edge2 = & g2->edges[vertex2->edges[e2]];
+      other2 = edge2->vertex1;
+      if (other2 == v2)
+         other2 = edge2->vertex2;
+      if (mapped2[other2] != VERTEX_UNMAPPED)
+         numEdges2++;
+   }
+   mapped1[v1] = VERTEX_UNMAPPED;
+   mapped2[v2] = VERTEX_UNMAPPED;
+
+   return (feasible && (numEdges1 == numEdges2));
+}
+
+
+//******************************************************************************
+// NAME: MatchCostLowerBound
+//
+// INPUTS: (Graph *g1)
+//         (Graph *g2) - graphs to be matched
+//
+// RETURN: (double) - lower bound on the cost InexactGraphMatch finds
+//                    for g1 and g2
+//
+// PURPOSE: Bound the match cost from the graphs' vertex label and edge
+// label multisets and their sorted degree sequences, without
+// searching.  With g1 the graph with more vertices (n1 >= n2), a
+// complete mapping maps some vertices of g1 to g2, deletes the rest,
+// and inserts the unmapped vertices of g2.  Then
+//
+//   - vertices cost at least n1 - (common vertex labels), and at
+//     least n1 - n2 + 4 if two or more vertices of g2 are inserted;
+//   - an edge of g1 costs nothing only if matched to an edge of g2
+//     with the same label and directedness, so edges of g1 cost at
+//     least m1 - (common edge labels);
+//   - an edge is matched at a mapped vertex pair, using an edge of
+//     each vertex, so pairing the degree sequences in sorted order
+//     bounds the unmatched edges of g1 by half their total surplus;
+//   - edges of g2 are charged the same way, except that
+//     InsertedVerticesCost does not charge edges between two inserted
+//     vertices, so the g2 terms only count when at most one vertex of
+//     g2 is inserted.
+//
+// The label terms assume LabelMatchFactor is either 0 or 1.
+//******************************************************************************
+
+double MatchCostLowerBound(Graph *g1, Graph *g2)
+{
+   Graph *g;
+   ULONG *values;
+   ULONG *values1;
+   ULONG *values2;
+   ULONG n1, n2, m1, m2;
+   ULONG commonVertexLabels;
+   ULONG commonEdgeLabels;
+   ULONG surplus1 = 0;    // degree of g1 vertices not matched in g2
+   ULONG surplus2 = 0;    // degree of g2 vertices not matched in g1
+   ULONG d1, d2;
+   ULONG vertexOps;
+   ULONG edgeOps;
+   ULONG i;
+   double bound;
+   double manyInsertedBound;
+
+   if (g1->numVertices < g2->numVertices)
+   {
+      g = g1;
+      g1 = g2;
+      g2 = g;
+   }
+   n1 = g1->numVertices;
+   n2 = g2->numVertices;
+   m1 = g1->numEdges;
+   m2 = g2->numEdges;
+   values = (ULONG *) malloc(sizeof(ULONG) * (n1 + n2 + m1 + m2 + 1));
+   if (values == NULL)
+      OutOfMemoryError("MatchCostLowerBound:values");
+
+   // common vertex labels
+   values1 = values;
+   values2 = & values[n1];
+   for (i = 0; i < n1; i++)
+      values1[i] = g1->vertices[i].label;
+   for (i = 0; i < n2; i++)
+      values2[i] = g2->vertices[i].label;
+   commonVertexLabels = CommonValues(values1, n1, values2, n2);
+
+   // common edge labels, with directedness
+   values1 = & values[n1 + n2];
+   values2 = & values[n1 + n2 + m1];
+   for (i = 0; i < m1; i++)
+      values1[i] = (2 * g1->edges[i].label) + g1->edges[i].directed;
+   for (i = 0; i < m2; i++)
+      values2[i] = (2 * g2->edges[i].label) + g2->edges[i].directed;
+   commonEdgeLabels = CommonValues(values1, m1, values2, m2);
+
+   // degree surpluses, pairing largest degrees first
+   values1 = values;
+   values2 = & values[n1];
+   for (i = 0; i < n1; i++)
+      values1[i] = g1->vertices[i].numEdges;
+   for (i = 0; i < n2; i++)
+      values2[i] = g2->vertices[i].numEdges;
+   SortULONGs(values1, n1);
+   SortULONGs(values2, n2);
+   for (i = 0; i < n1; i++)
+   {
+      d1 = values1[n1 - 1 - i];
+      d2 = 0;
+      if (i < n2)
+         d2 = values2[n2 - 1 - i];
+      if (d1 > d2)
+         surplus1 += d1 - d2;
+      else
+         surplus2 += d2 - d1;
+   }
+   free(values);
+
+   // at most one vertex of g2 inserted
+   vertexOps = n1 - commonVertexLabels;
+   edgeOps = m1 - commonEdgeLabels;
+   if (m2 > m1)
+      edgeOps = m2 - commonEdgeLabels;
+   if (((surplus1 + 1) / 2) + ((surplus2 + 1) / 2) > edgeOps)
+      edgeOps = ((surplus1 + 1) / 2) + ((surplus2 + 1) / 2);
+   bound = (vertexOps * MIN_VERTEX_EDIT_COST) + (edgeOps * MIN_EDGE_EDIT_COST);
+
+   // two or more vertices of g2 inserted
+   if (n2 > 1)
+   {
+      if (n1 - n2 + 4 > vertexOps)
+         vertexOps = n1 - n2 + 4;
+      edgeOps = m1 - commonEdgeLabels;
+      if ((surplus1 + 1) / 2 > edgeOps)
+         edgeOps = (surplus1 + 1) / 2;
+      manyInsertedBound = (vertexOps * MIN_VERTEX_EDIT_COST) +
+                          (edgeOps * MIN_EDGE_EDIT_COST);
+      if (manyInsertedBound < bound)
+         bound = manyInsertedBound;
+   }
+   return bound;
+}
+
+
+//******************************************************************************
+// NAME: CommonValues
+//
+// INPUTS: (ULONG *values1) - first multiset of values
+//         (ULONG numValues1) - size of first multiset
+//         (ULONG *values2) - second multiset of values
+//         (ULONG numValues2) - size of second multiset
+//
+// RETURN: (ULONG) - size of the intersection of the two multisets
+//
+// PURPOSE: Count the values the two multisets have in common.  Both
+// arrays are sorted as a side-effect.
+//******************************************************************************
+
+ULONG CommonValues(ULONG *values1, ULONG numValues1,
+                   ULONG *values2, ULONG numValues2)
+{
+   ULONG i = 0;
+   ULONG j = 0;
+   ULONG numCommon = 0;
+
+   SortULONGs(values1, numValues1);
+   SortULONGs(values2, numValues2);
+   while ((i < numValues1) && (j < numValues2))
+   {
+      if (values1[i] < values2[j])
+         i++;
+      else if (values1[i] > values2[j])
+         j++;
+      else
+      {
+         numCommon++;
+         i++;
+         j++;
+      }
+   }
+   return numCommon;
+}
+
+
 //******************************************************************************
 // NAME: OrderVerticesByDegree
 //
@@ -367,6 +893,8 @@ ULONG MaximumNodes(ULONG n)
 //         (ULONG v2) - vertex in g2 being mapped
 //         (ULONG *mapped1) - mapping of vertices in g1 to vertices in g2
 //         (LabelList *labelList) - label list containing labels for g1 and g2
+//         (VisitSet *edgeVisits) - marks on edges of g2, set to the edges
+//                                  matched to edges of g1
 //
 // RETURN: (double) - cost of match edges according to given mapping
 //
@@ -379,16 +907,19 @@ ULONG MaximumNodes(ULONG n)
 //******************************************************************************
 
 double DeletedEdgesCost(Graph *g1, Graph *g2, ULONG v1, ULONG v2,
-                        ULONG *mapped1, LabelList *labelList)
+                        ULONG *mapped1, LabelList *labelList,
+                        VisitSet *edgeVisits)
 {
    ULONG e1, e2;
    Edge *edge1, *edge2;
    ULONG otherVertex1, otherVertex2;
-   Edge *bestMatchEdge;
+   ULONG bestMatchEdge = 0;
    double bestMatchCost;
    double matchCost;
    double totalCost = 0.0;
 
+   ClearVisitSet(edgeVisits, g2->numEdges);
+
    // try to match each edge involving v1 to an edge involving v2
    for (e1 = 0; e1 < g1->vertices[v1].numEdges; e1++) 
    {
@@ -401,13 +932,12 @@ double DeletedEdgesCost(Graph *g1, Graph *g2, ULONG v1, ULONG v2,
           (mapped1[otherVertex1] != VERTEX_DELETED)) 
       {
          // target vertex of edge also mapped
-         bestMatchEdge = NULL;
          bestMatchCost = -1.0;
          otherVertex2 = mapped1[otherVertex1];
          for (e2 = 0; e2 < g2->vertices[v2].numEdges; e2++) 
          {
             edge2 = & g2->edges[g2->vertices[v2].edges[e2]];
-            if ((! edge2->used) &&
+            if ((! VISITED(edgeVisits, g2->vertices[v2].edges[e2])) &&
                 (((edge2->vertex1 == otherVertex2) && (edge2->vertex2 == v2)) ||
                 ((edge2->vertex1 == v2) && (edge2->vertex2 == otherVertex2)))) 
             {
@@ -427,15 +957,15 @@ double DeletedEdgesCost(Graph *g1, Graph *g2, ULONG v1, ULONG v2,
                if ((matchCost < bestMatchCost) || (bestMatchCost < 0.0)) 
                {
                   bestMatchCost = matchCost;
-                  bestMatchEdge = edge2;
+                  bestMatchEdge = g2->vertices[v2].edges[e2];
                }
             }
          }
          // if matching edge found, then add cost of match and mark edge used;
          // else add cost of deleting edge from g1
-         if (bestMatchEdge != NULL) 
+         if (bestMatchCost >= 0.0) 
          {
-            bestMatchEdge->used = TRUE;
+            VISIT(edgeVisits, bestMatchEdge);
             totalCost += bestMatchCost;
          } 
          else 
@@ -452,6 +982,8 @@ double DeletedEdgesCost(Graph *g1, Graph *g2, ULONG v1, ULONG v2,
 // INPUTS: (Graph *g2) - graph containing vertex being mapped to
 //         (ULONG v2) - vertex in g2 being mapped to
 //         (ULONG *mapped2) - array mapping vertices of g2 to vertices of g1
+//         (VisitSet *edgeVisits) - marks on edges of g2 matched by
+//                                  DeletedEdgesCost()
 //
 // RETURN: (double) - cost of inserting edges found in g2 between v2
 //                    and another mapped vertex, but not matched to
@@ -464,7 +996,8 @@ double DeletedEdgesCost(Graph *g1, Graph *g2, ULONG v1, ULONG v2,
 // NOTE: Assumes DeletedEdgesCost() run before this one.
 //******************************************************************************
 
-double InsertedEdgesCost(Graph *g2, ULONG v2, ULONG *mapped2)
+double InsertedEdgesCost(Graph *g2, ULONG v2, ULONG *mapped2,
+                         VisitSet *edgeVisits)
 {
    ULONG e2;
    Edge *edge2;
@@ -473,13 +1006,12 @@ double InsertedEdgesCost(Graph *g2, ULONG v2, ULONG *mapped2)
    for (e2 = 0; e2 < g2->vertices[v2].numEdges; e2++) 
    {
       edge2 = & g2->edges[g2->vertices[v2].edges[e2]];
-      if ((! edge2->used) &&
+      if ((! VISITED(edgeVisits, g2->vertices[v2].edges[e2])) &&
           (mapped2[edge2->vertex1] != VERTEX_UNMAPPED) &&
           (mapped2[edge2->vertex2] != VERTEX_UNMAPPED)) 
       {
          totalCost += INSERT_EDGE_COST;
       }
-      edge2->used = FALSE;
    }
    return totalCost;
 }
@@ -560,37 +1092,120 @@ MatchHeap *AllocateMatchHeap(ULONG size)
 
 
 //******************************************************************************
-// NAME: AllocateNewMapping
+// NAME: AllocateMatchSearchTree
+//
+// INPUTS: (ULONG size) - initial number of search nodes
 //
-// INPUTS: (ULONG depth) - depth (vertices mapped) of new node in search space
-//         (VertexMap *mapping) - partial mapping to be augmented
+// RETURN: (MatchSearchTree *) - empty search tree
+//
+// PURPOSE: Allocate the pool of search nodes for one call to
+// InexactGraphMatch.  Each node of the search space records only the
+// vertex map it adds to its parent's mapping, so a new node costs no
+// copying, and the whole tree is freed at once when the match is done.
+//******************************************************************************
+
+MatchSearchTree *AllocateMatchSearchTree(ULONG size)
+{
+   MatchSearchTree *tree;
+
+   if (size < LIST_SIZE_INC)
+      size = LIST_SIZE_INC;
+   tree = (MatchSearchTree *) malloc(sizeof(MatchSearchTree));
+   if (tree == NULL)
+      OutOfMemoryError("AllocateMatchSearchTree:tree");
+   tree->size = size;
+   tree->numNodes = 0;
+   tree->nodes = (MatchSearchNode *) malloc(size * sizeof(MatchSearchNode));
+   if (tree->nodes == NULL)
+      OutOfMemoryError("AllocateMatchSearchTree:tree->nodes");
+
+   return tree;
+}
+
+
+//******************************************************************************
+// NAME: AddMatchSearchNode
+//
+// INPUTS: (MatchSearchTree *tree) - search tree to add to
+//         (ULONG parent) - search node whose mapping is augmented, or
+//                          MATCH_SEARCH_ROOT for the empty mapping
 //         (ULONG v1)
 //         (ULONG v2) - node's mapping includes v1 -> v2
 //
-// RETURN:  (VertexMap *) - newly-allocated vertex mapping
+// RETURN: (ULONG) - index of new search node
 //
-// PURPOSE: Allocate a new vertex mapping as a copy of the given mapping
+// PURPOSE: Add a search node whose mapping is the parent's mapping
 // appended with the new map v1 -> v2.
 //******************************************************************************
 
-VertexMap *AllocateNewMapping(ULONG depth, VertexMap *mapping,
-                ULONG v1, ULONG v2)
+ULONG AddMatchSearchNode(MatchSearchTree *tree, ULONG parent,
+                         ULONG v1, ULONG v2)
 {
-   VertexMap *newMapping;
+   MatchSearchNode *node;
+
+   if (tree->numNodes == tree->size)
+   {
+      tree->size = 2 * tree->size;
+      tree->nodes = (MatchSearchNode *) realloc
+                    (tree->nodes, tree->size * sizeof(MatchSearchNode));
+      if (tree->nodes == NULL)
+         OutOfMemoryError("AddMatchSearchNode:tree->nodes");
+   }
+   node = & tree->nodes[tree->numNodes];
+   node->parent = parent;
+   node->v1 = v1;
+   node->v2 = v2;
+   tree->numNodes++;
+
+   return tree->numNodes - 1;
+}
+
+
+//******************************************************************************
+// NAME: GetMatchSearchMapping
+//
+// INPUTS: (MatchSearchTree *tree) - search tree containing node
+//         (ULONG searchNode) - last vertex map of the mapping
+//         (ULONG depth) - number of vertex maps in the mapping
+//         (VertexMap *mapping) - array to hold the mapping
+//
+// RETURN: (void)
+//
+// PURPOSE: Store the mapping ending at the given search node in the
+// given array, in the order the vertices were mapped.
+//******************************************************************************
+
+void GetMatchSearchMapping(MatchSearchTree *tree, ULONG searchNode,
+                           ULONG depth, VertexMap *mapping)
+{
+   ULONG s;
    ULONG i;
 
-   newMapping = (VertexMap *) malloc(sizeof(VertexMap) * depth);
-   if (newMapping == NULL)
-      OutOfMemoryError("AllocateNewMapping: newMapping");
-   for (i = 0; i < (depth - 1); i++) 
+   i = depth;
+   for (s = searchNode; (s != MATCH_SEARCH_ROOT) && (i > 0);
+        s = tree->nodes[s].parent)
    {
-      newMapping[i].v1 = mapping[i].v1;
-      newMapping[i].v2 = mapping[i].v2;
+      i--;
+      mapping[i].v1 = tree->nodes[s].v1;
+      mapping[i].v2 = tree->nodes[s].v2;
    }
-   newMapping[depth-1].v1 = v1;
-   newMapping[depth-1].v2 = v2;
+}
+
+
+//******************************************************************************
+// NAME: FreeMatchSearchTree
+//
+// INPUTS: (MatchSearchTree *tree) - search tree to free
+//
+// RETURN: (void)
+//
+// PURPOSE: Free memory in given search tree.
+//******************************************************************************
 
-   return newMapping;
+void FreeMatchSearchTree(MatchSearchTree *tree)
+{
+   free(tree->nodes);
+   free(tree);
 }
 
 
@@ -654,7 +1269,7 @@ void InsertMatchHeapNode(MatchHeapNode *node, MatchHeap *heap)
       {
          heap->nodes[i].cost = heap->nodes[parent].cost;
          heap->nodes[i].depth = heap->nodes[parent].depth;
-         heap->nodes[i].mapping = heap->nodes[parent].mapping;
+         heap->nodes[i].searchNode = heap->nodes[parent].searchNode;
          i = parent;
       } 
       else 
@@ -663,7 +1278,7 @@ void InsertMatchHeapNode(MatchHeapNode *node, MatchHeap *heap)
    // store new node
    heap->nodes[i].cost = node->cost;
    heap->nodes[i].depth = node->depth;
-   heap->nodes[i].mapping = node->mapping;
+   heap->nodes[i].searchNode = node->searchNode;
 }
 
 
@@ -687,13 +1302,13 @@ void ExtractMatchHeapNode(MatchHeap *heap, MatchHeapNode *node)
    // copy best node to input storage node
    node->cost = heap->nodes[0].cost;
    node->depth = heap->nodes[0].depth;
-   node->mapping = heap->nodes[0].mapping;
+   node->searchNode = heap->nodes[0].searchNode;
 
    // copy last node in heap array to first
    i = heap->numNodes - 1;
    heap->nodes[0].cost = heap->nodes[i].cost;
    heap->nodes[0].depth = heap->nodes[i].depth;
-   heap->nodes[0].mapping = heap->nodes[i].mapping;
+   heap->nodes[0].searchNode = heap->nodes[i].searchNode;
    heap->numNodes--;
  
    HeapifyMatchHeap(heap);
@@ -725,7 +1340,7 @@ void HeapifyMatchHeap(MatchHeap *heap)
    MatchHeapNode *rightNode;
    ULONG tmpDepth;
    double tmpCost;
-   VertexMap *tmpMapping;
+   ULONG tmpSearchNode;
 
    parent = 0;
    best = 1;
@@ -765,13 +1380,13 @@ void HeapifyMatchHeap(MatchHeap *heap)
       {
          tmpCost = parentNode->cost;
          tmpDepth = parentNode->depth;
-         tmpMapping = parentNode->mapping;
+         tmpSearchNode = parentNode->searchNode;
          parentNode->cost = bestNode->cost;
          parentNode->depth = bestNode->depth;
-         parentNode->mapping = bestNode->mapping;
+         parentNode->searchNode = bestNode->searchNode;
          bestNode->cost = tmpCost;
          bestNode->depth = tmpDepth;
-         bestNode->mapping = tmpMapping;
+         bestNode->searchNode = tmpSearchNode;
          parent = best;
          best = 0; // something other than parent so while loop continues
       }
@@ -802,7 +1417,6 @@ void MergeMatchHeaps(MatchHeap *heap1, MatchHeap *heap2)
    {
       node = & heap1->nodes[i];
       InsertMatchHeapNode(node, heap2);
-      node->mapping = NULL;
    }
    heap1->numNodes = 0;
 }
@@ -820,7 +1434,7 @@ void MergeMatchHeaps(MatchHeap *heap1, MatchHeap *heap2)
 // search within the InexactGraphMatch function.  The first n nodes
 // are left on the heap.  If there are more nodes on the heap, then
 // the nodes with unique costs remain on the heap, and the rest are
-// freed.  Note that the heap is assumed to already be in increasing
+// dropped.  Note that the heap is assumed to already be in increasing
 // order by cost, and for nodes having the same cost, in decreasing
 // order by depth.
 //******************************************************************************
@@ -848,9 +1462,7 @@ void CompressMatchHeap(MatchHeap *heap, ULONG n)
    while (! MatchHeapEmpty(heap)) 
    {
       ExtractMatchHeapNode(heap, & node2);
-      if (node1.cost == node2.cost)
-         free(node2.mapping);
-      else 
+      if (node1.cost != node2.cost)
       {
          InsertMatchHeapNode(& node2, newHeap);
          node1.cost = node2.cost;
@@ -870,29 +1482,37 @@ void CompressMatchHeap(MatchHeap *heap, ULONG n)
 // NAME: PrintMatchHeapNode
 //
 // INPUTS: (MatchHeapNode *node) - match node to print
+//         (MatchSearchTree *tree) - search tree holding node's mapping
 //
 // RETURN: (void)
 //
 // PURPOSE: Print match node.
 //******************************************************************************
 
-void PrintMatchHeapNode(MatchHeapNode *node)
+void PrintMatchHeapNode(MatchHeapNode *node, MatchSearchTree *tree)
 {
    ULONG i;
+   VertexMap *mapping;
+
    printf("MatchHeapNode: depth = %lu, cost = %f, mapping =",
            node->depth, node->cost);
    if (node->depth > 0) 
    {
+      mapping = (VertexMap *) malloc(sizeof(VertexMap) * node->depth);
+      if (mapping == NULL)
+         OutOfMemoryError("PrintMatchHeapNode:mapping");
+      GetMatchSearchMapping(tree, node->searchNode, node->depth, mapping);
       printf("\n");
       for (i = 0; i < node->depth; i++) 
       {
-         printf("            %lu -> ", node->mapping[i].v1);
-         if (node->mapping[i].v2 == VERTEX_UNMAPPED)
+         printf("            %lu -> ", mapping[i].v1);
+         if (mapping[i].v2 == VERTEX_UNMAPPED)
             printf("unmapped\n");
-         else if (node->mapping[i].v2 == VERTEX_DELETED)
+         else if (mapping[i].v2 == VERTEX_DELETED)
             printf("deleted\n");
-         else printf("%lu\n", node->mapping[i].v2);
+         else printf("%lu\n", mapping[i].v2);
       }
+      free(mapping);
    } 
    else 
       printf(" NULL\n");
@@ -903,13 +1523,14 @@ void PrintMatchHeapNode(MatchHeapNode *node)
 // NAME: PrintMatchHeap
 //
 // INPUTS: (MatchHeap *heap) - match node heap to print
+//         (MatchSearchTree *tree) - search tree holding nodes' mappings
 //
 // RETURN: (void)
 //
 // PURPOSE: Print match node list.
 //******************************************************************************
 
-void PrintMatchHeap(MatchHeap *heap)
+void PrintMatchHeap(MatchHeap *heap, MatchSearchTree *tree)
 {
    ULONG i;
    MatchHeapNode *node;
@@ -919,7 +1540,7 @@ void PrintMatchHeap(MatchHeap *heap)
    {
       node = & heap->nodes[i];
       printf("(%lu) ", i);
-      PrintMatchHeapNode(node);
+      PrintMatchHeapNode(node, tree);
    }
 }
 
@@ -931,16 +1552,12 @@ void PrintMatchHeap(MatchHeap *heap)
 //
 // RETURN: (void)
 //
-// PURPOSE: Free mappings of match nodes still in heap and reset heap to
-// have zero nodes.
+// PURPOSE: Reset heap to have zero nodes.  The nodes' mappings belong
+// to the search tree and are freed with it.
 //******************************************************************************
 
 void ClearMatchHeap(MatchHeap *heap)
 {
-   ULONG i;
-
-   for (i = 0; i < heap->numNodes; i++)
-      free(heap->nodes[i].mapping);
    heap->numNodes = 0;
 }
 
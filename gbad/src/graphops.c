@@ -8,6 +8,16 @@
 // ========  =========  ========================================================
 // 08/12/09  Eberle     Initial version, taken from SUBDUE 5.2.1
 // 12/17/09  Graves     Added GUI coloring logic
+// 10/16/26  agent      Vertex edge arrays are slices of one adjacency array
+//                      built in bulk by BuildGraphAdjacency
+// 10/16/26  agent      Source and GUI fields stored in graph side tables
+// 10/17/26  agent      Added VisitSet functions
+// 10/17/26  agent      Exit if GP_read_graph reports an error
+// 10/17/26  agent      ReadInputFile reads binary graph files
+// 10/17/26  agent      Added CopyOriginalGraph
+// 10/17/26  agent      Added SetPosVertexExamples
+// 10/17/26  agent      Added graph label index
+// 10/17/26  agent      Added graph edge type index
 //
 //******************************************************************************
 
@@ -26,12 +36,14 @@
 // the positive graph fields of the parameters.  Each example in the input file 
 // is prefaced by the appropriate token defined in gbad.h.  The first graph in 
 // the file is assumed positive.  Each graph is assumed to begin at vertex #1 
-// and therefore examples are not connected to one another.
+// and therefore examples are not connected to one another.  A binary graph
+// file written by graph2bin is read without parsing; its edges keep the
+// directedness they were converted with.
 //******************************************************************************
 
 void ReadInputFile(Parameters *parameters)
 {
-   ULONG index;
+   GP_error error;
    
    Graph_Info info;
    info.graph = parameters->posGraph;
@@ -48,7 +60,22 @@ void ReadInputFile(Parameters *parameters)
    
    info.xp_graph = TRUE;
    
-   GP_read_graph(&info, parameters->inputFileName);
+   if (BinaryGraphFile(parameters->inputFileName))
+   {
+      if (ReadBinaryGraph(&info, parameters->inputFileName, &error) != 0)
+      {
+         fprintf(stderr, "%s: error: %s\n", parameters->inputFileName,
+                 error.message);
+         exit(1);
+      }
+   }
+   else
+   {
+      if (GP_read_graph(&info, parameters->inputFileName) != 0)
+         exit(1);
+      if (info.graph != NULL)
+         BuildGraphAdjacency(info.graph);
+   }
   
    parameters->posGraph = info.graph;
    parameters->labelList = info.labelList;
@@ -60,6 +87,26 @@ void ReadInputFile(Parameters *parameters)
    
 	
    // GUI coloring
+   CopyOriginalGraph(parameters);
+}
+
+
+//******************************************************************************
+// NAME: CopyOriginalGraph
+//
+// INPUTS: (Parameters *parameters)
+//
+// RETURN: (void)
+//
+// PURPOSE: Keep a copy of the positive graph and its labels as read, on
+// which anomalous values are recorded for coloring and reporting while
+// the positive graph itself is compressed.
+//******************************************************************************
+
+void CopyOriginalGraph(Parameters *parameters)
+{
+   ULONG index;
+
    if (parameters->posGraph == NULL)
       parameters->originalPosGraph = NULL;
    else
@@ -116,6 +163,7 @@ ULONG *AddVertexIndex(ULONG *vertexIndices, ULONG n, ULONG index)
 
 void ReadPredefinedSubsFile(Parameters *parameters)
 {
+   ULONG i;
    Graph_Info info;
    info.graph = NULL;
    info.labelList = parameters->labelList;
@@ -131,7 +179,10 @@ void ReadPredefinedSubsFile(Parameters *parameters)
    
    info.xp_graph = FALSE;
    
-   GP_read_graph(&info, parameters->psInputFileName);
+   if (GP_read_graph(&info, parameters->psInputFileName) != 0)
+      exit(1);
+   for (i = 0; i < info.numPreSubs; i++)
+      BuildGraphAdjacency(info.preSubs[i]);
   
    parameters->labelList = info.labelList;
    parameters->preSubs = info.preSubs;
@@ -151,17 +202,21 @@ void ReadPredefinedSubsFile(Parameters *parameters)
 // RETURN: (void)
 //
 // PURPOSE: Add vertex information to graph. AddVertex also changes the
-// size of the currently-allocated vertex array, which increases by
-// LIST_SIZE_INC (instead of just 1) when exceeded.
+// size of the currently-allocated vertex array, and of the graph's vertex
+// information table with it, which increases by LIST_SIZE_INC (instead
+// of just 1) when exceeded.
 //******************************************************************************
 
 void AddVertex(Graph *graph, ULONG labelIndex, ULONG *vertexListSize, 
                ULONG sourceVertex)
 {
    Vertex *newVertexList;
+   VertexInfo *newVertexInfo;
    ULONG numVertices;
 
    numVertices = graph->numVertices;
+   FreeGraphLabelIndex(graph);
+   FreeGraphEdgeIndex(graph);
    // make sure there is enough room for another vertex
    if (*vertexListSize == graph->numVertices) 
    {
@@ -171,21 +226,24 @@ void AddVertex(Graph *graph, ULONG labelIndex, ULONG *vertexListSize,
       if (newVertexList == NULL)
          OutOfMemoryError("vertex list");
       graph->vertices = newVertexList;
+      newVertexInfo = (VertexInfo *) realloc(graph->vertexInfo,
+                                   (sizeof(VertexInfo) * (*vertexListSize)));
+      if (newVertexInfo == NULL)
+         OutOfMemoryError("AddVertex:newVertexInfo");
+      graph->vertexInfo = newVertexInfo;
    }
 
    // store information in vertex
    graph->vertices[numVertices].label = labelIndex;
    graph->vertices[numVertices].numEdges = 0;
    graph->vertices[numVertices].edges = NULL;
-   graph->vertices[numVertices].map = VERTEX_UNMAPPED;
-   graph->vertices[numVertices].used = FALSE;
-   graph->vertices[numVertices].sourceVertex = sourceVertex;
-   graph->vertices[numVertices].sourceExample = 0;   // will set later...
+   graph->vertexInfo[numVertices].sourceVertex = sourceVertex;
+   graph->vertexInfo[numVertices].sourceExample = 0;   // will set later...
 
    // GUI coloring
-   graph->vertices[numVertices].originalVertexIndex = numVertices;
-   graph->vertices[numVertices].color = VERTEX_DEFAULT;
-   graph->vertices[numVertices].anomalousValue = 2.0;
+   graph->vertexInfo[numVertices].originalVertexIndex = numVertices;
+   graph->vertexInfo[numVertices].color = VERTEX_DEFAULT;
+   graph->vertexInfo[numVertices].anomalousValue = 2.0;
 
    graph->numVertices++;
 }
@@ -206,8 +264,11 @@ void AddVertex(Graph *graph, ULONG labelIndex, ULONG *vertexListSize,
 // RETURN: (void)
 //
 // PURPOSE: Add edge information to graph. AddEdge also changes the
-// size of the currently-allocated edge array, which increases by
-// LIST_SIZE_INC (instead of just 1) when exceeded.
+// size of the currently-allocated edge array, and of the graph's edge
+// information table with it, which increases by LIST_SIZE_INC (instead
+// of just 1) when exceeded.  The vertices' edge
+// arrays are not updated; BuildGraphAdjacency must be called once all
+// edges have been added.
 //******************************************************************************
 
 void AddEdge(Graph *graph, ULONG sourceVertexIndex, ULONG targetVertexIndex,
@@ -215,7 +276,10 @@ void AddEdge(Graph *graph, ULONG sourceVertexIndex, ULONG targetVertexIndex,
              BOOLEAN spansIncrement)
 {
    Edge *newEdgeList;
+   EdgeInfo *newEdgeInfo;
+   EdgeInfo *edgeInfo;
 
+   FreeGraphEdgeIndex(graph);
    // make sure there is enough room for another edge in the graph
    if (*edgeListSize == graph->numEdges) 
    {
@@ -225,6 +289,11 @@ void AddEdge(Graph *graph, ULONG sourceVertexIndex, ULONG targetVertexIndex,
       if (newEdgeList == NULL)
          OutOfMemoryError("AddEdge:newEdgeList");
       graph->edges = newEdgeList;
+      newEdgeInfo = (EdgeInfo *) realloc(graph->edgeInfo,
+                                   (sizeof(EdgeInfo) * (*edgeListSize)));
+      if (newEdgeInfo == NULL)
+         OutOfMemoryError("AddEdge:newEdgeInfo");
+      graph->edgeInfo = newEdgeInfo;
    }
 
    // add edge to graph
@@ -232,25 +301,22 @@ void AddEdge(Graph *graph, ULONG sourceVertexIndex, ULONG targetVertexIndex,
    graph->edges[graph->numEdges].vertex2 = targetVertexIndex;
    graph->edges[graph->numEdges].label = labelIndex;
    graph->edges[graph->numEdges].directed = directed;
-   graph->edges[graph->numEdges].used = FALSE;
    graph->edges[graph->numEdges].spansIncrement = spansIncrement;
    graph->edges[graph->numEdges].validPath = TRUE;
    //
    // GBAD-P: Initialize anomalous flag and source vertices
    //
    graph->edges[graph->numEdges].anomalous = FALSE;
-   graph->edges[graph->numEdges].sourceVertex1 = graph->vertices[sourceVertexIndex].sourceVertex;
-   graph->edges[graph->numEdges].sourceVertex2 = graph->vertices[targetVertexIndex].sourceVertex;
-   graph->edges[graph->numEdges].sourceExample = 0;   // will set later...
+   edgeInfo = & graph->edgeInfo[graph->numEdges];
+   edgeInfo->sourceVertex1 = graph->vertexInfo[sourceVertexIndex].sourceVertex;
+   edgeInfo->sourceVertex2 = graph->vertexInfo[targetVertexIndex].sourceVertex;
+   edgeInfo->sourceExample = 0;   // will set later...
    //
 
-   // add index to edge in edge index array of both vertices
-   AddEdgeToVertices(graph, graph->numEdges);
-
    // GUI coloring
-   graph->edges[graph->numEdges].originalEdgeIndex = graph->numEdges;
-   graph->edges[graph->numEdges].color = EDGE_DEFAULT;
-   graph->edges[graph->numEdges].anomalousValue = 2.0;
+   edgeInfo->originalEdgeIndex = graph->numEdges;
+   edgeInfo->color = EDGE_DEFAULT;
+   edgeInfo->anomalousValue = 2.0;
 
    graph->numEdges++;
 }
@@ -280,50 +346,553 @@ void StoreEdge(Edge *overlapEdges, ULONG edgeIndex,
    overlapEdges[edgeIndex].vertex2 = v2;
    overlapEdges[edgeIndex].label = label;
    overlapEdges[edgeIndex].directed = directed;
-   overlapEdges[edgeIndex].used = FALSE;
    overlapEdges[edgeIndex].spansIncrement = spansIncrement;
 }
 
 
 //******************************************************************************
-// NAME: AddEdgeToVertices
+// NAME: BuildGraphAdjacency
 //
-// INPUTS: (Graph *graph) - graph containing edge and vertices
-//         (ULONG edgeIndex) - edge's index into graph edge array
+// INPUTS: (Graph *graph) - graph whose vertex edge arrays are built
 //
 // RETURN: (void)
 //
-// PURPOSE: Add edge index to the edge array of each of the two
-// vertices involved in the edge.  If a self-edge, then only add once.
+// PURPOSE: Build the edge array of every vertex from the graph's edges.
+// The edge arrays are consecutive slices of a single adjacency array
+// owned by the graph, each holding the indices of the vertex's edges in
+// increasing order; a self edge is only added once.  Any existing edge
+// arrays are freed first, so this can be called again after edges are
+// added to the graph.
 //******************************************************************************
 
-void AddEdgeToVertices(Graph *graph, ULONG edgeIndex)
+void BuildGraphAdjacency(Graph *graph)
 {
+   ULONG v, e;
    ULONG v1, v2;
+   ULONG numEntries;
    Vertex *vertex;
-   ULONG *edgeIndices;
-
-   v1 = graph->edges[edgeIndex].vertex1;
-   v2 = graph->edges[edgeIndex].vertex2;
-   vertex = & graph->vertices[v1];
-   edgeIndices = (ULONG *) realloc(vertex->edges,
-                                   sizeof(ULONG) * (vertex->numEdges + 1));
-   if (edgeIndices == NULL)
-      OutOfMemoryError("AddEdgeToVertices:edgeIndices1");
-   edgeIndices[vertex->numEdges] = edgeIndex;
-   vertex->edges = edgeIndices;
-   vertex->numEdges++;
-
-   if (v1 != v2) 
-   { // don't add a self edge twice
-      vertex = & graph->vertices[v2];
-      edgeIndices = (ULONG *) realloc(vertex->edges,
-                                      sizeof(ULONG) * (vertex->numEdges + 1));
-      if (edgeIndices == NULL)
-         OutOfMemoryError("AddEdgeToVertices:edgeIndices2");
-      edgeIndices[vertex->numEdges] = edgeIndex;
-      vertex->edges = edgeIndices;
+
+   // free existing edge arrays and count the edges of each vertex
+   FreeGraphEdgeIndex(graph);
+   if (graph->adjacency != NULL)
+      free(graph->adjacency);
+   else
+      for (v = 0; v < graph->numVertices; v++)
+         free(graph->vertices[v].edges);
+   graph->adjacency = NULL;
+   for (v = 0; v < graph->numVertices; v++)
+      graph->vertices[v].numEdges = 0;
+   numEntries = 0;
+   for (e = 0; e < graph->numEdges; e++)
+   {
+      v1 = graph->edges[e].vertex1;
+      v2 = graph->edges[e].vertex2;
+      graph->vertices[v1].numEdges++;
+      numEntries++;
+      if (v1 != v2)
+      { // don't add a self edge twice
+         graph->vertices[v2].numEdges++;
+         numEntries++;
+      }
+   }
+
+   // assign each vertex its slice of the adjacency array
+   if (numEntries > 0)
+   {
+      graph->adjacency = (ULONG *) malloc(sizeof(ULONG) * numEntries);
+      if (graph->adjacency == NULL)
+         OutOfMemoryError("BuildGraphAdjacency:graph->adjacency");
+   }
+   numEntries = 0;
+   for (v = 0; v < graph->numVertices; v++)
+   {
+      vertex = & graph->vertices[v];
+      vertex->edges = NULL;
+      if (vertex->numEdges > 0)
+         vertex->edges = & graph->adjacency[numEntries];
+      numEntries += vertex->numEdges;
+      vertex->numEdges = 0;
+   }
+
+   // fill in edge indices in edge order
+   for (e = 0; e < graph->numEdges; e++)
+   {
+      v1 = graph->edges[e].vertex1;
+      v2 = graph->edges[e].vertex2;
+      vertex = & graph->vertices[v1];
+      vertex->edges[vertex->numEdges] = e;
       vertex->numEdges++;
+      if (v1 != v2)
+      {
+         vertex = & graph->vertices[v2];
+         vertex->edges[vertex->numEdges] = e;
+         vertex->numEdges++;
+      }
+   }
+}
+
+
+//******************************************************************************
+// NAME: GetGraphLabelIndex
+//
+// INPUTS: (Graph *graph)
+//
+// RETURN: (GraphLabelIndex *) - graph's vertices grouped by label
+//
+// PURPOSE: Return the graph's label index, building it by counting sort if
+// not yet built.  The index is kept with the graph until the graph's
+// vertex labels change (FreeGraphLabelIndex), so it is only built once per
+// version of the positive graph.  Since building changes the graph, the
+// first call for a graph must not be made while other threads read it.
+//******************************************************************************
+
+GraphLabelIndex *GetGraphLabelIndex(Graph *graph)
+{
+   GraphLabelIndex *index;
+   ULONG v;
+   ULONG label;
+   ULONG numLabels;
+
+   if (graph->labelIndex != NULL)
+      return graph->labelIndex;
+
+   numLabels = 0;
+   for (v = 0; v < graph->numVertices; v++)
+      if (graph->vertices[v].label >= numLabels)
+         numLabels = graph->vertices[v].label + 1;
+
+   index = (GraphLabelIndex *) malloc(sizeof(GraphLabelIndex));
+   if (index == NULL)
+      OutOfMemoryError("GetGraphLabelIndex:index");
+   index->numLabels = numLabels;
+   index->starts = (ULONG *) calloc(numLabels + 1, sizeof(ULONG));
+   index->vertices = (ULONG *) malloc(sizeof(ULONG) *
+                                      (graph->numVertices + 1));
+   if ((index->starts == NULL) || (index->vertices == NULL))
+      OutOfMemoryError("GetGraphLabelIndex:arrays");
+
+   // count vertices of each label, then turn counts into bucket starts
+   for (v = 0; v < graph->numVertices; v++)
+      index->starts[graph->vertices[v].label + 1]++;
+   for (label = 0; label < numLabels; label++)
+      index->starts[label + 1] += index->starts[label];
+
+   // fill buckets in vertex order, using starts as fill positions
+   for (v = 0; v < graph->numVertices; v++)
+   {
+      label = graph->vertices[v].label;
+      index->vertices[index->starts[label]] = v;
+      index->starts[label]++;
+   }
+   // each fill position is now the start of the next bucket
+   for (label = numLabels; label > 0; label--)
+      index->starts[label] = index->starts[label - 1];
+   index->starts[0] = 0;
+
+   graph->labelIndex = index;
+   return index;
+}
+
+
+//******************************************************************************
+// NAME: FreeGraphLabelIndex
+//
+// INPUTS: (Graph *graph)
+//
+// RETURN: (void)
+//
+// PURPOSE: Free the graph's label index, if built, so that it is rebuilt
+// on next use.  Called whenever the graph's vertex labels change.
+//******************************************************************************
+
+void FreeGraphLabelIndex(Graph *graph)
+{
+   if (graph->labelIndex != NULL)
+   {
+      free(graph->labelIndex->starts);
+      free(graph->labelIndex->vertices);
+      free(graph->labelIndex);
+      graph->labelIndex = NULL;
+   }
+}
+
+
+//******************************************************************************
+// NAME: GetGraphEdgeIndex
+//
+// INPUTS: (Graph *graph)
+//
+// RETURN: (GraphEdgeIndex *) - graph's edges grouped by type
+//
+// PURPOSE: Return the graph's edge type index, building it if not yet
+// built.  Each edge is given a type through the index's hash table.  The
+// incidences of edges on vertices, taken in edge order, are then sorted
+// by counting sort on their type and again on their vertex, so that each
+// vertex's edges end up grouped by type and in increasing order within a
+// type.  As with GetGraphLabelIndex, the index is kept until the graph
+// changes, and the first call for a graph must be made before other
+// threads read it.
+//******************************************************************************
+
+GraphEdgeIndex *GetGraphEdgeIndex(Graph *graph)
+{
+   GraphEdgeIndex *index;
+   ULONG key[EDGE_TYPE_KEY_LEN];
+   ULONG v, e;
+   ULONG i, type, slot;
+   ULONG numEntries;
+   ULONG *typeStarts;
+   ULONG *entryVertices;
+   ULONG *entryEdges;
+   Edge *edge;
+
+   if (graph->edgeIndex != NULL)
+      return graph->edgeIndex;
+
+   index = (GraphEdgeIndex *) malloc(sizeof(GraphEdgeIndex));
+   if (index == NULL)
+      OutOfMemoryError("GetGraphEdgeIndex:index");
+   index->numTypes = 0;
+   index->hashSize = 1;
+   while (index->hashSize < (2 * graph->numEdges))
+      index->hashSize *= 2;
+   index->hashTable = (ULONG *) malloc(sizeof(ULONG) * index->hashSize);
+   index->typeKeys = (ULONG *)
+      malloc(sizeof(ULONG) * EDGE_TYPE_KEY_LEN * (graph->numEdges + 1));
+   index->typeCounts = (ULONG *) malloc(sizeof(ULONG) * (graph->numEdges + 1));
+   index->edgeTypes = (ULONG *) malloc(sizeof(ULONG) * (graph->numEdges + 1));
+   index->starts = (ULONG *) calloc(graph->numVertices + 1, sizeof(ULONG));
+   typeStarts = (ULONG *) calloc(graph->numEdges + 2, sizeof(ULONG));
+   if ((index->hashTable == NULL) || (index->typeKeys == NULL) ||
+       (index->typeCounts == NULL) || (index->edgeTypes == NULL) ||
+       (index->starts == NULL) || (typeStarts == NULL))
+      OutOfMemoryError("GetGraphEdgeIndex:arrays");
+   for (slot = 0; slot < index->hashSize; slot++)
+      index->hashTable[slot] = EDGE_TYPE_NONE;
+
+   // type each edge, adding new types to the hash index, and count the
+   // edges and incidences of each type
+   numEntries = 0;
+   for (e = 0; e < graph->numEdges; e++)
+   {
+      edge = & graph->edges[e];
+      EdgeTypeKey(graph, edge, key);
+      type = FindEdgeType(index, key);
+      if (type == EDGE_TYPE_NONE)
+      {
+         type = index->numTypes;
+         index->numTypes++;
+         for (i = 0; i < EDGE_TYPE_KEY_LEN; i++)
+            index->typeKeys[(type * EDGE_TYPE_KEY_LEN) + i] = key[i];
+         index->typeCounts[type] = 0;
+         slot = EdgeTypeHash(key) & (index->hashSize - 1);
+         while (index->hashTable[slot] != EDGE_TYPE_NONE)
+            slot = (slot + 1) & (index->hashSize - 1);
+         index->hashTable[slot] = type;
+      }
+      index->edgeTypes[e] = type;
+      index->typeCounts[type]++;
+      typeStarts[type + 1]++;
+      numEntries++;
+      if (edge->vertex1 != edge->vertex2)
+      { // don't add a self edge twice
+         typeStarts[type + 1]++;
+         numEntries++;
+      }
+   }
+
+   // sort the incidences of edges on vertices by type
+   entryVertices = (ULONG *) malloc(sizeof(ULONG) * (numEntries + 1));
+   entryEdges = (ULONG *) malloc(sizeof(ULONG) * (numEntries + 1));
+   index->edges = (ULONG *) malloc(sizeof(ULONG) * (numEntries + 1));
+   if ((entryVertices == NULL) || (entryEdges == NULL) ||
+       (index->edges == NULL))
+      OutOfMemoryError("GetGraphEdgeIndex:entries");
+   for (type = 0; type < index->numTypes; type++)
+      typeStarts[type + 1] += typeStarts[type];
+   for (e = 0; e < graph->numEdges; e++)
+   {
+      edge = & graph->edges[e];
+      type = index->edgeTypes[e];
+      entryVertices[typeStarts[type]] = edge->vertex1;
+      entryEdges[typeStarts[type]] = e;
+      typeStarts[type]++;
+      if (edge->vertex1 != edge->vertex2)
+      {
+         entryVertices[typeStarts[type]] = edge->vertex2;
+         entryEdges[typeStarts[type]] = e;
+         typeStarts[type]++;
+      }
+   }
+
+   // then by vertex, keeping each vertex's edges in type order
+   for (i = 0; i < numEntries; i++)
+      index->starts[entryVertices[i] + 1]++;
+   for (v = 0; v < graph->numVertices; v++)
+      index->starts[v + 1] += index->starts[v];
+   for (i = 0; i < numEntries; i++)
+   {
+      index->edges[index->starts[entryVertices[i]]] = entryEdges[i];
+      index->starts[entryVertices[i]]++;
+   }
+   for (v = graph->numVertices; v > 0; v--)
+      index->starts[v] = index->starts[v - 1];
+   index->starts[0] = 0;
+
+   free(typeStarts);
+   free(entryVertices);
+   free(entryEdges);
+   graph->edgeIndex = index;
+   return index;
+}
+
+
+//******************************************************************************
+// NAME: FreeGraphEdgeIndex
+//
+// INPUTS: (Graph *graph)
+//
+// RETURN: (void)
+//
+// PURPOSE: Free the graph's edge type index, if built, so that it is
+// rebuilt on next use.  Called whenever the graph's vertices, edges or
+// labels change.
+//******************************************************************************
+
+void FreeGraphEdgeIndex(Graph *graph)
+{
+   GraphEdgeIndex *index = graph->edgeIndex;
+
+   if (index != NULL)
+   {
+      free(index->typeKeys);
+      free(index->typeCounts);
+      free(index->hashTable);
+      free(index->edgeTypes);
+      free(index->starts);
+      free(index->edges);
+      free(index);
+      graph->edgeIndex = NULL;
+   }
+}
+
+
+//******************************************************************************
+// NAME: EdgeTypeKey
+//
+// INPUTS: (Graph *graph) - graph containing edge
+//         (Edge *edge)
+//         (ULONG *key) - set to the EDGE_TYPE_KEY_LEN values of edge's type
+//
+// RETURN: (void)
+//
+// PURPOSE: Compute the key of the edge's type.  Two edges have the same
+// key exactly when EdgesMatch finds them to match.
+//******************************************************************************
+
+void EdgeTypeKey(Graph *graph, Edge *edge, ULONG *key)
+{
+   ULONG label1 = graph->vertices[edge->vertex1].label;
+   ULONG label2 = graph->vertices[edge->vertex2].label;
+
+   if ((! edge->directed) && (label2 < label1))
+   {
+      key[0] = label2;
+      key[2] = label1;
+   }
+   else
+   {
+      key[0] = label1;
+      key[2] = label2;
+   }
+   key[1] = edge->label;
+   key[3] = edge->directed;
+}
+
+
+//******************************************************************************
+// NAME: EdgeTypeHash
+//
+// INPUTS: (ULONG *key) - edge type key
+//
+// RETURN: (ULONG) - hash value of key
+//
+// PURPOSE: Compute the FNV-1a hash value of an edge type key.
+//******************************************************************************
+
+ULONG EdgeTypeHash(ULONG *key)
+{
+   unsigned long long hash = 14695981039346656037ULL;
+   ULONG i;
+
+   for (i = 0; i < EDGE_TYPE_KEY_LEN; i++)
+      hash = (hash ^ key[i]) * 1099511628211ULL;
+   return (ULONG) (hash ^ (hash >> 32));
+}
+
+
+//******************************************************************************
+// NAME: FindEdgeType
+//
+// INPUTS: (GraphEdgeIndex *index) - edge type index of a graph
+//         (ULONG *key) - edge type key
+//
+// RETURN: (ULONG) - type with the given key, or EDGE_TYPE_NONE if no edge
+//                   of the graph has it
+//
+// PURPOSE: Look up an edge type in the index's hash table, by linear
+// probing from the key's hash value.
+//******************************************************************************
+
+ULONG FindEdgeType(GraphEdgeIndex *index, ULONG *key)
+{
+   ULONG slot;
+   ULONG type;
+   ULONG i;
+   BOOLEAN found = FALSE;
+
+   slot = EdgeTypeHash(key) & (index->hashSize - 1);
+   type = index->hashTable[slot];
+   while ((type != EDGE_TYPE_NONE) && (! found))
+   {
+      found = TRUE;
+      for (i = 0; i < EDGE_TYPE_KEY_LEN; i++)
+         if (index->typeKeys[(type * EDGE_TYPE_KEY_LEN) + i] != key[i])
+            found = FALSE;
+      if (! found)
+      {
+         slot = (slot + 1) & (index->hashSize - 1);
+         type = index->hashTable[slot];
+      }
+   }
+   return type;
+}
+
+
+//******************************************************************************
+// NAME: VertexEdgesOfType
+//
+// INPUTS: (GraphEdgeIndex *index) - edge type index of a graph
+//         (ULONG v) - vertex of the graph
+//         (ULONG type) - edge type
+//         (ULONG **edges) - set to the vertex's edges of the type
+//
+// RETURN: (ULONG) - number of the vertex's edges of the type
+//
+// PURPOSE: Find the vertex's edges of the given type, in increasing
+// order, by binary search on the vertex's edges, which are grouped by
+// type in increasing type order.
+//******************************************************************************
+
+ULONG VertexEdgesOfType(GraphEdgeIndex *index, ULONG v, ULONG type,
+                        ULONG **edges)
+{
+   ULONG low = index->starts[v];
+   ULONG high = index->starts[v + 1];
+   ULONG middle;
+   ULONG first;
+
+   // find first edge of type at least the given one
+   while (low < high)
+   {
+      middle = (low + high) / 2;
+      if (index->edgeTypes[index->edges[middle]] < type)
+         low = middle + 1;
+      else
+         high = middle;
+   }
+   first = low;
+   high = index->starts[v + 1];
+   while ((low < high) && (index->edgeTypes[index->edges[low]] == type))
+      low++;
+   *edges = & index->edges[first];
+   return low - first;
+}
+
+
+//******************************************************************************
+// NAME: AllocateVisitSet
+//
+// INPUTS: (ULONG size) - number of vertices or edges to be marked
+//
+// RETURN: (VisitSet *) - visit set with no index marked
+//
+// PURPOSE: Allocate a set of marks for the vertices or edges of a graph.
+// Routines that used to mark the graph itself mark a visit set instead,
+// so a graph can be shared by threads that only read it.
+//******************************************************************************
+
+VisitSet *AllocateVisitSet(ULONG size)
+{
+   VisitSet *set;
+
+   set = (VisitSet *) malloc(sizeof(VisitSet));
+   if (set == NULL)
+      OutOfMemoryError("AllocateVisitSet:set");
+   set->size = size;
+   set->epoch = 1;
+   set->stamps = (ULONG *) calloc(size + 1, sizeof(ULONG));
+   set->values = (ULONG *) malloc(sizeof(ULONG) * (size + 1));
+   if ((set->stamps == NULL) || (set->values == NULL))
+      OutOfMemoryError("AllocateVisitSet:arrays");
+   return set;
+}
+
+
+//******************************************************************************
+// NAME: ClearVisitSet
+//
+// INPUTS: (VisitSet *set) - visit set to clear
+//         (ULONG size) - number of vertices or edges to be marked next
+//
+// RETURN: (void)
+//
+// PURPOSE: Unmark every index of the set by advancing its epoch, growing
+// the set first if it is smaller than the given size.  The stamps are
+// only rewritten when the epoch wraps around to zero.
+//******************************************************************************
+
+void ClearVisitSet(VisitSet *set, ULONG size)
+{
+   ULONG i;
+
+   if (size > set->size)
+   {
+      set->stamps = (ULONG *) realloc(set->stamps, sizeof(ULONG) * (size + 1));
+      set->values = (ULONG *) realloc(set->values, sizeof(ULONG) * (size + 1));
+      if ((set->stamps == NULL) || (set->values == NULL))
+         OutOfMemoryError("ClearVisitSet:arrays");
+      for (i = set->size + 1; i <= size; i++)
+         set->stamps[i] = 0;
+      set->size = size;
+   }
+   set->epoch++;
+   if (set->epoch == 0)
+   {
+      for (i = 0; i <= set->size; i++)
+         set->stamps[i] = 0;
+      set->epoch = 1;
+   }
+}
+
+
+//******************************************************************************
+// NAME: FreeVisitSet
+//
+// INPUTS: (VisitSet *set) - visit set to free
+//
+// RETURN: (void)
+//
+// PURPOSE: Free memory used by visit set.
+//******************************************************************************
+
+void FreeVisitSet(VisitSet *set)
+{
+   if (set != NULL)
+   {
+      free(set->stamps);
+      free(set->values);
+      free(set);
    }
 }
 
@@ -352,6 +921,11 @@ Graph *AllocateGraph(ULONG v, ULONG e)
    graph->numEdges = e;
    graph->vertices = NULL;
    graph->edges = NULL;
+   graph->adjacency = NULL;
+   graph->vertexInfo = NULL;
+   graph->edgeInfo = NULL;
+   graph->labelIndex = NULL;
+   graph->edgeIndex = NULL;
    if (v > 0) 
    {
       graph->vertices = (Vertex *) malloc(sizeof(Vertex) * v);
@@ -368,6 +942,29 @@ Graph *AllocateGraph(ULONG v, ULONG e)
    return graph;
 }
 
+//******************************************************************************
+// NAME:    AllocateGraphInfo
+//
+// INPUTS:  (Graph *graph) - graph with vertex and edge arrays allocated
+//
+// RETURN:  void
+//
+// PURPOSE: Allocate the vertex and edge information tables of the given
+// graph, one entry per vertex and edge.  Only graphs derived from the
+// input graph carry these tables; substructure and instance graphs,
+// which are only matched, do not.
+//******************************************************************************
+
+void AllocateGraphInfo(Graph *graph)
+{
+   graph->vertexInfo = (VertexInfo *)
+      malloc(sizeof(VertexInfo) * (graph->numVertices + 1));
+   graph->edgeInfo = (EdgeInfo *)
+      malloc(sizeof(EdgeInfo) * (graph->numEdges + 1));
+   if ((graph->vertexInfo == NULL) || (graph->edgeInfo == NULL))
+      OutOfMemoryError("AllocateGraphInfo");
+}
+
 //******************************************************************************
 // NAME:    CopyGraph
 //
@@ -385,37 +982,25 @@ Graph *CopyGraph(Graph *g)
    ULONG ne;
    ULONG v;
    ULONG e;
-   ULONG numEdges;
 
    nv = g->numVertices;
    ne = g->numEdges;
 
    // allocate graph
    gCopy = AllocateGraph(nv, ne);
+   if (g->vertexInfo != NULL)
+   {
+      AllocateGraphInfo(gCopy);
+      memcpy(gCopy->vertexInfo, g->vertexInfo, sizeof(VertexInfo) * nv);
+      memcpy(gCopy->edgeInfo, g->edgeInfo, sizeof(EdgeInfo) * ne);
+   }
 
-   // copy vertices; allocate and copy vertex edge arrays
+   // copy vertices; vertex edge arrays are rebuilt below
    for (v = 0; v < nv; v++) 
    {
       gCopy->vertices[v].label = g->vertices[v].label;
-      gCopy->vertices[v].map = g->vertices[v].map;
-      gCopy->vertices[v].used = g->vertices[v].used;
-      numEdges = g->vertices[v].numEdges;
-      gCopy->vertices[v].numEdges = numEdges;
+      gCopy->vertices[v].numEdges = 0;
       gCopy->vertices[v].edges = NULL;
-      gCopy->vertices[v].sourceVertex = g->vertices[v].sourceVertex;
-      gCopy->vertices[v].sourceExample = g->vertices[v].sourceExample;
-      if (numEdges > 0) 
-      {
-          gCopy->vertices[v].edges = (ULONG *) malloc(numEdges * sizeof(ULONG));
-          if (gCopy->vertices[v].edges == NULL)
-             OutOfMemoryError("CopyGraph:edges");
-          for (e = 0; e < numEdges; e++)
-             gCopy->vertices[v].edges[e] = g->vertices[v].edges[e];
-      }
-      // GUI coloring
-      gCopy->vertices[v].originalVertexIndex = g->vertices[v].originalVertexIndex;
-      gCopy->vertices[v].color = g->vertices[v].color;
-      gCopy->vertices[v].anomalousValue = g->vertices[v].anomalousValue;
    }
 
    // copy edges
@@ -425,15 +1010,76 @@ Graph *CopyGraph(Graph *g)
       gCopy->edges[e].vertex2 = g->edges[e].vertex2;
       gCopy->edges[e].label = g->edges[e].label;
       gCopy->edges[e].directed = g->edges[e].directed;
-      gCopy->edges[e].used = g->edges[e].used;
-      gCopy->edges[e].sourceVertex1 = g->edges[e].sourceVertex1;
-      gCopy->edges[e].sourceVertex2 = g->edges[e].sourceVertex2;
-      gCopy->edges[e].sourceExample = g->edges[e].sourceExample;
-      // GUI coloring
-      gCopy->edges[e].originalEdgeIndex = g->edges[e].originalEdgeIndex;
-      gCopy->edges[e].color = g->edges[e].color;
-      gCopy->edges[e].anomalousValue = g->edges[e].anomalousValue;
    }
+   BuildGraphAdjacency(gCopy);
+
+   return gCopy;
+}
+
+
+//******************************************************************************
+// NAME:    CopyExampleGraph
+//
+// INPUTS:  (Graph *g) - graph containing the example
+//          (ULONG start) - index of first vertex of the example
+//          (ULONG finish) - index one past the last vertex of the example
+//
+// RETURN:  (Graph *) - pointer to copy of the example graph
+//
+// PURPOSE: Create and return a copy of the vertices in [start,finish) of
+// the given graph, and the edges between them, with vertex indices rebased
+// to start at zero.  Since examples are never connected to one another,
+// this extracts a single positive example.  The original vertex and edge
+// indices are kept so that GUI coloring still refers to the full graph.
+//******************************************************************************
+
+Graph *CopyExampleGraph(Graph *g, ULONG start, ULONG finish)
+{
+   Graph *gCopy;
+   ULONG v;
+   ULONG e;
+   ULONG ne;
+   Edge *edge;
+
+   // count edges of the example
+   ne = 0;
+   for (e = 0; e < g->numEdges; e++)
+      if ((g->edges[e].vertex1 >= start) && (g->edges[e].vertex1 < finish))
+         ne++;
+
+   gCopy = AllocateGraph(finish - start, ne);
+   if (g->vertexInfo != NULL)
+   {
+      AllocateGraphInfo(gCopy);
+      memcpy(gCopy->vertexInfo, & g->vertexInfo[start],
+             sizeof(VertexInfo) * (finish - start));
+   }
+
+   // copy vertices; vertex edge arrays are rebuilt below
+   for (v = start; v < finish; v++)
+   {
+      gCopy->vertices[v - start].label = g->vertices[v].label;
+      gCopy->vertices[v - start].numEdges = 0;
+      gCopy->vertices[v - start].edges = NULL;
+      gCopy->vertices[v - start].anomalous = FALSE;
+   }
+
+   // copy edges
+   ne = 0;
+   for (e = 0; e < g->numEdges; e++)
+   {
+      edge = & g->edges[e];
+      if ((edge->vertex1 >= start) && (edge->vertex1 < finish))
+      {
+         gCopy->edges[ne] = *edge;
+         gCopy->edges[ne].vertex1 = edge->vertex1 - start;
+         gCopy->edges[ne].vertex2 = edge->vertex2 - start;
+         if (gCopy->edgeInfo != NULL)
+            gCopy->edgeInfo[ne] = g->edgeInfo[e];
+         ne++;
+      }
+   }
+   BuildGraphAdjacency(gCopy);
 
    return gCopy;
 }
@@ -447,7 +1093,8 @@ Graph *CopyGraph(Graph *g)
 // RETURN:  void
 //
 // PURPOSE: Free memory used by given graph, including the vertices array
-// and the edges array for each vertex.
+// and the edges array for each vertex, which are either separately
+// allocated or slices of the graph's adjacency array.
 //******************************************************************************
 
 void FreeGraph(Graph *graph)
@@ -456,8 +1103,15 @@ void FreeGraph(Graph *graph)
 
    if (graph != NULL) 
    {
-      for (v = 0; v < graph->numVertices; v++)
-         free(graph->vertices[v].edges);
+      if (graph->adjacency != NULL)
+         free(graph->adjacency);
+      else
+         for (v = 0; v < graph->numVertices; v++)
+            free(graph->vertices[v].edges);
+      FreeGraphLabelIndex(graph);
+      FreeGraphEdgeIndex(graph);
+      free(graph->vertexInfo);
+      free(graph->edgeInfo);
       free(graph->edges);
       free(graph->vertices);
       free(graph);
@@ -717,3 +1371,48 @@ void WriteGraphToFile(FILE *outFile, Graph *graph, LabelList *labelList,
          fprintf(outFile, "\n");
    }
 }
+
+
+//******************************************************************************
+// NAME:    SetPosVertexExamples
+//
+// INPUTS:  (Parameters *parameters)
+//
+// RETURN:  (void)
+//
+// PURPOSE: Build parameters->posVertexExamples, the number (from 0) of the
+// positive example holding each vertex of the positive graph, from the
+// examples' starting vertices.  The table is only kept when there is more
+// than one example, since otherwise every vertex is in example 0.  Once
+// built, it is carried through compression by CompressFinalGraphs, after
+// which the examples' vertices need no longer be contiguous.
+//******************************************************************************
+
+void SetPosVertexExamples(Parameters *parameters)
+{
+   ULONG v;
+   ULONG posEgNo;
+
+   // parameters used
+   Graph *posGraph            = parameters->posGraph;
+   ULONG numPosEgs            = parameters->numPosEgs;
+   ULONG *posEgsVertexIndices = parameters->posEgsVertexIndices;
+
+   free(parameters->posVertexExamples);
+   parameters->posVertexExamples = NULL;
+   if ((numPosEgs <= 1) || (posGraph->numVertices == 0))
+      return;
+
+   parameters->posVertexExamples =
+      (ULONG *) malloc(sizeof(ULONG) * posGraph->numVertices);
+   if (parameters->posVertexExamples == NULL)
+      OutOfMemoryError("SetPosVertexExamples:posVertexExamples");
+   posEgNo = 0;
+   for (v = 0; v < posGraph->numVertices; v++)
+   {
+      while ((posEgNo < (numPosEgs - 1)) &&
+             (v >= posEgsVertexIndices[posEgNo + 1]))
+         posEgNo++;
+      parameters->posVertexExamples[v] = posEgNo;
+   }
+}
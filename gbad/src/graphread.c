@@ -0,0 +1,592 @@
+//******************************************************************************
+// graphread.c
+//
+// Hand-written reader for the graph input format, run over the contents of
+// an input file mapped into memory.  Accepts the same input as the
+// flex/bison parser in actions.c, but reports errors by return value and
+// keeps no global state, so graphs may be read concurrently.
+//
+// Date      Name       Description
+// ========  =========  ========================================================
+// 10/17/26  agent      Initial version.
+// 10/17/26  agent      Added GP_read_graph_r; errors reported in GP_error.
+// 10/17/26  agent      INT and FLOAT tokens take a leading sign
+//
+//******************************************************************************
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "gbad.h"
+
+#define GRAPH_NUMBER_LEN 64  // longest FLOAT token converted without malloc
+#define GRAPH_READ_SIZE 65536  // initial buffer size for unmappable input
+
+
+//******************************************************************************
+// NAME: GP_read_graph_r
+//
+// INPUTS: (Graph_Info *info) - where graphs and labels are stored, as for
+//                              GP_read_graph
+//         (const char *inputFileName) - specifies the input file to read
+//         (GP_error *error) - where to report an error
+//
+// RETURN: (int) - 0 if success, 1 if error
+//
+// PURPOSE: Reentrant counterpart of GP_read_graph.  Reads the input file
+// into info exactly as GP_read_graph does, but uses no global state and
+// prints nothing: on an error, the line number (0 if the file could not
+// be read) and a description are stored in error and 1 is returned, and
+// info holds whatever was read before the error.  Calls on different
+// Graph_Info's, with different label lists, may run in parallel threads.
+//******************************************************************************
+
+int GP_read_graph_r(Graph_Info *info, const char *inputFileName,
+                    GP_error *error)
+{
+   int fd;
+   int ret;
+
+   fd = open(inputFileName, O_RDONLY);
+   if (fd < 0)
+   {
+      error->lineNo = 0;
+      snprintf(error->message, GP_ERROR_LEN, "unable to open input file");
+      return 1;
+   }
+   ret = ReadGraphDescriptor(info, fd, error);
+   close(fd);
+   return ret;
+}
+
+
+//******************************************************************************
+// NAME: ReadGraphDescriptor
+//
+// INPUTS: (Graph_Info *info) - where graphs and labels are stored
+//         (int fd) - open input file
+//         (GP_error *error) - where to report an error
+//
+// RETURN: (int) - 0 if success, 1 if error
+//
+// PURPOSE: Read the graph input from the given file with ReadMappedGraph.
+// A non-empty regular file is mapped into memory; other inputs (e.g.,
+// pipes), or files that cannot be mapped, are read into a buffer first.
+// The file is left open.
+//******************************************************************************
+
+int ReadGraphDescriptor(Graph_Info *info, int fd, GP_error *error)
+{
+   struct stat fileStatus;
+   char *buffer;
+   ULONG length = 0;
+   ULONG bufferSize = GRAPH_READ_SIZE;
+   ssize_t numRead = 1;
+   int ret;
+
+   if ((fstat(fd, & fileStatus) == 0) && (S_ISREG(fileStatus.st_mode)) &&
+       (fileStatus.st_size > 0))
+   {
+      buffer = (char *) mmap(NULL, fileStatus.st_size, PROT_READ, MAP_PRIVATE,
+                             fd, 0);
+      if (buffer != MAP_FAILED)
+      {
+         madvise(buffer, fileStatus.st_size, MADV_SEQUENTIAL);
+         ret = ReadMappedGraph(info, buffer, (ULONG) fileStatus.st_size,
+                               error);
+         munmap(buffer, fileStatus.st_size);
+         return ret;
+      }
+   }
+
+   buffer = (char *) malloc(sizeof(char) * bufferSize);
+   if (buffer == NULL)
+      OutOfMemoryError("ReadGraphDescriptor:buffer");
+   while (numRead > 0)
+   {
+      if (length == bufferSize)
+      {
+         bufferSize = 2 * bufferSize;
+         buffer = (char *) realloc(buffer, sizeof(char) * bufferSize);
+         if (buffer == NULL)
+            OutOfMemoryError("ReadGraphDescriptor:buffer");
+      }
+      numRead = read(fd, & buffer[length], bufferSize - length);
+      if (numRead > 0)
+         length += numRead;
+   }
+   if (numRead < 0)
+   {
+      free(buffer);
+      error->lineNo = 0;
+      snprintf(error->message, GP_ERROR_LEN, "unable to read input file");
+      return 1;
+   }
+   ret = ReadMappedGraph(info, buffer, length, error);
+   free(buffer);
+   return ret;
+}
+
+
+//******************************************************************************
+// NAME: ReadMappedGraph
+//
+// INPUTS: (Graph_Info *info) - where graphs and labels are stored, as for
+//                              GP_read_graph
+//         (char *buffer) - contents of input file
+//         (ULONG length) - number of characters in buffer
+//         (GP_error *error) - where to report an error
+//
+// RETURN: (int) - 0 if success, 1 if error
+//
+// PURPOSE: Read the XP graphs (if info->xp_graph) or PS graphs in the
+// given buffer into info, exactly as GP_read_graph's parser would.  The
+// buffer need not be null-terminated, and is only read.  Vertex and edge
+// labels are stored in the label list straight from the buffer.  On an
+// error, it is reported in error and 1 is returned; info then holds
+// whatever was read before the error.
+//******************************************************************************
+
+int ReadMappedGraph(Graph_Info *info, char *buffer, ULONG length,
+                    GP_error *error)
+{
+   GraphReader reader;
+   int graphToken;
+   char message[GP_ERROR_LEN];
+
+   reader.buffer = buffer;
+   reader.length = length;
+   reader.position = 0;
+   reader.lineNo = 1;
+   reader.tokenLineNo = 1;
+   reader.error = error;
+   if (NextGraphToken(& reader) != 0)
+      return 1;
+   if ((reader.token != GRAPH_TOKEN_XP) && (reader.token != GRAPH_TOKEN_PS))
+      return GraphReaderError(& reader, "syntax error, expecting XP or PS");
+   graphToken = reader.token;
+
+   while (reader.token == graphToken)
+   {
+      // graph header: XP # n or PS # n
+      if (NextGraphToken(& reader) != 0)
+         return 1;
+      if (reader.token != GRAPH_TOKEN_HASH)
+         return GraphReaderError(& reader, "syntax error, expecting #");
+      if (NextGraphToken(& reader) != 0)
+         return 1;
+      if (reader.token != GRAPH_TOKEN_INT)
+         return GraphReaderError(& reader,
+                                 "syntax error, expecting graph number");
+      if (graphToken == GRAPH_TOKEN_XP)
+      {
+         if (! info->xp_graph)
+            return GraphReaderError(& reader,
+                      "invalid graph type, found XP, expecting PS.");
+         if (reader.intValue != info->numPosEgs + 1)
+         {
+            snprintf(message, GP_ERROR_LEN,
+                     "invalid XP number, found %d, expecting %lu",
+                     reader.intValue, info->numPosEgs + 1);
+            return GraphReaderError(& reader, message);
+         }
+         if (info->graph == NULL)
+            info->graph = AllocateGraph(0, 0);
+         info->numPosEgs++;
+         info->vertexOffset = info->graph->numVertices;
+         info->posEgsVertexIndices =
+            AddVertexIndex(info->posEgsVertexIndices, info->numPosEgs,
+                           info->vertexOffset);
+      }
+      else
+      {
+         if (info->xp_graph)
+            return GraphReaderError(& reader,
+                      "invalid graph type, found PS, expecting XP.");
+         if (reader.intValue != info->numPreSubs + 1)
+         {
+            snprintf(message, GP_ERROR_LEN,
+                     "invalid PS number, found %d, expecting %lu",
+                     reader.intValue, info->numPreSubs + 1);
+            return GraphReaderError(& reader, message);
+         }
+         info->numPreSubs++;
+         info->preSubs = (Graph **) realloc(info->preSubs,
+                                            (sizeof(Graph *) *
+                                             info->numPreSubs));
+         if (info->preSubs == NULL)
+            OutOfMemoryError("ReadMappedGraph:info->preSubs");
+         info->preSubs[info->numPreSubs - 1] = AllocateGraph(0, 0);
+         info->graph = info->preSubs[info->numPreSubs - 1];
+         info->posGraphVertexListSize = 0;
+         info->posGraphEdgeListSize = 0;
+      }
+
+      // graph body: one or more vertices and edges
+      if (NextGraphToken(& reader) != 0)
+         return 1;
+      if ((reader.token != GRAPH_TOKEN_VERTEX) &&
+          (reader.token != GRAPH_TOKEN_E_EDGE) &&
+          (reader.token != GRAPH_TOKEN_D_EDGE) &&
+          (reader.token != GRAPH_TOKEN_U_EDGE))
+         return GraphReaderError(& reader,
+                                 "syntax error, expecting vertex or edge");
+      while ((reader.token == GRAPH_TOKEN_VERTEX) ||
+             (reader.token == GRAPH_TOKEN_E_EDGE) ||
+             (reader.token == GRAPH_TOKEN_D_EDGE) ||
+             (reader.token == GRAPH_TOKEN_U_EDGE))
+      {
+         if (ReadGraphElement(& reader, info) != 0)
+            return 1;
+      }
+   }
+
+   if (reader.token != GRAPH_TOKEN_END)
+      return GraphReaderError(& reader, "syntax error, expecting end of file");
+   return 0;
+}
+
+
+//******************************************************************************
+// NAME: ReadGraphElement
+//
+// INPUTS: (GraphReader *reader) - reader whose current token is v, e, d or u
+//         (Graph_Info *info) - where the vertex or edge is stored
+//
+// RETURN: (int) - 0 if success, 1 if error
+//
+// PURPOSE: Read a vertex (v n label) or an edge (e|d|u n1 n2 label) into
+// info->graph, and advance the reader past it.  Vertices must be numbered
+// consecutively from 1 within each graph, and edges must join vertices
+// already read.  An e edge is directed if info->directed.
+//******************************************************************************
+
+int ReadGraphElement(GraphReader *reader, Graph_Info *info)
+{
+   int elementToken;
+   int v;
+   int source;
+   int target;
+   ULONG labelIndex;
+   BOOLEAN directed;
+   char message[GP_ERROR_LEN];
+
+   elementToken = reader->token;
+   if (NextGraphToken(reader) != 0)
+      return 1;
+   if (reader->token != GRAPH_TOKEN_INT)
+      return GraphReaderError(reader, "syntax error, expecting vertex number");
+   if (elementToken == GRAPH_TOKEN_VERTEX)
+   {
+      v = reader->intValue;
+      if (v + info->vertexOffset != (info->graph->numVertices + 1))
+      {
+         snprintf(message, GP_ERROR_LEN,
+                  "invalid vertex number, found %d, expecting %lu", v,
+                  (info->graph->numVertices + 1) - info->vertexOffset);
+         return GraphReaderError(reader, message);
+      }
+      if (ReadGraphLabel(reader, info, & labelIndex) != 0)
+         return 1;
+      AddVertex(info->graph, labelIndex, & info->posGraphVertexListSize, v);
+   }
+   else
+   {
+      source = reader->intValue;
+      if ((source < 1) ||
+          (source + info->vertexOffset > info->graph->numVertices))
+      {
+         snprintf(message, GP_ERROR_LEN,
+                  "undefined source vertex number, found %d", source);
+         return GraphReaderError(reader, message);
+      }
+      if (NextGraphToken(reader) != 0)
+         return 1;
+      if (reader->token != GRAPH_TOKEN_INT)
+         return GraphReaderError(reader,
+                                 "syntax error, expecting vertex number");
+      target = reader->intValue;
+      if ((target < 1) ||
+          (target + info->vertexOffset > info->graph->numVertices))
+      {
+         snprintf(message, GP_ERROR_LEN,
+                  "undefined target vertex number, found %d", target);
+         return GraphReaderError(reader, message);
+      }
+      if (ReadGraphLabel(reader, info, & labelIndex) != 0)
+         return 1;
+      if (elementToken == GRAPH_TOKEN_E_EDGE)
+         directed = info->directed;
+      else
+         directed = (elementToken == GRAPH_TOKEN_D_EDGE);
+      AddEdge(info->graph, source - 1 + info->vertexOffset,
+              target - 1 + info->vertexOffset, directed, labelIndex,
+              & info->posGraphEdgeListSize, FALSE);
+   }
+   return NextGraphToken(reader);
+}
+
+
+//******************************************************************************
+// NAME: ReadGraphLabel
+//
+// INPUTS: (GraphReader *reader) - reader positioned before a label
+//         (Graph_Info *info) - label list to store label in
+//         (ULONG *labelIndex) - where to put the label's index
+//
+// RETURN: (int) - 0 if success, 1 if error
+//
+// PURPOSE: Read the next token as a label and store it in the label list.
+// An INT or FLOAT label is numeric; a quoted label is a string label
+// that, as with the flex/bison parser, includes its quotes.
+//******************************************************************************
+
+int ReadGraphLabel(GraphReader *reader, Graph_Info *info, ULONG *labelIndex)
+{
+   Label label;
+
+   if (NextGraphToken(reader) != 0)
+      return 1;
+   switch (reader->token)
+   {
+      case GRAPH_TOKEN_INT:
+         label.labelType = NUMERIC_LABEL;
+         label.labelValue.numericLabel = (double) reader->intValue;
+         *labelIndex = StoreLabel(& label, info->labelList);
+         break;
+      case GRAPH_TOKEN_FLOAT:
+         label.labelType = NUMERIC_LABEL;
+         label.labelValue.numericLabel = reader->floatValue;
+         *labelIndex = StoreLabel(& label, info->labelList);
+         break;
+      case GRAPH_TOKEN_STRING:
+         *labelIndex = StoreStringLabel(reader->tokenText, reader->tokenLength,
+                                        info->labelList);
+         break;
+      default:
+         return GraphReaderError(reader, "syntax error, expecting label");
+   }
+   return 0;
+}
+
+
+//******************************************************************************
+// NAME: NextGraphToken
+//
+// INPUTS: (GraphReader *reader) - reader to advance
+//
+// RETURN: (int) - 0 if success, 1 if error
+//
+// PURPOSE: Scan the next token of the buffer into the reader, skipping
+// white space (space, tab, newline, carriage return, vertical tab and
+// form feed), // comments to the end of the line and /* */ comments.
+// Keywords (XP, xp, PS, ps, #, and v, e, d, u in either case) must be
+// followed by a space or tab.  Strings are delimited by double or single
+// quotes, contain no null characters, and may span lines; a backslash
+// escapes the following character, other than a newline.  INT and FLOAT
+// values may have a leading sign, and INT values wrap as atoi's do.  Any
+// other character is an error.
+//******************************************************************************
+
+int NextGraphToken(GraphReader *reader)
+{
+   char *buffer = reader->buffer;
+   ULONG length = reader->length;
+   ULONG p = reader->position;
+   ULONG start;
+   ULONG digits;
+   unsigned long value;
+   BOOLEAN negative;
+   char quote;
+   char c;
+   char number[GRAPH_NUMBER_LEN];
+   char *numberText;
+   BOOLEAN scanning = TRUE;
+
+   // skip white space and comments
+   while (scanning && (p < length))
+   {
+      c = buffer[p];
+      if ((c == ' ') || (c == '\t') || (c == '\r') || (c == '\v') ||
+          (c == '\f'))
+         p++;
+      else if (c == '\n')
+      {
+         reader->lineNo++;
+         p++;
+      }
+      else if ((c == '/') && (p + 1 < length) && (buffer[p + 1] == '/'))
+      {
+         while ((p < length) && (buffer[p] != '\n'))
+            p++;
+      }
+      else if ((c == '/') && (p + 1 < length) && (buffer[p + 1] == '*'))
+      {
+         reader->tokenLineNo = reader->lineNo;
+         p += 2;
+         while ((p + 1 < length) &&
+                ((buffer[p] != '*') || (buffer[p + 1] != '/')))
+         {
+            if (buffer[p] == '\n')
+               reader->lineNo++;
+            p++;
+         }
+         if (p + 1 >= length)
+         {
+            reader->lineNo = reader->tokenLineNo;
+            return GraphReaderError(reader, "unterminated comment");
+         }
+         p += 2;
+      }
+      else
+         scanning = FALSE;
+   }
+
+   reader->tokenLineNo = reader->lineNo;
+   reader->tokenText = & buffer[p];
+   start = p;
+   if (p == length)
+      reader->token = GRAPH_TOKEN_END;
+   else
+   {
+      c = buffer[p];
+      // digits of an INT or FLOAT follow an optional sign
+      digits = p;
+      if (((c == '-') || (c == '+')) && (p + 1 < length))
+         digits = p + 1;
+      if (((buffer[digits] >= '0') && (buffer[digits] <= '9')) ||
+          ((buffer[digits] == '.') && (digits + 1 < length) &&
+           (buffer[digits + 1] >= '0') && (buffer[digits + 1] <= '9')))
+      {
+         // INT, or FLOAT if digits follow a point
+         negative = (c == '-');
+         p = digits;
+         value = 0;
+         while ((p < length) && (buffer[p] >= '0') && (buffer[p] <= '9'))
+         {
+            if (value <= LONG_MAX)
+               value = (value * 10) + (buffer[p] - '0');
+            p++;
+         }
+         if ((p + 1 < length) && (buffer[p] == '.') &&
+             (buffer[p + 1] >= '0') && (buffer[p + 1] <= '9'))
+         {
+            p++;
+            while ((p < length) && (buffer[p] >= '0') && (buffer[p] <= '9'))
+               p++;
+            numberText = number;
+            if (p - start >= GRAPH_NUMBER_LEN)
+            {
+               numberText = (char *) malloc(sizeof(char) * (p - start + 1));
+               if (numberText == NULL)
+                  OutOfMemoryError("NextGraphToken:numberText");
+            }
+            memcpy(numberText, & buffer[start], p - start);
+            numberText[p - start] = '\0';
+            reader->token = GRAPH_TOKEN_FLOAT;
+            reader->floatValue = atof(numberText);
+            if (numberText != number)
+               free(numberText);
+         }
+         else
+         {
+            if (value > LONG_MAX)
+               value = LONG_MAX;
+            reader->token = GRAPH_TOKEN_INT;
+            if (negative)
+               reader->intValue = (int) (- (long) value);
+            else
+               reader->intValue = (int) (long) value;
+         }
+      }
+      else if ((c == '"') || (c == '\''))
+      {
+         quote = c;
+         p++;
+         while ((p < length) && (buffer[p] != quote) && (buffer[p] != '\0') &&
+                ((buffer[p] != '\\') ||
+                 ((p + 1 < length) && (buffer[p + 1] != '\n'))))
+         {
+            if (buffer[p] == '\\')
+               p++;
+            if (buffer[p] == '\n')
+               reader->lineNo++;
+            p++;
+         }
+         if ((p == length) || (buffer[p] != quote))
+            return GraphReaderError(reader, "unterminated string");
+         p++;
+         reader->token = GRAPH_TOKEN_STRING;
+      }
+      else
+      {
+         // keyword, which must be followed by a space or tab
+         if ((p + 2 < length) &&
+             ((buffer[p + 2] == ' ') || (buffer[p + 2] == '\t')) &&
+             ((strncmp(& buffer[p], "XP", 2) == 0) ||
+              (strncmp(& buffer[p], "xp", 2) == 0)))
+            reader->token = GRAPH_TOKEN_XP;
+         else if ((p + 2 < length) &&
+                  ((buffer[p + 2] == ' ') || (buffer[p + 2] == '\t')) &&
+                  ((strncmp(& buffer[p], "PS", 2) == 0) ||
+                   (strncmp(& buffer[p], "ps", 2) == 0)))
+            reader->token = GRAPH_TOKEN_PS;
+         else if ((p + 1 < length) &&
+                  ((buffer[p + 1] == ' ') || (buffer[p + 1] == '\t')))
+         {
+            switch (c)
+            {
+               case '#':
+                  reader->token = GRAPH_TOKEN_HASH;
+                  break;
+               case 'v': case 'V':
+                  reader->token = GRAPH_TOKEN_VERTEX;
+                  break;
+               case 'e': case 'E':
+                  reader->token = GRAPH_TOKEN_E_EDGE;
+                  break;
+               case 'd': case 'D':
+                  reader->token = GRAPH_TOKEN_D_EDGE;
+                  break;
+               case 'u': case 'U':
+                  reader->token = GRAPH_TOKEN_U_EDGE;
+                  break;
+               default:
+                  return GraphReaderError(reader, "unexpected character");
+            }
+         }
+         else
+            return GraphReaderError(reader, "unexpected character");
+         if ((reader->token == GRAPH_TOKEN_XP) ||
+             (reader->token == GRAPH_TOKEN_PS))
+            p += 2;
+         else
+            p++;
+      }
+   }
+   reader->tokenLength = p - start;
+   reader->position = p;
+   return 0;
+}
+
+
+//******************************************************************************
+// NAME: GraphReaderError
+//
+// INPUTS: (GraphReader *reader) - reader at the error
+//         (char *message) - description of error
+//
+// RETURN: (int) - 1
+//
+// PURPOSE: Report the error message, with the line number of the current
+// token, in the reader's GP_error.
+//******************************************************************************
+
+int GraphReaderError(GraphReader *reader, char *message)
+{
+   reader->error->lineNo = reader->tokenLineNo;
+   snprintf(reader->error->message, GP_ERROR_LEN, "%s", message);
+   return 1;
+}
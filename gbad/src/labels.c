@@ -6,6 +6,10 @@
 // Date      Name       Description
 // ========  =========  ========================================================
 // 08/12/09  Eberle     Initial version, taken from SUBDUE 5.2.1
+// 10/16/26  agent      Replaced linear label search with an open-addressing
+//                      hash index; string labels now stored in an arena.
+// 10/17/26  agent      String labels can be stored straight from an input
+//                      buffer with StoreStringLabel
 //
 //******************************************************************************
 
@@ -31,6 +35,9 @@ LabelList *AllocateLabelList(void)
    labelList->size = 0;
    labelList->numLabels = 0;
    labelList->labels = NULL;
+   labelList->hashSize = 0;
+   labelList->hashTable = NULL;
+   labelList->arena = NULL;
    return labelList;
 }
 
@@ -51,45 +58,109 @@ LabelList *AllocateLabelList(void)
 ULONG StoreLabel(Label *label, LabelList *labelList)
 {
    ULONG labelIndex;
-   Label *newLabelList;
-   char *stringLabel;
+   Label newLabel;
 
    labelIndex = GetLabelIndex(label, labelList);
    if (labelIndex == labelList->numLabels) 
    { // i.e., label not found
-      // make sure there is room for a new label
-      if (labelList->size == labelList->numLabels) 
-      {
-         labelList->size += LIST_SIZE_INC;
-         newLabelList = (Label *) realloc(labelList->labels,
-                                          (sizeof(Label) * labelList->size));
-         if (newLabelList == NULL)
-            OutOfMemoryError("StoreLabel:newLabelList");
-         labelList->labels = newLabelList;
-      }
-      // store label
-      labelList->labels[labelList->numLabels].labelType = label->labelType;
-      switch(label->labelType) 
+      newLabel = *label;
+      if (label->labelType == STRING_LABEL)
+         newLabel.labelValue.stringLabel =
+            LabelArenaCopy(label->labelValue.stringLabel,
+                           strlen(label->labelValue.stringLabel), labelList);
+      AppendLabel(& newLabel, labelList);
+   }
+   return labelIndex;
+}
+
+
+//******************************************************************************
+// NAME:    StoreStringLabel
+//
+// INPUTS:  (char *string) - characters of string label, not necessarily
+//                           null-terminated
+//          (ULONG length) - number of characters in string label
+//          (LabelList *labelList) - list to contain label
+//
+// RETURN:  (ULONG) - label's index in given label list
+//
+// PURPOSE: Same as StoreLabel for a string label given by its
+// characters and length, so that labels can be stored straight from an
+// input buffer.  The characters are only copied, into the label list's
+// arena, if the label is new.
+//******************************************************************************
+
+ULONG StoreStringLabel(char *string, ULONG length, LabelList *labelList)
+{
+   ULONG slot;
+   ULONG i;
+   Label *storedLabel;
+   Label newLabel;
+
+   if (labelList->hashSize > 0)
+   {
+      slot = StringLabelHash(string, length) & (labelList->hashSize - 1);
+      while ((i = labelList->hashTable[slot]) != LABEL_HASH_EMPTY)
       {
-         case STRING_LABEL:
-            stringLabel = (char *) malloc
-                          (sizeof(char) * 
-                           (strlen(label->labelValue.stringLabel)) + 1);
-            if (stringLabel == NULL)
-               OutOfMemoryError("StoreLabel:stringLabel");
-            strcpy(stringLabel, label->labelValue.stringLabel);
-            labelList->labels[labelList->numLabels].labelValue.stringLabel =
-               stringLabel;
-            break;
-         case NUMERIC_LABEL:
-            labelList->labels[labelList->numLabels].labelValue.numericLabel =
-               label->labelValue.numericLabel;
-            break;
-         default:
-            break;  // error
+         storedLabel = & labelList->labels[i];
+         if ((storedLabel->labelType == STRING_LABEL) &&
+             (strncmp(storedLabel->labelValue.stringLabel, string,
+                      length) == 0) &&
+             (storedLabel->labelValue.stringLabel[length] == '\0'))
+            return i;
+         slot = (slot + 1) & (labelList->hashSize - 1);
       }
-      labelList->labels[labelList->numLabels].used = FALSE;
-      labelList->numLabels++;
+   }
+   newLabel.labelType = STRING_LABEL;
+   newLabel.labelValue.stringLabel = LabelArenaCopy(string, length, labelList);
+   return AppendLabel(& newLabel, labelList);
+}
+
+
+//******************************************************************************
+// NAME:    AppendLabel
+//
+// INPUTS:  (Label *label) - label not yet in the list, with any string
+//                           already in the list's arena
+//          (LabelList *labelList) - list to contain label
+//
+// RETURN:  (ULONG) - label's index in given label list
+//
+// PURPOSE: Add the label at the end of the label list and to the list's
+// hash index.
+//******************************************************************************
+
+ULONG AppendLabel(Label *label, LabelList *labelList)
+{
+   ULONG labelIndex;
+   Label *newLabelList;
+   ULONG slot;
+
+   // make sure there is room for a new label
+   if (labelList->size == labelList->numLabels) 
+   {
+      labelList->size += LIST_SIZE_INC;
+      newLabelList = (Label *) realloc(labelList->labels,
+                                       (sizeof(Label) * labelList->size));
+      if (newLabelList == NULL)
+         OutOfMemoryError("AppendLabel:newLabelList");
+      labelList->labels = newLabelList;
+   }
+   // store label
+   labelIndex = labelList->numLabels;
+   labelList->labels[labelIndex] = *label;
+   labelList->labels[labelIndex].used = FALSE;
+   labelList->numLabels++;
+
+   // index new label, keeping the hash table at most half full
+   if ((2 * labelList->numLabels) > labelList->hashSize)
+      GrowLabelHashTable(labelList);
+   else
+   {
+      slot = LabelHash(label) & (labelList->hashSize - 1);
+      while (labelList->hashTable[slot] != LABEL_HASH_EMPTY)
+         slot = (slot + 1) & (labelList->hashSize - 1);
+      labelList->hashTable[slot] = labelIndex;
    }
    return labelIndex;
 }
@@ -106,43 +177,197 @@ ULONG StoreLabel(Label *label, LabelList *labelList)
 //
 // PURPOSE: Returns the index of the given label in the given label
 // list.  If not found, then the index just past the end (i.e., number
-// of stored labels) is returned.
+// of stored labels) is returned.  The label is looked up in the list's
+// hash index, probing linearly from the label's hash slot until the label
+// or an empty slot is found.
 //******************************************************************************
 
 ULONG GetLabelIndex(Label *label, LabelList *labelList)
 {
-   ULONG i = 0;
-   ULONG labelIndex = labelList->numLabels;
-   BOOLEAN found = FALSE;
+   ULONG slot;
+   ULONG i;
+   Label *storedLabel;
 
-   while ((i < labelList->numLabels) && (! found)) 
+   if (labelList->hashSize == 0)
+      return labelList->numLabels;
+
+   slot = LabelHash(label) & (labelList->hashSize - 1);
+   while ((i = labelList->hashTable[slot]) != LABEL_HASH_EMPTY)
    {
-      if (labelList->labels[i].labelType == label->labelType) 
+      storedLabel = & labelList->labels[i];
+      if (storedLabel->labelType == label->labelType) 
       {
          switch(label->labelType) 
          {
             case STRING_LABEL:
-               if (strcmp(labelList->labels[i].labelValue.stringLabel,
+               if (strcmp(storedLabel->labelValue.stringLabel,
                    label->labelValue.stringLabel) == 0) 
-               {
-                  labelIndex = i;
-                  found = TRUE;
-               }
+                  return i;
                break;
             case NUMERIC_LABEL:
-               if (labelList->labels[i].labelValue.numericLabel ==
+               if (storedLabel->labelValue.numericLabel ==
                    label->labelValue.numericLabel) 
-               {
-                  labelIndex = i;
-                  found = TRUE;
-               }
+                  return i;
+               break;
             default:
                break;  // error
          }
       }
-      i++;
+      slot = (slot + 1) & (labelList->hashSize - 1);
    }
-   return labelIndex;
+   return labelList->numLabels;
+}
+
+
+//******************************************************************************
+// NAME:    LabelHash
+//
+// INPUTS:  (Label *label) - label to hash
+//
+// RETURN:  (ULONG) - hash value of label
+//
+// PURPOSE: Compute the hash value (64-bit FNV-1a) of the given label, over
+// the characters of a string label or the bytes of a numeric label.  The
+// label type is mixed in so that equal string and numeric values do not
+// collide.  Numeric labels that compare equal (0.0 and -0.0) hash the same.
+//******************************************************************************
+
+ULONG LabelHash(Label *label)
+{
+   unsigned long long hash = 14695981039346656037ULL;
+   unsigned char *bytes;
+   double numericLabel;
+   ULONG i;
+
+   hash = (hash ^ label->labelType) * 1099511628211ULL;
+   switch(label->labelType) 
+   {
+      case STRING_LABEL:
+         return StringLabelHash(label->labelValue.stringLabel,
+                                strlen(label->labelValue.stringLabel));
+      case NUMERIC_LABEL:
+         numericLabel = label->labelValue.numericLabel;
+         if (numericLabel == 0.0)
+            numericLabel = 0.0;
+         bytes = (unsigned char *) & numericLabel;
+         for (i = 0; i < sizeof(double); i++)
+            hash = (hash ^ bytes[i]) * 1099511628211ULL;
+         break;
+      default:
+         break;
+   }
+   return (ULONG) hash;
+}
+
+
+//******************************************************************************
+// NAME:    StringLabelHash
+//
+// INPUTS:  (char *string) - characters of string label
+//          (ULONG length) - number of characters in string label
+//
+// RETURN:  (ULONG) - hash value of label
+//
+// PURPOSE: Compute LabelHash of the string label with the given
+// characters, which need not be null-terminated.
+//******************************************************************************
+
+ULONG StringLabelHash(char *string, ULONG length)
+{
+   unsigned long long hash = 14695981039346656037ULL;
+   unsigned char *bytes = (unsigned char *) string;
+   ULONG i;
+
+   hash = (hash ^ STRING_LABEL) * 1099511628211ULL;
+   for (i = 0; i < length; i++)
+      hash = (hash ^ bytes[i]) * 1099511628211ULL;
+   return (ULONG) hash;
+}
+
+
+//******************************************************************************
+// NAME:    GrowLabelHashTable
+//
+// INPUTS:  (LabelList *labelList) - label list whose index is to grow
+//
+// RETURN:  (void)
+//
+// PURPOSE: Double the number of slots in the label list's hash index (or
+// allocate the initial index) and re-insert every stored label.
+//******************************************************************************
+
+void GrowLabelHashTable(LabelList *labelList)
+{
+   ULONG i;
+   ULONG slot;
+   ULONG hashSize;
+
+   hashSize = labelList->hashSize;
+   if (hashSize == 0)
+      hashSize = LABEL_HASH_INIT_SIZE;
+   while ((2 * labelList->numLabels) > hashSize)
+      hashSize *= 2;
+
+   free(labelList->hashTable);
+   labelList->hashTable = (ULONG *) malloc(sizeof(ULONG) * hashSize);
+   if (labelList->hashTable == NULL)
+      OutOfMemoryError("GrowLabelHashTable:labelList->hashTable");
+   labelList->hashSize = hashSize;
+   for (slot = 0; slot < hashSize; slot++)
+      labelList->hashTable[slot] = LABEL_HASH_EMPTY;
+
+   for (i = 0; i < labelList->numLabels; i++)
+   {
+      slot = LabelHash(& labelList->labels[i]) & (hashSize - 1);
+      while (labelList->hashTable[slot] != LABEL_HASH_EMPTY)
+         slot = (slot + 1) & (hashSize - 1);
+      labelList->hashTable[slot] = i;
+   }
+}
+
+
+//******************************************************************************
+// NAME:    LabelArenaCopy
+//
+// INPUTS:  (char *stringLabel) - string to copy
+//          (ULONG length) - number of characters to copy
+//          (LabelList *labelList) - label list owning the arena
+//
+// RETURN:  (char *) - copy of string in label list's arena
+//
+// PURPOSE: Copy the first length characters of the given string, and a
+// terminating null, into the label list's string arena, starting a new
+// block when the current one is full.  Blocks are never moved, so the
+// copies remain valid until the label list is freed.
+//******************************************************************************
+
+char *LabelArenaCopy(char *stringLabel, ULONG length, LabelList *labelList)
+{
+   LabelArenaBlock *block;
+   char *copy;
+
+   length++;
+   block = labelList->arena;
+   if ((block == NULL) || ((block->size - block->used) < length))
+   {
+      block = (LabelArenaBlock *) malloc(sizeof(LabelArenaBlock));
+      if (block == NULL)
+         OutOfMemoryError("LabelArenaCopy:block");
+      block->size = LABEL_ARENA_BLOCK_SIZE;
+      if (length > block->size)
+         block->size = length;
+      block->bytes = (char *) malloc(sizeof(char) * block->size);
+      if (block->bytes == NULL)
+         OutOfMemoryError("LabelArenaCopy:block->bytes");
+      block->used = 0;
+      block->next = labelList->arena;
+      labelList->arena = block;
+   }
+   copy = & block->bytes[block->used];
+   memcpy(copy, stringLabel, length - 1);
+   copy[length - 1] = '\0';
+   block->used += length;
+   return copy;
 }
 
 
@@ -285,11 +510,24 @@ void PrintLabelList(LabelList *labelList)
 //
 // RETURN: (void)
 //
-// PURPOSE: Free memory in labelList.
+// PURPOSE: Free memory in labelList, including its hash index and the
+// string arena holding its string labels.
 //******************************************************************************
 
 void FreeLabelList(LabelList *labelList)
 {
+   LabelArenaBlock *block;
+   LabelArenaBlock *nextBlock;
+
+   block = labelList->arena;
+   while (block != NULL)
+   {
+      nextBlock = block->next;
+      free(block->bytes);
+      free(block);
+      block = nextBlock;
+   }
+   free(labelList->hashTable);
    free(labelList->labels);
    free(labelList);
 }
@@ -16,6 +16,20 @@
 // 01/31/13  Hensley    Removed Linux-Specific aspects, for compilation in Windows
 // 02/14/13  Eberle     Clarified "Optimized" flag.
 // 02/16/13  Hensley    Removed obsolete code.
+// 10/16/26  agent      Added -perexample option to discover substructures
+//                      separately in each positive example of one input file.
+// 10/16/26  agent      Added -threads option for parallel beam expansion.
+// 10/17/26  agent      Allocate the parameters' VisitSets.
+// 10/17/26  agent      Release instance arena after each iteration.
+// 10/17/26  agent      Initialize preSubs before reading predefined subs.
+// 10/17/26  agent      Moved parameter defaults, settings checks and the
+//                      discovery steps of an iteration to gbadlib.c.
+// 10/17/26  agent      Added -serve option for server mode; options are
+//                      now set by GBAD_SetOption.
+// 10/17/26  agent      Added -window option for windowed discovery.
+// 10/17/26  agent      Reject -threads with -prob.
+// 10/17/26  agent      GBAD-P vertex mapping files are written by the
+//                      program, not the library.
 //
 //********************************************************************************
 
@@ -27,8 +41,9 @@
 
 int main(int, char **);
 Parameters *GetParameters(int, char **);
+void DiscoverSubsPerExample(Parameters *);
+void DiscoverSubsInWindow(Parameters *);
 void PrintParameters(Parameters *);
-void FreeParameters(Parameters *);
 
 //******************************************************************************
 // NAME:    main
@@ -55,6 +70,9 @@ int main(int argc, char **argv)
    ULONG iteration;
    BOOLEAN done;
 
+   if ((argc > 1) && (strcmp(argv[1], "-serve") == 0))
+      return ServeGraphs(argc, argv);
+
    clktck = CLOCKS_PER_SEC;
    startTime = clock();
    printf("GBAD %s\n\n", GBAD_VERSION);
@@ -66,11 +84,30 @@ int main(int argc, char **argv)
 
    PrintParameters(parameters);
 
+   if (parameters->perExample)
+   {
+      DiscoverSubsPerExample(parameters);
+      GBAD_FreeParameters(parameters);
+      endTime = clock();
+      printf("\nGBAD done (elapsed CPU time = %7.2f seconds).\n",
+             (endTime - startTime) / (double) clktck);
+      return 0;
+   }
+
+   if (parameters->windowSize > 0)
+   {
+      DiscoverSubsInWindow(parameters);
+      GBAD_FreeParameters(parameters);
+      endTime = clock();
+      printf("\nGBAD done (elapsed CPU time = %7.2f seconds).\n",
+             (endTime - startTime) / (double) clktck);
+      return 0;
+   }
+
    if (parameters->iterations > 1)
       printf("----- Iteration 1 -----\n\n");
 
    iteration = 1;
-   parameters->currentIteration = iteration;
    done = FALSE;
 
    while ((iteration <= parameters->iterations) && (!done))
@@ -90,47 +127,7 @@ int main(int argc, char **argv)
       printf("%lu unique labels\n", parameters->labelList->numLabels);
       printf("\n");
 
-      if ((parameters->prob) && (iteration > 1))
-      {
-         //
-         // If GBAD-P option chosen, after the first iteration, we no longer
-         // care about minsize of maxsize after the first iteration (if the
-         // user specified these parameters), as we are just dealing with
-         // single extensions from the normative - so set it to where we
-         // just look at substructures that are composed of the normative
-         // pattern (SUB_) and the single vertex extension.
-         //
-         parameters->minVertices = 1;
-         parameters->maxVertices = 2;
-      }
-      //
-      // If the user has specified a normative pattern, on the first iteration
-      // need to save the top-N substructures, where N is what the user
-      // specified with the -norm parameter.
-      //
-      ULONG saveNumBestSubs = parameters->numBestSubs;
-      if ((iteration == 1) && (!parameters->noAnomalyDetection) &&
-          (parameters->norm > parameters->numBestSubs))
-         parameters->numBestSubs = parameters->norm;
-      //
-      // -prune is useful to get to the initial normative pattern, but 
-      // possibly detremental to discovering anomalies... so, turn off 
-      // pruning (in case it was turned on), so that it is not used in 
-      // future iterations.
-      //
-      if ((parameters->prob) && (iteration > 1))
-      {
-         parameters->prune = FALSE;
-      }
- 
-      subList = DiscoverSubs(parameters, iteration);
-
-      //
-      // Now that we have the best substructure(s), return the user
-      // specified number of best substructures to its original value.
-      //
-      if (iteration == 1)
-         parameters->numBestSubs = saveNumBestSubs;
+      subList = GBAD_DiscoverIteration(parameters, &normSub);
 
       if (subList->head == NULL) 
       {
@@ -139,28 +136,6 @@ int main(int argc, char **argv)
       }
       else 
       {
-         //
-         // GBAD-MDL
-         //
-         if (parameters->mdl)
-            GBAD_MDL(subList,parameters);
-
-         //
-         // GBAD-MPS
-         //
-         if (parameters->mps)
-         {
-            GBAD_MPS(subList,parameters);
-         }
-
-         //
-         // GBAD-P
-         //
-         if (parameters->prob)
-         {
-            normSub = GBAD_P(subList,iteration,parameters);
-         }
-
          // write output to stdout
          if (parameters->outputLevel > 1) 
          {
@@ -214,49 +189,28 @@ int main(int argc, char **argv)
             {
                printf("Removing positive examples covered by");
                printf(" best substructure.\n\n");
-               RemovePosEgsCovered(subList->head->sub, parameters);
             } 
-            else 
+            else if ((iteration == 1) && (parameters->prob))
             {
-               //
-               // For the GBAD-P algorithm, multiple iterations will need
-               // to be performed, and if it is the first iteration
-	       // AND the user has specified a different normative
-	       // pattern (other than the best one), we need to 
-	       // use the substructure that was set above.
-	       //
-	       if ((iteration == 1) && (parameters->prob))
-	       {
-	          printf("Compressing graph by best substructure (%lu):\n",
-	                 parameters->norm);
-                  PrintSub(normSub,parameters);
-	          printf("\n");
-                  CompressFinalGraphs(normSub, parameters, 
-	                              iteration, FALSE);
-               } else
-                  CompressFinalGraphs(subList->head->sub, parameters, 
-	                              iteration, FALSE);
-	    }
+               printf("Compressing graph by best substructure (%lu):\n",
+                      parameters->norm);
+               PrintSub(normSub,parameters);
+               printf("\n");
+            }
 
             // check for stopping condition
             // if set-covering, then no more positive examples
             // if MDL or size, then positive graph contains no edges
-            if (parameters->evalMethod == EVAL_SETCOVER) 
+            if (! GBAD_CompressIteration(parameters, subList, normSub))
             {
-               if (parameters->numPosEgs == 0) 
+               done = TRUE;
+               if (parameters->evalMethod == EVAL_SETCOVER) 
                {
-                  done = TRUE;
                   printf("Ending iterations - ");
                   printf("all positive examples covered.\n\n");
-               }
-            } 
-            else 
-            {
-               if (parameters->posGraph->numEdges == 0) 
-               {
-                  done = TRUE;
+               } 
+               else 
                   printf("Ending iterations - graph fully compressed.\n\n");
-               }
             }
          }
          if ((iteration == parameters->iterations) && (parameters->compress))
@@ -269,18 +223,7 @@ int main(int argc, char **argv)
          }
       }
 
-      //
-      // Need to store information regarding initial best substructure, for use
-      // in future GBAD-P calculations
-      //
-      if ((parameters->prob) && (iteration == 1) && (subList->head != NULL))
-      {
-         parameters->numPreviousInstances = subList->head->sub->numInstances;
-      }
-      if ((parameters->prob) && (iteration > 1) && (subList->head != NULL))
-         parameters->numPreviousInstances = subList->head->sub->numInstances;
-
-      FreeSubList(subList);
+      GBAD_EndIteration(parameters, subList);
       if (parameters->iterations > 1) 
       {
          iterationEndTime = time(NULL);
@@ -288,7 +231,6 @@ int main(int argc, char **argv)
          iteration, (iterationEndTime - iterationStartTime));
       }
       iteration++;
-      parameters->currentIteration = iteration;
    }
  
    // GUI coloring
@@ -300,32 +242,32 @@ int main(int argc, char **argv)
       // find the min anom value
       for (index=0; index < parameters->originalPosGraph->numVertices; index++)
       {
-         if (parameters->originalPosGraph->vertices[index].anomalousValue < minAnomalousValue)
-            minAnomalousValue = parameters->originalPosGraph->vertices[index].anomalousValue;
+         if (parameters->originalPosGraph->vertexInfo[index].anomalousValue < minAnomalousValue)
+            minAnomalousValue = parameters->originalPosGraph->vertexInfo[index].anomalousValue;
       }
       for (index=0; index < parameters->originalPosGraph->numEdges; index++)
       {
-         if (parameters->originalPosGraph->edges[index].anomalousValue < minAnomalousValue)
-            minAnomalousValue = parameters->originalPosGraph->edges[index].anomalousValue;
+         if (parameters->originalPosGraph->edgeInfo[index].anomalousValue < minAnomalousValue)
+            minAnomalousValue = parameters->originalPosGraph->edgeInfo[index].anomalousValue;
       }
 
       // update color based on min anom value
       for (index=0; index < parameters->originalPosGraph->numVertices; index++)
       {
-         if (parameters->originalPosGraph->vertices[index].anomalousValue == minAnomalousValue)
-            parameters->originalPosGraph->vertices[index].color = POSITIVE_ANOM_VERTEX;
+         if (parameters->originalPosGraph->vertexInfo[index].anomalousValue == minAnomalousValue)
+            parameters->originalPosGraph->vertexInfo[index].color = POSITIVE_ANOM_VERTEX;
       }
 
       for (index=0; index < parameters->originalPosGraph->numEdges; index++)
       {
-         if (parameters->originalPosGraph->edges[index].anomalousValue == minAnomalousValue)
-            parameters->originalPosGraph->edges[index].color = POSITIVE_ANOM_EDGE;
+         if (parameters->originalPosGraph->edgeInfo[index].anomalousValue == minAnomalousValue)
+            parameters->originalPosGraph->edgeInfo[index].color = POSITIVE_ANOM_EDGE;
       }
 
       WriteGraphToDotFile(parameters->dotFileName, parameters);
    }
 
-   FreeParameters(parameters);
+   GBAD_FreeParameters(parameters);
    endTime = clock();
    printf("\nGBAD done (elapsed CPU time = %7.2f seconds).\n",
           (endTime - startTime) / (double) clktck);
@@ -349,49 +291,13 @@ Parameters *GetParameters(int argc, char *argv[])
 {
    Parameters *parameters;
    int i;
-   double doubleArg;
-   ULONG ulongArg;
+   int used;
    FILE *outputFile;
-   ULONG argumentExists;
+   char message[GBAD_MESSAGE_LEN];
+   char *prepareMessage;
 
-   parameters = (Parameters *) malloc(sizeof(Parameters));
-   if (parameters == NULL)
-      OutOfMemoryError("parameters");
-
-   // GUI coloring
-   strcpy(parameters->dotFileName, "none");
-   parameters->dotToFile = FALSE;
-
-   // initialize default parameter settings
-   parameters->directed = TRUE;
-   parameters->limit = 0;
-   parameters->numBestSubs = 3;
-   parameters->beamWidth = 4;
-   parameters->valueBased = FALSE;
-   parameters->prune = FALSE;
-   strcpy(parameters->outFileName, "none");
-   parameters->outputToFile = FALSE;
-   parameters->outputLevel = 2;
-   parameters->allowInstanceOverlap = FALSE;
-   parameters->threshold = 0.0;
-   parameters->evalMethod = EVAL_MDL;
-   parameters->iterations = 1;
-   strcpy(parameters->psInputFileName, "none");
-   parameters->predefinedSubs = FALSE;
-   parameters->minVertices = 1;
-   parameters->maxVertices = 0; // i.e., infinity
-   parameters->compress = FALSE;
-
-   parameters->mdl = FALSE;
-   parameters->mdlThreshold = 0.0;
-   parameters->mpsThreshold = 0.0;
-   parameters->prob = FALSE;
-   parameters->mps = FALSE;
-   parameters->maxAnomalousScore = MAX_DOUBLE;
-   parameters->minAnomalousScore = 0.0;
-   parameters->noAnomalyDetection = TRUE;
-   parameters->norm = 1;
-   parameters->optimize = TRUE;
+   parameters = GBAD_AllocateParameters();
+   parameters->writeAnomFiles = TRUE;
 
    if (argc < 2)
    {
@@ -403,258 +309,58 @@ Parameters *GetParameters(int argc, char *argv[])
    i = 1;
    while (i < (argc - 1))
    {
-      if (strcmp(argv[i], "-beam") == 0) 
-      {
-         i++;
-         sscanf(argv[i], "%lu", &ulongArg);
-         if (ulongArg == 0) 
-         {
-            fprintf(stderr, "%s: beam must be greater than zero\n", argv[0]);
-            exit(1);
-         }
-         parameters->beamWidth = ulongArg;
-      }
-      else if (strcmp(argv[i], "-compress") == 0)
-      {
-         parameters->compress = TRUE;
-      }
-      else if (strcmp(argv[i], "-eval") == 0) 
-      {
-         i++;
-         sscanf(argv[i], "%lu", &ulongArg);
-         if ((ulongArg < 1) || (ulongArg > 3)) 
-         {
-            fprintf(stderr, "%s: eval must be 1-3\n", argv[0]);
-            exit(1);
-         }
-         parameters->evalMethod = ulongArg;
-      } 
-      else if (strcmp(argv[i], "-iterations") == 0) 
-      {
-         i++;
-         sscanf(argv[i], "%lu", &ulongArg);
-         parameters->iterations = ulongArg;
-      } 
-      else if (strcmp(argv[i], "-limit") == 0) 
+      used = GBAD_SetOption(parameters, argc, argv, i, message);
+      if (used == 0)
       {
-         i++;
-         sscanf(argv[i], "%lu", &ulongArg);
-         if (ulongArg == 0) 
-         {
-            fprintf(stderr, "%s: limit must be greater than zero\n", argv[0]);
-            exit(1);
-         }
-         parameters->limit = ulongArg;
-      }
-      else if (strcmp(argv[i], "-maxsize") == 0) 
-      {
-         i++;
-         sscanf(argv[i], "%lu", &ulongArg);
-         if (ulongArg == 0) 
-         {
-            fprintf(stderr, "%s: maxsize must be greater than zero\n", argv[0]);
-            exit(1);
-         }
-         parameters->maxVertices = ulongArg;
-      }
-      else if (strcmp(argv[i], "-minsize") == 0) 
-      {
-         i++;
-         sscanf(argv[i], "%lu", &ulongArg);
-         if (ulongArg == 0) 
-         {
-            fprintf(stderr, "%s: minsize must be greater than zero\n", argv[0]);
-            exit(1);
-         }
-         parameters->minVertices = ulongArg;
-      }
-      else if (strcmp(argv[i], "-nsubs") == 0) 
-      {
-         i++;
-         sscanf(argv[i], "%lu", &ulongArg);
-         if (ulongArg == 0) 
-         {
-            fprintf(stderr, "%s: nsubs must be greater than zero\n", argv[0]);
-            exit(1);
-         }
-         parameters->numBestSubs = ulongArg;
-      }
-      else if (strcmp(argv[i], "-out") == 0) 
-      {
-         i++;
-         strcpy(parameters->outFileName, argv[i]);
-         parameters->outputToFile = TRUE;
-      }
-      else if (strcmp(argv[i], "-output") == 0) 
-      {
-         i++;
-         sscanf(argv[i], "%lu", &ulongArg);
-         if ((ulongArg < 1) || (ulongArg > 5)) 
-         {
-            fprintf(stderr, "%s: output must be 1-5\n", argv[0]);
-            exit(1);
-         }
-         parameters->outputLevel = ulongArg;
-      }
-      else if (strcmp(argv[i], "-overlap") == 0) 
-      {
-         parameters->allowInstanceOverlap = TRUE;
-      }
-      else if (strcmp(argv[i], "-prune") == 0) 
-      {
-         parameters->prune = TRUE;
-      }
-      else if (strcmp(argv[i], "-ps") == 0) 
-      {
-         i++;
-         strcpy(parameters->psInputFileName, argv[i]);
-         parameters->predefinedSubs = TRUE;
-      }
-      else if (strcmp(argv[i], "-threshold") == 0) 
-      {
-         i++;
-         sscanf(argv[i], "%lf", &doubleArg);
-         if ((doubleArg < (double) 0.0) || (doubleArg > (double) 1.0))
-         {
-            fprintf(stderr, "%s: threshold must be 0.0-1.0\n", argv[0]);
-            exit(1);
-         }
-         parameters->threshold = doubleArg;
-      }
-      else if (strcmp(argv[i], "-undirected") == 0) 
-      {
-         parameters->directed = FALSE;
-      }
-      else if (strcmp(argv[i], "-valuebased") == 0) 
-      {
-         parameters->valueBased = TRUE;
-      }
-      else if (strcmp(argv[i], "-mdl") == 0) 
-      {
-         i++;
-         argumentExists = sscanf(argv[i], "%lf", &doubleArg);
-         if ((argumentExists != 1) || (doubleArg <= (double) 0.0) || 
-             (doubleArg >= (double) 1.0))
-         {
-            fprintf(stderr, "%s: Information Theoretic (MDL) threshold must be greater than 0.0 and less than 1.0\n", argv[0]);
-            exit(1);
-         }
-         parameters->mdl = TRUE;
-         parameters->mdlThreshold = doubleArg;
-      }
-      else if (strcmp(argv[i], "-prob") == 0) 
-      {
-         i++;
-         sscanf(argv[i], "%lu", &ulongArg);
-         if (ulongArg < 2)
-         {
-            fprintf(stderr, "%s: you must include a value greater than 1 as a parameter to the probabilistic anomaly detection method.\n", argv[0]);
-            exit(1);
-         }
-         parameters->prob = TRUE;
-         parameters->iterations = ulongArg;  // overrides -iterations specification
-         parameters->maxAnomalousScore = 1.0;  // overrides default of MAX_DOUBLE
-      }
-      else if (strcmp(argv[i], "-mps") == 0) 
-      {
-         i++;
-         argumentExists = sscanf(argv[i], "%lf", &doubleArg);
-         if ((argumentExists != 1) || (doubleArg <= (double) 0.0) || 
-             (doubleArg >= (double) 1.0))
-         {
-            fprintf(stderr, "%s: Maximum Partial Substructure (MPS) threshold must be greater than 0.0 and less than 1.0\n", argv[0]);
-            exit(1);
-         }
-         parameters->mps = TRUE;
-         parameters->mpsThreshold = doubleArg;
-      }
-      else if (strcmp(argv[i], "-maxAnomalousScore") == 0) 
-      {
-         i++;
-         argumentExists = sscanf(argv[i], "%lf", &doubleArg);
-         if ((argumentExists != 1) || (doubleArg <= (double) 0.0) || 
-             (doubleArg >= (double) MAX_DOUBLE))
-         {
-            fprintf(stderr, "%s: maximum anomalous score must be greater than 0.0 and less than %lf\n", 
-	            argv[0],MAX_DOUBLE);
-            exit(1);
-         }
-	 //
-	 // NOTE:  This check assumes that the user has specified a max
-	 // anomalous score AFTER specifying they want to run the GBAD-P 
-	 // algorithm.
-	 //
-         if (((doubleArg <= (double) 0.0) || (doubleArg >= 1.0)) &&
-	     (parameters->prob))
-         {
-            fprintf(stderr, "%s: maximum anomalous score must be greater than 0.0 and less than 1.0\n",argv[0]);
-            exit(1);
-         }
-         parameters->maxAnomalousScore = doubleArg;
-      }
-      else if (strcmp(argv[i], "-minAnomalousScore") == 0) 
-      {
-         i++;
-         argumentExists = sscanf(argv[i], "%lf", &doubleArg);
-         if ((argumentExists != 1) || (doubleArg < (double) 0.0) || 
-             (doubleArg >= (double) MAX_DOUBLE))
-         {
-            fprintf(stderr, "%s: minimum anomalous score must be greater than or equal to 0.0 and less than %lf\n", argv[0],MAX_DOUBLE);
-            exit(1);
-         }
-         parameters->minAnomalousScore = doubleArg;
-      }
-      else if (strcmp(argv[i], "-norm") == 0) 
-      {
-         i++;
-         sscanf(argv[i], "%lu", &ulongArg);
-         if (ulongArg < 1)
-         {
-            fprintf(stderr, "%s: you must specify a value of 1 or greater.\n", argv[0]);
-            exit(1);
-         }
-         parameters->norm = ulongArg;
-      }
-      else if (strcmp(argv[i], "-noOpt") == 0) 
-      {
-         parameters->optimize = FALSE;
-      }
-      // GUI coloring
-      else if(strcmp(argv[i], "-dot") == 0)
-      {
-         i++;
-         strcpy(parameters->dotFileName, argv[i]);
-         parameters->dotToFile = TRUE;
-      }
-      else 
-      {
-         fprintf(stderr, "%s: unknown option %s\n", argv[0], argv[i]);
+         fprintf(stderr, "%s: %s\n", argv[0], message);
          exit(1);
       }
-      i++;
+      i += used;
    }
 
-   if ((parameters->mdl) || (parameters->prob) || (parameters->mps)) 
-      parameters->noAnomalyDetection = FALSE;
+   //
+   // In batch mode each example is searched on its own for the best
+   // substructures only, so options that work across iterations or on the
+   // whole input graph are not supported.  (An iterations value of 0 is
+   // infinite.)
+   //
+   if ((parameters->perExample) &&
+       ((parameters->mdl) || (parameters->prob) || (parameters->mps) ||
+        (parameters->iterations != 1) ||
+        (parameters->predefinedSubs) || (parameters->compress) ||
+        (parameters->dotToFile) || (parameters->evalMethod == EVAL_SETCOVER)))
+   {
+      fprintf(stderr, "%s: perexample can not be combined with anomaly detection, iterations, ps, compress, dot or setcover\n", argv[0]);
+      exit(1);
+   }
 
-   if (parameters->iterations == 0)
-      parameters->iterations = MAX_UNSIGNED_LONG; // infinity
+   //
+   // Windowed discovery slides over the positive examples as a stream,
+   // and has the same restrictions as batch mode.
+   //
+   if ((parameters->windowSize > 0) &&
+       ((parameters->perExample) ||
+        (parameters->mdl) || (parameters->prob) || (parameters->mps) ||
+        (parameters->iterations != 1) ||
+        (parameters->predefinedSubs) || (parameters->compress) ||
+        (parameters->dotToFile)))
+   {
+      fprintf(stderr, "%s: window can not be combined with perexample, anomaly detection, iterations, ps, compress or dot\n", argv[0]);
+      exit(1);
+   }
 
-   // initialize log2Factorial[0..1]
-   parameters->log2Factorial = (double *) malloc(2 * sizeof(double));
-   if (parameters->log2Factorial == NULL)
-      OutOfMemoryError("GetParameters:parameters->log2Factorial");
-   parameters->log2FactorialSize = 2;
-   parameters->log2Factorial[0] = 0; // lg(0!)
-   parameters->log2Factorial[1] = 0; // lg(1!)
+   //
+   // GBAD-P evaluation compresses the graph on the worker threads, which
+   // is not yet known to give the same results as a single thread.
+   //
+   if ((parameters->numThreads > 1) && (parameters->prob))
+   {
+      fprintf(stderr, "%s: threads can not be combined with prob\n", argv[0]);
+      exit(1);
+   }
 
    // read graphs from input file
    strcpy(parameters->inputFileName, argv[argc - 1]);
-   parameters->labelList = AllocateLabelList();
-   parameters->posGraph = NULL;
-   parameters->numPosEgs = 0;
-   parameters->posEgsVertexIndices = NULL;
-
    ReadInputFile(parameters);
    if (parameters->evalMethod == EVAL_MDL)
    {
@@ -663,13 +369,9 @@ Parameters *GetParameters(int argc, char *argv[])
    }
 
    // read predefined substructures
-   parameters->numPreSubs = 0;
    if (parameters->predefinedSubs)
       ReadPredefinedSubsFile(parameters);
 
-   parameters->incrementList = malloc(sizeof(IncrementList));
-   parameters->incrementList->head = NULL;
-
    // create output file, if given
    if (parameters->outputToFile) 
    {
@@ -683,28 +385,235 @@ Parameters *GetParameters(int argc, char *argv[])
       fclose(outputFile);
    }  
 
-   if (parameters->numPosEgs == 0)
+   prepareMessage = GBAD_PrepareParameters(parameters);
+   if (prepareMessage != NULL)
    {
-      fprintf(stderr, "ERROR: no positive graphs defined\n");
+      fprintf(stderr, "ERROR: %s\n", prepareMessage);
       exit(1);
    }
 
-   // Check bounds on discovered substructures' number of vertices
-   if (parameters->maxVertices == 0)
-      parameters->maxVertices = parameters->posGraph->numVertices;
-   if (parameters->maxVertices < parameters->minVertices)
+   return parameters;
+}
+
+
+//******************************************************************************
+// NAME: DiscoverSubsPerExample
+//
+// INPUTS: (Parameters *parameters)
+//
+// RETURN: (void)
+//
+// PURPOSE: Batch mode.  Discover the best substructures in each positive
+// example of the input file independently, as if each example had been
+// given to GBAD in a file of its own.  For every example, the example's
+// vertex range (from posEgsVertexIndices) is copied into its own graph and
+// label list, which temporarily replace the positive graph in parameters
+// while DiscoverSubs runs.  If an output file was given, the best
+// substructures of each example are written to it following a line of the
+// form "XP # <example number>".
+//******************************************************************************
+
+void DiscoverSubsPerExample(Parameters *parameters)
+{
+   SubList *subList;
+   Graph *exampleGraph;
+   LabelList *exampleLabelList;
+   FILE *outputFile;
+   ULONG posEgNo;
+   ULONG start;
+   ULONG finish;
+   ULONG exampleVertexIndex = 0;
+
+   // parameters saved, since they are replaced for each example
+   Graph *posGraph             = parameters->posGraph;
+   LabelList *labelList        = parameters->labelList;
+   ULONG numPosEgs             = parameters->numPosEgs;
+   ULONG *posEgsVertexIndices  = parameters->posEgsVertexIndices;
+   double posGraphDL           = parameters->posGraphDL;
+   ULONG maxVertices           = parameters->maxVertices;
+   ULONG limit                 = parameters->limit;
+
+   parameters->currentIteration = 1;
+   for (posEgNo = 0; posEgNo < numPosEgs; posEgNo++)
    {
-      fprintf(stderr, "ERROR: minsize exceeds maxsize\n");
-      exit(1);
+      start = posEgsVertexIndices[posEgNo];
+      if (posEgNo < (numPosEgs - 1))
+         finish = posEgsVertexIndices[posEgNo + 1];
+      else
+         finish = posGraph->numVertices;
+
+      exampleGraph = CopyExampleGraph(posGraph, start, finish);
+      exampleLabelList = AllocateLabelList();
+      parameters->labelList = labelList;
+      CompressLabelListWithGraph(exampleLabelList, exampleGraph, parameters);
+
+      parameters->posGraph = exampleGraph;
+      parameters->labelList = exampleLabelList;
+      parameters->numPosEgs = 1;
+      parameters->posEgsVertexIndices = & exampleVertexIndex;
+      if (parameters->evalMethod == EVAL_MDL)
+         parameters->posGraphDL = MDL(exampleGraph,
+                                      exampleLabelList->numLabels, parameters);
+      if (maxVertices == 0)
+         parameters->maxVertices = exampleGraph->numVertices;
+      if (limit == 0)
+         parameters->limit = exampleGraph->numEdges / 2;
+
+      printf("----- Example %lu -----\n\n", posEgNo + 1);
+      printf("%lu vertices, %lu edges", exampleGraph->numVertices,
+             exampleGraph->numEdges);
+      if (parameters->evalMethod == EVAL_MDL)
+         printf(", %.0f bits\n", parameters->posGraphDL);
+      else
+         printf("\n");
+      printf("%lu unique labels\n", exampleLabelList->numLabels);
+      printf("\n");
+
+      if (parameters->maxVertices < parameters->minVertices)
+         subList = AllocateSubList();
+      else
+         subList = DiscoverSubs(parameters, 1);
+
+      if (subList->head == NULL)
+         printf("No substructures found.\n\n");
+      else if (parameters->outputLevel > 1)
+      {
+         printf("\nBest %lu substructures:\n\n", CountSubs(subList));
+         PrintSubList(subList, parameters);
+      }
+      else
+      {
+         printf("\nBest substructure: ");
+         PrintSub(subList->head->sub, parameters);
+         printf("\n\n");
+      }
+
+      // write machine-readable output to file, if given
+      if (parameters->outputToFile)
+      {
+         outputFile = fopen(parameters->outFileName, "a");
+         if (outputFile == NULL)
+         {
+            printf("WARNING: unable to write to output file %s,",
+                   parameters->outFileName);
+            printf("disabling\n");
+            parameters->outputToFile = FALSE;
+         }
+         else
+         {
+            fprintf(outputFile, "%s # %lu\n", POS_EG_TOKEN, posEgNo + 1);
+            WriteSubGraphToFile(outputFile, subList, parameters, TRUE);
+            fclose(outputFile);
+         }
+      }
+
+      FreeSubList(subList);
+      ResetInstanceArena(parameters->instanceArena);
+      FreeGraph(exampleGraph);
+      FreeLabelList(exampleLabelList);
    }
 
-   // Set limit accordingly
-   if (parameters->limit == 0)
+   // restore the full positive graph
+   parameters->posGraph = posGraph;
+   parameters->labelList = labelList;
+   parameters->numPosEgs = numPosEgs;
+   parameters->posEgsVertexIndices = posEgsVertexIndices;
+   parameters->posGraphDL = posGraphDL;
+   parameters->maxVertices = maxVertices;
+   parameters->limit = limit;
+}
+
+
+//******************************************************************************
+// NAME: DiscoverSubsInWindow
+//
+// INPUTS: (Parameters *parameters)
+//
+// RETURN: (void)
+//
+// PURPOSE: Windowed mode.  Treat the positive examples of the input file
+// as a stream, and after each one arrives report the best substructures
+// of the window of the parameters->windowSize most recent examples.  Each
+// example's vertex range is copied into its own graph, which the window
+// (WindowAddExample) takes over.  If an output file was given, the best
+// substructures of each window are written to it following a line of the
+// form "XP # <number of the window's newest example>".
+//******************************************************************************
+
+void DiscoverSubsInWindow(Parameters *parameters)
+{
+   SubList *subList;
+   Graph *exampleGraph;
+   Window *window;
+   FILE *outputFile;
+   ULONG posEgNo;
+   ULONG start;
+   ULONG finish;
+
+   // parameters used
+   Graph *posGraph             = parameters->posGraph;
+   ULONG numPosEgs             = parameters->numPosEgs;
+   ULONG *posEgsVertexIndices  = parameters->posEgsVertexIndices;
+
+   parameters->currentIteration = 1;
+   for (posEgNo = 0; posEgNo < numPosEgs; posEgNo++)
    {
-      parameters->limit = parameters->posGraph->numEdges / 2;
-   }
+      start = posEgsVertexIndices[posEgNo];
+      if (posEgNo < (numPosEgs - 1))
+         finish = posEgsVertexIndices[posEgNo + 1];
+      else
+         finish = posGraph->numVertices;
 
-   return parameters;
+      printf("----- Example %lu -----\n\n", posEgNo + 1);
+      exampleGraph = CopyExampleGraph(posGraph, start, finish);
+      WindowAddExample(exampleGraph, parameters);
+      window = parameters->window;
+
+      printf("Window of %lu examples: %lu vertices, %lu edges",
+             window->numIncrements, window->numVertices, window->numEdges);
+      if (parameters->evalMethod == EVAL_MDL)
+         printf(", %.0f bits\n", window->graphSize);
+      else
+         printf("\n");
+      printf("%lu substructures tracked\n", window->numSubs);
+      printf("\n");
+
+      subList = WindowBestSubs(parameters);
+      if (subList->head == NULL)
+         printf("No substructures found.\n\n");
+      else if (parameters->outputLevel > 1)
+      {
+         printf("\nBest %lu substructures:\n\n", CountSubs(subList));
+         PrintSubList(subList, parameters);
+      }
+      else
+      {
+         printf("\nBest substructure: ");
+         PrintSub(subList->head->sub, parameters);
+         printf("\n\n");
+      }
+
+      // write machine-readable output to file, if given
+      if (parameters->outputToFile)
+      {
+         outputFile = fopen(parameters->outFileName, "a");
+         if (outputFile == NULL)
+         {
+            printf("WARNING: unable to write to output file %s,",
+                   parameters->outFileName);
+            printf("disabling\n");
+            parameters->outputToFile = FALSE;
+         }
+         else
+         {
+            fprintf(outputFile, "%s # %lu\n", POS_EG_TOKEN, posEgNo + 1);
+            WriteSubGraphToFile(outputFile, subList, parameters, TRUE);
+            fclose(outputFile);
+         }
+      }
+
+      FreeSubList(subList);
+   }
 }
 
 
@@ -775,6 +684,12 @@ void PrintParameters(Parameters *parameters)
    printf("  Maximum size of substructures.. %lu\n", parameters->maxVertices);
    printf("  Number of best substructures... %lu\n", parameters->numBestSubs);
    printf("  Output level................... %lu\n", parameters->outputLevel);
+   if (parameters->perExample)
+      printf("  Per-example (batch) discovery.. TRUE\n");
+   if (parameters->windowSize > 0)
+      printf("  Window of examples............. %lu\n", parameters->windowSize);
+   if (parameters->numThreads > 1)
+      printf("  Threads........................ %lu\n", parameters->numThreads);
    printf("  Allow overlapping instances.... ");
    PrintBoolean(parameters->allowInstanceOverlap);
    printf("  Prune.......................... ");
@@ -794,25 +709,3 @@ void PrintParameters(Parameters *parameters)
       printf("Read %lu predefined substructures\n", parameters->numPreSubs);
    printf("\n");
 }
-
-
-//******************************************************************************
-// NAME: FreeParameters
-//
-// INPUTS: (Parameters *parameters)
-//
-// RETURN: (void)
-//
-// PURPOSE: Free memory allocated for parameters.  Note that the
-//          predefined substructures are de-allocated as soon as they are
-//          processed, and not here.
-//******************************************************************************
-
-void FreeParameters(Parameters *parameters)
-{
-   FreeGraph(parameters->posGraph);
-   FreeLabelList(parameters->labelList);
-   free(parameters->posEgsVertexIndices);
-   free(parameters->log2Factorial);
-   free(parameters);
-}
@@ -0,0 +1,512 @@
+//******************************************************************************
+// server.c
+//
+// Server mode of gbad:
+//
+//    gbad -serve <socket> [-workers <n>] [options]
+//
+// listens on a Unix-domain socket and runs discovery on the graphs sent to
+// it, without the process startup, banner and file I/O of a command-line
+// run.  The options given after the socket are the defaults of every
+// request.  A pool of worker threads accepts connections, and each worker
+// serves the requests of one connection at a time, in order.
+//
+// A request is two length-prefixed fields: the option overrides, as
+// command-line options separated by white space, then the graph, in the
+// text or binary (graph2bin) input format.  Each length is a 32-bit
+// unsigned integer in network byte order.  The reply is a sequence of
+// length-prefixed frames, one for each iteration that found substructures,
+// holding the best substructures in the format of the -out file, followed
+// by an empty frame.  A request that fails is answered by a single frame
+// "ERROR: <message>" and the empty frame.  Options that name files (-out,
+// -ps, -dot, -compress), -perexample and -window are not supported.
+//
+// Date      Name       Description
+// ========  =========  ========================================================
+// 10/17/26  agent      Initial version.
+// 10/17/26  agent      Reject -window option.
+//
+//******************************************************************************
+
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "gbad.h"
+
+
+//******************************************************************************
+// NAME: ServeGraphs
+//
+// INPUTS: (int argc) - number of arguments to program
+//         (char **argv) - arguments to program, argv[1] being -serve
+//
+// RETURN: (int) - 1 if the server could not be started; otherwise the
+//                 server runs until the process is killed
+//
+// PURPOSE: Check the default options, listen on the socket and start the
+// worker threads.  Anything printed by discovery goes to /dev/null, and
+// errors of the server itself to stderr.
+//******************************************************************************
+
+int ServeGraphs(int argc, char **argv)
+{
+   ServerInfo serverInfo;
+   Parameters *parameters;
+   struct sockaddr_un address;
+   pthread_t *workers;
+   char message[GBAD_MESSAGE_LEN];
+   ULONG numWorkers = SERVER_WORKERS;
+   ULONG w;
+   int optionsStart = 3;
+
+   if (argc < 3)
+   {
+      fprintf(stderr, "%s: -serve must be given a socket name\n", argv[0]);
+      return 1;
+   }
+   if (strlen(argv[2]) >= sizeof(address.sun_path))
+   {
+      fprintf(stderr, "%s: socket name too long\n", argv[0]);
+      return 1;
+   }
+   if ((argc > 4) && (strcmp(argv[3], "-workers") == 0))
+   {
+      if ((sscanf(argv[4], "%lu", & numWorkers) != 1) || (numWorkers == 0))
+      {
+         fprintf(stderr, "%s: workers must be greater than zero\n", argv[0]);
+         return 1;
+      }
+      optionsStart = 5;
+   }
+   serverInfo.argc = argc - optionsStart;
+   serverInfo.argv = argv + optionsStart;
+
+   // check the default options once, rather than on each request
+   parameters = GBAD_AllocateParameters();
+   if (! SetServerOptions(parameters, serverInfo.argc, serverInfo.argv,
+                          message))
+   {
+      fprintf(stderr, "%s: %s\n", argv[0], message);
+      GBAD_FreeParameters(parameters);
+      return 1;
+   }
+   GBAD_FreeParameters(parameters);
+
+   serverInfo.listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+   if (serverInfo.listenFd < 0)
+   {
+      perror("socket");
+      return 1;
+   }
+   memset(& address, 0, sizeof(address));
+   address.sun_family = AF_UNIX;
+   strcpy(address.sun_path, argv[2]);
+   unlink(argv[2]);
+   if ((bind(serverInfo.listenFd, (struct sockaddr *) & address,
+             sizeof(address)) != 0) ||
+       (listen(serverInfo.listenFd, SERVER_BACKLOG) != 0))
+   {
+      perror(argv[2]);
+      close(serverInfo.listenFd);
+      return 1;
+   }
+
+   signal(SIGPIPE, SIG_IGN);
+   fprintf(stderr, "%s: serving on %s with %lu workers\n", argv[0], argv[2],
+           numWorkers);
+   if (freopen("/dev/null", "w", stdout) == NULL)
+      fprintf(stderr, "%s: unable to discard standard output\n", argv[0]);
+
+   workers = (pthread_t *) malloc(sizeof(pthread_t) * numWorkers);
+   if (workers == NULL)
+      OutOfMemoryError("ServeGraphs:workers");
+   for (w = 0; w < numWorkers; w++)
+      if (pthread_create(& workers[w], NULL, ServerWorker, & serverInfo)
+          != 0)
+      {
+         fprintf(stderr, "%s: unable to create worker thread\n", argv[0]);
+         exit(1);
+      }
+   for (w = 0; w < numWorkers; w++)
+      pthread_join(workers[w], NULL);
+   free(workers);
+   close(serverInfo.listenFd);
+   return 0;
+}
+
+
+//******************************************************************************
+// NAME: ServerWorker
+//
+// INPUTS: (void *arg) - the ServerInfo of the server
+//
+// RETURN: (void *) - NULL
+//
+// PURPOSE: Worker thread of the server: accept connections and serve
+// their requests, one connection at a time.
+//******************************************************************************
+
+void *ServerWorker(void *arg)
+{
+   ServerInfo *serverInfo = (ServerInfo *) arg;
+   int connectionFd;
+
+   while (TRUE)
+   {
+      connectionFd = accept(serverInfo->listenFd, NULL, NULL);
+      if (connectionFd >= 0)
+      {
+         ServeConnection(serverInfo, connectionFd);
+         close(connectionFd);
+      }
+      else if (errno != EINTR)
+         perror("accept");
+   }
+   return NULL;
+}
+
+
+//******************************************************************************
+// NAME: ServeConnection
+//
+// INPUTS: (ServerInfo *serverInfo)
+//         (int connectionFd) - connected socket
+//
+// RETURN: (void)
+//
+// PURPOSE: Serve the requests sent on one connection until the client
+// closes it, or a request or reply is cut short.
+//******************************************************************************
+
+void ServeConnection(ServerInfo *serverInfo, int connectionFd)
+{
+   char *options;
+   char *graph;
+   ULONG graphLength;
+   BOOLEAN connected = TRUE;
+
+   while ((connected) &&
+          (ReadServerRequest(connectionFd, & options, & graph,
+                             & graphLength)))
+   {
+      connected = ServeRequest(serverInfo, connectionFd, options, graph,
+                               graphLength);
+      free(options);
+      free(graph);
+   }
+}
+
+
+//******************************************************************************
+// NAME: ReadServerRequest
+//
+// INPUTS: (int connectionFd) - connected socket
+//         (char **options) - where to put the null-terminated options
+//         (char **graph) - where to put the graph
+//         (ULONG *graphLength) - where to put the length of the graph
+//
+// RETURN: (BOOLEAN) - TRUE if a whole request was read
+//
+// PURPOSE: Read the next request of a connection.  The options and graph
+// are allocated here, and freed by the caller if TRUE is returned.
+//******************************************************************************
+
+BOOLEAN ReadServerRequest(int connectionFd, char **options, char **graph,
+                          ULONG *graphLength)
+{
+   uint32_t length;
+
+   if (! ReadFully(connectionFd, (char *) & length, sizeof(length)))
+      return FALSE;
+   length = ntohl(length);
+   if (length > SERVER_MAX_OPTIONS)
+      return FALSE;
+   *options = (char *) malloc(length + 1);
+   if (*options == NULL)
+      OutOfMemoryError("ReadServerRequest:options");
+   (*options)[length] = '\0';
+   if ((! ReadFully(connectionFd, *options, length)) ||
+       (! ReadFully(connectionFd, (char *) & length, sizeof(length))))
+   {
+      free(*options);
+      return FALSE;
+   }
+   length = ntohl(length);
+   if (length > SERVER_MAX_GRAPH)
+   {
+      free(*options);
+      return FALSE;
+   }
+   *graph = (char *) malloc(length + 1);
+   if (*graph == NULL)
+      OutOfMemoryError("ReadServerRequest:graph");
+   if (! ReadFully(connectionFd, *graph, length))
+   {
+      free(*options);
+      free(*graph);
+      return FALSE;
+   }
+   *graphLength = length;
+   return TRUE;
+}
+
+
+//******************************************************************************
+// NAME: ServeRequest
+//
+// INPUTS: (ServerInfo *serverInfo)
+//         (int connectionFd) - connected socket
+//         (char *options) - option overrides of the request
+//         (char *graph) - graph of the request
+//         (ULONG graphLength) - length of graph
+//
+// RETURN: (BOOLEAN) - FALSE if the reply could not be sent
+//
+// PURPOSE: Run discovery on the graph of one request, with the server's
+// default options overridden by the request's, and send back the best
+// substructures of each iteration as it ends, as main would write them
+// to the -out file.
+//******************************************************************************
+
+BOOLEAN ServeRequest(ServerInfo *serverInfo, int connectionFd,
+                     char *options, char *graph, ULONG graphLength)
+{
+   Parameters *parameters;
+   SubList *subList;
+   Substructure *normSub = NULL;
+   GP_error error;
+   char message[GBAD_MESSAGE_LEN];
+   char **optionArgv;
+   int optionArgc;
+   char *token;
+   char *position;
+   char *records;
+   size_t recordsLength;
+   FILE *recordsFile;
+   char *prepareMessage;
+   ULONG iteration;
+   BOOLEAN done = FALSE;
+   BOOLEAN sent = TRUE;
+
+   parameters = GBAD_AllocateParameters();
+
+   // split the option overrides at white space
+   optionArgv = (char **) malloc(sizeof(char *) * (strlen(options) / 2 + 1));
+   if (optionArgv == NULL)
+      OutOfMemoryError("ServeRequest:optionArgv");
+   optionArgc = 0;
+   token = strtok_r(options, " \t\r\n", & position);
+   while (token != NULL)
+   {
+      optionArgv[optionArgc] = token;
+      optionArgc++;
+      token = strtok_r(NULL, " \t\r\n", & position);
+   }
+
+   message[0] = '\0';
+   if ((! SetServerOptions(parameters, serverInfo->argc, serverInfo->argv,
+                           message)) ||
+       (! SetServerOptions(parameters, optionArgc, optionArgv, message)))
+      done = TRUE;
+   else if (GBAD_ReadGraph(parameters, graph, graphLength, & error) != 0)
+   {
+      if (error.lineNo > 0)
+         snprintf(message, GBAD_MESSAGE_LEN, "line %lu: %s", error.lineNo,
+                  error.message);
+      else
+         snprintf(message, GBAD_MESSAGE_LEN, "%s", error.message);
+      done = TRUE;
+   }
+   else
+   {
+      prepareMessage = GBAD_PrepareParameters(parameters);
+      if (prepareMessage != NULL)
+      {
+         snprintf(message, GBAD_MESSAGE_LEN, "%s", prepareMessage);
+         done = TRUE;
+      }
+   }
+   free(optionArgv);
+   if (done)
+   {
+      sent = WriteServerError(connectionFd, message);
+      GBAD_FreeParameters(parameters);
+      return sent;
+   }
+
+   iteration = 1;
+   while ((iteration <= parameters->iterations) && (!done))
+   {
+      subList = GBAD_DiscoverIteration(parameters, & normSub);
+      if (subList->head == NULL)
+         done = TRUE;
+      else
+      {
+         recordsFile = open_memstream(& records, & recordsLength);
+         if (recordsFile == NULL)
+            OutOfMemoryError("ServeRequest:recordsFile");
+         WriteSubGraphToFile(recordsFile, subList, parameters, TRUE);
+         fclose(recordsFile);
+         if (sent)
+            sent = WriteServerFrame(connectionFd, records, recordsLength);
+         free(records);
+
+         if ((iteration < parameters->iterations) &&
+             (! GBAD_CompressIteration(parameters, subList, normSub)))
+            done = TRUE;
+      }
+      GBAD_EndIteration(parameters, subList);
+      iteration++;
+   }
+
+   if (sent)
+      sent = WriteServerFrame(connectionFd, NULL, 0);
+   GBAD_FreeParameters(parameters);
+   return sent;
+}
+
+
+//******************************************************************************
+// NAME: SetServerOptions
+//
+// INPUTS: (Parameters *parameters) - parameters to change
+//         (int argc) - number of option arguments
+//         (char **argv) - option arguments
+//         (char *message) - where to describe an error, of at least
+//                           GBAD_MESSAGE_LEN characters
+//
+// RETURN: (BOOLEAN) - FALSE if an option is not valid
+//
+// PURPOSE: Set the options of a request, refusing those that the server
+// does not support.
+//******************************************************************************
+
+BOOLEAN SetServerOptions(Parameters *parameters, int argc, char **argv,
+                         char *message)
+{
+   int i = 0;
+   int used;
+
+   while (i < argc)
+   {
+      if ((strcmp(argv[i], "-out") == 0) || (strcmp(argv[i], "-ps") == 0) ||
+          (strcmp(argv[i], "-dot") == 0) ||
+          (strcmp(argv[i], "-compress") == 0) ||
+          (strcmp(argv[i], "-perexample") == 0) ||
+          (strcmp(argv[i], "-window") == 0))
+      {
+         snprintf(message, GBAD_MESSAGE_LEN,
+                  "option %s is not supported by the server", argv[i]);
+         return FALSE;
+      }
+      used = GBAD_SetOption(parameters, argc, argv, i, message);
+      if (used == 0)
+         return FALSE;
+      i += used;
+   }
+   return TRUE;
+}
+
+
+//******************************************************************************
+// NAME: WriteServerFrame
+//
+// INPUTS: (int connectionFd) - connected socket
+//         (char *data) - contents of frame
+//         (ULONG length) - length of data
+//
+// RETURN: (BOOLEAN) - TRUE if the frame was sent
+//
+// PURPOSE: Send one length-prefixed frame of a reply.
+//******************************************************************************
+
+BOOLEAN WriteServerFrame(int connectionFd, char *data, ULONG length)
+{
+   uint32_t prefix = htonl((uint32_t) length);
+
+   return ((WriteFully(connectionFd, (char *) & prefix, sizeof(prefix))) &&
+           (WriteFully(connectionFd, data, length)));
+}
+
+
+//******************************************************************************
+// NAME: WriteServerError
+//
+// INPUTS: (int connectionFd) - connected socket
+//         (char *message) - description of the error
+//
+// RETURN: (BOOLEAN) - TRUE if the reply was sent
+//
+// PURPOSE: Send the reply to a request that failed.
+//******************************************************************************
+
+BOOLEAN WriteServerError(int connectionFd, char *message)
+{
+   char frame[GBAD_MESSAGE_LEN + 16];
+
+   snprintf(frame, sizeof(frame), "ERROR: %s\n", message);
+   return ((WriteServerFrame(connectionFd, frame, strlen(frame))) &&
+           (WriteServerFrame(connectionFd, NULL, 0)));
+}
+
+
+//******************************************************************************
+// NAME: ReadFully
+//
+// INPUTS: (int fd) - file descriptor
+//         (char *buffer) - where to put the data
+//         (ULONG length) - number of bytes to read
+//
+// RETURN: (BOOLEAN) - TRUE if all length bytes were read
+//******************************************************************************
+
+BOOLEAN ReadFully(int fd, char *buffer, ULONG length)
+{
+   ssize_t count;
+
+   while (length > 0)
+   {
+      count = read(fd, buffer, length);
+      if (count > 0)
+      {
+         buffer += count;
+         length -= count;
+      }
+      else if ((count == 0) || (errno != EINTR))
+         return FALSE;
+   }
+   return TRUE;
+}
+
+
+//******************************************************************************
+// NAME: WriteFully
+//
+// INPUTS: (int fd) - file descriptor
+//         (char *buffer) - data to write
+//         (ULONG length) - number of bytes to write
+//
+// RETURN: (BOOLEAN) - TRUE if all length bytes were written
+//******************************************************************************
+
+BOOLEAN WriteFully(int fd, char *buffer, ULONG length)
+{
+   ssize_t count;
+
+   while (length > 0)
+   {
+      count = write(fd, buffer, length);
+      if (count > 0)
+      {
+         buffer += count;
+         length -= count;
+      }
+      else if ((count == 0) || (errno != EINTR))
+         return FALSE;
+   }
+   return TRUE;
+}
@@ -9,6 +9,10 @@
 // Date      Name       Description
 // ========  =========  ========================================================
 // 08/12/09  Eberle     Initial version, taken from SUBDUE 5.2.1
+// 10/17/26  agent      Vertex and edge marks kept in VisitSets
+// 10/17/26  agent      FindSingleVertexInstances uses the graph label index
+// 10/17/26  agent      Instances extended through the graph edge type index
+// 10/17/26  agent      Instance overlap checked against vertex coverage marks
 //
 //******************************************************************************
 
@@ -25,7 +29,8 @@
 //
 // PURPOSE: Searches for subgraphs of g2 that match g1 and returns the
 // list of such subgraphs as instances in g2.  Returns empty list if
-// no matches exist.  This procedure mimics the DiscoverSubs loop by
+// no matches exist, without searching if g2 lacks edges of g1's edge
+// types (EdgeTypesPresent).  This procedure mimics the DiscoverSubs loop by
 // repeatedly expanding instances of subgraphs of g1 in g2 until
 // matches are found.  The procedure is optimized toward g1 being a
 // small graph and g2 being a large graph.
@@ -46,27 +51,34 @@ InstanceList *FindInstances(Graph *g1, Graph *g2, Parameters *parameters)
    BOOLEAN *reached;
    BOOLEAN noMatches;
    BOOLEAN found;
+   VisitSet *vertexVisits;  // g1 vertices whose edges have been added
+   VisitSet *edgeVisits;    // g1 edges added
 
    reached = (BOOLEAN *) malloc(sizeof(BOOLEAN) * g1->numVertices);
    if (reached == NULL)
       OutOfMemoryError("FindInstances:reached");
+   vertexVisits = AllocateVisitSet(g1->numVertices);
+   edgeVisits = AllocateVisitSet(g1->numEdges);
    for (v1 = 0; v1 < g1->numVertices; v1++)
       reached[v1] = FALSE;
    v1 = 0; // first vertex in g1
    reached[v1] = TRUE;
    vertex1 = & g1->vertices[v1];
-   instanceList = FindSingleVertexInstances(g2, vertex1, parameters);
+   if (EdgeTypesPresent(g1, g2))
+      instanceList = FindSingleVertexInstances(g2, vertex1, parameters);
+   else
+      instanceList = AllocateInstanceList();
    noMatches = FALSE;
    if (instanceList->head == NULL) // no matches to vertex1 found in g2
       noMatches = TRUE;
    while ((vertex1 != NULL) && (! noMatches)) 
    {
-      vertex1->used = TRUE;
+      VISIT(vertexVisits, v1);
       // extend by each unmarked edge involving vertex v1
       for (e1 = 0; ((e1 < vertex1->numEdges) && (! noMatches)); e1++) 
       {
          edge1 = & g1->edges[g1->vertices[v1].edges[e1]];
-         if (! edge1->used) 
+         if (! VISITED(edgeVisits, g1->vertices[v1].edges[e1])) 
          {
             reached[edge1->vertex1] = TRUE;
             reached[edge1->vertex2] = TRUE;
@@ -74,7 +86,7 @@ InstanceList *FindInstances(Graph *g1, Graph *g2, Parameters *parameters)
                ExtendInstancesByEdge(instanceList, g1, edge1, g2, parameters);
             if (instanceList->head == NULL)
                noMatches = TRUE;
-            edge1->used = TRUE;
+            VISIT(edgeVisits, g1->vertices[v1].edges[e1]);
          }
       }
       // find next un-used, reached vertex
@@ -82,7 +94,7 @@ InstanceList *FindInstances(Graph *g1, Graph *g2, Parameters *parameters)
       found = FALSE;
       for (v = 0; ((v < g1->numVertices) && (! found)); v++) 
       {
-         if ((! g1->vertices[v].used) && (reached[v])) 
+         if ((! VISITED(vertexVisits, v)) && (reached[v])) 
          {
             v1 = v;
             vertex1 = & g1->vertices[v1];
@@ -91,12 +103,8 @@ InstanceList *FindInstances(Graph *g1, Graph *g2, Parameters *parameters)
       }
    }
    free(reached);
-
-   // set used flags to FALSE
-   for (v1 = 0; v1 < g1->numVertices; v1++)
-      g1->vertices[v1].used = FALSE;
-   for (e1 = 0; e1 < g1->numEdges; e1++)
-      g1->edges[e1].used = FALSE;
+   FreeVisitSet(vertexVisits);
+   FreeVisitSet(edgeVisits);
 
    // filter instances not matching g1
    // filter overlapping instances if appropriate
@@ -106,6 +114,42 @@ InstanceList *FindInstances(Graph *g1, Graph *g2, Parameters *parameters)
 }
 
 
+//******************************************************************************
+// NAME: EdgeTypesPresent
+//
+// INPUTS: (Graph *g1) - graph to search for
+//         (Graph *g2) - graph to search in
+//
+// RETURN: (BOOLEAN) - FALSE if g1 can have no instance in g2
+//
+// PURPOSE: Check, through the edge type indices of both graphs, that g2
+// has at least as many edges of each edge type as g1 does.  Since the
+// edges of an instance match g1's edges exactly (EdgesMatch), there are
+// no instances of g1 in g2 otherwise.
+//******************************************************************************
+
+BOOLEAN EdgeTypesPresent(Graph *g1, Graph *g2)
+{
+   GraphEdgeIndex *index1;
+   GraphEdgeIndex *index2;
+   ULONG type1;
+   ULONG type2;
+   BOOLEAN present = TRUE;
+
+   index1 = GetGraphEdgeIndex(g1);
+   index2 = GetGraphEdgeIndex(g2);
+   for (type1 = 0; ((type1 < index1->numTypes) && present); type1++)
+   {
+      type2 = FindEdgeType(index2,
+                           & index1->typeKeys[type1 * EDGE_TYPE_KEY_LEN]);
+      if ((type2 == EDGE_TYPE_NONE) ||
+          (index2->typeCounts[type2] < index1->typeCounts[type1]))
+         present = FALSE;
+   }
+   return present;
+}
+
+
 //******************************************************************************
 // NAME: FindSingleVertexInstances
 //
@@ -123,21 +167,24 @@ InstanceList *FindInstances(Graph *g1, Graph *g2, Parameters *parameters)
 InstanceList *FindSingleVertexInstances(Graph *graph, Vertex *vertex,
                                         Parameters *parameters)
 {
-   ULONG v;
+   ULONG i;
    InstanceList *instanceList;
    Instance *instance;
+   GraphLabelIndex *labelIndex;
 
    instanceList = AllocateInstanceList();
-   for (v = 0; v < graph->numVertices; v++) 
+   labelIndex = GetGraphLabelIndex(graph);
+   if (vertex->label >= labelIndex->numLabels)
+      return instanceList;
+   for (i = labelIndex->starts[vertex->label];
+        i < labelIndex->starts[vertex->label + 1]; i++)
    {
-      if (graph->vertices[v].label == vertex->label) 
-      {
-         // ***** do inexact label matches here? (instance->minMatchCost too)
-         instance = AllocateInstance(1, 0);
-         instance->vertices[0] = v;
-         instance->minMatchCost = 0.0;
-         InstanceListInsert(instance, instanceList, FALSE);
-      }
+      // ***** do inexact label matches here? (instance->minMatchCost too)
+      instance = AllocateInstance(1, 0,
+                                  parameters->instanceArena);
+      instance->vertices[0] = labelIndex->vertices[i];
+      instance->minMatchCost = 0.0;
+      InstanceListInsert(instance, instanceList, FALSE);
    }
    return instanceList;
 }
@@ -158,6 +205,10 @@ InstanceList *FindSingleVertexInstances(Graph *graph, Vertex *vertex,
 // edge from graph g2 that matches the attributes of the given edge in
 // graph g1.  Returns a new (possibly empty) instance list containing
 // the extended instances.  The given instance list is de-allocated.
+// Only the edges of each instance vertex that have the given edge's
+// type are considered, as found in g2's edge type index, in the same
+// order as in the vertex's edge array.  EdgeTypesPresent or
+// FindSingleVertexInstances must first have built g2's index.
 //******************************************************************************
 
 InstanceList *ExtendInstancesByEdge(InstanceList *instanceList,
@@ -170,25 +221,35 @@ InstanceList *ExtendInstancesByEdge(InstanceList *instanceList,
    Instance *newInstance;
    ULONG v2;
    ULONG e2;
-   Edge *edge2;
-   Vertex *vertex2;
+   ULONG key[EDGE_TYPE_KEY_LEN];
+   ULONG type;
+   ULONG numTypeEdges;
+   ULONG *typeEdges;
+   GraphEdgeIndex *edgeIndex;
+   VisitSet *edgeVisits = parameters->edgeVisits;
 
    newInstanceList = AllocateInstanceList();
-   // extend each instance
-   instanceListNode = instanceList->head;
+   edgeIndex = GetGraphEdgeIndex(g2);
+   EdgeTypeKey(g1, edge1, key);
+   type = FindEdgeType(edgeIndex, key);
+   // extend each instance, unless no edge in g2 matches edge1
+   if (type != EDGE_TYPE_NONE)
+      instanceListNode = instanceList->head;
+   else
+      instanceListNode = NULL;
    while (instanceListNode != NULL) 
    {
       instance = instanceListNode->instance;
-      MarkInstanceEdges(instance, g2, TRUE);
+      ClearVisitSet(edgeVisits, g2->numEdges);
+      MarkInstanceEdges(instance, edgeVisits);
       // consider extending from each vertex in instance
       for (v2 = 0; v2 < instance->numVertices; v2++) 
       {
-         vertex2 = & g2->vertices[instance->vertices[v2]];
-         for (e2 = 0; e2 < vertex2->numEdges; e2++) 
+         numTypeEdges = VertexEdgesOfType(edgeIndex, instance->vertices[v2],
+                                          type, & typeEdges);
+         for (e2 = 0; e2 < numTypeEdges; e2++) 
          {
-            edge2 = & g2->edges[vertex2->edges[e2]];
-            if ((! edge2->used) &&
-                (EdgesMatch(g1, edge1, g2, edge2, parameters))) 
+            if (! VISITED(edgeVisits, typeEdges[e2])) 
             {
                // add new instance to list
                newInstance =
@@ -196,13 +257,12 @@ InstanceList *ExtendInstancesByEdge(InstanceList *instanceList,
                   // GBAD-P:  Added instance parameter.
                   //
                   CreateExtendedInstance(instance, instance->vertices[v2],
-                                         vertex2->edges[e2], g2, FALSE);
+                                         typeEdges[e2], g2, FALSE);
                   //
                InstanceListInsert(newInstance, newInstanceList, TRUE);
             }
          }
       }
-      MarkInstanceEdges(instance, g2, FALSE);
       instanceListNode = instanceListNode->next;
    }
    FreeInstanceList(instanceList);
@@ -269,7 +329,9 @@ BOOLEAN EdgesMatch(Graph *g1, Edge *edge1, Graph *g2, Edge *edge2,
 // PURPOSE: Creates and returns a new instance list containing only
 // those instances matching subGraph.  If
 // parameters->allowInstanceOverlap=FALSE, then remaining instances
-// will not overlap.  The given instance list is de-allocated.
+// will not overlap, as checked against the vertices of the instances
+// kept so far, marked in parameters->coverVisits.  The given instance
+// list is de-allocated.
 //******************************************************************************
 
 InstanceList *FilterInstances(Graph *subGraph, InstanceList *instanceList,
@@ -281,8 +343,10 @@ InstanceList *FilterInstances(Graph *subGraph, InstanceList *instanceList,
    Graph *instanceGraph;
    double thresholdLimit;
    double matchCost;
+   VisitSet *coverVisits = parameters->coverVisits;
 
    newInstanceList = AllocateInstanceList();
+   ClearVisitSet(coverVisits, graph->numVertices);
    if (instanceList != NULL) 
    {
       instanceListNode = instanceList->head;
@@ -292,7 +356,7 @@ InstanceList *FilterInstances(Graph *subGraph, InstanceList *instanceList,
          {
             instance = instanceListNode->instance;
             if (parameters->allowInstanceOverlap ||
-                (! InstanceListOverlap(instance, newInstanceList))) 
+                (! InstanceVerticesMarked(instance, coverVisits))) 
             {
                thresholdLimit = parameters->threshold *
                                 (instance->numVertices + instance->numEdges);
@@ -303,6 +367,7 @@ InstanceList *FilterInstances(Graph *subGraph, InstanceList *instanceList,
                   if (matchCost < instance->minMatchCost)
                      instance->minMatchCost = matchCost;
                   InstanceListInsert(instance, newInstanceList, FALSE);
+                  MarkInstanceVertices(instance, coverVisits);
                }
                FreeGraph(instanceGraph);
             }
@@ -6,6 +6,18 @@
 // Date      Name       Description
 // ========  =========  ========================================================
 // 08/12/09  Eberle     Initial version, taken from SUBDUE 5.2.1
+// 10/16/26  agent      Substructure lists indexed by canonical hash;
+//                      duplicate checks compare canonical codes
+// 10/16/26  agent      InstanceToGraph builds adjacency in one pass
+// 10/17/26  agent      Instance marks kept in a VisitSet
+// 10/17/26  agent      Instance lists indexed by instance hash for unique
+//                      insertion
+// 10/17/26  agent      Instances carved from an InstanceArena; removed
+//                      unused AddInstanceToInstance and AddEdgeToInstance
+// 10/17/26  agent      InstanceExampleNumber reads the per-vertex example table
+// 10/17/26  agent      InstancesOverlap checks in one pass over vertex marks;
+//                      added MarkInstanceListVertices
+// 10/17/26  agent      Instances no longer carry a used flag
 //
 //******************************************************************************
 
@@ -31,6 +43,7 @@ SubListNode *AllocateSubListNode(Substructure *sub)
       OutOfMemoryError("SubListNode");
    subListNode->sub = sub;
    subListNode->next = NULL;
+   subListNode->hashNext = NULL;
    return subListNode;
 }
 
@@ -74,6 +87,9 @@ SubList *AllocateSubList(void)
    if (subList == NULL)
       OutOfMemoryError("AllocateSubList:subList");
    subList->head = NULL;
+   subList->hashSize = 0;
+   subList->numHashed = 0;
+   subList->hashTable = NULL;
    return subList;
 }
 
@@ -112,7 +128,15 @@ void SubListInsert(Substructure *sub, SubList *subList, ULONG max,
    ULONG numDiffVals = 0;
    BOOLEAN inserted = FALSE;
 
+   // if sub already on subList, destroy and exit
+   if (FindSubInSubList(sub, subList, TRUE, labelList) != NULL)
+   {
+      FreeSub(sub);
+      return;
+   }
+
    newSubListNode = AllocateSubListNode(sub);
+   SubListIndexInsert(newSubListNode, subList);
 
    // if subList empty, insert new sub and exit (no need to check maximums)
    if (subList->head == NULL) 
@@ -121,22 +145,6 @@ void SubListInsert(Substructure *sub, SubList *subList, ULONG max,
       return;
    }
 
-   // if sub already on subList, destroy and exit
-   subIndex = subList->head;
-   while ((subIndex != NULL) && (subIndex->sub->value >= sub->value))
-   {
-      if (subIndex->sub->value == sub->value)
-      {
-         if (GraphMatch(subIndex->sub->definition, sub->definition,
-             labelList, 0.0, NULL, NULL))
-         {
-            FreeSubListNode(newSubListNode);
-            return;
-         }
-      }
-      subIndex = subIndex->next;
-   }
-
    // sub is unique, so insert in appropriate place and check maximums
    subIndex = subList->head;
    while (subIndex != NULL) 
@@ -182,6 +190,7 @@ void SubListInsert(Substructure *sub, SubList *subList, ULONG max,
          {
             subIndexPrevious = subIndex;
             subIndex = subIndex->next;
+            SubListIndexRemove(subIndexPrevious, subList);
             FreeSubListNode(subIndexPrevious);
          }
       } 
@@ -193,7 +202,10 @@ void SubListInsert(Substructure *sub, SubList *subList, ULONG max,
    }
 
    if (! inserted)
+   {
+      SubListIndexRemove(newSubListNode, subList);
       FreeSubListNode(newSubListNode);
+   }
 }
 
 
@@ -212,22 +224,140 @@ void SubListInsert(Substructure *sub, SubList *subList, ULONG max,
 
 BOOLEAN MemberOfSubList(Substructure *sub, SubList *subList,
                         LabelList *labelList)
+{
+   if (subList == NULL)
+      return FALSE;
+   return (FindSubInSubList(sub, subList, FALSE, labelList) != NULL);
+}
+
+
+//******************************************************************************
+// NAME: FindSubInSubList
+//
+// INPUTS: (Substructure *sub) - substructure to look for
+//         (SubList *subList) - list to search
+//         (BOOLEAN sameValue) - if TRUE, only substructures with the
+//                               same value as sub are considered
+//         (LabelList *labelList) - needed for checking sub equality
+//
+// RETURN: (SubListNode *) - node holding an equal substructure, or NULL
+//
+// PURPOSE: Look up sub in the list's hash index.  Only substructures
+// in sub's bucket with an equal canonical hash are compared (see
+// SubsMatch).  Nodes whose substructure has been taken off the list
+// (sub = NULL) are skipped.
+//******************************************************************************
+
+SubListNode *FindSubInSubList(Substructure *sub, SubList *subList,
+                              BOOLEAN sameValue, LabelList *labelList)
 {
    SubListNode *subListNode;
-   BOOLEAN found = FALSE;
 
-   if (subList != NULL) 
+   if (subList->numHashed == 0)
+      return NULL;
+   ComputeSubCanonicalCode(sub);
+   subListNode =
+      subList->hashTable[sub->canonicalHash & (subList->hashSize - 1)];
+   while (subListNode != NULL)
    {
-      subListNode = subList->head;
-      while ((subListNode != NULL) && (! found)) 
+      if ((subListNode->sub != NULL) &&
+          (subListNode->sub->canonicalHash == sub->canonicalHash) &&
+          ((! sameValue) || (subListNode->sub->value == sub->value)) &&
+          SubsMatch(sub, subListNode->sub, labelList))
+         return subListNode;
+      subListNode = subListNode->hashNext;
+   }
+   return NULL;
+}
+
+
+//******************************************************************************
+// NAME: SubListIndexInsert
+//
+// INPUTS: (SubListNode *subListNode) - node to index
+//         (SubList *subList) - list the node belongs to
+//
+// RETURN: (void)
+//
+// PURPOSE: Add the node to the list's hash index, keyed by the
+// canonical hash of its substructure.  The index is allocated on first
+// use and doubled when it holds twice as many nodes as buckets.
+//******************************************************************************
+
+void SubListIndexInsert(SubListNode *subListNode, SubList *subList)
+{
+   SubListNode **newTable;
+   SubListNode *node;
+   SubListNode *nextNode;
+   ULONG newSize;
+   ULONG i;
+   ULONG bucket;
+
+   ComputeSubCanonicalCode(subListNode->sub);
+   if ((subList->hashSize == 0) ||
+       (subList->numHashed >= 2 * subList->hashSize))
+   {
+      if (subList->hashSize == 0)
+         newSize = SUB_HASH_INIT_SIZE;
+      else
+         newSize = 2 * subList->hashSize;
+      newTable = (SubListNode **) malloc(sizeof(SubListNode *) * newSize);
+      if (newTable == NULL)
+         OutOfMemoryError("SubListIndexInsert:newTable");
+      for (i = 0; i < newSize; i++)
+         newTable[i] = NULL;
+      for (i = 0; i < subList->hashSize; i++)
       {
-         if (GraphMatch(sub->definition, subListNode->sub->definition,
-                        labelList, 0.0, NULL, NULL))
-            found = TRUE;
-         subListNode = subListNode->next;
+         node = subList->hashTable[i];
+         while (node != NULL)
+         {
+            nextNode = node->hashNext;
+            bucket = node->sub->canonicalHash & (newSize - 1);
+            node->hashNext = newTable[bucket];
+            newTable[bucket] = node;
+            node = nextNode;
+         }
       }
+      free(subList->hashTable);
+      subList->hashTable = newTable;
+      subList->hashSize = newSize;
+   }
+   bucket = subListNode->sub->canonicalHash & (subList->hashSize - 1);
+   subListNode->hashNext = subList->hashTable[bucket];
+   subList->hashTable[bucket] = subListNode;
+   subList->numHashed++;
+}
+
+
+//******************************************************************************
+// NAME: SubListIndexRemove
+//
+// INPUTS: (SubListNode *subListNode) - node to remove from index
+//         (SubList *subList) - list the node belongs to
+//
+// RETURN: (void)
+//
+// PURPOSE: Unlink the node from the list's hash index.  The node's
+// substructure must still be present.
+//******************************************************************************
+
+void SubListIndexRemove(SubListNode *subListNode, SubList *subList)
+{
+   SubListNode **link;
+
+   link = & subList->hashTable[subListNode->sub->canonicalHash &
+                               (subList->hashSize - 1)];
+   while (*link != NULL)
+   {
+      if (*link == subListNode)
+      {
+         *link = subListNode->hashNext;
+         subListNode->hashNext = NULL;
+         subList->numHashed--;
+         return;
+      }
+      link = & (*link)->hashNext;
    }
-   return found;
 }
 
 
@@ -256,6 +386,7 @@ void FreeSubList(SubList *subList)
          FreeSub(subListNode2->sub);
          free(subListNode2);
       }
+      free(subList->hashTable);
       free(subList);
    }
 }
@@ -317,6 +448,10 @@ Substructure *AllocateSub()
    sub->value = -1.0;
    sub->parentInstances = NULL;
    sub->numParentInstances = 0;
+   sub->canonicalDone = FALSE;
+   sub->canonicalHash = 0;
+   sub->canonicalCodeLength = 0;
+   sub->canonicalCode = NULL;
 
    return sub;
 }
@@ -338,6 +473,7 @@ void FreeSub(Substructure *sub)
    {
       FreeGraph(sub->definition);
       FreeInstanceList(sub->instances);
+      free(sub->canonicalCode);
       free(sub);
    }
 }
@@ -453,53 +589,94 @@ ULONG CountSubs(SubList *subList)
 //
 // INPUTS: (ULONG v) - number of vertices in instance
 //         (ULONG e) - number of edges in instance
+//         (InstanceArena *arena) - arena to carve instance from
 //
 // RETURN: (Instance *) - pointer to newly allocated instance
 //
-// PURPOSE: Allocate and return space for new instance.
+// PURPOSE: Allocate and return space for new instance.  The instance
+// and its vertices, anomalousVertices, mapping, edges and anomalousEdges
+// arrays are one piece of the arena, taken from the arena's free list
+// for pieces of that size if possible.
 //******************************************************************************
 
-Instance *AllocateInstance(ULONG v, ULONG e)
+Instance *AllocateInstance(ULONG v, ULONG e, InstanceArena *arena)
 {
-   Instance *instance;
+   Instance *instance = NULL;
+   InstanceArenaBlock *block;
+   ULONG *words;
+   ULONG headerWords;
+   ULONG vertexWords;
+   ULONG numWords;
+   ULONG numBytes;
+
+   // instance, then vertices, anomalousVertices, mapping, edges and
+   // anomalousEdges
+   headerWords = (sizeof(Instance) + sizeof(ULONG) - 1) / sizeof(ULONG);
+   vertexWords = v * (2 + (sizeof(VertexMap) / sizeof(ULONG)));
+   numWords = headerWords + vertexWords + (2 * e);
+   numBytes = numWords * sizeof(ULONG);
+
+   if (arena->shared)
+      pthread_mutex_lock(& arena->lock);
+   if ((numWords < arena->numFreeLists) &&
+       (arena->freeLists[numWords] != NULL))
+   {
+      instance = arena->freeLists[numWords];
+      arena->freeLists[numWords] = instance->parentInstance;
+   }
+   else
+   {
+      block = arena->blocks;
+      if ((block == NULL) || ((block->size - block->used) < numBytes))
+      {
+         block = (InstanceArenaBlock *) malloc(sizeof(InstanceArenaBlock));
+         if (block == NULL)
+            OutOfMemoryError("AllocateInstance:block");
+         block->size = INSTANCE_ARENA_BLOCK_SIZE;
+         if (numBytes > block->size)
+            block->size = numBytes;
+         block->bytes = (char *) malloc(sizeof(char) * block->size);
+         if (block->bytes == NULL)
+            OutOfMemoryError("AllocateInstance:block->bytes");
+         block->used = 0;
+         block->next = arena->blocks;
+         arena->blocks = block;
+      }
+      instance = (Instance *) & block->bytes[block->used];
+      block->used += numBytes;
+   }
+   if (arena->shared)
+      pthread_mutex_unlock(& arena->lock);
 
-   instance = (Instance *) malloc(sizeof(Instance));
-   if (instance == NULL)
-      OutOfMemoryError("AllocateInstance:instance");
+   instance->arena = arena;
+   instance->arenaWords = numWords;
    instance->numVertices = v;
    instance->numEdges = e;
    instance->vertices = NULL;
+   instance->anomalousVertices = NULL;
+   instance->mapping = NULL;
    instance->edges = NULL;
+   instance->anomalousEdges = NULL;
    instance->newVertex = 0;
    instance->newEdge = 0;
    instance->mappingIndex1 = MAX_UNSIGNED_LONG;
    instance->mappingIndex2 = MAX_UNSIGNED_LONG;
-   instance->used = FALSE;
    instance->numAnomalousVertices = 0;
    instance->numAnomalousEdges = 0;
    instance->frequency = 0;
    instance->matched = FALSE;
    //
+   words = (ULONG *) instance;
    if (v > 0) 
    {
-      instance->vertices = (ULONG *) malloc(sizeof(ULONG) * v);
-      if (instance->vertices == NULL)
-         OutOfMemoryError("AllocateInstance: instance->vertices");
-      instance->anomalousVertices = (ULONG *) malloc(sizeof(ULONG) * v);
-      if (instance->anomalousVertices == NULL)
-         OutOfMemoryError("AllocateInstance: instance->anomalousVertices");
-      instance->mapping = (VertexMap *) malloc(sizeof(VertexMap) * v);
-      if (instance->mapping == NULL)
-         OutOfMemoryError("AllocateInstance: instance->mapping");
+      instance->vertices = & words[headerWords];
+      instance->anomalousVertices = & words[headerWords + v];
+      instance->mapping = (VertexMap *) & words[headerWords + (2 * v)];
    }
    if (e > 0) 
    {
-      instance->edges = (ULONG *) malloc(sizeof(ULONG) * e);
-      if (instance->edges == NULL)
-         OutOfMemoryError("AllocateInstance: instance->edges");
-      instance->anomalousEdges = (ULONG *) malloc(sizeof(ULONG) * e);
-      if (instance->anomalousEdges == NULL)
-         OutOfMemoryError("AllocateInstance: instance->anomalousEdges");
+      instance->edges = & words[headerWords + vertexWords];
+      instance->anomalousEdges = & words[headerWords + vertexWords + e];
    }
    instance->minMatchCost = MAX_DOUBLE;
    instance->refCount = 0;
@@ -517,21 +694,119 @@ Instance *AllocateInstance(ULONG v, ULONG e)
 // RETURN: (void)
 //
 // PURPOSE: Deallocate memory of given instance, if there are no more
-// references to it.
+// references to it.  The instance's piece of its arena goes on the
+// arena's free list for pieces of that size.
 //******************************************************************************
 
 void FreeInstance(Instance *instance)
 {
+   InstanceArena *arena;
+   ULONG numFreeLists;
+   ULONG i;
+
    if ((instance != NULL) && (instance->refCount == 0)) 
    {
-      free(instance->vertices);
-      free(instance->mapping);
-      free(instance->edges);
-      free(instance);
+      arena = instance->arena;
+      if (arena->shared)
+         pthread_mutex_lock(& arena->lock);
+      if (instance->arenaWords >= arena->numFreeLists)
+      {
+         numFreeLists = 2 * (instance->arenaWords + 1);
+         arena->freeLists = (Instance **) realloc
+            (arena->freeLists, sizeof(Instance *) * numFreeLists);
+         if (arena->freeLists == NULL)
+            OutOfMemoryError("FreeInstance:arena->freeLists");
+         for (i = arena->numFreeLists; i < numFreeLists; i++)
+            arena->freeLists[i] = NULL;
+         arena->numFreeLists = numFreeLists;
+      }
+      instance->parentInstance = arena->freeLists[instance->arenaWords];
+      arena->freeLists[instance->arenaWords] = instance;
+      if (arena->shared)
+         pthread_mutex_unlock(& arena->lock);
    }
 }
 
 
+//******************************************************************************
+// NAME: AllocateInstanceArena
+//
+// INPUTS: (BOOLEAN shared) - TRUE if several threads will allocate and
+//                            free instances in the arena
+//
+// RETURN: (InstanceArena *) - newly allocated empty arena
+//
+// PURPOSE: Allocate an empty instance arena.  Blocks are allocated as
+// instances are.
+//******************************************************************************
+
+InstanceArena *AllocateInstanceArena(BOOLEAN shared)
+{
+   InstanceArena *arena;
+
+   arena = (InstanceArena *) malloc(sizeof(InstanceArena));
+   if (arena == NULL)
+      OutOfMemoryError("AllocateInstanceArena:arena");
+   arena->blocks = NULL;
+   arena->numFreeLists = 0;
+   arena->freeLists = NULL;
+   arena->shared = shared;
+   pthread_mutex_init(& arena->lock, NULL);
+   return arena;
+}
+
+
+//******************************************************************************
+// NAME: ResetInstanceArena
+//
+// INPUTS: (InstanceArena *arena) - arena to reset
+//
+// RETURN: (void)
+//
+// PURPOSE: Release all blocks of the arena at once, including the
+// instances still allocated in them.  Called when no instance of the
+// arena is referenced any more, at the end of each iteration.
+//******************************************************************************
+
+void ResetInstanceArena(InstanceArena *arena)
+{
+   InstanceArenaBlock *block;
+   InstanceArenaBlock *nextBlock;
+   ULONG i;
+
+   block = arena->blocks;
+   while (block != NULL)
+   {
+      nextBlock = block->next;
+      free(block->bytes);
+      free(block);
+      block = nextBlock;
+   }
+   arena->blocks = NULL;
+   for (i = 0; i < arena->numFreeLists; i++)
+      arena->freeLists[i] = NULL;
+}
+
+
+//******************************************************************************
+// NAME: FreeInstanceArena
+//
+// INPUTS: (InstanceArena *arena) - arena to free
+//
+// RETURN: (void)
+//
+// PURPOSE: Free the arena and all instances in it.
+//******************************************************************************
+
+void FreeInstanceArena(InstanceArena *arena)
+{
+   ResetInstanceArena(arena);
+   free(arena->freeLists);
+   pthread_mutex_destroy(& arena->lock);
+   free(arena);
+}
+
+
 //******************************************************************************
 // NAME: AllocateInstanceListNode
 //
@@ -552,6 +827,8 @@ InstanceListNode *AllocateInstanceListNode(Instance *instance)
    instanceListNode->instance = instance;
    instance->refCount++;
    instanceListNode->next = NULL;
+   instanceListNode->hash = 0;
+   instanceListNode->hashNext = NULL;
    return instanceListNode;
 }
 
@@ -585,7 +862,8 @@ void FreeInstanceListNode(InstanceListNode *instanceListNode)
 //
 // RETURN: (InstanceList *) - newly-allocated empty instance list
 //
-// PURPOSE: Allocate and return an empty instance list.
+// PURPOSE: Allocate and return an empty instance list.  The list's hash
+// index is not allocated until the first unique insertion.
 //******************************************************************************
 
 InstanceList *AllocateInstanceList(void)
@@ -596,6 +874,9 @@ InstanceList *AllocateInstanceList(void)
    if (instanceList == NULL)
       OutOfMemoryError("AllocateInstanceList:instanceList");
    instanceList->head = NULL;
+   instanceList->hashSize = 0;
+   instanceList->numHashed = 0;
+   instanceList->hashTable = NULL;
    return instanceList;
 }
 
@@ -624,6 +905,7 @@ void FreeInstanceList(InstanceList *instanceList)
          instanceListNode = instanceListNode->next;
          FreeInstanceListNode(instanceListNode2);
       }
+      free(instanceList->hashTable);
       free(instanceList);
    }
 }
@@ -632,44 +914,44 @@ void FreeInstanceList(InstanceList *instanceList)
 //******************************************************************************
 // NAME: MarkInstanceVertices
 //
-// INPUTS: (Instance *instance) - instance whose vertices to set
-//         (Graph *graph) - graph containing instance
-//         (BOOLEAN value) - value to set edge's used flag
+// INPUTS: (Instance *instance) - instance whose vertices to mark
+//         (VisitSet *vertexVisits) - marks on vertices of graph containing
+//                                    instance
 //
 // RETURN: (void)
 //
-// PURPOSE: Set the used flag to the given value for each vertex in
-// instance.
+// PURPOSE: Mark each vertex in instance.  The marks last until the
+// caller clears the visit set.
 //******************************************************************************
 
-void MarkInstanceVertices(Instance *instance, Graph *graph, BOOLEAN value)
+void MarkInstanceVertices(Instance *instance, VisitSet *vertexVisits)
 {
    ULONG v;
 
    for (v = 0; v < instance->numVertices; v++)
-      graph->vertices[instance->vertices[v]].used = value;
+      VISIT(vertexVisits, instance->vertices[v]);
 }
 
 
 //******************************************************************************
 // NAME: MarkInstanceEdges
 //
-// INPUTS: (Instance *instance) - instance whose edges to set
-//         (Graph *graph) - graph containing instance
-//         (BOOLEAN value) - value to set edge's used flag
+// INPUTS: (Instance *instance) - instance whose edges to mark
+//         (VisitSet *edgeVisits) - marks on edges of graph containing
+//                                  instance
 //
 // RETURN: (void)
 //
-// PURPOSE: Set the used flag to the given value for each edge in
-// instance.
+// PURPOSE: Mark each edge in instance.  The marks last until the caller
+// clears the visit set.
 //******************************************************************************
 
-void MarkInstanceEdges(Instance *instance, Graph *graph, BOOLEAN value)
+void MarkInstanceEdges(Instance *instance, VisitSet *edgeVisits)
 {
    ULONG e;
 
    for (e = 0; e < instance->numEdges; e++)
-      graph->edges[instance->edges[e]].used = value;
+      VISIT(edgeVisits, instance->edges[e]);
 }
 
 
@@ -757,7 +1039,7 @@ void PrintPosInstanceList(Substructure *sub, Parameters *parameters)
    // parameters used
    Graph *posGraph = parameters->posGraph;
    ULONG numPosEgs = parameters->numPosEgs;
-   ULONG *posEgsVertexIndices = parameters->posEgsVertexIndices;
+   ULONG *posVertexExamples = parameters->posVertexExamples;
    LabelList *labelList = parameters->labelList;
 
    if (sub->instances != NULL) 
@@ -770,7 +1052,7 @@ void PrintPosInstanceList(Substructure *sub, Parameters *parameters)
          if (numPosEgs > 1) 
          {
             posEgNo = InstanceExampleNumber(instanceListNode->instance,
-                                            posEgsVertexIndices, numPosEgs);
+                                            posVertexExamples, numPosEgs);
             printf(" in positive example %lu:\n", posEgNo);
          } 
          else 
@@ -787,26 +1069,21 @@ void PrintPosInstanceList(Substructure *sub, Parameters *parameters)
 // NAME: InstanceExampleNumber
 //
 // INPUTS: (Instance *instance) - instance to look for
-//         (ULONG *egsVertexIndices) - vertex indices of graph's examples
+//         (ULONG *vertexExamples) - example of each vertex of the graph
+//           (used only if numEgs > 1)
 //         (ULONG numEgs) - number of graph examples
 //
 // RETURN: (ULONG) - example number containing instance
 //
-// PURPOSE: Return which example contains the given instance.
+// PURPOSE: Return which example (from 1) contains the given instance.
 //******************************************************************************
 
-ULONG InstanceExampleNumber(Instance *instance, ULONG *egsVertexIndices,
+ULONG InstanceExampleNumber(Instance *instance, ULONG *vertexExamples,
                             ULONG numEgs)
 {
-   ULONG instanceVertexIndex;
-   ULONG egNo;
-
-   instanceVertexIndex = instance->vertices[0];
-   egNo = 1;
-   while ((egNo < numEgs) && (instanceVertexIndex >= egsVertexIndices[egNo]))
-      egNo++;
-
-   return egNo;
+   if (numEgs <= 1)
+      return 1;
+   return vertexExamples[instance->vertices[0]] + 1;
 }
 
 
@@ -851,7 +1128,10 @@ ULONG CountInstances(InstanceList *instanceList)
 // PURPOSE: Insert given instance on to given instance list.  If
 // unique=TRUE, then instance must not already exist on list, and if
 // so, it is deallocated.  If unique=FALSE, then instance is merely
-// inserted at the head of the instance list.
+// inserted at the head of the instance list.  The first unique
+// insertion indexes the nodes already on the list by InstanceHash;
+// from then on every inserted node is indexed, so the uniqueness check
+// only compares instances with the same hash.
 //******************************************************************************
 
 void InstanceListInsert(Instance *instance, InstanceList *instanceList,
@@ -859,18 +1139,89 @@ void InstanceListInsert(Instance *instance, InstanceList *instanceList,
 {
    InstanceListNode *instanceListNode;
 
+   if (unique && (instanceList->hashSize == 0))
+   {
+      instanceListNode = instanceList->head;
+      while (instanceListNode != NULL)
+      {
+         InstanceListIndexInsert(instanceListNode, instanceList);
+         instanceListNode = instanceListNode->next;
+      }
+   }
    if ((! unique) ||
        (unique && (! MemberOfInstanceList(instance, instanceList)))) 
    {
       instanceListNode = AllocateInstanceListNode(instance);
       instanceListNode->next = instanceList->head;
       instanceList->head = instanceListNode;
+      if (unique || (instanceList->hashSize > 0))
+         InstanceListIndexInsert(instanceListNode, instanceList);
    } 
    else 
       FreeInstance(instance);
 }
 
 
+//******************************************************************************
+// NAME: InstanceListIndexInsert
+//
+// INPUTS: (InstanceListNode *instanceListNode) - node to index
+//         (InstanceList *instanceList) - list the node belongs to
+//
+// RETURN: (void)
+//
+// PURPOSE: Add the node to the list's hash index, keyed by the
+// InstanceHash of its instance.  The index is allocated on first use
+// and doubled when it holds twice as many nodes as buckets.
+//******************************************************************************
+
+void InstanceListIndexInsert(InstanceListNode *instanceListNode,
+                             InstanceList *instanceList)
+{
+   InstanceListNode **newTable;
+   InstanceListNode *node;
+   InstanceListNode *nextNode;
+   ULONG newSize;
+   ULONG i;
+   ULONG bucket;
+
+   instanceListNode->hash = InstanceHash(instanceListNode->instance);
+   if ((instanceList->hashSize == 0) ||
+       (instanceList->numHashed >= 2 * instanceList->hashSize))
+   {
+      if (instanceList->hashSize == 0)
+         newSize = INSTANCE_HASH_INIT_SIZE;
+      else
+         newSize = 2 * instanceList->hashSize;
+      newTable = (InstanceListNode **)
+                 malloc(sizeof(InstanceListNode *) * newSize);
+      if (newTable == NULL)
+         OutOfMemoryError("InstanceListIndexInsert:newTable");
+      for (i = 0; i < newSize; i++)
+         newTable[i] = NULL;
+      for (i = 0; i < instanceList->hashSize; i++)
+      {
+         node = instanceList->hashTable[i];
+         while (node != NULL)
+         {
+            nextNode = node->hashNext;
+            bucket = node->hash & (newSize - 1);
+            node->hashNext = newTable[bucket];
+            newTable[bucket] = node;
+            node = nextNode;
+         }
+      }
+      free(instanceList->hashTable);
+      instanceList->hashTable = newTable;
+      instanceList->hashSize = newSize;
+   }
+   bucket = instanceListNode->hash & (instanceList->hashSize - 1);
+   instanceListNode->hashNext = instanceList->hashTable[bucket];
+   instanceList->hashTable[bucket] = instanceListNode;
+   instanceList->numHashed++;
+}
+
+
 //******************************************************************************
 // NAME: MemberOfInstanceList
 //
@@ -880,15 +1231,31 @@ void InstanceListInsert(Instance *instance, InstanceList *instanceList,
 // RETURN: (BOOLEAN)
 //
 // PURPOSE: Check if the given instance exactly matches an instance
-// already on the given instance list.
+// already on the given instance list.  If the list has a hash index,
+// then only the instances in the bucket of the given instance's hash
+// are compared.
 //******************************************************************************
 
 BOOLEAN MemberOfInstanceList(Instance *instance, InstanceList *instanceList)
 {
    InstanceListNode *instanceListNode;
+   ULONG hash;
    BOOLEAN found = FALSE;
 
-   if (instanceList != NULL) 
+   if ((instanceList != NULL) && (instanceList->hashSize > 0))
+   {
+      hash = InstanceHash(instance);
+      instanceListNode =
+         instanceList->hashTable[hash & (instanceList->hashSize - 1)];
+      while ((instanceListNode != NULL) && (! found)) 
+      {
+         if ((instanceListNode->hash == hash) &&
+             InstanceMatch(instance, instanceListNode->instance))
+            found = TRUE;
+         instanceListNode = instanceListNode->hashNext;
+      }
+   }
+   else if (instanceList != NULL) 
    {
       instanceListNode = instanceList->head;
       while ((instanceListNode != NULL) && (! found)) 
@@ -901,6 +1268,33 @@ BOOLEAN MemberOfInstanceList(Instance *instance, InstanceList *instanceList)
    return found;
 }
 
+
+//******************************************************************************
+// NAME: InstanceHash
+//
+// INPUTS: (Instance *instance)
+//
+// RETURN: (ULONG) - hash of instance's vertices and edges
+//
+// PURPOSE: Hash the instance's vertices and edges arrays, so that
+// instances for which InstanceMatch is TRUE have the same hash.  Like
+// InstanceMatch, this relies on the arrays being in increasing order.
+//******************************************************************************
+
+ULONG InstanceHash(Instance *instance)
+{
+   unsigned long long hash = 14695981039346656037ULL;
+   ULONG i;
+
+   hash = (hash ^ instance->numVertices) * 1099511628211ULL;
+   hash = (hash ^ instance->numEdges) * 1099511628211ULL;
+   for (i = 0; i < instance->numVertices; i++)
+      hash = (hash ^ instance->vertices[i]) * 1099511628211ULL;
+   for (i = 0; i < instance->numEdges; i++)
+      hash = (hash ^ instance->edges[i]) * 1099511628211ULL;
+   return (ULONG) (hash ^ (hash >> 32));
+}
+
 //******************************************************************************
 // NAME: InstanceMatch
 //
@@ -1010,41 +1404,107 @@ BOOLEAN InstanceListOverlap(Instance *instance, InstanceList *instanceList)
 // NAME: InstancesOverlap
 //
 // INPUTS: (InstanceList *instanceList)
+//         (VisitSet *vertexVisits) - marks on vertices of graph containing
+//                                    instances, cleared here
+//         (ULONG numVertices) - number of vertices in graph
 //
 // RETURN: (BOOLEAN) - TRUE if any pair of instances overlap
 //
 // PURPOSE: Check if any two instances in the given list overlap.  If
-// so, return TRUE, else return FALSE.
+// so, return TRUE, else return FALSE.  The instances' vertices are
+// marked in one pass, and two instances overlap exactly when a vertex
+// is found already marked.
 //******************************************************************************
 
-BOOLEAN InstancesOverlap(InstanceList *instanceList)
+BOOLEAN InstancesOverlap(InstanceList *instanceList, VisitSet *vertexVisits,
+                         ULONG numVertices)
 {
-   InstanceListNode *instanceListNode1;
-   InstanceListNode *instanceListNode2;
+   InstanceListNode *instanceListNode;
+   Instance *instance;
+   ULONG v;
    BOOLEAN overlap = FALSE;
 
    if (instanceList != NULL) 
    {
-      instanceListNode1 = instanceList->head;
-      while ((instanceListNode1 != NULL) && (! overlap)) 
+      ClearVisitSet(vertexVisits, numVertices);
+      instanceListNode = instanceList->head;
+      while ((instanceListNode != NULL) && (! overlap)) 
       {
-         instanceListNode2 = instanceListNode1->next;
-         while ((instanceListNode2 != NULL) && (! overlap)) 
-         {
-            if ((instanceListNode1->instance != NULL) &&
-                (instanceListNode2->instance != NULL) &&
-                (InstanceOverlap(instanceListNode1->instance,
-               instanceListNode2->instance)))
-            overlap = TRUE;
-            instanceListNode2 = instanceListNode2->next;
-         }
-         instanceListNode1 = instanceListNode1->next;
+         instance = instanceListNode->instance;
+         if (instance != NULL)
+            for (v = 0; ((v < instance->numVertices) && (! overlap)); v++)
+            {
+               if (VISITED(vertexVisits, instance->vertices[v]))
+                  overlap = TRUE;
+               VISIT(vertexVisits, instance->vertices[v]);
+            }
+         instanceListNode = instanceListNode->next;
       }
    }
    return overlap;
 }
 
 
+//******************************************************************************
+// NAME: MarkInstanceListVertices
+//
+// INPUTS: (InstanceList *instanceList) - instances whose vertices to mark
+//         (VisitSet *vertexVisits) - marks on vertices of graph containing
+//                                    instances, cleared here
+//         (ULONG numVertices) - number of vertices in graph
+//
+// RETURN: (void)
+//
+// PURPOSE: Mark exactly the vertices covered by the given instances, so
+// that InstanceVerticesMarked can stand in for InstanceListOverlap
+// against the list.  The caller must mark the vertices of each instance
+// later added to the list (MarkInstanceVertices).
+//******************************************************************************
+
+void MarkInstanceListVertices(InstanceList *instanceList,
+                              VisitSet *vertexVisits, ULONG numVertices)
+{
+   InstanceListNode *instanceListNode;
+
+   ClearVisitSet(vertexVisits, numVertices);
+   if (instanceList != NULL)
+   {
+      instanceListNode = instanceList->head;
+      while (instanceListNode != NULL)
+      {
+         if (instanceListNode->instance != NULL)
+            MarkInstanceVertices(instanceListNode->instance, vertexVisits);
+         instanceListNode = instanceListNode->next;
+      }
+   }
+}
+
+
+//******************************************************************************
+// NAME: InstanceVerticesMarked
+//
+// INPUTS: (Instance *instance) - instance to check
+//         (VisitSet *vertexVisits) - marks on vertices of graph containing
+//                                    instance
+//
+// RETURN: (BOOLEAN) - TRUE if any vertex of instance is marked
+//
+// PURPOSE: Check if the instance overlaps the instances whose vertices
+// are marked, in time linear in the instance's size.
+//******************************************************************************
+
+BOOLEAN InstanceVerticesMarked(Instance *instance, VisitSet *vertexVisits)
+{
+   ULONG v;
+   BOOLEAN marked = FALSE;
+
+   for (v = 0; ((v < instance->numVertices) && (! marked)); v++)
+      if (VISITED(vertexVisits, instance->vertices[v]))
+         marked = TRUE;
+   return marked;
+}
+
+
 //******************************************************************************
 // NAME: InstanceToGraph
 //
@@ -1077,7 +1537,6 @@ Graph *InstanceToGraph(Instance *instance, Graph *graph)
       newGraph->vertices[i].label = vertex->label;
       newGraph->vertices[i].numEdges = 0;
       newGraph->vertices[i].edges = NULL;
-      newGraph->vertices[i].used = FALSE;
    }
 
    // convert edges
@@ -1107,26 +1566,9 @@ Graph *InstanceToGraph(Instance *instance, Graph *graph)
       newGraph->edges[i].vertex2 = v2;
       newGraph->edges[i].label = edge->label;
       newGraph->edges[i].directed = edge->directed;
-      newGraph->edges[i].used = FALSE;
-      // add edge to appropriate vertices
-      vertex = & newGraph->vertices[v1];
-      vertex->numEdges++;
-      vertex->edges =
-         (ULONG *) realloc(vertex->edges, sizeof(ULONG) * vertex->numEdges);
-      if (vertex->edges == NULL)
-         OutOfMemoryError("InstanceToGraph:vertex1->edges");
-      vertex->edges[vertex->numEdges - 1] = i;
-      if (v1 != v2) 
-      {
-         vertex = & newGraph->vertices[v2];
-         vertex->numEdges++;
-         vertex->edges =
-            (ULONG *) realloc(vertex->edges, sizeof(ULONG) * vertex->numEdges);
-         if (vertex->edges == NULL)
-            OutOfMemoryError("InstanceToGraph:vertex2->edges");
-         vertex->edges[vertex->numEdges - 1] = i;
-      }
    }
+   BuildGraphAdjacency(newGraph);
+
    return newGraph;
 }
 
@@ -1157,110 +1599,6 @@ BOOLEAN InstanceContainsVertex(Instance *instance, ULONG v)
 }
 
 
-//******************************************************************************
-// NAME: AddInstanceToInstance
-//
-// INPUTS: (Instance *instance1) - instance to add
-//         (Instance *instance2) - instance to add to
-//
-// RETURN: (void)
-//
-// PURPOSE: Add vertices and edges of instance1 to instance2.  Duplicates
-// are not added.
-//******************************************************************************
-
-void AddInstanceToInstance(Instance *instance1, Instance *instance2)
-{
-   ULONG v1, v2, e1, e2, i;
-   ULONG nv2, ne2;
-
-   // search for vertices of instance1 in instance2; if not found, then add
-   // them, keeping instance2's vertices in order
-   v2 = 0;
-   for (v1 = 0; v1 < instance1->numVertices; v1++) 
-   {
-      nv2 = instance2->numVertices;
-      while ((v2 < nv2) && (instance2->vertices[v2] < instance1->vertices[v1]))
-         v2++;
-      if ((v2 == nv2) || (instance2->vertices[v2] > instance1->vertices[v1])) 
-      {
-         // vertex not in instance2, so make room
-         instance2->vertices =
-            (ULONG *) realloc(instance2->vertices, (sizeof(ULONG) * (nv2 + 1)));
-         if (instance2->vertices == NULL)
-            OutOfMemoryError("AddInstanceToInstance:instance2->vertices");
-         for (i = nv2; i > v2; i--)
-            instance2->vertices[i] = instance2->vertices[i-1];
-         instance2->vertices[v2] = instance1->vertices[v1];
-         instance2->numVertices++;
-      }
-   }
-   // insert new edges from instance1 into instance2
-   e2 = 0;
-   for (e1 = 0; e1 < instance1->numEdges; e1++) 
-   {
-      ne2 = instance2->numEdges;
-      while ((e2 < ne2) && (instance2->edges[e2] < instance1->edges[e1]))
-         e2++;
-      if ((e2 == ne2) || (instance2->edges[e2] > instance1->edges[e1])) 
-      {
-         // edge not in instance2, so make room
-         instance2->edges =
-            (ULONG *) realloc(instance2->edges, (sizeof(ULONG) * (ne2 + 1)));
-         if (instance2->edges == NULL)
-            OutOfMemoryError("AddInstanceToInstance:instance2->edges");
-         for (i = ne2; i > e2; i--)
-            instance2->edges[i] = instance2->edges[i-1];
-         instance2->edges[e2] = instance1->edges[e1];
-         instance2->numEdges++;
-      }
-   }
-}
-
-
-//******************************************************************************
-// NAME: AddEdgeToInstance
-//
-// INPUTS: (ULONG) edgeIndex - index of edge in graph
-//         (Edge *edge) - edge to add
-//         (Instance *instance2) - instance to add to
-//
-// RETURN: (void)
-//
-// PURPOSE: Add edge to instance.  Duplicate vertices or edges are not
-// added.
-//******************************************************************************
-
-void AddEdgeToInstance(ULONG edgeIndex, Edge *edge, Instance *instance2)
-{
-   Instance *instance1;
-
-   // convert edge to instance
-   if (edge->vertex1 == edge->vertex2) 
-   { // self-edge
-      instance1 = AllocateInstance(1, 1);
-      instance1->vertices[0] = edge->vertex1;
-   } 
-   else 
-   {
-      instance1 = AllocateInstance(2, 1);
-      if (edge->vertex1 < edge->vertex2) 
-      {
-         instance1->vertices[0] = edge->vertex1;
-         instance1->vertices[1] = edge->vertex2;
-      } 
-      else 
-      {
-         instance1->vertices[0] = edge->vertex2;
-         instance1->vertices[1] = edge->vertex1;
-      }
-   }
-   instance1->edges[0] = edgeIndex;
-   AddInstanceToInstance(instance1, instance2);
-   FreeInstance(instance1);
-}
-
-
 //******************************************************************************
 // NAME: UpdateMapping
 //
@@ -6,6 +6,8 @@
 // Date      Name       Description
 // ========  =========  ========================================================
 // 08/12/09  Eberle     Initial version, taken from SUBDUE 5.2.1
+// 10/16/26  agent      CopySub resets canonical code fields
+// 10/16/26  agent      Added SortULONGs
 //
 //******************************************************************************
 
@@ -48,6 +50,37 @@ void PrintBoolean(BOOLEAN boolean)
 }
 
 
+//******************************************************************************
+// NAME: SortULONGs
+//
+// INPUTS: (ULONG *values) - array of values
+//         (ULONG numValues) - number of values
+//
+// RETURN: (void)
+//
+// PURPOSE: Sort values in increasing order (insertion sort; the arrays
+// sorted are small).
+//******************************************************************************
+
+void SortULONGs(ULONG *values, ULONG numValues)
+{
+   ULONG i, j;
+   ULONG value;
+
+   for (i = 1; i < numValues; i++)
+   {
+      value = values[i];
+      j = i;
+      while ((j > 0) && (values[j - 1] > value))
+      {
+         values[j] = values[j - 1];
+         j--;
+      }
+      values[j] = value;
+   }
+}
+
+
 //******************************************************************************
 // NAME:  CopySub
 //
@@ -69,6 +102,10 @@ Substructure *CopySub(Substructure *sub)
    newSub->value = sub->value;
    newSub->numInstances = sub->numInstances;
    newSub->instances = NULL;
+   newSub->canonicalDone = FALSE;
+   newSub->canonicalHash = 0;
+   newSub->canonicalCodeLength = 0;
+   newSub->canonicalCode = NULL;
 
    return(newSub);
 }
@@ -0,0 +1,574 @@
+//******************************************************************************
+// window.c
+//
+// Windowed discovery: the best substructures in a window of the most
+// recent positive examples of a stream, updated as each example arrives
+// and the oldest one leaves.  Each example is an increment, kept with its
+// own graph in parameters->incrementList.  The substructures tracked over
+// the window are those among the best of some increment still in the
+// window.  For each of them, the number of instances in every increment
+// and the amount by which compressing the increment with them reduces its
+// size are recorded per window slot, so that adding an increment costs one
+// discovery and one instance search per tracked substructure in the new
+// increment (plus a search of the window for substructures tracked for the
+// first time), and retiring one only subtracts its slot.
+//
+// The value of a substructure S in the window of increments G_i is the
+// one of EvaluateSub, with the window's sizes summed over increments:
+//
+//   sum size(G_i) / (size(S) + sum size(G_i|S))
+//
+// For EVAL_SIZE this is the value EvaluateSub would give S on the graph
+// of all the window's examples; for EVAL_MDL it is the approximation of
+// incremental SUBDUE, each increment's description length being computed
+// with the labels known when the increment was added.
+//
+// Date      Name       Description
+// ========  =========  ========================================================
+// 10/17/26  agent      Initial version.
+//
+//******************************************************************************
+
+#include "gbad.h"
+
+
+//******************************************************************************
+// NAME: AllocateWindow
+//
+// INPUTS: (ULONG size) - most increments in the window (> 0)
+//
+// RETURN: (Window *) - empty window
+//******************************************************************************
+
+Window *AllocateWindow(ULONG size)
+{
+   Window *window;
+
+   window = (Window *) malloc(sizeof(Window));
+   if (window == NULL)
+      OutOfMemoryError("AllocateWindow:window");
+   window->size = size;
+   window->numIncrements = 0;
+   window->nextIncrementNum = 0;
+   window->nextVertexIndex = 0;
+   window->nextEdgeIndex = 0;
+   window->numVertices = 0;
+   window->numEdges = 0;
+   window->graphSize = 0.0;
+   window->graphSubSize = 0.0;
+   window->lastIncrement = NULL;
+   window->subs = NULL;
+   window->numSubs = 0;
+   return window;
+}
+
+
+//******************************************************************************
+// NAME: FreeWindow
+//
+// INPUTS: (Window *window) - window to free
+//         (IncrementList *incrementList) - increments of the window
+//
+// RETURN: (void)
+//
+// PURPOSE: Free the window, its tracked substructures and its increments,
+// leaving incrementList empty.
+//******************************************************************************
+
+void FreeWindow(Window *window, IncrementList *incrementList)
+{
+   IncrementListNode *incrementListNode;
+   WindowSub *windowSub;
+
+   while (incrementList->head != NULL)
+   {
+      incrementListNode = incrementList->head;
+      incrementList->head = incrementListNode->next;
+      FreeWindowIncrement(incrementListNode->increment);
+      free(incrementListNode);
+   }
+   while (window->subs != NULL)
+   {
+      windowSub = window->subs;
+      window->subs = windowSub->next;
+      FreeWindowSub(windowSub);
+   }
+   free(window);
+}
+
+
+//******************************************************************************
+// NAME: WindowAddExample
+//
+// INPUTS: (Graph *graph) - next positive example of the stream, with
+//                          labels in parameters->labelList
+//         (Parameters *parameters)
+//
+// RETURN: (void)
+//
+// PURPOSE: Slide the window by one example.  If the window is full, its
+// oldest increment is retired.  The example becomes the newest increment
+// (which takes over the graph), its best substructures are discovered,
+// those not yet tracked are searched for in the rest of the window, and
+// all tracked substructures are searched for in the new increment.
+// Substructures left with no instances in the window are dropped, and the
+// values of the others updated.  The positive graph settings of
+// parameters are restored on return.
+//******************************************************************************
+
+void WindowAddExample(Graph *graph, Parameters *parameters)
+{
+   Window *window;
+   Increment *increment;
+   IncrementListNode *incrementListNode;
+   SubList *subList;
+   SubListNode *subListNode;
+   WindowSub *windowSub;
+   ULONG exampleVertexIndex = 0;
+
+   // parameters saved, since they are replaced for the increment
+   Graph *posGraph             = parameters->posGraph;
+   ULONG numPosEgs             = parameters->numPosEgs;
+   ULONG *posEgsVertexIndices  = parameters->posEgsVertexIndices;
+   double posGraphDL           = parameters->posGraphDL;
+   ULONG maxVertices           = parameters->maxVertices;
+   ULONG limit                 = parameters->limit;
+
+   if (parameters->window == NULL)
+      parameters->window = AllocateWindow(parameters->windowSize);
+   window = parameters->window;
+   if (window->numIncrements == window->size)
+      RetireIncrement(parameters);
+
+   // add the new increment
+   increment = AllocateWindowIncrement(graph, parameters);
+   incrementListNode = (IncrementListNode *)
+                       malloc(sizeof(IncrementListNode));
+   if (incrementListNode == NULL)
+      OutOfMemoryError("WindowAddExample:incrementListNode");
+   incrementListNode->increment = increment;
+   incrementListNode->next = NULL;
+   if (window->lastIncrement == NULL)
+      parameters->incrementList->head = incrementListNode;
+   else
+      window->lastIncrement->next = incrementListNode;
+   window->lastIncrement = incrementListNode;
+   window->numIncrements++;
+   window->nextIncrementNum++;
+   window->nextVertexIndex += graph->numVertices;
+   window->nextEdgeIndex += graph->numEdges;
+   window->numVertices += graph->numVertices;
+   window->numEdges += graph->numEdges;
+   window->graphSize += increment->graphSize;
+   window->graphSubSize += increment->graphSubSize;
+
+   parameters->posGraph = graph;
+   parameters->numPosEgs = 1;
+   parameters->posEgsVertexIndices = & exampleVertexIndex;
+   parameters->posGraphDL = increment->graphSize;
+   if (maxVertices == 0)
+      parameters->maxVertices = graph->numVertices;
+   if (limit == 0)
+      parameters->limit = graph->numEdges / 2;
+
+   if (graph->numVertices > 0)
+   {
+      // best substructures of the increment; track those not yet tracked
+      if (parameters->maxVertices < parameters->minVertices)
+         subList = AllocateSubList();
+      else
+         subList = DiscoverSubs(parameters, 1);
+      subListNode = subList->head;
+      while (subListNode != NULL)
+      {
+         if (FindWindowSub(subListNode->sub, window, parameters) == NULL)
+            AddWindowSub(subListNode->sub, parameters);
+         subListNode = subListNode->next;
+      }
+      FreeSubList(subList);
+
+      // search all tracked substructures in the new increment
+      windowSub = window->subs;
+      while (windowSub != NULL)
+      {
+         SearchIncrement(windowSub, increment, parameters);
+         windowSub = windowSub->next;
+      }
+   }
+   RemoveEmptyWindowSubs(window);
+   ResetInstanceArena(parameters->instanceArena);
+
+   // restore parameters
+   parameters->posGraph = posGraph;
+   parameters->numPosEgs = numPosEgs;
+   parameters->posEgsVertexIndices = posEgsVertexIndices;
+   parameters->posGraphDL = posGraphDL;
+   parameters->maxVertices = maxVertices;
+   parameters->limit = limit;
+
+   EvaluateWindowSubs(parameters);
+}
+
+
+//******************************************************************************
+// NAME: AllocateWindowIncrement
+//
+// INPUTS: (Graph *graph) - graph of the new increment
+//         (Parameters *parameters)
+//
+// RETURN: (Increment *) - increment holding graph
+//
+// PURPOSE: Make the next increment of the window, with the sizes of its
+// graph needed to evaluate substructures in it.
+//******************************************************************************
+
+Increment *AllocateWindowIncrement(Graph *graph, Parameters *parameters)
+{
+   Window *window = parameters->window;
+   Increment *increment;
+
+   increment = (Increment *) malloc(sizeof(Increment));
+   if (increment == NULL)
+      OutOfMemoryError("AllocateWindowIncrement:increment");
+   increment->subList = NULL;
+   increment->incrementNum = window->nextIncrementNum;
+   increment->numPosVertices = graph->numVertices;
+   increment->numPosEdges = graph->numEdges;
+   increment->startPosVertexIndex = window->nextVertexIndex;
+   increment->startPosEdgeIndex = window->nextEdgeIndex;
+   increment->numPosEgs = 1.0;
+   increment->graph = graph;
+   increment->graphStats = NULL;
+   increment->numLabels = parameters->labelList->numLabels;
+   if (parameters->evalMethod == EVAL_MDL)
+   {
+      increment->graphSize = MDL(graph, increment->numLabels, parameters);
+      increment->graphSubSize = MDL(graph, increment->numLabels + 1,
+                                    parameters);
+      increment->graphStats = AllocateMDLGraphStats(graph,
+                                                    parameters->vertexVisits);
+   }
+   else
+   {
+      increment->graphSize = (double) GraphSize(graph);
+      increment->graphSubSize = increment->graphSize;
+   }
+   return increment;
+}
+
+
+//******************************************************************************
+// NAME: FreeWindowIncrement
+//
+// INPUTS: (Increment *increment)
+//
+// RETURN: (void)
+//
+// PURPOSE: Free an increment of the window and its graph.
+//******************************************************************************
+
+void FreeWindowIncrement(Increment *increment)
+{
+   FreeGraph(increment->graph);
+   FreeMDLGraphStats(increment->graphStats);
+   free(increment);
+}
+
+
+//******************************************************************************
+// NAME: RetireIncrement
+//
+// INPUTS: (Parameters *parameters)
+//
+// RETURN: (void)
+//
+// PURPOSE: Remove the oldest increment from the window, subtracting its
+// slot from the totals of the tracked substructures.
+//******************************************************************************
+
+void RetireIncrement(Parameters *parameters)
+{
+   Window *window = parameters->window;
+   IncrementListNode *incrementListNode = parameters->incrementList->head;
+   Increment *increment = incrementListNode->increment;
+   WindowSub *windowSub;
+   ULONG slot = increment->incrementNum % window->size;
+
+   windowSub = window->subs;
+   while (windowSub != NULL)
+   {
+      if (windowSub->numInstances[slot] > 0)
+      {
+         windowSub->sub->numInstances -= windowSub->numInstances[slot];
+         windowSub->sub->numExamples--;
+         windowSub->totalSavings -= windowSub->savings[slot];
+         windowSub->numInstances[slot] = 0;
+         windowSub->savings[slot] = 0.0;
+      }
+      windowSub = windowSub->next;
+   }
+
+   window->numVertices -= increment->numPosVertices;
+   window->numEdges -= increment->numPosEdges;
+   window->graphSize -= increment->graphSize;
+   window->graphSubSize -= increment->graphSubSize;
+   window->numIncrements--;
+   parameters->incrementList->head = incrementListNode->next;
+   if (window->lastIncrement == incrementListNode)
+      window->lastIncrement = NULL;
+   FreeWindowIncrement(increment);
+   free(incrementListNode);
+}
+
+
+//******************************************************************************
+// NAME: FindWindowSub
+//
+// INPUTS: (Substructure *sub) - substructure to look for
+//         (Window *window)
+//         (Parameters *parameters)
+//
+// RETURN: (WindowSub *) - tracked substructure isomorphic to sub, or NULL
+//******************************************************************************
+
+WindowSub *FindWindowSub(Substructure *sub, Window *window,
+                         Parameters *parameters)
+{
+   WindowSub *windowSub = window->subs;
+
+   while ((windowSub != NULL) &&
+          (! SubsMatch(sub, windowSub->sub, parameters->labelList)))
+      windowSub = windowSub->next;
+   return windowSub;
+}
+
+
+//******************************************************************************
+// NAME: AddWindowSub
+//
+// INPUTS: (Substructure *sub) - best substructure of the newest increment
+//         (Parameters *parameters)
+//
+// RETURN: (WindowSub *) - newly tracked substructure
+//
+// PURPOSE: Track a copy of the substructure's definition over the window.
+// Its instances are searched for in all increments but the newest, which
+// WindowAddExample searches for all tracked substructures.
+//******************************************************************************
+
+WindowSub *AddWindowSub(Substructure *sub, Parameters *parameters)
+{
+   Window *window = parameters->window;
+   WindowSub *windowSub;
+   IncrementListNode *incrementListNode;
+   ULONG slot;
+
+   windowSub = (WindowSub *) malloc(sizeof(WindowSub));
+   if (windowSub == NULL)
+      OutOfMemoryError("AddWindowSub:windowSub");
+   windowSub->numInstances = (ULONG *) malloc(sizeof(ULONG) * window->size);
+   windowSub->savings = (double *) malloc(sizeof(double) * window->size);
+   if ((windowSub->numInstances == NULL) || (windowSub->savings == NULL))
+      OutOfMemoryError("AddWindowSub:slots");
+   for (slot = 0; slot < window->size; slot++)
+   {
+      windowSub->numInstances[slot] = 0;
+      windowSub->savings[slot] = 0.0;
+   }
+   windowSub->totalSavings = 0.0;
+   windowSub->sub = AllocateSub();
+   windowSub->sub->definition = CopyGraph(sub->definition);
+   windowSub->next = window->subs;
+   window->subs = windowSub;
+   window->numSubs++;
+
+   incrementListNode = parameters->incrementList->head;
+   while (incrementListNode != window->lastIncrement)
+   {
+      SearchIncrement(windowSub, incrementListNode->increment, parameters);
+      incrementListNode = incrementListNode->next;
+   }
+   return windowSub;
+}
+
+
+//******************************************************************************
+// NAME: FreeWindowSub
+//
+// INPUTS: (WindowSub *windowSub)
+//
+// RETURN: (void)
+//******************************************************************************
+
+void FreeWindowSub(WindowSub *windowSub)
+{
+   FreeSub(windowSub->sub);
+   free(windowSub->numInstances);
+   free(windowSub->savings);
+   free(windowSub);
+}
+
+
+//******************************************************************************
+// NAME: SearchIncrement
+//
+// INPUTS: (WindowSub *windowSub) - tracked substructure
+//         (Increment *increment) - increment of the window
+//         (Parameters *parameters)
+//
+// RETURN: (void)
+//
+// PURPOSE: Find the instances of the substructure in the increment, and
+// record their number and the savings of compressing the increment with
+// them in the increment's slot.  The instances themselves are freed.
+//******************************************************************************
+
+void SearchIncrement(WindowSub *windowSub, Increment *increment,
+                     Parameters *parameters)
+{
+   Substructure *sub;
+   ULONG slot = increment->incrementNum % parameters->window->size;
+
+   // parameters saved, since the increment is evaluated on its own
+   Graph *posGraph              = parameters->posGraph;
+   MDLGraphStats *posGraphStats = parameters->posGraphStats;
+
+   sub = AllocateSub();
+   sub->definition = windowSub->sub->definition;
+   sub->instances = FindInstances(sub->definition, increment->graph,
+                                  parameters);
+   sub->numInstances = CountInstances(sub->instances);
+   if (sub->numInstances > 0)
+   {
+      parameters->posGraph = increment->graph;
+      parameters->posGraphStats = increment->graphStats;
+      windowSub->numInstances[slot] = sub->numInstances;
+      windowSub->savings[slot] = increment->graphSubSize -
+         CompressedPosGraphSize(sub, increment->numLabels, parameters);
+      windowSub->sub->numInstances += sub->numInstances;
+      windowSub->sub->numExamples++;
+      windowSub->totalSavings += windowSub->savings[slot];
+      parameters->posGraph = posGraph;
+      parameters->posGraphStats = posGraphStats;
+   }
+   sub->definition = NULL;
+   FreeSub(sub);
+}
+
+
+//******************************************************************************
+// NAME: RemoveEmptyWindowSubs
+//
+// INPUTS: (Window *window)
+//
+// RETURN: (void)
+//
+// PURPOSE: Stop tracking substructures with no instances in the window.
+//******************************************************************************
+
+void RemoveEmptyWindowSubs(Window *window)
+{
+   WindowSub *windowSub = window->subs;
+   WindowSub *previousWindowSub = NULL;
+   WindowSub *nextWindowSub;
+
+   while (windowSub != NULL)
+   {
+      nextWindowSub = windowSub->next;
+      if (windowSub->sub->numInstances == 0)
+      {
+         if (previousWindowSub == NULL)
+            window->subs = nextWindowSub;
+         else
+            previousWindowSub->next = nextWindowSub;
+         FreeWindowSub(windowSub);
+         window->numSubs--;
+      }
+      else
+         previousWindowSub = windowSub;
+      windowSub = nextWindowSub;
+   }
+}
+
+
+//******************************************************************************
+// NAME: EvaluateWindowSubs
+//
+// INPUTS: (Parameters *parameters)
+//
+// RETURN: (void)
+//
+// PURPOSE: Set the value of each tracked substructure over the window
+// from the totals of its slots.
+//******************************************************************************
+
+void EvaluateWindowSubs(Parameters *parameters)
+{
+   Window *window = parameters->window;
+   WindowSub *windowSub = window->subs;
+   Substructure *sub;
+   double sizeOfSub;
+
+   while (windowSub != NULL)
+   {
+      sub = windowSub->sub;
+      switch (parameters->evalMethod)
+      {
+         case EVAL_MDL:
+            sizeOfSub = MDL(sub->definition, parameters->labelList->numLabels,
+                            parameters);
+            sub->value = window->graphSize /
+               (sizeOfSub + window->graphSubSize - windowSub->totalSavings);
+            break;
+
+         case EVAL_SIZE:
+            sizeOfSub = (double) GraphSize(sub->definition);
+            sub->value = window->graphSize /
+               (sizeOfSub + window->graphSubSize - windowSub->totalSavings);
+            break;
+
+         case EVAL_SETCOVER:
+            sub->value = ((double) sub->numExamples) /
+                         ((double) window->numIncrements);
+            break;
+      }
+      windowSub = windowSub->next;
+   }
+}
+
+
+//******************************************************************************
+// NAME: WindowBestSubs
+//
+// INPUTS: (Parameters *parameters)
+//
+// RETURN: (SubList *) - best substructures of the window, best first
+//
+// PURPOSE: Return copies of the parameters->numBestSubs tracked
+// substructures of highest value, without instances, for printing and
+// writing to the output file.
+//******************************************************************************
+
+SubList *WindowBestSubs(Parameters *parameters)
+{
+   SubList *subList;
+   WindowSub *windowSub;
+   Substructure *sub;
+
+   subList = AllocateSubList();
+   if (parameters->window == NULL)
+      return subList;
+   windowSub = parameters->window->subs;
+   while (windowSub != NULL)
+   {
+      sub = AllocateSub();
+      sub->definition = CopyGraph(windowSub->sub->definition);
+      sub->numInstances = windowSub->sub->numInstances;
+      sub->numExamples = windowSub->sub->numExamples;
+      sub->value = windowSub->sub->value;
+      SubListInsert(sub, subList, parameters->numBestSubs, FALSE,
+                    parameters->labelList);
+      windowSub = windowSub->next;
+   }
+   return subList;
+}
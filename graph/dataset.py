@@ -4,8 +4,11 @@
 # Date      Name       Description
 # ========  =========  ========================================================
 # 1/27/19   Paudel     Initial version,
+# 10/17/26  agent      Discover subgraphs with the gbad server
+# 10/17/26  agent      Fall back to running gbad when no server is listening
 # ******************************************************************************
 from properties import DataList, SubGen, GBAD
+from graph.gbad_client import GBADClient, parse_subgraphs
 import os
 import networkx as nx
 
@@ -18,6 +21,7 @@ class Dataset():
     param = None
     available_dataset = []
     subgraph_list = {}
+    gbad_client = None
 
     def __int__(self):
         print("\n\n----- Preparing Dataset ----")
@@ -235,25 +239,27 @@ class Dataset():
 
     def read_subgraph(self, subgraphFile):
         # This is to read in networkx format
-        s = {}
-        instance = 0
         with open(subgraphFile) as f:
-            lines = f.readlines()
-            for l in lines:
-                item = l.split(' ')
-                if l == "\n":
-                    s[
-                        sub_graph] = instance  # insert total instance count, new window and old window..  old window 0 this time
-                elif item[0] == 'S':
-                    sub_graph = nx.DiGraph()
-                    instance = int(item[1].strip('\n').strip(' '))
-                elif item[0] == 'v':
-                    sub_graph.add_node(item[1], label=item[2].strip('\n').strip('\"'))
-                elif item[0] == 'u' or item[0] == 'd':
-                    sub_graph.add_edge(item[1], item[2], label=item[3].strip('\n').strip('\"'))
-        return s
+            return parse_subgraphs(f.readlines())
 
     def generate_discriminative_subgraph(self, graph_file, dataset_name, param_n):
+        # Discover with the gbad server (gbad -serve GBAD.server_socket),
+        # reusing one connection for all graphs.  If no server is listening,
+        # run gbad on each graph instead.
+        if Dataset.gbad_client is None:
+            try:
+                Dataset.gbad_client = GBADClient(GBAD.server_socket)
+            except OSError:
+                print("No gbad server on " + GBAD.server_socket + ", running " + GBAD.gbad_home + "/bin/gbad")
+                Dataset.gbad_client = False
+        if not Dataset.gbad_client:
+            return self.run_gbad(graph_file, dataset_name, param_n)
+        with open(graph_file) as f:
+            graph = f.read()
+        records = Dataset.gbad_client.discover(graph, GBAD.options + " -nsubs " + str(param_n))
+        return parse_subgraphs("".join(records).splitlines(True))
+
+    def run_gbad(self, graph_file, dataset_name, param_n):
         subgraph_file = GBAD.graph_folder + "/" + "SG_" + dataset_name + '.g'
         output_file = GBAD.graph_folder + "/" + "out_" + dataset_name +'.txt'
         try:
@@ -0,0 +1,104 @@
+# ******************************************************************************
+# gbad_client.py
+#
+# Client of the gbad server (gbad -serve <socket>). Sends a graph with option
+# overrides over the server's Unix-domain socket and returns the best
+# substructures, without starting gbad or writing files for each graph.
+#
+# Date      Name       Description
+# ========  =========  ========================================================
+# 10/17/26  agent      Initial version
+# 10/17/26  agent      Resolve the socket path against the repository root
+# ******************************************************************************
+import os
+import socket
+import struct
+import networkx as nx
+from properties import GBAD
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+def repo_path(path):
+    '''PURPOSE: Resolve a path given in properties.py, which is relative to
+               the repository root, whatever the working directory
+    '''
+    return os.path.join(ROOT, path)
+
+
+class GBADError(Exception):
+    pass
+
+
+class GBADClient():
+    def __init__(self, socket_path=GBAD.server_socket):
+        '''PURPOSE: Connect to the gbad server
+                :param socket_path: server socket, relative to the repository
+                                    root unless absolute
+                :raises OSError: if no server is listening on the socket
+        '''
+        self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        try:
+            self.sock.connect(repo_path(socket_path))
+        except OSError:
+            self.sock.close()
+            raise
+
+    def close(self):
+        self.sock.close()
+
+    def discover(self, graph, options=""):
+        '''PURPOSE: Run discovery on a graph in the gbad input format
+                :param graph: graph as text (str) or binary graph (bytes)
+                :param options: gbad command-line options for this graph
+                :return: best substructures of each iteration, in the format
+                         of the gbad -out file
+        '''
+        if isinstance(graph, str):
+            graph = graph.encode()
+        options = options.encode()
+        self.sock.sendall(struct.pack("!I", len(options)) + options +
+                          struct.pack("!I", len(graph)) + graph)
+        records = []
+        frame = self._read_frame()
+        while frame:
+            if frame.startswith(b"ERROR: "):
+                self._read_frame()
+                raise GBADError(frame[7:].decode().strip())
+            records.append(frame.decode())
+            frame = self._read_frame()
+        return records
+
+    def _read_frame(self):
+        length = struct.unpack("!I", self._read(4))[0]
+        return self._read(length)
+
+    def _read(self, length):
+        data = b""
+        while len(data) < length:
+            chunk = self.sock.recv(length - len(data))
+            if not chunk:
+                raise GBADError("connection closed by gbad server")
+            data += chunk
+        return data
+
+
+def parse_subgraphs(lines):
+    '''PURPOSE: Read substructures in the format of the gbad -out file
+            :param lines: lines of the file
+            :return: dictionary of substructure (networkx) to instance count
+    '''
+    s = {}
+    instance = 0
+    for l in lines:
+        item = l.split(' ')
+        if l == "\n":
+            s[sub_graph] = instance  # insert total instance count
+        elif item[0] == 'S':
+            sub_graph = nx.DiGraph()
+            instance = int(item[1].strip('\n').strip(' '))
+        elif item[0] == 'v':
+            sub_graph.add_node(item[1], label=item[2].strip('\n').strip('\"'))
+        elif item[0] == 'u' or item[0] == 'd':
+            sub_graph.add_edge(item[1], item[2], label=item[3].strip('\n').strip('\"'))
+    return s
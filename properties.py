@@ -21,6 +21,8 @@ class GBAD:
     minsize = 1
     maxsize = 10
     run_command = "bin/gbad " + " -minsize " + str(minsize) + " -maxsize " + str(maxsize)
+    options = " -minsize " + str(minsize) + " -maxsize " + str(maxsize)
+    server_socket = "gbad/gbad.sock"       # gbad -serve gbad/gbad.sock, from the repository root
     algorithm = "mdl"
 
 class SubDue: